@@ -61,6 +61,152 @@ Service* FindService(std::list<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+Database::Database(const Database& other) : services(other.services) {
+  BuildIndex();
+}
+
+Database& Database::operator=(const Database& other) {
+  if (this != &other) {
+    services = other.services;
+    BuildIndex();
+  }
+  return *this;
+}
+
+void Database::BuildIndex() {
+  service_index.clear();
+  attributes.clear();
+  handle_index.clear();
+
+  for (const Service& service : services) service_index.push_back(&service);
+  std::stable_sort(service_index.begin(), service_index.end(),
+                   [](const Service* a, const Service* b) {
+                     return a->handle < b->handle;
+                   });
+
+  /* Remote databases may nest or overlap service ranges. The closest
+   * preceding service is then not necessarily the first one containing a
+   * handle, so drop the index and let lookups scan |services| in order */
+  uint16_t max_end_handle = 0;
+  for (auto it = service_index.begin(); it != service_index.end(); ++it) {
+    if (it != service_index.begin() && (*it)->handle <= max_end_handle) {
+      service_index.clear();
+      break;
+    }
+    max_end_handle = std::max(max_end_handle, (*it)->end_handle);
+  }
+
+  /* Index only attributes that a lookup by handle would find in their own
+   * service, so the result is the same as scanning |services| */
+  for (const Service& service : services) {
+    for (const Characteristic& charac : service.characteristics) {
+      if (FindService(charac.value_handle) == &service) {
+        attributes.push_back(IndexedAttribute{.handle = charac.value_handle,
+                                              .characteristic = &charac,
+                                              .descriptor = nullptr,
+                                              .owner = nullptr});
+      }
+
+      for (const Descriptor& desc : charac.descriptors) {
+        if (FindService(desc.handle) != &service) continue;
+        attributes.push_back(IndexedAttribute{.handle = desc.handle,
+                                              .characteristic = nullptr,
+                                              .descriptor = &desc,
+                                              .owner = &charac});
+      }
+    }
+  }
+
+  /* Collapse attributes sharing a handle, the first one in service order wins
+   * just like it would when scanning */
+  std::stable_sort(attributes.begin(), attributes.end(),
+                   [](const IndexedAttribute& a, const IndexedAttribute& b) {
+                     return a.handle < b.handle;
+                   });
+  auto last = attributes.begin();
+  for (auto it = attributes.begin(); it != attributes.end(); ++it) {
+    if (it == last) continue;
+    if (it->handle != last->handle) {
+      *(++last) = *it;
+      continue;
+    }
+    if (!last->characteristic) last->characteristic = it->characteristic;
+    if (!last->descriptor) {
+      last->descriptor = it->descriptor;
+      last->owner = it->owner;
+    }
+  }
+  if (!attributes.empty()) attributes.erase(last + 1, attributes.end());
+  attributes.shrink_to_fit();
+
+  if (attributes.empty()) return;
+
+  size_t span = attributes.back().handle - attributes.front().handle + 1;
+  if (span > kMaxDenseHandleSpan) return;
+
+  handle_index.assign(span, 0);
+  for (size_t i = 0; i < attributes.size(); i++) {
+    handle_index[attributes[i].handle - attributes.front().handle] = i + 1;
+  }
+}
+
+const Service* Database::FindService(uint16_t handle) const {
+  if (service_index.empty()) {
+    for (const Service& service : services) {
+      if (HandleInRange(service, handle)) return &service;
+    }
+    return nullptr;
+  }
+
+  auto it = std::upper_bound(
+      service_index.begin(), service_index.end(), handle,
+      [](uint16_t handle, const Service* s) { return handle < s->handle; });
+  if (it == service_index.begin()) return nullptr;
+
+  const Service* service = *(--it);
+  return HandleInRange(*service, handle) ? service : nullptr;
+}
+
+const Database::IndexedAttribute* Database::FindAttribute(
+    uint16_t handle) const {
+  if (attributes.empty()) return nullptr;
+
+  if (!handle_index.empty()) {
+    uint16_t first = attributes.front().handle;
+    if (handle < first) return nullptr;
+
+    size_t offset = handle - first;
+    if (offset >= handle_index.size()) return nullptr;
+
+    uint16_t pos = handle_index[offset];
+    return pos ? &attributes[pos - 1] : nullptr;
+  }
+
+  auto it = std::lower_bound(
+      attributes.begin(), attributes.end(), handle,
+      [](const IndexedAttribute& a, uint16_t handle) {
+        return a.handle < handle;
+      });
+  if (it == attributes.end() || it->handle != handle) return nullptr;
+  return &(*it);
+}
+
+const Characteristic* Database::FindCharacteristic(uint16_t handle) const {
+  const IndexedAttribute* attr = FindAttribute(handle);
+  return attr ? attr->characteristic : nullptr;
+}
+
+const Descriptor* Database::FindDescriptor(uint16_t handle) const {
+  const IndexedAttribute* attr = FindAttribute(handle);
+  return attr ? attr->descriptor : nullptr;
+}
+
+const Characteristic* Database::FindOwningCharacteristic(
+    uint16_t handle) const {
+  const IndexedAttribute* attr = FindAttribute(handle);
+  return attr ? attr->owner : nullptr;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -170,15 +316,18 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
       LOG(ERROR) << "Can't find service for attribute with handle: "
                  << loghex(attr.handle);
       *success = false;
+      result.BuildIndex();
       return result;
     }
 
     if (attr.type == INCLUDE) {
       Service* included_service =
-          FindService(result.services, attr.value.included_service.handle);
+          gatt::FindService(result.services,
+                            attr.value.included_service.handle);
       if (!included_service) {
         LOG(ERROR) << __func__ << ": Non-existing included service!";
         *success = false;
+        result.BuildIndex();
         return result;
       }
       current_service_it->included_services.push_back(IncludedService{
@@ -209,6 +358,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
       }
     }
   }
+  result.BuildIndex();
   *success = true;
   return result;
 }
@@ -102,12 +102,25 @@ class DatabaseBuilder;
 
 class Database {
  public:
+  Database() = default;
+  Database(Database&&) = default;
+  Database& operator=(Database&&) = default;
+
+  /* The handle index points into |services|, so copies rebuild their own */
+  Database(const Database& other);
+  Database& operator=(const Database& other);
+
   /* Return true if there are no services in this database. */
   bool IsEmpty() const { return services.empty(); }
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::list<Service>().swap(services); }
+  void Clear() {
+    std::list<Service>().swap(services);
+    std::vector<const Service*>().swap(service_index);
+    std::vector<IndexedAttribute>().swap(attributes);
+    std::vector<uint16_t>().swap(handle_index);
+  }
 
   /* Return list of services available in this database */
   const std::list<Service>& Services() const { return services; }
@@ -122,10 +135,55 @@ class Database {
   /* Return 128 bit unique identifier of this GATT database */
   Octet16 Hash() const;
 
+  /* Return the service whose handle range contains |handle| */
+  const Service* FindService(uint16_t handle) const;
+
+  /* Return the characteristic whose value handle is |handle| */
+  const Characteristic* FindCharacteristic(uint16_t handle) const;
+
+  /* Return the descriptor with handle |handle| */
+  const Descriptor* FindDescriptor(uint16_t handle) const;
+
+  /* Return the characteristic that owns the descriptor with handle |handle| */
+  const Characteristic* FindOwningCharacteristic(uint16_t handle) const;
+
   friend class DatabaseBuilder;
 
  private:
+  /* Entry of the flattened, handle sorted view of |services|. All pointers
+   * refer to elements of |services|, and only attributes that lie inside the
+   * range of their service are indexed. */
+  struct IndexedAttribute {
+    uint16_t handle;
+    /* characteristic whose value handle is |handle| */
+    const Characteristic* characteristic;
+    /* descriptor with handle |handle|, and the characteristic owning it */
+    const Descriptor* descriptor;
+    const Characteristic* owner;
+  };
+
+  /* Above this many handles between the first and last indexed attribute the
+   * dense |handle_index| is not built, and lookups binary search instead */
+  static constexpr size_t kMaxDenseHandleSpan = 0x1000;
+
+  /* Rebuild the lookup tables from |services|. Must be called whenever
+   * |services| is done changing. */
+  void BuildIndex();
+
+  const IndexedAttribute* FindAttribute(uint16_t handle) const;
+
   std::list<Service> services;
+
+  /* |services| sorted by start handle. Empty if service ranges overlap, in
+   * which case lookups scan |services| */
+  std::vector<const Service*> service_index;
+
+  /* attributes sorted by handle, one entry per handle */
+  std::vector<IndexedAttribute> attributes;
+
+  /* handle - attributes.front().handle -> 1 + position in |attributes|, or 0
+   * if there is no attribute with that handle. Empty if the span is too wide */
+  std::vector<uint16_t> handle_index;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
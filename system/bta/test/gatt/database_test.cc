@@ -285,4 +285,110 @@ TEST(GattCacheTest,
   // LOG(ERROR) << " " << base::HexEncode(&attr, len);
   EXPECT_EQ(memcmp(binary_form, &attr, len), 0);
 }
+
+/* This test makes sure that attributes are found by handle, and that copies and
+ * deserialized databases resolve handles into their own services */
+TEST(GattDatabaseTest, find_by_handle_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0020, 0x002f, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddCharacteristic(0x0021, 0x0022, SERVICE_1_CHAR_1_UUID, 0x10);
+  builder.AddDescriptor(0x0023, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database db = builder.Build();
+
+  const Service& service_1 = db.Services().front();
+  const Service& service_2 = db.Services().back();
+  EXPECT_EQ(db.FindService(0x0001), &service_1);
+  EXPECT_EQ(db.FindService(0x000f), &service_1);
+  EXPECT_EQ(db.FindService(0x0010), nullptr);
+  EXPECT_EQ(db.FindService(0x0025), &service_2);
+  EXPECT_EQ(db.FindService(0x0030), nullptr);
+
+  EXPECT_EQ(db.FindCharacteristic(0x0004), &service_1.characteristics[0]);
+  EXPECT_EQ(db.FindCharacteristic(0x0022), &service_2.characteristics[0]);
+  EXPECT_EQ(db.FindCharacteristic(0x0003), nullptr);
+  EXPECT_EQ(db.FindCharacteristic(0x0005), nullptr);
+
+  EXPECT_EQ(db.FindDescriptor(0x0005),
+            &service_1.characteristics[0].descriptors[0]);
+  EXPECT_EQ(db.FindDescriptor(0x0023),
+            &service_2.characteristics[0].descriptors[0]);
+  EXPECT_EQ(db.FindDescriptor(0x0004), nullptr);
+  EXPECT_EQ(db.FindDescriptor(0x0024), nullptr);
+
+  EXPECT_EQ(db.FindOwningCharacteristic(0x0023),
+            &service_2.characteristics[0]);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x0022), nullptr);
+
+  Database copy = db;
+  EXPECT_EQ(copy.FindCharacteristic(0x0022),
+            &copy.Services().back().characteristics[0]);
+
+  bool success = false;
+  Database loaded = Database::Deserialize(db.Serialize(), &success);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(loaded.FindDescriptor(0x0005),
+            &loaded.Services().front().characteristics[0].descriptors[0]);
+
+  db.Clear();
+  EXPECT_EQ(db.FindService(0x0001), nullptr);
+  EXPECT_EQ(db.FindCharacteristic(0x0004), nullptr);
+}
+
+/* This test makes sure that lookups work when attributes are too far apart for
+ * a dense handle table */
+TEST(GattDatabaseTest, find_by_handle_sparse_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0005, SERVICE_1_UUID, true);
+  builder.AddService(0xfff0, 0xffff, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0xfff1, 0xfff2, SERVICE_1_CHAR_1_UUID, 0x10);
+  builder.AddDescriptor(0xffff, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database db = builder.Build();
+
+  const Service& service_2 = db.Services().back();
+  EXPECT_EQ(db.FindCharacteristic(0x0003),
+            &db.Services().front().characteristics[0]);
+  EXPECT_EQ(db.FindCharacteristic(0xfff2), &service_2.characteristics[0]);
+  EXPECT_EQ(db.FindCharacteristic(0x8000), nullptr);
+  EXPECT_EQ(db.FindDescriptor(0xffff),
+            &service_2.characteristics[0].descriptors[0]);
+  EXPECT_EQ(db.FindOwningCharacteristic(0xffff), &service_2.characteristics[0]);
+}
+
+/* This test makes sure that a service nested inside another one does not hide
+ * the outer service's handles above the nested range */
+TEST(GattDatabaseTest, find_by_handle_nested_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0100, SERVICE_1_UUID, true);
+  builder.AddService(0x0010, 0x0020, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0011, 0x0012, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0030, 0x0031, SERVICE_1_CHAR_1_UUID, 0x10);
+  builder.AddDescriptor(0x0032, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database db = builder.Build();
+
+  /* the nested service is first in |services|, as the builder orders them */
+  const Service& inner = db.Services().front();
+  const Service& outer = db.Services().back();
+  ASSERT_EQ(inner.handle, 0x0010);
+  ASSERT_EQ(outer.handle, 0x0001);
+
+  EXPECT_EQ(db.FindService(0x0002), &outer);
+  EXPECT_EQ(db.FindService(0x0015), &inner);
+  EXPECT_EQ(db.FindService(0x0050), &outer);
+  EXPECT_EQ(db.FindService(0x0101), nullptr);
+
+  EXPECT_EQ(db.FindCharacteristic(0x0003), &outer.characteristics[0]);
+  EXPECT_EQ(db.FindCharacteristic(0x0012), &inner.characteristics[0]);
+  EXPECT_EQ(db.FindCharacteristic(0x0031), &outer.characteristics[1]);
+  EXPECT_EQ(db.FindDescriptor(0x0032),
+            &outer.characteristics[1].descriptors[0]);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x0032), &outer.characteristics[1]);
+}
 }  // namespace gatt
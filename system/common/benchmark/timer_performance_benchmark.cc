@@ -19,12 +19,14 @@
 #include <base/threading/thread.h>
 #include <benchmark/benchmark.h>
 #include <future>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "common/once_timer.h"
 #include "common/repeating_timer.h"
 #include "common/time_util.h"
 #include "osi/include/alarm.h"
+#include "osi/include/list.h"
 
 using ::benchmark::State;
 using bluetooth::common::MessageLoopThread;
@@ -45,6 +47,8 @@ int g_task_counter;
 
 void TimerFire(void*) { g_promise->set_value(); }
 
+void NoopAlarmCallback(void*) {}
+
 void AlarmSleepAndCountDelayedTime(void*) {
   auto end_time_us = time_get_os_boottime_us();
   auto time_after_start_ms = (end_time_us - g_start_time) / 1000;
@@ -275,6 +279,107 @@ BENCHMARK_REGISTER_F(BM_AlarmTaskPeriodicTimer, periodic_accuracy)
     ->Iterations(1)
     ->UseRealTime();
 
+// Cost of arming and cancelling one osi alarm while |state.range(0)| other
+// alarms are pending, i.e. the O(log n) heap maintenance in alarm_set() and
+// alarm_cancel(). The deadlines stay far in the future so nothing fires, and
+// the earliest live alarm stays ahead of the measured one so the underlying
+// posix timers are not re-armed.
+class BM_OsiAlarmScheduler : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    for (int64_t i = 0; i < st.range(0); i++) {
+      alarm_t* alarm = alarm_new("osi_alarm_scheduler_live");
+      alarm_set(alarm, 600000 + i * 1000, &NoopAlarmCallback, nullptr);
+      live_alarms_.push_back(alarm);
+    }
+    alarm_ = alarm_new("osi_alarm_scheduler_test");
+  }
+
+  void TearDown(State& st) override {
+    alarm_free(alarm_);
+    alarm_ = nullptr;
+    for (alarm_t* alarm : live_alarms_) {
+      alarm_free(alarm);
+    }
+    live_alarms_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  alarm_t* alarm_ = nullptr;
+  std::vector<alarm_t*> live_alarms_;
+};
+
+BENCHMARK_DEFINE_F(BM_OsiAlarmScheduler, set_and_cancel_with_live_alarms)
+(State& state) {
+  uint64_t delay_ms = 0;
+  for (auto _ : state) {
+    delay_ms = (delay_ms + 7919) % 3600000;
+    alarm_set(alarm_, 1200000 + delay_ms, &NoopAlarmCallback, nullptr);
+    alarm_cancel(alarm_);
+  }
+  state.SetItemsProcessed(state.iterations());
+};
+
+BENCHMARK_REGISTER_F(BM_OsiAlarmScheduler, set_and_cancel_with_live_alarms)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
+
+// Baseline: the sorted-list insertion and removal that osi alarm used before
+// it moved to a min-heap, on the same deadline pattern as above.
+namespace {
+struct LegacyListAlarm {
+  uint64_t deadline_ms;
+};
+
+void legacy_sorted_list_insert(list_t* alarms, LegacyListAlarm* alarm) {
+  if (list_is_empty(alarms) ||
+      static_cast<LegacyListAlarm*>(list_front(alarms))->deadline_ms >
+          alarm->deadline_ms) {
+    list_prepend(alarms, alarm);
+    return;
+  }
+  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
+       node = list_next(node)) {
+    list_node_t* next = list_next(node);
+    if (next == list_end(alarms) ||
+        static_cast<LegacyListAlarm*>(list_node(next))->deadline_ms >
+            alarm->deadline_ms) {
+      list_insert_after(alarms, node, alarm);
+      return;
+    }
+  }
+}
+}  // namespace
+
+static void BM_LegacySortedAlarmList_set_and_cancel_with_live_alarms(
+    State& state) {
+  list_t* alarms = list_new(nullptr);
+  std::vector<LegacyListAlarm> live_alarms(state.range(0));
+  for (int64_t i = 0; i < state.range(0); i++) {
+    live_alarms[i].deadline_ms = 600000 + i * 1000;
+    legacy_sorted_list_insert(alarms, &live_alarms[i]);
+  }
+  LegacyListAlarm alarm = {};
+  uint64_t delay_ms = 0;
+  for (auto _ : state) {
+    delay_ms = (delay_ms + 7919) % 3600000;
+    alarm.deadline_ms = 1200000 + delay_ms;
+    legacy_sorted_list_insert(alarms, &alarm);
+    list_remove(alarms, &alarm);
+  }
+  list_free(alarms);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_LegacySortedAlarmList_set_and_cancel_with_live_alarms)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
+
 int main(int argc, char** argv) {
   // Disable LOG() output from libchrome
   logging::LoggingSettings log_settings;
@@ -0,0 +1,411 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/aes_backend.h"
+
+#include <algorithm>
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#define AES_BACKEND_X86 1
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define AES_BACKEND_ARMV8 1
+#endif
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr uint8_t xtime(uint8_t x) {
+  return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+constexpr uint8_t gf_multiply(uint8_t a, uint8_t b) {
+  uint8_t product = 0;
+  for (int i = 0; i < 8; i++) {
+    if (b & 1) product ^= a;
+    a = xtime(a);
+    b >>= 1;
+  }
+  return product;
+}
+
+constexpr std::array<uint8_t, 256> make_sbox() {
+  std::array<uint8_t, 256> sbox{};
+  for (int x = 0; x < 256; x++) {
+    // Multiplicative inverse in GF(2^8), x^254, followed by the affine transformation
+    uint8_t inverse = 0;
+    if (x != 0) {
+      uint8_t power = static_cast<uint8_t>(x);
+      inverse = 1;
+      for (int exponent = 254; exponent != 0; exponent >>= 1) {
+        if (exponent & 1) inverse = gf_multiply(inverse, power);
+        power = gf_multiply(power, power);
+      }
+    }
+    uint8_t s = inverse;
+    for (int i = 1; i < 5; i++) {
+      s ^= static_cast<uint8_t>((inverse << i) | (inverse >> (8 - i)));
+    }
+    sbox[x] = s ^ 0x63;
+  }
+  return sbox;
+}
+
+constexpr std::array<uint8_t, 256> kSbox = make_sbox();
+
+constexpr uint32_t rotate_right(uint32_t word, int bits) {
+  return bits == 0 ? word : (word >> bits) | (word << (32 - bits));
+}
+
+// Column contributions of SubBytes, ShiftRows and MixColumns, Te[i][x] = Te[0][x] rotated right by 8 * i
+constexpr std::array<std::array<uint32_t, 256>, 4> make_te() {
+  std::array<std::array<uint32_t, 256>, 4> te{};
+  for (int x = 0; x < 256; x++) {
+    uint8_t s = kSbox[x];
+    uint32_t word = (static_cast<uint32_t>(xtime(s)) << 24) | (static_cast<uint32_t>(s) << 16) |
+                    (static_cast<uint32_t>(s) << 8) | static_cast<uint32_t>(xtime(s) ^ s);
+    for (int i = 0; i < 4; i++) {
+      te[i][x] = rotate_right(word, 8 * i);
+    }
+  }
+  return te;
+}
+
+constexpr std::array<std::array<uint32_t, 256>, 4> kTe = make_te();
+
+constexpr uint8_t kRcon[kAes128Rounds] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+uint32_t load_be32(const uint8_t* bytes) {
+  return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+void store_be32(uint32_t word, uint8_t* bytes) {
+  bytes[0] = static_cast<uint8_t>(word >> 24);
+  bytes[1] = static_cast<uint8_t>(word >> 16);
+  bytes[2] = static_cast<uint8_t>(word >> 8);
+  bytes[3] = static_cast<uint8_t>(word);
+}
+
+// SubBytes of the bytes of a, b, c and d in the columns of one output column, as after ShiftRows
+uint32_t sub_column(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  return (static_cast<uint32_t>(kSbox[a >> 24]) << 24) | (static_cast<uint32_t>(kSbox[(b >> 16) & 0xff]) << 16) |
+         (static_cast<uint32_t>(kSbox[(c >> 8) & 0xff]) << 8) | static_cast<uint32_t>(kSbox[d & 0xff]);
+}
+
+uint32_t te_column(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  return kTe[0][a >> 24] ^ kTe[1][(b >> 16) & 0xff] ^ kTe[2][(c >> 8) & 0xff] ^ kTe[3][d & 0xff];
+}
+
+void expand_key_table(const uint8_t key[kAesBlockSize], Aes128KeySchedule* schedule) {
+  uint32_t w[4 * (kAes128Rounds + 1)];
+  for (int i = 0; i < 4; i++) {
+    w[i] = load_be32(key + 4 * i);
+  }
+  for (size_t i = 4; i < 4 * (kAes128Rounds + 1); i++) {
+    uint32_t temp = w[i - 1];
+    if (i % 4 == 0) {
+      uint32_t rotated = (temp << 8) | (temp >> 24);
+      temp = sub_column(rotated, rotated, rotated, rotated) ^ (static_cast<uint32_t>(kRcon[i / 4 - 1]) << 24);
+    }
+    w[i] = w[i - 4] ^ temp;
+  }
+  for (size_t i = 0; i < 4 * (kAes128Rounds + 1); i++) {
+    store_be32(w[i], schedule->round_keys + 4 * i);
+  }
+}
+
+void encrypt_table(const Aes128KeySchedule& schedule, const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]) {
+  const uint8_t* rk = schedule.round_keys;
+  uint32_t s0 = load_be32(in) ^ load_be32(rk);
+  uint32_t s1 = load_be32(in + 4) ^ load_be32(rk + 4);
+  uint32_t s2 = load_be32(in + 8) ^ load_be32(rk + 8);
+  uint32_t s3 = load_be32(in + 12) ^ load_be32(rk + 12);
+
+  for (size_t round = 1; round < kAes128Rounds; round++) {
+    rk += kAesBlockSize;
+    uint32_t t0 = te_column(s0, s1, s2, s3) ^ load_be32(rk);
+    uint32_t t1 = te_column(s1, s2, s3, s0) ^ load_be32(rk + 4);
+    uint32_t t2 = te_column(s2, s3, s0, s1) ^ load_be32(rk + 8);
+    uint32_t t3 = te_column(s3, s0, s1, s2) ^ load_be32(rk + 12);
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+
+  // The last round has no MixColumns
+  rk += kAesBlockSize;
+  store_be32(sub_column(s0, s1, s2, s3) ^ load_be32(rk), out);
+  store_be32(sub_column(s1, s2, s3, s0) ^ load_be32(rk + 4), out + 4);
+  store_be32(sub_column(s2, s3, s0, s1) ^ load_be32(rk + 8), out + 8);
+  store_be32(sub_column(s3, s0, s1, s2) ^ load_be32(rk + 12), out + 12);
+}
+
+void encrypt_blocks_table(
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count) {
+  Aes128KeySchedule schedule;
+  for (size_t i = 0; i < count; i++) {
+    expand_key_table(keys[i], &schedule);
+    encrypt_table(schedule, in[i], out[i]);
+  }
+}
+
+#if defined(AES_BACKEND_X86)
+
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+// Number of blocks in flight, enough to hide the latency of AESENC
+constexpr size_t kAesniInterleave = 8;
+
+bool cpu_supports_aesni() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  return (ecx & bit_AES) != 0;
+}
+
+AESNI_TARGET __m128i expand_key_step(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, 0xff);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+AESNI_TARGET __m128i load_block(const uint8_t* bytes) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+}
+
+AESNI_TARGET void store_block(__m128i block, uint8_t* bytes) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), block);
+}
+
+AESNI_TARGET void encrypt_aesni(
+    const Aes128KeySchedule& schedule, const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]) {
+  const uint8_t* rk = schedule.round_keys;
+  __m128i block = _mm_xor_si128(load_block(in), load_block(rk));
+  for (size_t round = 1; round < kAes128Rounds; round++) {
+    block = _mm_aesenc_si128(block, load_block(rk + round * kAesBlockSize));
+  }
+  block = _mm_aesenclast_si128(block, load_block(rk + kAes128Rounds * kAesBlockSize));
+  store_block(block, out);
+}
+
+// Encrypt |kBlocks| blocks, each with its own key. The keys are expanded along with the encryption so that the
+// independent blocks hide the latency of each other.
+template <size_t kBlocks>
+AESNI_TARGET void encrypt_group_aesni(
+    const uint8_t (*keys)[kAesBlockSize], const uint8_t (*in)[kAesBlockSize], uint8_t (*out)[kAesBlockSize]) {
+  __m128i round_keys[kBlocks];
+  __m128i blocks[kBlocks];
+  for (size_t i = 0; i < kBlocks; i++) {
+    round_keys[i] = load_block(keys[i]);
+    blocks[i] = _mm_xor_si128(load_block(in[i]), round_keys[i]);
+  }
+  // The round constant of AESKEYGENASSIST is an immediate
+#define AESNI_ROUND(rcon, aesenc)                                                                                      \
+  for (size_t i = 0; i < kBlocks; i++) {                                                                               \
+    __m128i assist = _mm_aeskeygenassist_si128(round_keys[i], rcon);                                                   \
+    round_keys[i] = expand_key_step(round_keys[i], assist);                                                            \
+    blocks[i] = aesenc(blocks[i], round_keys[i]);                                                                      \
+  }
+  AESNI_ROUND(0x01, _mm_aesenc_si128);
+  AESNI_ROUND(0x02, _mm_aesenc_si128);
+  AESNI_ROUND(0x04, _mm_aesenc_si128);
+  AESNI_ROUND(0x08, _mm_aesenc_si128);
+  AESNI_ROUND(0x10, _mm_aesenc_si128);
+  AESNI_ROUND(0x20, _mm_aesenc_si128);
+  AESNI_ROUND(0x40, _mm_aesenc_si128);
+  AESNI_ROUND(0x80, _mm_aesenc_si128);
+  AESNI_ROUND(0x1b, _mm_aesenc_si128);
+  AESNI_ROUND(0x36, _mm_aesenclast_si128);
+#undef AESNI_ROUND
+  for (size_t i = 0; i < kBlocks; i++) {
+    store_block(blocks[i], out[i]);
+  }
+}
+
+void encrypt_blocks_aesni(
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count) {
+  size_t first = 0;
+  for (; first + kAesniInterleave <= count; first += kAesniInterleave) {
+    encrypt_group_aesni<kAesniInterleave>(keys + first, in + first, out + first);
+  }
+  // The remaining blocks in groups of 4, 2 and 1
+  if (count - first >= 4) {
+    encrypt_group_aesni<4>(keys + first, in + first, out + first);
+    first += 4;
+  }
+  if (count - first >= 2) {
+    encrypt_group_aesni<2>(keys + first, in + first, out + first);
+    first += 2;
+  }
+  if (count - first >= 1) {
+    encrypt_group_aesni<1>(keys + first, in + first, out + first);
+  }
+}
+
+#endif  // defined(AES_BACKEND_X86)
+
+#if defined(AES_BACKEND_ARMV8)
+
+#if defined(__clang__)
+#define ARMV8_CRYPTO_TARGET __attribute__((target("aes")))
+#else
+#define ARMV8_CRYPTO_TARGET __attribute__((target("+crypto")))
+#endif
+
+// Number of blocks in flight, enough to hide the latency of AESE/AESMC
+constexpr size_t kArmv8Interleave = 4;
+
+bool cpu_supports_armv8_crypto() {
+  return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+}
+
+ARMV8_CRYPTO_TARGET uint8x16_t round_key(const Aes128KeySchedule& schedule, size_t round) {
+  return vld1q_u8(schedule.round_keys + round * kAesBlockSize);
+}
+
+ARMV8_CRYPTO_TARGET void encrypt_armv8(
+    const Aes128KeySchedule& schedule, const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]) {
+  uint8x16_t block = vld1q_u8(in);
+  // AESE is AddRoundKey followed by SubBytes and ShiftRows
+  for (size_t round = 0; round < kAes128Rounds - 1; round++) {
+    block = vaesmcq_u8(vaeseq_u8(block, round_key(schedule, round)));
+  }
+  block = vaeseq_u8(block, round_key(schedule, kAes128Rounds - 1));
+  block = veorq_u8(block, round_key(schedule, kAes128Rounds));
+  vst1q_u8(out, block);
+}
+
+ARMV8_CRYPTO_TARGET void encrypt_blocks_armv8(
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count) {
+  Aes128KeySchedule schedules[kArmv8Interleave];
+  uint8x16_t blocks[kArmv8Interleave];
+  for (size_t first = 0; first < count; first += kArmv8Interleave) {
+    size_t n = std::min(kArmv8Interleave, count - first);
+    for (size_t i = 0; i < n; i++) {
+      expand_key_table(keys[first + i], &schedules[i]);
+      blocks[i] = vld1q_u8(in[first + i]);
+    }
+    for (size_t round = 0; round < kAes128Rounds - 1; round++) {
+      for (size_t i = 0; i < n; i++) {
+        blocks[i] = vaesmcq_u8(vaeseq_u8(blocks[i], round_key(schedules[i], round)));
+      }
+    }
+    for (size_t i = 0; i < n; i++) {
+      blocks[i] = vaeseq_u8(blocks[i], round_key(schedules[i], kAes128Rounds - 1));
+      blocks[i] = veorq_u8(blocks[i], round_key(schedules[i], kAes128Rounds));
+      vst1q_u8(out[first + i], blocks[i]);
+    }
+  }
+}
+
+#endif  // defined(AES_BACKEND_ARMV8)
+
+AesImplementation select_implementation() {
+#if defined(AES_BACKEND_X86)
+  if (cpu_supports_aesni()) return AesImplementation::X86_AESNI;
+#elif defined(AES_BACKEND_ARMV8)
+  if (cpu_supports_armv8_crypto()) return AesImplementation::ARMV8_CRYPTO;
+#endif
+  return AesImplementation::TABLE;
+}
+
+}  // namespace
+
+AesImplementation GetAesImplementation() {
+  static const AesImplementation implementation = select_implementation();
+  return implementation;
+}
+
+bool IsAesImplementationSupported(AesImplementation implementation) {
+  return implementation == AesImplementation::TABLE || implementation == GetAesImplementation();
+}
+
+void aes128_expand_key(const uint8_t key[kAesBlockSize], Aes128KeySchedule* schedule) {
+  // All implementations share the key schedule of FIPS-197, only encryption is accelerated
+  expand_key_table(key, schedule);
+}
+
+void aes128_encrypt(const Aes128KeySchedule& schedule, const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]) {
+  switch (GetAesImplementation()) {
+#if defined(AES_BACKEND_X86)
+    case AesImplementation::X86_AESNI:
+      encrypt_aesni(schedule, in, out);
+      return;
+#endif
+#if defined(AES_BACKEND_ARMV8)
+    case AesImplementation::ARMV8_CRYPTO:
+      encrypt_armv8(schedule, in, out);
+      return;
+#endif
+    default:
+      encrypt_table(schedule, in, out);
+      return;
+  }
+}
+
+void aes128_encrypt_blocks(
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count) {
+  aes128_encrypt_blocks(GetAesImplementation(), keys, in, out, count);
+}
+
+void aes128_encrypt_blocks(
+    AesImplementation implementation,
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count) {
+  switch (implementation) {
+#if defined(AES_BACKEND_X86)
+    case AesImplementation::X86_AESNI:
+      encrypt_blocks_aesni(keys, in, out, count);
+      return;
+#endif
+#if defined(AES_BACKEND_ARMV8)
+    case AesImplementation::ARMV8_CRYPTO:
+      encrypt_blocks_armv8(keys, in, out, count);
+      return;
+#endif
+    default:
+      encrypt_blocks_table(keys, in, out, count);
+      return;
+  }
+}
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+// AES-128 block encryption with the fastest implementation the CPU supports. Unlike the rest of the crypto_toolbox,
+// keys and blocks are in the byte order of FIPS-197, as with aes_encrypt() of aes.h.
+
+enum class AesImplementation {
+  // Portable implementation with 32-bit lookup tables
+  TABLE,
+  // x86 AES-NI instructions
+  X86_AESNI,
+  // ARMv8 Cryptography Extension
+  ARMV8_CRYPTO,
+};
+
+constexpr size_t kAesBlockSize = 16;
+constexpr size_t kAes128Rounds = 10;
+
+struct Aes128KeySchedule {
+  alignas(16) uint8_t round_keys[(kAes128Rounds + 1) * kAesBlockSize];
+};
+
+// Implementation used by the functions below, selected once from the CPU features
+AesImplementation GetAesImplementation();
+
+bool IsAesImplementationSupported(AesImplementation implementation);
+
+void aes128_expand_key(const uint8_t key[kAesBlockSize], Aes128KeySchedule* schedule);
+
+void aes128_encrypt(const Aes128KeySchedule& schedule, const uint8_t in[kAesBlockSize], uint8_t out[kAesBlockSize]);
+
+// Encrypt |count| independent blocks, in[i] with keys[i] into out[i]. Hardware implementations interleave the blocks,
+// which is several times faster than encrypting them one at a time.
+void aes128_encrypt_blocks(
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count);
+
+// Same as above with the given implementation, which must be supported. For tests and benchmarks.
+void aes128_encrypt_blocks(
+    AesImplementation implementation,
+    const uint8_t (*keys)[kAesBlockSize],
+    const uint8_t (*in)[kAesBlockSize],
+    uint8_t (*out)[kAesBlockSize],
+    size_t count);
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
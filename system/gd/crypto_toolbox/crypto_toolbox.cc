@@ -20,7 +20,7 @@
 
 #include <algorithm>
 
-#include "crypto_toolbox/aes.h"
+#include "crypto_toolbox/aes_backend.h"
 
 namespace bluetooth {
 namespace crypto_toolbox {
@@ -170,6 +170,38 @@ Octet16 link_key_to_ltk(const Octet16& link_key, bool use_h7) {
   return h6(iltk, keyID_brle);
 }
 
+uint32_t ah(const Octet16& irk, uint32_t prand) {
+  uint32_t hash;
+  ah(&irk, 1, prand, &hash);
+  return hash;
+}
+
+void ah(const Octet16* irks, size_t count, uint32_t prand, uint32_t* hashes) {
+  // Blocks handed to the AES backend at once
+  constexpr size_t kBatchSize = 32;
+  uint8_t keys[kBatchSize][kAesBlockSize];
+  uint8_t r_prime[kBatchSize][kAesBlockSize] = {};
+  uint8_t outputs[kBatchSize][kAesBlockSize];
+
+  // r' = padding || prand, MSB first like the keys given to the backend
+  for (size_t i = 0; i < kBatchSize; i++) {
+    r_prime[i][13] = static_cast<uint8_t>(prand >> 16);
+    r_prime[i][14] = static_cast<uint8_t>(prand >> 8);
+    r_prime[i][15] = static_cast<uint8_t>(prand);
+  }
+
+  for (size_t first = 0; first < count; first += kBatchSize) {
+    size_t n = std::min(kBatchSize, count - first);
+    for (size_t i = 0; i < n; i++) {
+      std::reverse_copy(irks[first + i].begin(), irks[first + i].end(), keys[i]);
+    }
+    aes128_encrypt_blocks(keys, r_prime, outputs, n);
+    for (size_t i = 0; i < n; i++) {
+      hashes[first + i] = (outputs[i][13] << 16) | (outputs[i][14] << 8) | outputs[i][15];
+    }
+  }
+}
+
 Octet16 c1(
     const Octet16& k,
     const Octet16& r,
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -50,6 +51,12 @@ extern uint32_t g2(uint8_t* u, uint8_t* v, const Octet16& x, const Octet16& y);
 extern Octet16 ltk_to_link_key(const Octet16& ltk, bool use_h7);
 extern Octet16 link_key_to_ltk(const Octet16& link_key, bool use_h7);
 
+// Random address hash function ah (Core spec Vol 3, Part H, 2.2.2). |prand| and the hash are 24 bit values.
+extern uint32_t ah(const Octet16& irk, uint32_t prand);
+// ah() of |prand| with each of the |count| keys of |irks|, the hash for irks[i] is stored in hashes[i]. Resolves a
+// random address against a whole list of IRKs several times faster than calling ah() for each of them.
+extern void ah(const Octet16* irks, size_t count, uint32_t prand, uint32_t* hashes);
+
 /* This function computes AES_128(key, message). |key| must be 128bit.
  * |message| can be at most 16 bytes long, it's length in bytes is given in
  * |length| */
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "crypto_toolbox/aes.h"
+#include "crypto_toolbox/aes_backend.h"
+#include "crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace crypto_toolbox {
+namespace {
+
+constexpr size_t kNumBlocks = 64;
+
+void FillBlocks(uint8_t (*blocks)[kAesBlockSize], size_t count, uint8_t seed) {
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < kAesBlockSize; j++) {
+      blocks[i][j] = static_cast<uint8_t>(seed + 31 * i + j);
+    }
+  }
+}
+
+// The byte oriented implementation of aes.h, which the toolbox used before the AES backend
+void BM_Aes128_Reference(State& state) {
+  uint8_t keys[kNumBlocks][kAesBlockSize];
+  uint8_t in[kNumBlocks][kAesBlockSize];
+  uint8_t out[kNumBlocks][kAesBlockSize];
+  FillBlocks(keys, kNumBlocks, 1);
+  FillBlocks(in, kNumBlocks, 2);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumBlocks; i++) {
+      aes_context ctx;
+      aes_set_key(keys[i], kAesBlockSize, &ctx);
+      aes_encrypt(in[i], out[i], &ctx);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kNumBlocks * kAesBlockSize);
+}
+BENCHMARK(BM_Aes128_Reference);
+
+void BM_Aes128(State& state) {
+  auto implementation = static_cast<AesImplementation>(state.range(0));
+  if (!IsAesImplementationSupported(implementation)) {
+    state.SkipWithError("Not supported by this CPU");
+    return;
+  }
+  uint8_t keys[kNumBlocks][kAesBlockSize];
+  uint8_t in[kNumBlocks][kAesBlockSize];
+  uint8_t out[kNumBlocks][kAesBlockSize];
+  FillBlocks(keys, kNumBlocks, 1);
+  FillBlocks(in, kNumBlocks, 2);
+  for (auto _ : state) {
+    aes128_encrypt_blocks(implementation, keys, in, out, kNumBlocks);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kNumBlocks * kAesBlockSize);
+}
+BENCHMARK(BM_Aes128)
+    ->ArgName("implementation")
+    ->Arg(static_cast<int>(AesImplementation::TABLE))
+    ->Arg(static_cast<int>(AesImplementation::X86_AESNI))
+    ->Arg(static_cast<int>(AesImplementation::ARMV8_CRYPTO));
+
+// Same size as the GATT database hash of a large database
+void BM_AesCmac(State& state) {
+  Octet16 key{};
+  std::vector<uint8_t> message(state.range(0), 0x5a);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(aes_cmac(key, message.data(), message.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_AesCmac)->Arg(16)->Arg(4096);
+
+// Resolve one random address against |range(0)| bonded IRKs
+void BM_Ah_OneByOne(State& state) {
+  std::vector<Octet16> irks(state.range(0));
+  FillBlocks(reinterpret_cast<uint8_t(*)[kAesBlockSize]>(irks.data()), irks.size(), 3);
+  uint32_t prand = 0x708194;
+  for (auto _ : state) {
+    for (const auto& irk : irks) {
+      benchmark::DoNotOptimize(ah(irk, prand));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * irks.size());
+}
+BENCHMARK(BM_Ah_OneByOne)->Arg(100);
+
+void BM_Ah_Batched(State& state) {
+  std::vector<Octet16> irks(state.range(0));
+  FillBlocks(reinterpret_cast<uint8_t(*)[kAesBlockSize]>(irks.data()), irks.size(), 3);
+  std::vector<uint32_t> hashes(irks.size());
+  uint32_t prand = 0x708194;
+  for (auto _ : state) {
+    ah(irks.data(), irks.size(), prand, hashes.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * irks.size());
+}
+BENCHMARK(BM_Ah_Batched)->Arg(100);
+
+}  // namespace
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
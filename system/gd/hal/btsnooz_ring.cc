@@ -0,0 +1,215 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/btsnooz_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+
+#include "os/log.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+
+constexpr char kRingMagic[8] = {'b', 't', 's', 'n', 'o', 'o', 'z', 'r'};
+constexpr uint32_t kRingVersion = 1;
+// Slots start on their own cache line
+constexpr size_t kHeaderSize = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The ring is shared with the page cache");
+
+}  // namespace
+
+struct BtsnoozRing::Header {
+  char magic[sizeof(kRingMagic)];
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t slot_size;
+  uint32_t reserved;
+  // Number of records committed since the ring was created
+  std::atomic<uint64_t> commit_count;
+};
+
+struct BtsnoozRing::Slot {
+  // Number of commits when this record was committed, 0 while the slot is empty or being written
+  std::atomic<uint64_t> sequence;
+  uint8_t length;
+  uint8_t data[kMaxRecordSize];
+};
+
+BtsnoozRing::~BtsnoozRing() {
+  Close();
+}
+
+size_t BtsnoozRing::GetMappingSize(size_t slot_count) {
+  return kHeaderSize + slot_count * sizeof(Slot);
+}
+
+bool BtsnoozRing::OpenAnonymous(size_t slot_count) {
+  Close();
+  if (!Map(-1, slot_count)) {
+    return false;
+  }
+  std::memcpy(header_->magic, kRingMagic, sizeof(kRingMagic));
+  header_->version = kRingVersion;
+  header_->slot_count = slot_count;
+  header_->slot_size = sizeof(Slot);
+  return true;
+}
+
+bool BtsnoozRing::Open(const std::string& path, size_t slot_count) {
+  Close();
+  size_t mapping_size = GetMappingSize(slot_count);
+
+  mode_t prevmask = umask(0);
+  int fd;
+  RUN_NO_INTR(fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666));
+  umask(prevmask);
+  if (fd == -1) {
+    LOG_ERROR("Unable to open btsnooz ring at \"%s\", error: \"%s\"", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  struct stat file_stat;
+  bool keep = fstat(fd, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) == mapping_size;
+  if (!keep && ftruncate(fd, 0) == -1) {
+    LOG_ERROR("Unable to truncate btsnooz ring at \"%s\", error: \"%s\"", path.c_str(), strerror(errno));
+    close(fd);
+    return false;
+  }
+  // Allocate every block now: running out of space while writing through the mapping would raise SIGBUS
+  int allocate_error = posix_fallocate(fd, 0, mapping_size);
+  if (allocate_error != 0) {
+    LOG_ERROR("Unable to allocate btsnooz ring at \"%s\", error: \"%s\"", path.c_str(), strerror(allocate_error));
+    close(fd);
+    return false;
+  }
+  bool mapped = Map(fd, slot_count);
+  close(fd);
+  if (!mapped) {
+    return false;
+  }
+
+  keep = keep && std::memcmp(header_->magic, kRingMagic, sizeof(kRingMagic)) == 0 &&
+         header_->version == kRingVersion && header_->slot_count == slot_count && header_->slot_size == sizeof(Slot);
+  if (keep) {
+    LOG_INFO("Recovered %zu btsnooz records from \"%s\"", GetRecordCount(), path.c_str());
+    return true;
+  }
+
+  std::memset(mapping_, 0, mapping_size_);
+  std::memcpy(header_->magic, kRingMagic, sizeof(kRingMagic));
+  header_->version = kRingVersion;
+  header_->slot_count = slot_count;
+  header_->slot_size = sizeof(Slot);
+  return true;
+}
+
+bool BtsnoozRing::Map(int fd, size_t slot_count) {
+  static_assert(sizeof(Header) <= kHeaderSize);
+  ASSERT(slot_count > 0);
+  size_t mapping_size = GetMappingSize(slot_count);
+  int flags = fd == -1 ? (MAP_PRIVATE | MAP_ANONYMOUS) : MAP_SHARED;
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, flags, fd, 0);
+  if (mapping == MAP_FAILED) {
+    LOG_ERROR("Unable to map %zu bytes of btsnooz ring, error: \"%s\"", mapping_size, strerror(errno));
+    return false;
+  }
+  mapping_ = mapping;
+  mapping_size_ = mapping_size;
+  header_ = static_cast<Header*>(mapping);
+  slot_count_ = slot_count;
+  return true;
+}
+
+void BtsnoozRing::Close() {
+  if (mapping_ == nullptr) {
+    return;
+  }
+  munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  header_ = nullptr;
+  slot_count_ = 0;
+}
+
+BtsnoozRing::Slot* BtsnoozRing::GetSlot(uint64_t sequence) const {
+  auto* slots = reinterpret_cast<Slot*>(static_cast<uint8_t*>(mapping_) + kHeaderSize);
+  return &slots[sequence % slot_count_];
+}
+
+void BtsnoozRing::Append(const void* header, size_t header_size, const uint8_t* payload, size_t payload_size) {
+  ASSERT(IsOpen());
+  ASSERT(header_size + payload_size <= kMaxRecordSize);
+  uint64_t sequence = header_->commit_count.load(std::memory_order_relaxed);
+  Slot* slot = GetSlot(sequence);
+
+  // The kernel keeps every store executed before a crash, so only the compiler could reorder these in a way that
+  // exposes a torn record. The oldest record is invalidated before it's overwritten, and the new one is valid only
+  // once it's complete.
+  slot->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  std::memcpy(slot->data, header, header_size);
+  std::memcpy(slot->data + header_size, payload, payload_size);
+  slot->length = header_size + payload_size;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+  header_->commit_count.store(sequence + 1, std::memory_order_relaxed);
+}
+
+std::vector<uint8_t> BtsnoozRing::ReadRecords() const {
+  std::vector<uint8_t> records;
+  if (!IsOpen()) {
+    return records;
+  }
+  uint64_t commit_count = header_->commit_count.load(std::memory_order_relaxed);
+  uint64_t first = commit_count > slot_count_ ? commit_count - slot_count_ : 0;
+  records.reserve((commit_count - first) * kMaxRecordSize);
+  for (uint64_t sequence = first; sequence < commit_count; sequence++) {
+    const Slot* slot = GetSlot(sequence);
+    if (slot->sequence.load(std::memory_order_relaxed) != sequence + 1 || slot->length > kMaxRecordSize) {
+      continue;
+    }
+    records.insert(records.end(), slot->data, slot->data + slot->length);
+  }
+  return records;
+}
+
+size_t BtsnoozRing::GetRecordCount() const {
+  if (!IsOpen()) {
+    return 0;
+  }
+  uint64_t commit_count = header_->commit_count.load(std::memory_order_relaxed);
+  uint64_t first = commit_count > slot_count_ ? commit_count - slot_count_ : 0;
+  size_t count = 0;
+  for (uint64_t sequence = first; sequence < commit_count; sequence++) {
+    if (GetSlot(sequence)->sequence.load(std::memory_order_relaxed) == sequence + 1) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
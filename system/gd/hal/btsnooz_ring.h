@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// A fixed size ring of the most recent btsnooz records, each one a btsnoop packet header followed by the (truncated)
+// packet.
+//
+// The ring lives in a memory mapping, either anonymous or shared with a ring file. A ring file is written through the
+// page cache, so its content outlives a crash of the process and is found again by the next Open() of the same file.
+// Each slot keeps the sequence number of the record committed into it and the file header keeps the number of
+// commits, so a record torn by a crash is never read back.
+//
+// Not thread safe.
+class BtsnoozRing {
+ public:
+  // Largest record, packet header included
+  static constexpr size_t kMaxRecordSize = 150;
+
+  BtsnoozRing() = default;
+  BtsnoozRing(const BtsnoozRing&) = delete;
+  BtsnoozRing& operator=(const BtsnoozRing&) = delete;
+  ~BtsnoozRing();
+
+  // Map an anonymous ring of |slot_count| records
+  bool OpenAnonymous(size_t slot_count);
+
+  // Map the ring file at |path|, with room for |slot_count| records. The records of a previous session are kept when
+  // the file was created with the same geometry, otherwise the file is reset.
+  bool Open(const std::string& path, size_t slot_count);
+
+  void Close();
+
+  bool IsOpen() const {
+    return mapping_ != nullptr;
+  }
+
+  // Commit a record made of |header| followed by |payload|, overwriting the oldest record when the ring is full
+  void Append(const void* header, size_t header_size, const uint8_t* payload, size_t payload_size);
+
+  // The committed records, oldest first, back to back
+  std::vector<uint8_t> ReadRecords() const;
+
+  // Number of committed records currently held by the ring
+  size_t GetRecordCount() const;
+
+  // Size of the mapping, for a ring of |slot_count| records
+  static size_t GetMappingSize(size_t slot_count);
+
+ private:
+  struct Header;
+  struct Slot;
+
+  bool Map(int fd, size_t slot_count);
+  Slot* GetSlot(uint64_t sequence) const;
+
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  Header* header_ = nullptr;
+  size_t slot_count_ = 0;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
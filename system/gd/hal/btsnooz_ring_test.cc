@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/btsnooz_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+constexpr size_t kSlotCount = 4;
+
+// A two byte header followed by |length| bytes of |value|
+void AppendRecord(BtsnoozRing* ring, uint8_t value, size_t length) {
+  uint8_t header[2] = {0xaa, value};
+  std::vector<uint8_t> payload(length, value);
+  ring->Append(header, sizeof(header), payload.data(), payload.size());
+}
+
+std::vector<uint8_t> ExpectedRecords(const std::vector<std::pair<uint8_t, size_t>>& records) {
+  std::vector<uint8_t> bytes;
+  for (const auto& [value, length] : records) {
+    bytes.push_back(0xaa);
+    bytes.push_back(value);
+    bytes.insert(bytes.end(), length, value);
+  }
+  return bytes;
+}
+
+class BtsnoozRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ring_path_ = (std::filesystem::temp_directory_path() / "btsnooz_ring_test.ring").string();
+    std::filesystem::remove(ring_path_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(ring_path_);
+  }
+
+  std::string ring_path_;
+};
+
+TEST_F(BtsnoozRingTest, empty) {
+  BtsnoozRing ring;
+  ASSERT_FALSE(ring.IsOpen());
+  ASSERT_TRUE(ring.ReadRecords().empty());
+  ASSERT_TRUE(ring.OpenAnonymous(kSlotCount));
+  ASSERT_EQ(ring.GetRecordCount(), 0u);
+  ASSERT_TRUE(ring.ReadRecords().empty());
+}
+
+TEST_F(BtsnoozRingTest, records_are_read_oldest_first) {
+  BtsnoozRing ring;
+  ASSERT_TRUE(ring.OpenAnonymous(kSlotCount));
+  AppendRecord(&ring, 1, 3);
+  AppendRecord(&ring, 2, 0);
+  AppendRecord(&ring, 3, BtsnoozRing::kMaxRecordSize - 2);
+  ASSERT_EQ(ring.GetRecordCount(), 3u);
+  ASSERT_EQ(ring.ReadRecords(), ExpectedRecords({{1, 3}, {2, 0}, {3, BtsnoozRing::kMaxRecordSize - 2}}));
+}
+
+TEST_F(BtsnoozRingTest, oldest_records_are_overwritten) {
+  BtsnoozRing ring;
+  ASSERT_TRUE(ring.OpenAnonymous(kSlotCount));
+  for (uint8_t i = 0; i < 10; i++) {
+    AppendRecord(&ring, i, i);
+  }
+  ASSERT_EQ(ring.GetRecordCount(), kSlotCount);
+  ASSERT_EQ(ring.ReadRecords(), ExpectedRecords({{6, 6}, {7, 7}, {8, 8}, {9, 9}}));
+}
+
+TEST_F(BtsnoozRingTest, ring_file_keeps_records_across_sessions) {
+  {
+    BtsnoozRing ring;
+    ASSERT_TRUE(ring.Open(ring_path_, kSlotCount));
+    AppendRecord(&ring, 1, 1);
+    AppendRecord(&ring, 2, 2);
+    // Unmapped without any shutdown step, as when the process dies
+  }
+  ASSERT_EQ(std::filesystem::file_size(ring_path_), BtsnoozRing::GetMappingSize(kSlotCount));
+
+  BtsnoozRing ring;
+  ASSERT_TRUE(ring.Open(ring_path_, kSlotCount));
+  ASSERT_EQ(ring.GetRecordCount(), 2u);
+  AppendRecord(&ring, 3, 3);
+  ASSERT_EQ(ring.ReadRecords(), ExpectedRecords({{1, 1}, {2, 2}, {3, 3}}));
+}
+
+TEST_F(BtsnoozRingTest, ring_file_of_other_geometry_is_reset) {
+  {
+    BtsnoozRing ring;
+    ASSERT_TRUE(ring.Open(ring_path_, kSlotCount));
+    AppendRecord(&ring, 1, 1);
+  }
+
+  BtsnoozRing ring;
+  ASSERT_TRUE(ring.Open(ring_path_, 2 * kSlotCount));
+  ASSERT_EQ(ring.GetRecordCount(), 0u);
+  ASSERT_EQ(std::filesystem::file_size(ring_path_), BtsnoozRing::GetMappingSize(2 * kSlotCount));
+}
+
+TEST_F(BtsnoozRingTest, corrupted_ring_file_is_reset) {
+  {
+    BtsnoozRing ring;
+    ASSERT_TRUE(ring.Open(ring_path_, kSlotCount));
+    AppendRecord(&ring, 1, 1);
+  }
+  {
+    FILE* file = fopen(ring_path_.c_str(), "r+");
+    ASSERT_NE(file, nullptr);
+    fputs("garbage", file);
+    fclose(file);
+  }
+
+  BtsnoozRing ring;
+  ASSERT_TRUE(ring.Open(ring_path_, kSlotCount));
+  ASSERT_EQ(ring.GetRecordCount(), 0u);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
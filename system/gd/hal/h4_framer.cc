@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_framer.h"
+
+#include <algorithm>
+
+#include "hal/hci_packet_pool.h"
+
+namespace bluetooth {
+namespace hal {
+
+H4Framer::H4Framer(PacketCallback on_packet) : on_packet_(std::move(on_packet)) {}
+
+size_t H4Framer::HeaderSize(uint8_t type) {
+  switch (type) {
+    case kH4Command:
+      return 3;  // opcode, parameter total length
+    case kH4Acl:
+      return 4;  // handle and flags, data total length
+    case kH4Sco:
+      return 3;  // handle and flags, data total length
+    case kH4Event:
+      return 2;  // event code, parameter total length
+    case kH4Iso:
+      return 4;  // handle and flags, data load length
+    default:
+      return 0;
+  }
+}
+
+size_t H4Framer::payload_size() const {
+  switch (type_) {
+    case kH4Command:
+    case kH4Sco:
+      return packet_[2];
+    case kH4Acl:
+      return packet_[2] | (packet_[3] << 8);
+    case kH4Event:
+      return packet_[1];
+    case kH4Iso:
+      return packet_[2] | ((packet_[3] & 0x3f) << 8);
+    default:
+      return 0;
+  }
+}
+
+bool H4Framer::Feed(const uint8_t* data, size_t length) {
+  bool in_sync = true;
+  while (length > 0) {
+    if (!has_type_) {
+      type_ = *data;
+      expected_size_ = HeaderSize(type_);
+      if (expected_size_ == 0) {
+        // Skip it and look for a packet type in the next byte
+        in_sync = false;
+        data++;
+        length--;
+        continue;
+      }
+      has_type_ = true;
+      has_header_ = false;
+      packet_ = HciPacketPool::Get().Acquire();
+      data++;
+      length--;
+      continue;
+    }
+
+    size_t chunk = std::min(expected_size_ - packet_.size(), length);
+    packet_.insert(packet_.end(), data, data + chunk);
+    data += chunk;
+    length -= chunk;
+
+    if (!has_header_ && packet_.size() == expected_size_) {
+      has_header_ = true;
+      expected_size_ += payload_size();
+      packet_.reserve(expected_size_);
+    }
+    if (has_header_ && packet_.size() == expected_size_) {
+      has_type_ = false;
+      on_packet_(type_, std::move(packet_));
+      packet_ = HciPacket();
+    }
+  }
+  return in_sync;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "hal/hci_hal.h"
+
+namespace bluetooth {
+namespace hal {
+
+constexpr uint8_t kH4Command = 0x01;
+constexpr uint8_t kH4Acl = 0x02;
+constexpr uint8_t kH4Sco = 0x03;
+constexpr uint8_t kH4Event = 0x04;
+constexpr uint8_t kH4Iso = 0x05;
+
+// Incrementally splits an H4 byte stream (one type byte followed by an HCI packet, back to back) into HCI packets.
+//
+// Bytes can be fed in chunks of any size, so a whole socket buffer holding several packets is consumed with a single
+// read, and a packet split across reads is completed by the next one.
+class H4Framer {
+ public:
+  // |type| is the H4 packet type, |packet| the HCI packet without it
+  using PacketCallback = std::function<void(uint8_t type, HciPacket packet)>;
+
+  explicit H4Framer(PacketCallback on_packet);
+
+  H4Framer(const H4Framer&) = delete;
+  H4Framer& operator=(const H4Framer&) = delete;
+
+  // Consume |length| bytes, calling the packet callback for every packet they complete. Returns false when bytes had to
+  // be skipped because they didn't start with a known H4 type.
+  bool Feed(const uint8_t* data, size_t length);
+
+  // True when no packet is partially received
+  bool IsIdle() const {
+    return !has_type_;
+  }
+
+  // Size of the HCI header that carries the payload length for H4 packet |type|, 0 for an unknown type
+  static size_t HeaderSize(uint8_t type);
+
+ private:
+  size_t payload_size() const;
+
+  PacketCallback on_packet_;
+  bool has_type_ = false;
+  bool has_header_ = false;
+  uint8_t type_ = 0;
+  size_t expected_size_ = 0;
+  HciPacket packet_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
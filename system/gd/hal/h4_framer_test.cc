@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_framer.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+class H4FramerTest : public ::testing::Test {
+ protected:
+  std::vector<std::pair<uint8_t, HciPacket>> received_;
+  H4Framer framer_{[this](uint8_t type, HciPacket packet) { received_.emplace_back(type, std::move(packet)); }};
+};
+
+const std::vector<uint8_t> kH4Stream = {
+    kH4Event, 0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00,        // Command Complete (Reset)
+    kH4Acl,   0x01, 0x20, 0x03, 0x00, 0xaa, 0xbb, 0xcc,  // ACL, 3 bytes of data
+    kH4Sco,   0x02, 0x00, 0x02, 0x11, 0x22,              // SCO, 2 bytes of data
+    kH4Iso,   0x03, 0x00, 0x01, 0x40, 0x55,              // ISO, 1 byte of data, reserved bits set
+    kH4Event, 0x13, 0x00,                                // event without parameters
+};
+
+void ExpectStreamReceived(const std::vector<std::pair<uint8_t, HciPacket>>& received) {
+  ASSERT_EQ(received.size(), 5u);
+  EXPECT_EQ(received[0].first, kH4Event);
+  EXPECT_EQ(received[0].second, HciPacket({0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00}));
+  EXPECT_EQ(received[1].first, kH4Acl);
+  EXPECT_EQ(received[1].second, HciPacket({0x01, 0x20, 0x03, 0x00, 0xaa, 0xbb, 0xcc}));
+  EXPECT_EQ(received[2].first, kH4Sco);
+  EXPECT_EQ(received[2].second, HciPacket({0x02, 0x00, 0x02, 0x11, 0x22}));
+  EXPECT_EQ(received[3].first, kH4Iso);
+  EXPECT_EQ(received[3].second, HciPacket({0x03, 0x00, 0x01, 0x40, 0x55}));
+  EXPECT_EQ(received[4].first, kH4Event);
+  EXPECT_EQ(received[4].second, HciPacket({0x13, 0x00}));
+}
+
+TEST_F(H4FramerTest, several_packets_in_one_chunk) {
+  ASSERT_TRUE(framer_.Feed(kH4Stream.data(), kH4Stream.size()));
+  ExpectStreamReceived(received_);
+  EXPECT_TRUE(framer_.IsIdle());
+}
+
+TEST_F(H4FramerTest, one_byte_at_a_time) {
+  for (uint8_t byte : kH4Stream) {
+    ASSERT_TRUE(framer_.Feed(&byte, 1));
+  }
+  ExpectStreamReceived(received_);
+  EXPECT_TRUE(framer_.IsIdle());
+}
+
+TEST_F(H4FramerTest, packet_split_across_chunks) {
+  size_t split = 10;  // in the middle of the ACL data
+  ASSERT_TRUE(framer_.Feed(kH4Stream.data(), split));
+  EXPECT_EQ(received_.size(), 1u);
+  EXPECT_FALSE(framer_.IsIdle());
+  ASSERT_TRUE(framer_.Feed(kH4Stream.data() + split, kH4Stream.size() - split));
+  ExpectStreamReceived(received_);
+}
+
+TEST_F(H4FramerTest, long_acl_packet) {
+  std::vector<uint8_t> stream = {kH4Acl, 0x01, 0x20, 0x00, 0x04};  // 1024 bytes of data
+  stream.resize(stream.size() + 1024, 0x5a);
+  ASSERT_TRUE(framer_.Feed(stream.data(), stream.size()));
+  ASSERT_EQ(received_.size(), 1u);
+  EXPECT_EQ(received_[0].second.size(), 4u + 1024u);
+}
+
+TEST_F(H4FramerTest, unknown_type_is_skipped) {
+  std::vector<uint8_t> stream = {0x7f, 0x00};
+  EXPECT_FALSE(framer_.Feed(stream.data(), stream.size()));
+  EXPECT_TRUE(received_.empty());
+  EXPECT_TRUE(framer_.IsIdle());
+
+  // Framing goes on with the next known packet type
+  ASSERT_TRUE(framer_.Feed(kH4Stream.data(), kH4Stream.size()));
+  ExpectStreamReceived(received_);
+}
+
+TEST_F(H4FramerTest, packets_around_unknown_bytes_are_framed) {
+  std::vector<uint8_t> stream = {0x7f, 0x00};
+  stream.insert(stream.end(), kH4Stream.begin(), kH4Stream.end());
+  EXPECT_FALSE(framer_.Feed(stream.data(), stream.size()));
+  ExpectStreamReceived(received_);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -21,14 +21,20 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <csignal>
+#include <deque>
 #include <mutex>
-#include <queue>
 
+#include "hal/h4_framer.h"
 #include "hal/hci_hal.h"
+#include "hal/hci_hal_host_stats.h"
+#include "hal/hci_packet_pool.h"
 #include "hal/snoop_logger.h"
 #include "metrics/counter_metrics.h"
 #include "os/log.h"
@@ -38,18 +44,19 @@
 namespace {
 constexpr int INVALID_FD = -1;
 
-constexpr uint8_t kH4Command = 0x01;
-constexpr uint8_t kH4Acl = 0x02;
-constexpr uint8_t kH4Sco = 0x03;
-constexpr uint8_t kH4Event = 0x04;
-constexpr uint8_t kH4Iso = 0x05;
-
 constexpr uint8_t kH4HeaderSize = 1;
 constexpr uint8_t kHciAclHeaderSize = 4;
 constexpr uint8_t kHciScoHeaderSize = 3;
 constexpr uint8_t kHciEvtHeaderSize = 2;
 constexpr uint8_t kHciIsoHeaderSize = 4;
 constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
+// The user channel socket carries one H4 packet per datagram. Pending packets are sent in batches of one sendmmsg(),
+// and queued packets are read with one recvmmsg(), up to these bounds. Outgoing batches are sent back to back for at
+// most kMaxWriteTime, so a burst of outgoing data doesn't hold back the packets read on the same thread.
+constexpr int kMaxPacketsPerWrite = 64;
+constexpr size_t kMaxBytesPerWrite = 16 * 1024;
+constexpr std::chrono::microseconds kMaxWriteTime = std::chrono::microseconds(500);
+constexpr int kMaxPacketsPerRead = 16;
 
 constexpr uint8_t BTPROTO_HCI = 1;
 constexpr uint16_t HCI_CHANNEL_USER = 1;
@@ -228,37 +235,29 @@ class HciHalHost : public HciHal {
   void sendHciCommand(HciPacket command) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(command);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    packet.insert(packet.cbegin(), kH4Command);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(command, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+    write_to_fd(kH4Command, std::move(command));
   }
 
   void sendAclData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
-    packet.insert(packet.cbegin(), kH4Acl);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    write_to_fd(kH4Acl, std::move(data));
   }
 
   void sendScoData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    packet.insert(packet.cbegin(), kH4Sco);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
+    write_to_fd(kH4Sco, std::move(data));
   }
 
   void sendIsoData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
-    packet.insert(packet.cbegin(), kH4Iso);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
+    write_to_fd(kH4Iso, std::move(data));
   }
 
  protected:
@@ -303,6 +302,13 @@ class HciHalHost : public HciHal {
     return std::string("HciHalHost");
   }
 
+  DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const override {
+    auto dumpsys_data = stats_.GetDumpsysData(builder, ToString());
+    return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+      dumpsys_builder->add_hci_hal_host_dumpsys_data(dumpsys_data);
+    };
+  }
+
  private:
   // Held when APIs are called, NOT to be held during callbacks
   std::mutex api_mutex_;
@@ -312,12 +318,23 @@ class HciHalHost : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  // The H4 packet type is written from |type|, so packets don't have to be shifted to make room for it
+  struct OutgoingPacket {
+    uint8_t type;
+    HciPacket packet;
+  };
+  std::deque<OutgoingPacket> hci_outgoing_queue_;
   SnoopLogger* btsnoop_logger_ = nullptr;
+  HciHalHostStats stats_;
+  // Only used on |hci_incoming_thread_|. recvmmsg() reads straight into these pooled packets, a received packet is
+  // handed up as is and its slot refilled from the pool.
+  std::array<uint8_t, kMaxPacketsPerRead> rx_h4_types_;
+  std::array<HciPacket, kMaxPacketsPerRead> rx_packets_;
 
-  void write_to_fd(HciPacket packet) {
+  void write_to_fd(uint8_t type, HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    HciPacketPool::Get().CountPacket();
+    hci_outgoing_queue_.push_back(OutgoingPacket{type, std::move(packet)});
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(
           reactable_,
@@ -326,14 +343,18 @@ class HciHalHost : public HciHal {
     }
   }
 
+  // Send the pending packets, one batch per sendmmsg(), until the queue is empty, the socket is full or
+  // kMaxWriteTime has passed
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(this->api_mutex_);
-    auto packet_to_send = this->hci_outgoing_queue_.front();
-    auto bytes_written = write(this->sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    this->hci_outgoing_queue_.pop();
-    if (bytes_written == -1) {
-      abort();
+    auto start = std::chrono::steady_clock::now();
+    // The reactor only calls us when the socket is writable, the batches after the first one must not block
+    int flags = 0;
+    while (!hci_outgoing_queue_.empty() && send_batch(flags) &&
+           std::chrono::steady_clock::now() - start < kMaxWriteTime) {
+      flags = MSG_DONTWAIT;
     }
+
     if (hci_outgoing_queue_.empty()) {
       this->hci_incoming_thread_.GetReactor()->ModifyRegistration(
           this->reactable_,
@@ -342,6 +363,44 @@ class HciHalHost : public HciHal {
     }
   }
 
+  // Send as many of the pending packets as fit in one batch with a single sendmmsg(). Returns false when the socket
+  // didn't take the whole batch.
+  bool send_batch(int flags) {
+    struct iovec iov[kMaxPacketsPerWrite][2];
+    struct mmsghdr messages[kMaxPacketsPerWrite] = {};
+    int message_count = 0;
+    size_t batch_bytes = 0;
+    for (auto& outgoing : hci_outgoing_queue_) {
+      if (message_count == kMaxPacketsPerWrite || (message_count > 0 && batch_bytes >= kMaxBytesPerWrite)) {
+        break;
+      }
+      iov[message_count][0] = {.iov_base = &outgoing.type, .iov_len = kH4HeaderSize};
+      iov[message_count][1] = {.iov_base = outgoing.packet.data(), .iov_len = outgoing.packet.size()};
+      messages[message_count].msg_hdr.msg_iov = iov[message_count];
+      messages[message_count].msg_hdr.msg_iovlen = 2;
+      batch_bytes += kH4HeaderSize + outgoing.packet.size();
+      message_count++;
+    }
+
+    int sent;
+    RUN_NO_INTR(sent = sendmmsg(this->sock_fd_, messages, message_count, flags));
+    if (sent == -1) {
+      if ((flags & MSG_DONTWAIT) && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return false;
+      }
+      abort();
+    }
+    size_t bytes_written = 0;
+    for (int i = 0; i < sent; i++) {
+      bytes_written += messages[i].msg_len;
+      HciPacketPool::Get().Release(std::move(hci_outgoing_queue_.front().packet));
+      hci_outgoing_queue_.pop_front();
+    }
+    stats_.CountTxSyscall(sent, bytes_written);
+    return sent == message_count;
+  }
+
+  // Read every queued datagram, up to kMaxPacketsPerRead, with a single recvmmsg()
   void incoming_packet_received() {
     {
       std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -350,21 +409,59 @@ class HciHalHost : public HciHal {
         return;
       }
     }
-    uint8_t buf[kBufSize] = {};
-
-    ssize_t received_size;
-    RUN_NO_INTR(received_size = read(sock_fd_, buf, kBufSize));
-    ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-    if (received_size == 0) {
-      LOG_WARN("Can't read H4 header. EOF received");
-      raise(SIGINT);
+    struct iovec iov[kMaxPacketsPerRead][2];
+    struct mmsghdr messages[kMaxPacketsPerRead] = {};
+    for (int i = 0; i < kMaxPacketsPerRead; i++) {
+      if (rx_packets_[i].size() != kBufSize - kH4HeaderSize) {
+        // Handed up by the previous read
+        rx_packets_[i] = HciPacketPool::Get().Acquire();
+        rx_packets_[i].resize(kBufSize - kH4HeaderSize);
+      }
+      iov[i][0] = {.iov_base = &rx_h4_types_[i], .iov_len = kH4HeaderSize};
+      iov[i][1] = {.iov_base = rx_packets_[i].data(), .iov_len = rx_packets_[i].size()};
+      messages[i].msg_hdr.msg_iov = iov[i];
+      messages[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    // The reactor only calls us when the first datagram is there, the others are taken if already queued
+    int received;
+    RUN_NO_INTR(received = recvmmsg(sock_fd_, messages, kMaxPacketsPerRead, MSG_DONTWAIT, nullptr));
+    ASSERT_LOG(received != -1 || errno == EAGAIN, "Can't receive from socket: %s", strerror(errno));
+    received = std::max(received, 0);
+    if (received == 0 || messages[0].msg_len == 0) {
+      if (received != 0) {
+        LOG_WARN("Can't read H4 header. EOF received");
+        raise(SIGINT);
+      }
       return;
     }
 
-    if (buf[0] == kH4Event) {
+    size_t bytes_received = 0;
+    for (int i = 0; i < received; i++) {
+      bytes_received += messages[i].msg_len;
+    }
+    stats_.CountRxSyscall(bytes_received);
+    stats_.CountRxBatch(received);
+    for (int i = 0; i < received; i++) {
+      size_t received_size = messages[i].msg_len;
+      if (received_size < kH4HeaderSize) {
+        LOG_WARN("Skipping an empty datagram");
+        continue;
+      }
+      stats_.CountRxPacket();
+      HciPacket packet = std::move(rx_packets_[i]);
+      packet.resize(received_size - kH4HeaderSize);
+      on_packet_received(rx_h4_types_[i], std::move(packet), received_size);
+    }
+  }
+
+  void on_packet_received(uint8_t h4_type, HciPacket receivedHciPacket, size_t received_size) {
+    HciPacketPool::Get().CountPacket();
+
+    if (h4_type == kH4Event) {
       ASSERT_LOG(
           received_size >= kH4HeaderSize + kHciEvtHeaderSize, "Received bad HCI_EVT packet size: %zu", received_size);
-      uint8_t hci_evt_parameter_total_length = buf[2];
+      uint8_t hci_evt_parameter_total_length = receivedHciPacket[1];
       ssize_t payload_size = received_size - (kH4HeaderSize + kHciEvtHeaderSize);
       ASSERT_LOG(
           payload_size == hci_evt_parameter_total_length,
@@ -372,8 +469,6 @@ class HciHalHost : public HciHal {
           payload_size,
           hci_evt_parameter_total_length);
 
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + payload_size);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -381,15 +476,15 @@ class HciHalHost : public HciHal {
           LOG_INFO("Dropping an event after processing");
           return;
         }
-        incoming_packet_callback_->hciEventReceived(receivedHciPacket);
+        incoming_packet_callback_->hciEventReceived(std::move(receivedHciPacket));
       }
     }
 
-    if (buf[0] == kH4Acl) {
+    if (h4_type == kH4Acl) {
       ASSERT_LOG(
           received_size >= kH4HeaderSize + kHciAclHeaderSize, "Received bad HCI_ACL packet size: %zu", received_size);
       int payload_size = received_size - (kH4HeaderSize + kHciAclHeaderSize);
-      uint16_t hci_acl_data_total_length = (buf[4] << 8) + buf[3];
+      uint16_t hci_acl_data_total_length = (receivedHciPacket[3] << 8) + receivedHciPacket[2];
       ASSERT_LOG(
           payload_size == hci_acl_data_total_length,
           "malformed ACL length received: %d != %d",
@@ -397,8 +492,6 @@ class HciHalHost : public HciHal {
           hci_acl_data_total_length);
       ASSERT_LOG(hci_acl_data_total_length <= kBufSize - kH4HeaderSize - kHciAclHeaderSize, "packet too long");
 
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciAclHeaderSize + payload_size);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -406,23 +499,21 @@ class HciHalHost : public HciHal {
           LOG_INFO("Dropping an ACL packet after processing");
           return;
         }
-        incoming_packet_callback_->aclDataReceived(receivedHciPacket);
+        incoming_packet_callback_->aclDataReceived(std::move(receivedHciPacket));
       }
     }
 
-    if (buf[0] == kH4Sco) {
+    if (h4_type == kH4Sco) {
       ASSERT_LOG(
           received_size >= kH4HeaderSize + kHciScoHeaderSize, "Received bad HCI_SCO packet size: %zu", received_size);
       int payload_size = received_size - (kH4HeaderSize + kHciScoHeaderSize);
-      uint8_t hci_sco_data_total_length = buf[3];
+      uint8_t hci_sco_data_total_length = receivedHciPacket[2];
       ASSERT_LOG(
           payload_size == hci_sco_data_total_length,
           "malformed SCO length received: %d != %d",
           payload_size,
           hci_sco_data_total_length);
 
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciScoHeaderSize + payload_size);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -430,23 +521,21 @@ class HciHalHost : public HciHal {
           LOG_INFO("Dropping a SCO packet after processing");
           return;
         }
-        incoming_packet_callback_->scoDataReceived(receivedHciPacket);
+        incoming_packet_callback_->scoDataReceived(std::move(receivedHciPacket));
       }
     }
 
-    if (buf[0] == kH4Iso) {
+    if (h4_type == kH4Iso) {
       ASSERT_LOG(
           received_size >= kH4HeaderSize + kHciIsoHeaderSize, "Received bad HCI_ISO packet size: %zu", received_size);
       int payload_size = received_size - (kH4HeaderSize + kHciIsoHeaderSize);
-      uint16_t hci_iso_data_total_length = ((buf[4] & 0x3f) << 8) + buf[3];
+      uint16_t hci_iso_data_total_length = ((receivedHciPacket[3] & 0x3f) << 8) + receivedHciPacket[2];
       ASSERT_LOG(
           payload_size == hci_iso_data_total_length,
           "malformed ISO length received: %d != %d",
           payload_size,
           hci_iso_data_total_length);
 
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciIsoHeaderSize + payload_size);
       btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ISO);
       {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -454,10 +543,9 @@ class HciHalHost : public HciHal {
           LOG_INFO("Dropping a ISO packet after processing");
           return;
         }
-        incoming_packet_callback_->isoDataReceived(receivedHciPacket);
+        incoming_packet_callback_->isoDataReceived(std::move(receivedHciPacket));
       }
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
@@ -21,14 +21,19 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <array>
 #include <chrono>
 #include <csignal>
+#include <deque>
 #include <mutex>
-#include <queue>
 
+#include "hal/h4_framer.h"
 #include "hal/hci_hal.h"
+#include "hal/hci_hal_host_stats.h"
+#include "hal/hci_packet_pool.h"
 #include "hal/snoop_logger.h"
 #include "metrics/counter_metrics.h"
 #include "os/log.h"
@@ -38,18 +43,12 @@
 namespace {
 constexpr int INVALID_FD = -1;
 
-constexpr uint8_t kH4Command = 0x01;
-constexpr uint8_t kH4Acl = 0x02;
-constexpr uint8_t kH4Sco = 0x03;
-constexpr uint8_t kH4Event = 0x04;
-constexpr uint8_t kH4Iso = 0x05;
-
 constexpr uint8_t kH4HeaderSize = 1;
-constexpr uint8_t kHciAclHeaderSize = 4;
-constexpr uint8_t kHciScoHeaderSize = 3;
-constexpr uint8_t kHciEvtHeaderSize = 2;
-constexpr uint8_t kHciIsoHeaderSize = 4;
-constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
+// A read takes whatever the socket holds up to this size, usually several packets
+constexpr size_t kRxBufferSize = 16 * 1024;
+// Bounds of a single writev() of pending packets
+constexpr int kMaxPacketsPerWrite = 64;
+constexpr size_t kMaxBytesPerWrite = 16 * 1024;
 
 int ConnectToSocket() {
   auto* config = bluetooth::hal::HciHalHostRootcanalConfig::Get();
@@ -123,37 +122,29 @@ class HciHalHost : public HciHal {
   void sendHciCommand(HciPacket command) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(command);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    packet.insert(packet.cbegin(), kH4Command);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(command, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+    write_to_fd(kH4Command, std::move(command));
   }
 
   void sendAclData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
-    packet.insert(packet.cbegin(), kH4Acl);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    write_to_fd(kH4Acl, std::move(data));
   }
 
   void sendScoData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    packet.insert(packet.cbegin(), kH4Sco);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
+    write_to_fd(kH4Sco, std::move(data));
   }
 
   void sendIsoData(HciPacket data) override {
     std::lock_guard<std::mutex> lock(api_mutex_);
     ASSERT(sock_fd_ != INVALID_FD);
-    std::vector<uint8_t> packet = std::move(data);
-    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
-    packet.insert(packet.cbegin(), kH4Iso);
-    write_to_fd(packet);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
+    write_to_fd(kH4Iso, std::move(data));
   }
 
  protected:
@@ -198,6 +189,13 @@ class HciHalHost : public HciHal {
     return std::string("HciHalHost");
   }
 
+  DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const override {
+    auto dumpsys_data = stats_.GetDumpsysData(builder, ToString());
+    return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+      dumpsys_builder->add_hci_hal_host_dumpsys_data(dumpsys_data);
+    };
+  }
+
  private:
   // Held when APIs are called, NOT to be held during callbacks
   std::mutex api_mutex_;
@@ -207,12 +205,26 @@ class HciHalHost : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  // Packets waiting for the socket to be writable. The H4 packet type is written from |type|, so packets don't have
+  // to be shifted to make room for it.
+  struct OutgoingPacket {
+    uint8_t type;
+    HciPacket packet;
+  };
+  std::deque<OutgoingPacket> hci_outgoing_queue_;
+  // Bytes of the H4 packet at the front of |hci_outgoing_queue_| already written by a short write
+  size_t front_packet_bytes_written_ = 0;
   SnoopLogger* btsnoop_logger_ = nullptr;
+  HciHalHostStats stats_;
+  // Only used on |hci_incoming_thread_|
+  H4Framer h4_framer_{[this](uint8_t type, HciPacket packet) { on_packet_received(type, std::move(packet)); }};
+  std::array<uint8_t, kRxBufferSize> rx_buffer_;
+  size_t rx_packets_in_read_ = 0;
 
-  void write_to_fd(HciPacket packet) {
+  void write_to_fd(uint8_t type, HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    HciPacketPool::Get().CountPacket();
+    hci_outgoing_queue_.push_back(OutgoingPacket{type, std::move(packet)});
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(
           reactable_,
@@ -221,14 +233,52 @@ class HciHalHost : public HciHal {
     }
   }
 
+  // Write as many of the pending packets as fit in one batch with a single writev()
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(this->api_mutex_);
-    auto packet_to_send = this->hci_outgoing_queue_.front();
-    auto bytes_written = write(this->sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    this->hci_outgoing_queue_.pop();
+    struct iovec iov[2 * kMaxPacketsPerWrite];
+    int iov_count = 0;
+    size_t batch_bytes = 0;
+    size_t skip = front_packet_bytes_written_;
+    for (auto& outgoing : hci_outgoing_queue_) {
+      // A packet takes up to two entries, and a partially written one only one, so iov_count can be odd
+      if (iov_count + 2 > 2 * kMaxPacketsPerWrite || (iov_count > 0 && batch_bytes >= kMaxBytesPerWrite)) {
+        break;
+      }
+      if (skip == 0) {
+        iov[iov_count++] = {.iov_base = &outgoing.type, .iov_len = kH4HeaderSize};
+        batch_bytes += kH4HeaderSize;
+      }
+      size_t data_offset = skip == 0 ? 0 : skip - kH4HeaderSize;
+      iov[iov_count++] = {
+          .iov_base = outgoing.packet.data() + data_offset, .iov_len = outgoing.packet.size() - data_offset};
+      batch_bytes += outgoing.packet.size() - data_offset;
+      skip = 0;
+    }
+
+    ssize_t bytes_written;
+    RUN_NO_INTR(bytes_written = writev(this->sock_fd_, iov, iov_count));
     if (bytes_written == -1) {
       abort();
     }
+
+    // Drop the packets that went out completely, and remember how much of a partially written one did
+    size_t remaining = bytes_written;
+    size_t packets_written = 0;
+    while (!hci_outgoing_queue_.empty()) {
+      size_t packet_bytes = kH4HeaderSize + hci_outgoing_queue_.front().packet.size() - front_packet_bytes_written_;
+      if (remaining < packet_bytes) {
+        front_packet_bytes_written_ += remaining;
+        break;
+      }
+      remaining -= packet_bytes;
+      front_packet_bytes_written_ = 0;
+      HciPacketPool::Get().Release(std::move(hci_outgoing_queue_.front().packet));
+      hci_outgoing_queue_.pop_front();
+      packets_written++;
+    }
+    stats_.CountTxSyscall(packets_written, bytes_written);
+
     if (hci_outgoing_queue_.empty()) {
       this->hci_incoming_thread_.GetReactor()->ModifyRegistration(
           this->reactable_,
@@ -237,20 +287,7 @@ class HciHalHost : public HciHal {
     }
   }
 
-  bool socketRecvAll(void* buffer, int bufferLen) {
-    auto buf = static_cast<char*>(buffer);
-    while (bufferLen > 0) {
-      ssize_t ret;
-      RUN_NO_INTR(ret = recv(sock_fd_, buf, bufferLen, 0));
-      if (ret <= 0) {
-        return false;
-      }
-      buf += ret;
-      bufferLen -= ret;
-    }
-    return true;
-  }
-
+  // Read whatever the socket holds, possibly several packets, and let the framer split it
   void incoming_packet_received() {
     {
       std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -259,113 +296,70 @@ class HciHalHost : public HciHal {
         return;
       }
     }
-    uint8_t buf[kBufSize] = {};
 
     ssize_t received_size;
-    RUN_NO_INTR(received_size = recv(sock_fd_, buf, kH4HeaderSize, 0));
+    RUN_NO_INTR(received_size = recv(sock_fd_, rx_buffer_.data(), rx_buffer_.size(), 0));
     ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
     if (received_size == 0) {
       LOG_WARN("Can't read H4 header. EOF received");
       raise(SIGINT);
       return;
     }
+    stats_.CountRxSyscall(received_size);
+    // Framing copies each packet out of the socket buffer into its own
+    HciPacketPool::Get().CountCopy(received_size);
 
-    if (buf[0] == kH4Event) {
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize, kHciEvtHeaderSize), "Can't receive from socket: %s", strerror(errno));
-
-      uint8_t hci_evt_parameter_total_length = buf[2];
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize + kHciEvtHeaderSize, hci_evt_parameter_total_length),
-          "Can't receive from socket: %s",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + hci_evt_parameter_total_length);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping an event after processing");
-          return;
-        }
-        incoming_packet_callback_->hciEventReceived(receivedHciPacket);
-      }
+    rx_packets_in_read_ = 0;
+    if (!h4_framer_.Feed(rx_buffer_.data(), received_size)) {
+      LOG_WARN("Dropped bytes without a known H4 packet type");
     }
+    stats_.CountRxBatch(rx_packets_in_read_);
+  }
 
-    if (buf[0] == kH4Acl) {
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize, kHciAclHeaderSize), "Can't receive from socket: %s", strerror(errno));
-
-      uint16_t hci_acl_data_total_length = (buf[4] << 8) + buf[3];
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize + kHciAclHeaderSize, hci_acl_data_total_length),
-          "Can't receive from socket: %s",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciAclHeaderSize + hci_acl_data_total_length);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping an ACL packet after processing");
-          return;
-        }
-        incoming_packet_callback_->aclDataReceived(receivedHciPacket);
-      }
+  void on_packet_received(uint8_t type, HciPacket packet) {
+    rx_packets_in_read_++;
+    stats_.CountRxPacket();
+    HciPacketPool::Get().CountPacket();
+
+    SnoopLogger::PacketType snoop_type;
+    switch (type) {
+      case kH4Event:
+        snoop_type = SnoopLogger::PacketType::EVT;
+        break;
+      case kH4Acl:
+        snoop_type = SnoopLogger::PacketType::ACL;
+        break;
+      case kH4Sco:
+        snoop_type = SnoopLogger::PacketType::SCO;
+        break;
+      case kH4Iso:
+        snoop_type = SnoopLogger::PacketType::ISO;
+        break;
+      default:
+        LOG_WARN("Dropping an incoming packet of H4 type %hhu", type);
+        return;
     }
+    btsnoop_logger_->Capture(packet, SnoopLogger::Direction::INCOMING, snoop_type);
 
-    if (buf[0] == kH4Sco) {
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize, kHciScoHeaderSize), "Can't receive from socket: %s", strerror(errno));
-
-      uint8_t hci_sco_data_total_length = buf[3];
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize + kHciScoHeaderSize, hci_sco_data_total_length),
-          "Can't receive from socket: %s",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciScoHeaderSize + hci_sco_data_total_length);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping a SCO packet after processing");
-          return;
-        }
-        incoming_packet_callback_->scoDataReceived(receivedHciPacket);
-      }
+    std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
+    if (incoming_packet_callback_ == nullptr) {
+      LOG_INFO("Dropping a packet after processing");
+      return;
     }
-
-    if (buf[0] == kH4Iso) {
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize, kHciIsoHeaderSize), "Can't receive from socket: %s", strerror(errno));
-
-      uint16_t hci_iso_data_total_length = ((buf[4] & 0x3f) << 8) + buf[3];
-      ASSERT_LOG(
-          socketRecvAll(buf + kH4HeaderSize + kHciIsoHeaderSize, hci_iso_data_total_length),
-          "Can't receive from socket: %s",
-          strerror(errno));
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(
-          buf + kH4HeaderSize, buf + kH4HeaderSize + kHciIsoHeaderSize + hci_iso_data_total_length);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ISO);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping a ISO packet after processing");
-          return;
-        }
-        incoming_packet_callback_->isoDataReceived(receivedHciPacket);
-      }
+    switch (type) {
+      case kH4Event:
+        incoming_packet_callback_->hciEventReceived(std::move(packet));
+        break;
+      case kH4Acl:
+        incoming_packet_callback_->aclDataReceived(std::move(packet));
+        break;
+      case kH4Sco:
+        incoming_packet_callback_->scoDataReceived(std::move(packet));
+        break;
+      case kH4Iso:
+        incoming_packet_callback_->isoDataReceived(std::move(packet));
+        break;
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_hal_host_stats.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+
+void update_max(std::atomic<uint64_t>* max, uint64_t value) {
+  uint64_t current = max->load(std::memory_order_relaxed);
+  while (value > current && !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+float ratio(uint64_t numerator, uint64_t denominator) {
+  return denominator == 0 ? 0.0f : static_cast<float>(numerator) / static_cast<float>(denominator);
+}
+
+}  // namespace
+
+void HciHalHostStats::CountTxSyscall(size_t packets, size_t bytes) {
+  tx_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  tx_packets_.fetch_add(packets, std::memory_order_relaxed);
+  tx_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  update_max(&max_tx_packets_per_syscall_, packets);
+}
+
+void HciHalHostStats::CountRxSyscall(size_t bytes) {
+  rx_syscalls_.fetch_add(1, std::memory_order_relaxed);
+  rx_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void HciHalHostStats::CountRxPacket() {
+  rx_packets_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HciHalHostStats::CountRxBatch(size_t packets) {
+  update_max(&max_rx_packets_per_syscall_, packets);
+}
+
+flatbuffers::Offset<HciHalHostData> HciHalHostStats::GetDumpsysData(
+    flatbuffers::FlatBufferBuilder* builder, const std::string& title) const {
+  auto title_offset = builder->CreateString(title);
+  uint64_t tx_packets = tx_packets_.load(std::memory_order_relaxed);
+  uint64_t tx_syscalls = tx_syscalls_.load(std::memory_order_relaxed);
+  uint64_t rx_packets = rx_packets_.load(std::memory_order_relaxed);
+  uint64_t rx_syscalls = rx_syscalls_.load(std::memory_order_relaxed);
+
+  HciHalHostDataBuilder data_builder(*builder);
+  data_builder.add_title(title_offset);
+  data_builder.add_tx_packets(tx_packets);
+  data_builder.add_tx_bytes(tx_bytes_.load(std::memory_order_relaxed));
+  data_builder.add_tx_syscalls(tx_syscalls);
+  data_builder.add_tx_syscalls_per_packet(ratio(tx_syscalls, tx_packets));
+  data_builder.add_max_tx_packets_per_syscall(max_tx_packets_per_syscall_.load(std::memory_order_relaxed));
+  data_builder.add_rx_packets(rx_packets);
+  data_builder.add_rx_bytes(rx_bytes_.load(std::memory_order_relaxed));
+  data_builder.add_rx_syscalls(rx_syscalls);
+  data_builder.add_rx_syscalls_per_packet(ratio(rx_syscalls, rx_packets));
+  data_builder.add_max_rx_packets_per_syscall(max_rx_packets_per_syscall_.load(std::memory_order_relaxed));
+  return data_builder.Finish();
+}
+
+}  // namespace hal
+}  // namespace bluetooth
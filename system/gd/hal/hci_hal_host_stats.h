@@ -0,0 +1,60 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <flatbuffers/flatbuffers.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "hci_hal_host_generated.h"
+
+namespace bluetooth {
+namespace hal {
+
+// Counts the socket syscalls of the host HALs against the packets they carry
+class HciHalHostStats {
+ public:
+  // One write syscall carried |packets| packets in |bytes| bytes
+  void CountTxSyscall(size_t packets, size_t bytes);
+
+  // One read syscall returned |bytes| bytes
+  void CountRxSyscall(size_t bytes);
+
+  // One packet was framed from the bytes read so far
+  void CountRxPacket();
+
+  // Called after the packets read by a syscall were dispatched. |packets| is how many it carried.
+  void CountRxBatch(size_t packets);
+
+  flatbuffers::Offset<HciHalHostData> GetDumpsysData(
+      flatbuffers::FlatBufferBuilder* builder, const std::string& title) const;
+
+ private:
+  std::atomic<uint64_t> tx_packets_{0};
+  std::atomic<uint64_t> tx_bytes_{0};
+  std::atomic<uint64_t> tx_syscalls_{0};
+  std::atomic<uint64_t> max_tx_packets_per_syscall_{0};
+  std::atomic<uint64_t> rx_packets_{0};
+  std::atomic<uint64_t> rx_bytes_{0};
+  std::atomic<uint64_t> rx_syscalls_{0};
+  std::atomic<uint64_t> max_rx_packets_per_syscall_{0};
+};
+
+}  // namespace hal
+}  // namespace bluetooth
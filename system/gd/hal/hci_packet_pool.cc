@@ -0,0 +1,82 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_packet_pool.h"
+
+#include <algorithm>
+
+namespace bluetooth {
+namespace hal {
+
+HciPacketPool& HciPacketPool::Get() {
+  static HciPacketPool* instance = new HciPacketPool();
+  return *instance;
+}
+
+HciPacket HciPacketPool::Acquire(size_t capacity) {
+  HciPacket packet;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_list_.empty()) {
+      packet = std::move(free_list_.back());
+      free_list_.pop_back();
+    }
+  }
+  if (packet.capacity() >= capacity) {
+    reuses_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    packet.reserve(std::max(capacity, kDefaultCapacity));
+  }
+  return packet;
+}
+
+void HciPacketPool::Release(HciPacket packet) {
+  if (packet.capacity() < kDefaultCapacity) {
+    // Not worth keeping, e.g. a packet built by a serializer
+    return;
+  }
+  packet.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_list_.size() < kMaxPooledPackets) {
+    free_list_.push_back(std::move(packet));
+  }
+}
+
+std::shared_ptr<std::vector<uint8_t>> HciPacketPool::Share(HciPacket packet) {
+  return std::shared_ptr<std::vector<uint8_t>>(new HciPacket(std::move(packet)), [this](HciPacket* shared) {
+    Release(std::move(*shared));
+    delete shared;
+  });
+}
+
+HciPacketPool::Stats HciPacketPool::GetStats() const {
+  size_t pooled;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pooled = free_list_.size();
+  }
+  return Stats{
+      .packets = packets_.load(std::memory_order_relaxed),
+      .bytes_copied = bytes_copied_.load(std::memory_order_relaxed),
+      .allocations = allocations_.load(std::memory_order_relaxed),
+      .reuses = reuses_.load(std::memory_order_relaxed),
+      .pooled = pooled,
+  };
+}
+
+}  // namespace hal
+}  // namespace bluetooth
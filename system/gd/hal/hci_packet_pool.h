@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "hal/hci_hal.h"
+
+namespace bluetooth {
+namespace hal {
+
+// Recycles the storage of HciPackets on the data path, and counts the bytes that are still copied on the way.
+//
+// A packet read by the HAL is acquired from the pool, moved through HciHalCallbacks, and shared by every PacketView
+// created from it in the stack. When the last view is gone its storage goes back to the pool instead of being freed.
+class HciPacketPool {
+ public:
+  // Pooled buffers are at least this large: an H4 ACL packet of the largest size we read from the controller
+  static constexpr size_t kDefaultCapacity = 1024 + 4 + 1;
+  // Storage beyond this many idle buffers is freed
+  static constexpr size_t kMaxPooledPackets = 64;
+
+  struct Stats {
+    uint64_t packets;
+    uint64_t bytes_copied;
+    uint64_t allocations;
+    uint64_t reuses;
+    size_t pooled;
+  };
+
+  // The process wide pool. It is never destroyed, so shared buffers can outlive any module.
+  static HciPacketPool& Get();
+
+  HciPacketPool() = default;
+  HciPacketPool(const HciPacketPool&) = delete;
+  HciPacketPool& operator=(const HciPacketPool&) = delete;
+
+  // Return an empty packet with room for at least |capacity| bytes, reusing pooled storage when possible
+  HciPacket Acquire(size_t capacity = kDefaultCapacity);
+
+  // Give the storage of |packet| back to the pool
+  void Release(HciPacket packet);
+
+  // Wrap |packet| without copying it. Its storage returns to the pool when the last reference is dropped.
+  std::shared_ptr<std::vector<uint8_t>> Share(HciPacket packet);
+
+  // Account for one packet crossing the HAL, in either direction
+  void CountPacket() {
+    packets_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Account for |bytes| copied from one buffer into another on the way between the HAL and the stack
+  void CountCopy(size_t bytes) {
+    bytes_copied_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  Stats GetStats() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<HciPacket> free_list_;
+  std::atomic<uint64_t> packets_{0};
+  std::atomic<uint64_t> bytes_copied_{0};
+  std::atomic<uint64_t> allocations_{0};
+  std::atomic<uint64_t> reuses_{0};
+};
+
+}  // namespace hal
+}  // namespace bluetooth
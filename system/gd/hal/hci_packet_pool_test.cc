@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_packet_pool.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+TEST(HciPacketPoolTest, acquire_reuses_released_storage) {
+  HciPacketPool pool;
+  HciPacket packet = pool.Acquire();
+  EXPECT_TRUE(packet.empty());
+  EXPECT_GE(packet.capacity(), HciPacketPool::kDefaultCapacity);
+  packet.assign({0x01, 0x02, 0x03});
+  const uint8_t* storage = packet.data();
+  pool.Release(std::move(packet));
+  EXPECT_EQ(pool.GetStats().pooled, 1u);
+
+  HciPacket reused = pool.Acquire();
+  EXPECT_TRUE(reused.empty());
+  EXPECT_EQ(reused.data(), storage);
+
+  auto stats = pool.GetStats();
+  EXPECT_EQ(stats.allocations, 1u);
+  EXPECT_EQ(stats.reuses, 1u);
+  EXPECT_EQ(stats.pooled, 0u);
+}
+
+TEST(HciPacketPoolTest, small_packets_are_not_pooled) {
+  HciPacketPool pool;
+  pool.Release(HciPacket{0x01, 0x02});
+  EXPECT_EQ(pool.GetStats().pooled, 0u);
+}
+
+TEST(HciPacketPoolTest, pool_is_bounded) {
+  HciPacketPool pool;
+  std::vector<HciPacket> packets;
+  for (size_t i = 0; i < HciPacketPool::kMaxPooledPackets + 1; i++) {
+    packets.push_back(pool.Acquire());
+  }
+  for (auto& packet : packets) {
+    pool.Release(std::move(packet));
+  }
+  EXPECT_EQ(pool.GetStats().pooled, HciPacketPool::kMaxPooledPackets);
+}
+
+TEST(HciPacketPoolTest, shared_packet_returns_to_pool_after_last_reference) {
+  HciPacketPool pool;
+  HciPacket packet = pool.Acquire();
+  packet.assign({0x0e, 0x01, 0x00});
+  const uint8_t* storage = packet.data();
+
+  auto shared = pool.Share(std::move(packet));
+  EXPECT_EQ(shared->data(), storage);
+  EXPECT_EQ(shared->size(), 3u);
+  auto second_reference = shared;
+  shared.reset();
+  EXPECT_EQ(pool.GetStats().pooled, 0u);
+  second_reference.reset();
+  EXPECT_EQ(pool.GetStats().pooled, 1u);
+  EXPECT_EQ(pool.Acquire().data(), storage);
+}
+
+TEST(HciPacketPoolTest, counts_copies_per_packet) {
+  HciPacketPool pool;
+  pool.CountPacket();
+  pool.CountPacket();
+  pool.CountCopy(27);
+  auto stats = pool.GetStats();
+  EXPECT_EQ(stats.packets, 2u);
+  EXPECT_EQ(stats.bytes_copied, 27u);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -17,14 +17,16 @@
 #include "hal/snoop_logger.h"
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <bitset>
 #include <chrono>
-#include <sstream>
+#include <cstring>
 
-#include "common/circular_buffer.h"
 #include "common/init_flags.h"
 #include "common/strings.h"
 #include "os/fake_timer/fake_timerfd.h"
@@ -32,6 +34,8 @@
 #include "os/log.h"
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
+#include "os/utils.h"
+#include "snoop_logger_generated.h"
 
 namespace bluetooth {
 #ifdef USE_FAKE_TIMERS
@@ -72,7 +76,7 @@ constexpr SnoopLogger::FileHeaderType kBtSnoopFileHeader = {
 constexpr size_t kDefaultBtSnoopMaxPacketsPerFile = 0xffff;
 
 // We restrict the maximum packet size to 150 bytes
-constexpr size_t kDefaultBtSnoozMaxBytesPerPacket = 150;
+constexpr size_t kDefaultBtSnoozMaxBytesPerPacket = SnoopLogger::kBtSnoozMaxBytesPerPacket;
 constexpr size_t kDefaultBtSnoozMaxPayloadBytesPerPacket =
     kDefaultBtSnoozMaxBytesPerPacket - sizeof(SnoopLogger::PacketHeaderType);
 
@@ -80,6 +84,47 @@ using namespace std::chrono_literals;
 constexpr std::chrono::hours kBtSnoozLogLifeTime = 12h;
 constexpr std::chrono::hours kBtSnoozLogDeleteRepeatingAlarmInterval = 1h;
 
+static_assert(
+    (SnoopLogger::kBtSnoopRecordRingSize & (SnoopLogger::kBtSnoopRecordRingSize - 1)) == 0,
+    "The btsnoop record ring size must be a power of 2");
+// Records written by a single writev(), two iovecs each
+constexpr size_t kBtSnoopMaxRecordsPerWrite = 256;
+// Written data is synced to storage at most this often while packets are captured
+constexpr std::chrono::milliseconds kBtSnoopSyncInterval = 1000ms;
+// Preallocated payload size of a record, enough for an ACL packet of the usual controller buffer size
+constexpr size_t kBtSnoopRecordCapacity = 1024 + 4;
+
+// Write all of |iov|, resuming after short writes
+bool write_all(int fd, struct iovec* iov, int iov_count) {
+  while (iov_count > 0) {
+    ssize_t written;
+    RUN_NO_INTR(written = writev(fd, iov, iov_count));
+    if (written == -1) {
+      return false;
+    }
+    while (iov_count > 0 && static_cast<size_t>(written) >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      iov_count--;
+    }
+    if (iov_count > 0) {
+      iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+  return true;
+}
+
+std::string get_btsnooz_ring_path(std::string log_file_path) {
+  return log_file_path.append(".ring");
+}
+
+void delete_btsnooz_ring_file(const std::string& ring_path) {
+  if (os::FileExists(ring_path) && !os::RemoveFile(ring_path)) {
+    LOG_ERROR("Failed to remove btsnooz ring file at \"%s\"", ring_path.c_str());
+  }
+}
+
 std::string get_btsnoop_log_path(std::string log_dir, bool filtered) {
   if (filtered) {
     log_dir.append(".filtered");
@@ -202,6 +247,7 @@ const std::string SnoopLogger::kIsDebuggableProperty = "ro.debuggable";
 const std::string SnoopLogger::kBtSnoopLogModeProperty = "persist.bluetooth.btsnooplogmode";
 const std::string SnoopLogger::kBtSnoopDefaultLogModeProperty = "persist.bluetooth.btsnoopdefaultmode";
 const std::string SnoopLogger::kSoCManufacturerProperty = "ro.soc.manufacturer";
+const std::string SnoopLogger::kBtSnoozRingFileProperty = "persist.bluetooth.btsnoozringfile";
 
 SnoopLogger::SnoopLogger(
     std::string snoop_log_path,
@@ -210,13 +256,16 @@ SnoopLogger::SnoopLogger(
     size_t max_packets_per_buffer,
     const std::string& btsnoop_mode,
     bool qualcomm_debug_log_enabled,
+    bool btsnooz_ring_file_enabled,
     const std::chrono::milliseconds snooz_log_life_time,
     const std::chrono::milliseconds snooz_log_delete_alarm_interval)
     : snoop_log_path_(std::move(snoop_log_path)),
       snooz_log_path_(std::move(snooz_log_path)),
       max_packets_per_file_(max_packets_per_file),
-      btsnooz_buffer_(max_packets_per_buffer),
       qualcomm_debug_log_enabled_(qualcomm_debug_log_enabled),
+      max_packets_per_buffer_(max_packets_per_buffer),
+      btsnooz_ring_file_enabled_(btsnooz_ring_file_enabled),
+      btsnooz_ring_path_(get_btsnooz_ring_path(snooz_log_path_)),
       snooz_log_life_time_(snooz_log_life_time),
       snooz_log_delete_alarm_interval_(snooz_log_delete_alarm_interval) {
   if (false && btsnoop_mode == kBtSnoopLogModeFiltered) {
@@ -246,13 +295,29 @@ SnoopLogger::SnoopLogger(
   }
   // Add ".filtered" extension if necessary
   snoop_log_path_ = get_btsnoop_log_path(snoop_log_path_, is_filtered_);
+  // A ring file left by a crash is only of use to a btsnooz log kept in a ring file
+  if (is_enabled_ || !btsnooz_ring_file_enabled_) {
+    delete_btsnooz_ring_file(btsnooz_ring_path_);
+  }
+
+  if (is_enabled_) {
+    btsnoop_records_ = std::vector<BtsnoopRecord>(kBtSnoopRecordRingSize);
+    for (size_t i = 0; i < btsnoop_records_.size(); i++) {
+      btsnoop_records_[i].sequence.store(i, std::memory_order_relaxed);
+      btsnoop_records_[i].packet.reserve(kBtSnoopRecordCapacity);
+    }
+  }
 }
 
 void SnoopLogger::CloseCurrentSnoopLogFile() {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
-  if (btsnoop_ostream_.is_open()) {
-    btsnoop_ostream_.flush();
-    btsnoop_ostream_.close();
+  if (btsnoop_fd_ != -1) {
+    if (fdatasync(btsnoop_fd_) == -1) {
+      LOG_ERROR("Failed to sync, error: \"%s\"", strerror(errno));
+    }
+    sync_calls_.fetch_add(1, std::memory_order_relaxed);
+    ::close(btsnoop_fd_);
+    btsnoop_fd_ = -1;
   }
   packet_counter_ = 0;
 }
@@ -275,21 +340,19 @@ void SnoopLogger::OpenNextSnoopLogFile() {
   }
 
   mode_t prevmask = umask(0);
-  // do not use std::ios::app as we want override the existing file
-  btsnoop_ostream_.open(snoop_log_path_, std::ios::binary | std::ios::out);
+  // do not use O_APPEND as we want override the existing file
+  RUN_NO_INTR(btsnoop_fd_ = open(snoop_log_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
 #ifdef USE_FAKE_TIMERS
   file_creation_time = fake_timerfd_get_clock();
 #endif
-  if (!btsnoop_ostream_.good()) {
+  if (btsnoop_fd_ == -1) {
     LOG_ALWAYS_FATAL("Unable to open snoop log at \"%s\", error: \"%s\"", snoop_log_path_.c_str(), strerror(errno));
   }
   umask(prevmask);
-  if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(&kBtSnoopFileHeader), sizeof(FileHeaderType))) {
+  struct iovec iov = {.iov_base = const_cast<FileHeaderType*>(&kBtSnoopFileHeader), .iov_len = sizeof(FileHeaderType)};
+  if (!write_all(btsnoop_fd_, &iov, 1)) {
     LOG_ALWAYS_FATAL("Unable to write file header to \"%s\", error: \"%s\"", snoop_log_path_.c_str(), strerror(errno));
   }
-  if (!btsnoop_ostream_.flush()) {
-    LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
-  }
 }
 
 void SnoopLogger::Capture(const HciPacket& packet, Direction direction, PacketType type) {
@@ -320,49 +383,177 @@ void SnoopLogger::Capture(const HciPacket& packet, Direction direction, PacketTy
                              .dropped_packets = 0,
                              .timestamp = htonll(timestamp_us + kBtSnoopEpochDelta),
                              .type = static_cast<uint8_t>(type)};
-  {
-    std::lock_guard<std::recursive_mutex> lock(file_mutex_);
-    if (!is_enabled_) {
-      // btsnoop disabled, log in-memory btsnooz log only
-      std::stringstream ss;
-      size_t included_length = get_btsnooz_packet_length_to_write(packet, type, qualcomm_debug_log_enabled_);
-      header.length_captured = htonl(included_length + /* type byte */ 1);
-      if (!ss.write(reinterpret_cast<const char*>(&header), sizeof(PacketHeaderType))) {
-        LOG_ERROR("Failed to write packet header for btsnooz, error: \"%s\"", strerror(errno));
+  captured_packets_.fetch_add(1, std::memory_order_relaxed);
+  if (!is_enabled_) {
+    // btsnoop disabled, log in-memory btsnooz log only
+    size_t included_length = get_btsnooz_packet_length_to_write(packet, type, qualcomm_debug_log_enabled_);
+    header.length_captured = htonl(included_length + /* type byte */ 1);
+    std::lock_guard<std::mutex> lock(btsnooz_mutex_);
+    if (btsnooz_ring_.IsOpen()) {
+      btsnooz_ring_.Append(&header, sizeof(PacketHeaderType), packet.data(), included_length);
+    }
+    return;
+  }
+  // The writer thread does the file I/O. If it falls too far behind the packet is dropped, and counted in the
+  // cumulative drops of the next records.
+  header.dropped_packets = htonl(static_cast<uint32_t>(dropped_packets_.load(std::memory_order_relaxed)));
+  if (!PushBtsnoopRecord(header, packet)) {
+    dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// Multi producer enqueue into the bounded ring, see Dmitry Vyukov's bounded MPMC queue
+bool SnoopLogger::PushBtsnoopRecord(const PacketHeaderType& header, const HciPacket& packet) {
+  size_t position = btsnoop_enqueue_position_.load(std::memory_order_relaxed);
+  BtsnoopRecord* record;
+  for (;;) {
+    record = &btsnoop_records_[position & (kBtSnoopRecordRingSize - 1)];
+    size_t sequence = record->sequence.load(std::memory_order_acquire);
+    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (btsnoop_enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // Full: the writer hasn't released the slot written a whole ring ago
+      return false;
+    } else {
+      position = btsnoop_enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  record->header = header;
+  record->packet.assign(packet.begin(), packet.end());
+  record->sequence.store(position + 1, std::memory_order_release);
+
+  // Only wake the writer when it went to sleep, so a busy writer costs the capturing thread no syscall
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (writer_idle_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    writer_wakeup_ = true;
+    writer_cv_.notify_one();
+  }
+  return true;
+}
+
+bool SnoopLogger::IsBtsnoopRecordReady() const {
+  const BtsnoopRecord& record = btsnoop_records_[btsnoop_dequeue_position_ & (kBtSnoopRecordRingSize - 1)];
+  return record.sequence.load(std::memory_order_acquire) == btsnoop_dequeue_position_ + 1;
+}
+
+// Write every ready record, in batches of one writev() each. Returns the number of records written.
+size_t SnoopLogger::WriteBtsnoopRecords() {
+  size_t total = 0;
+  for (;;) {
+    struct iovec iov[2 * kBtSnoopMaxRecordsPerWrite];
+    size_t count = 0;
+    size_t bytes = 0;
+    bool rotate = false;
+    while (count < kBtSnoopMaxRecordsPerWrite) {
+      BtsnoopRecord& record = btsnoop_records_[(btsnoop_dequeue_position_ + count) & (kBtSnoopRecordRingSize - 1)];
+      if (record.sequence.load(std::memory_order_acquire) != btsnoop_dequeue_position_ + count + 1) {
+        break;
       }
-      if (!ss.write(reinterpret_cast<const char*>(packet.data()), included_length)) {
-        LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
+      // A file always gets at least one packet, even with a limit of 0 packets per file
+      if (packet_counter_ + count != 0 && packet_counter_ + count >= max_packets_per_file_) {
+        rotate = true;
+        break;
       }
-      btsnooz_buffer_.Push(ss.str());
-      return;
+      iov[2 * count] = {.iov_base = &record.header, .iov_len = sizeof(PacketHeaderType)};
+      iov[2 * count + 1] = {.iov_base = record.packet.data(), .iov_len = record.packet.size()};
+      bytes += sizeof(PacketHeaderType) + record.packet.size();
+      count++;
+    }
+
+    if (count > 0) {
+      if (!write_all(btsnoop_fd_, iov, 2 * count)) {
+        LOG_ERROR("Failed to write %zu packets for btsnoop, error: \"%s\"", count, strerror(errno));
+      }
+      write_calls_.fetch_add(1, std::memory_order_relaxed);
+      bytes_written_.fetch_add(bytes, std::memory_order_relaxed);
+      for (size_t i = 0; i < count; i++) {
+        BtsnoopRecord& record = btsnoop_records_[(btsnoop_dequeue_position_ + i) & (kBtSnoopRecordRingSize - 1)];
+        record.sequence.store(btsnoop_dequeue_position_ + i + kBtSnoopRecordRingSize, std::memory_order_release);
+      }
+      btsnoop_dequeue_position_ += count;
+      packet_counter_ += count;
+      total += count;
     }
-    packet_counter_++;
-    if (packet_counter_ > max_packets_per_file_) {
+    if (rotate) {
       OpenNextSnoopLogFile();
+      continue;
+    }
+    if (count < kBtSnoopMaxRecordsPerWrite) {
+      return total;
+    }
+  }
+}
+
+void SnoopLogger::BtsnoopWriterLoop() {
+  auto last_sync = std::chrono::steady_clock::now();
+  bool unsynced = false;
+  for (;;) {
+    if (WriteBtsnoopRecords() != 0) {
+      unsynced = true;
+    }
+    // Group commit: the data reaches kernel memory with every batch, and storage once per sync interval
+    auto now = std::chrono::steady_clock::now();
+    if (unsynced && now - last_sync >= kBtSnoopSyncInterval) {
+      if (fdatasync(btsnoop_fd_) == -1) {
+        LOG_ERROR("Failed to sync, error: \"%s\"", strerror(errno));
+      }
+      sync_calls_.fetch_add(1, std::memory_order_relaxed);
+      last_sync = now;
+      unsynced = false;
     }
-    if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(&header), sizeof(PacketHeaderType))) {
-      LOG_ERROR("Failed to write packet header for btsnoop, error: \"%s\"", strerror(errno));
+
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    writer_idle_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (IsBtsnoopRecordReady()) {
+      writer_idle_.store(false, std::memory_order_relaxed);
+      continue;
     }
-    if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(packet.data()), packet.size())) {
-      LOG_ERROR("Failed to write packet payload for btsnoop, error: \"%s\"", strerror(errno));
+    if (writer_stopping_) {
+      return;
     }
-    // std::ofstream::flush() pushes user data into kernel memory. The data will be written even if this process
-    // crashes. However, data will be lost if there is a kernel panic, which is out of scope of BT snoop log.
-    // NOTE: std::ofstream::write() followed by std::ofstream::flush() has similar effect as UNIX write(fd, data, len)
-    //       as write() syscall dumps data into kernel memory directly
-    if (!btsnoop_ostream_.flush()) {
-      LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
+    auto woken = [this] { return writer_wakeup_ || writer_stopping_; };
+    if (unsynced) {
+      writer_cv_.wait_until(lock, last_sync + kBtSnoopSyncInterval, woken);
+    } else {
+      writer_cv_.wait(lock, woken);
     }
+    writer_wakeup_ = false;
+    writer_idle_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void SnoopLogger::StopBtsnoopWriter() {
+  if (!btsnoop_writer_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    writer_stopping_ = true;
+    writer_cv_.notify_one();
   }
+  // The writer drains the ring before it exits
+  btsnoop_writer_thread_.join();
 }
 
-void SnoopLogger::DumpSnoozLogToFile(const std::vector<std::string>& data) const {
+void SnoopLogger::DumpSnoozLogToFile() const {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (is_enabled_) {
     LOG_DEBUG("btsnoop log is enabled, skip dumping btsnooz log");
     return;
   }
 
+  // Copy the records out, so captures aren't held back by the file I/O
+  std::vector<uint8_t> records;
+  {
+    std::lock_guard<std::mutex> btsnooz_lock(btsnooz_mutex_);
+    records = btsnooz_ring_.ReadRecords();
+  }
+
   auto last_file_path = get_last_log_path(snooz_log_path_);
 
   if (os::FileExists(snooz_log_path_)) {
@@ -377,23 +568,23 @@ void SnoopLogger::DumpSnoozLogToFile(const std::vector<std::string>& data) const
   }
 
   mode_t prevmask = umask(0);
-  // do not use std::ios::app as we want override the existing file
-  std::ofstream btsnooz_ostream(snooz_log_path_, std::ios::binary | std::ios::out);
-  if (!btsnooz_ostream.good()) {
+  // do not use O_APPEND as we want override the existing file
+  int btsnooz_fd;
+  RUN_NO_INTR(btsnooz_fd = open(snooz_log_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+  if (btsnooz_fd == -1) {
     LOG_ALWAYS_FATAL("Unable to open snoop log at \"%s\", error: \"%s\"", snooz_log_path_.c_str(), strerror(errno));
   }
   umask(prevmask);
-  if (!btsnooz_ostream.write(reinterpret_cast<const char*>(&kBtSnoopFileHeader), sizeof(FileHeaderType))) {
+  struct iovec header_iov = {
+      .iov_base = const_cast<FileHeaderType*>(&kBtSnoopFileHeader), .iov_len = sizeof(FileHeaderType)};
+  if (!write_all(btsnooz_fd, &header_iov, 1)) {
     LOG_ALWAYS_FATAL("Unable to write file header to \"%s\", error: \"%s\"", snooz_log_path_.c_str(), strerror(errno));
   }
-  for (const auto& packet : data) {
-    if (!btsnooz_ostream.write(packet.data(), packet.size())) {
-      LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
-    }
-  }
-  if (!btsnooz_ostream.flush()) {
-    LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
+  struct iovec records_iov = {.iov_base = records.data(), .iov_len = records.size()};
+  if (!write_all(btsnooz_fd, &records_iov, 1)) {
+    LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
   }
+  ::close(btsnooz_fd);
 }
 
 void SnoopLogger::ListDependencies(ModuleList* list) const {
@@ -404,6 +595,16 @@ void SnoopLogger::Start() {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (is_enabled_) {
     OpenNextSnoopLogFile();
+    writer_stopping_ = false;
+    btsnoop_writer_thread_ = std::thread(&SnoopLogger::BtsnoopWriterLoop, this);
+  } else {
+    std::lock_guard<std::mutex> btsnooz_lock(btsnooz_mutex_);
+    // Packets captured before a crash of the previous session are still in the ring file, ahead of the new ones
+    if (btsnooz_ring_file_enabled_ && btsnooz_ring_.Open(btsnooz_ring_path_, max_packets_per_buffer_)) {
+      recovered_packets_ = btsnooz_ring_.GetRecordCount();
+    } else if (!btsnooz_ring_.OpenAnonymous(max_packets_per_buffer_)) {
+      LOG_ERROR("Unable to allocate btsnooz log of %zu packets", max_packets_per_buffer_);
+    }
   }
   alarm_ = std::make_unique<os::RepeatingAlarm>(GetHandler());
   alarm_->Schedule(
@@ -411,6 +612,7 @@ void SnoopLogger::Start() {
 }
 
 void SnoopLogger::Stop() {
+  StopBtsnoopWriter();
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   LOG_DEBUG("Closing btsnoop log data at %s", snoop_log_path_.c_str());
   CloseCurrentSnoopLogFile();
@@ -418,13 +620,33 @@ void SnoopLogger::Stop() {
   alarm_->Cancel();
   alarm_.reset();
   // delete any existing snooz logs
+  {
+    std::lock_guard<std::mutex> btsnooz_lock(btsnooz_mutex_);
+    btsnooz_ring_.Close();
+  }
   delete_btsnoop_files(snooz_log_path_);
+  delete_btsnooz_ring_file(btsnooz_ring_path_);
 }
 
 DumpsysDataFinisher SnoopLogger::GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const {
   LOG_DEBUG("Dumping btsnooz log data to %s", snooz_log_path_.c_str());
-  DumpSnoozLogToFile(btsnooz_buffer_.Pull());
-  return Module::GetDumpsysData(builder);
+  DumpSnoozLogToFile();
+
+  auto title = builder->CreateString(ToString());
+  SnoopLoggerDataBuilder data_builder(*builder);
+  data_builder.add_title(title);
+  data_builder.add_btsnoop_enabled(is_enabled_);
+  data_builder.add_captured_packets(captured_packets_.load(std::memory_order_relaxed));
+  data_builder.add_dropped_packets(dropped_packets_.load(std::memory_order_relaxed));
+  data_builder.add_bytes_written(bytes_written_.load(std::memory_order_relaxed));
+  data_builder.add_write_calls(write_calls_.load(std::memory_order_relaxed));
+  data_builder.add_sync_calls(sync_calls_.load(std::memory_order_relaxed));
+  data_builder.add_btsnooz_ring_file(btsnooz_ring_file_enabled_);
+  data_builder.add_btsnooz_recovered_packets(recovered_packets_);
+  auto dumpsys_data = data_builder.Finish();
+  return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+    dumpsys_builder->add_snoop_logger_dumpsys_data(dumpsys_data);
+  };
 }
 
 size_t SnoopLogger::GetMaxPacketsPerFile() {
@@ -488,6 +710,11 @@ bool SnoopLogger::IsQualcommDebugLogEnabled() {
   return qualcomm_debug_log_enabled;
 }
 
+bool SnoopLogger::IsBtsnoozRingFileEnabled() {
+  auto ring_file_prop = os::GetSystemProperty(kBtSnoozRingFileProperty);
+  return ring_file_prop.has_value() && common::StringTrim(ring_file_prop.value()) == "true";
+}
+
 const ModuleFactory SnoopLogger::Factory = ModuleFactory([]() {
   return new SnoopLogger(
       os::ParameterProvider::SnoopLogFilePath(),
@@ -496,6 +723,7 @@ const ModuleFactory SnoopLogger::Factory = ModuleFactory([]() {
       GetMaxPacketsPerBuffer(),
       GetBtSnoopMode(),
       IsQualcommDebugLogEnabled(),
+      IsBtsnoozRingFileEnabled(),
       kBtSnoozLogLifeTime,
       kBtSnoozLogDeleteRepeatingAlarmInterval);
 });
@@ -16,12 +16,15 @@
 
 #pragma once
 
-#include <fstream>
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
-#include "common/circular_buffer.h"
+#include "hal/btsnooz_ring.h"
 #include "hal/hci_hal.h"
 #include "module.h"
 #include "os/repeating_alarm.h"
@@ -47,6 +50,7 @@ class SnoopLogger : public ::bluetooth::Module {
   static const std::string kBtSnoopLogModeProperty;
   static const std::string kBtSnoopDefaultLogModeProperty;
   static const std::string kSoCManufacturerProperty;
+  static const std::string kBtSnoozRingFileProperty;
 
   // Put in header for test
   struct PacketHeaderType {
@@ -65,6 +69,12 @@ class SnoopLogger : public ::bluetooth::Module {
     uint32_t datalink_type;
   } __attribute__((__packed__));
 
+  // Largest btsnooz record, packet header included. Packets are truncated to fit.
+  static constexpr size_t kBtSnoozMaxBytesPerPacket = BtsnoozRing::kMaxRecordSize;
+
+  // Packets waiting for the btsnoop writer thread. Captures are dropped when it is full.
+  static constexpr size_t kBtSnoopRecordRingSize = 1024;
+
   // Returns the maximum number of packets per file
   // Changes to this value is only effective after restarting Bluetooth
   static size_t GetMaxPacketsPerFile();
@@ -79,6 +89,10 @@ class SnoopLogger : public ::bluetooth::Module {
   // Changes to this value is only effective after restarting Bluetooth
   static bool IsQualcommDebugLogEnabled();
 
+  // Returns whether the btsnooz log is kept in a memory-mapped ring file, so it survives a crash of the stack
+  // Changes to this value is only effective after restarting Bluetooth
+  static bool IsBtsnoozRingFileEnabled();
+
   // Has to be defined from 1 to 4 per btsnoop format
   enum PacketType {
     CMD = 1,
@@ -112,23 +126,64 @@ class SnoopLogger : public ::bluetooth::Module {
       size_t max_packets_per_buffer,
       const std::string& btsnoop_mode,
       bool qualcomm_debug_log_enabled,
+      bool btsnooz_ring_file_enabled,
       const std::chrono::milliseconds snooz_log_life_time,
       const std::chrono::milliseconds snooz_log_delete_alarm_interval);
   void CloseCurrentSnoopLogFile();
   void OpenNextSnoopLogFile();
-  void DumpSnoozLogToFile(const std::vector<std::string>& data) const;
+  void DumpSnoozLogToFile() const;
 
  private:
+  // A captured packet in a preallocated slot of |btsnoop_records_|. |sequence| tells whether the slot is free, being
+  // filled, or ready for the writer thread.
+  struct BtsnoopRecord {
+    std::atomic<size_t> sequence;
+    PacketHeaderType header;
+    HciPacket packet;
+  };
+
+  bool PushBtsnoopRecord(const PacketHeaderType& header, const HciPacket& packet);
+  bool IsBtsnoopRecordReady() const;
+  size_t WriteBtsnoopRecords();
+  void BtsnoopWriterLoop();
+  void StopBtsnoopWriter();
+
   std::string snoop_log_path_;
   std::string snooz_log_path_;
-  std::ofstream btsnoop_ostream_;
+  int btsnoop_fd_ = -1;
   bool is_enabled_ = false;
   bool is_filtered_ = false;
   size_t max_packets_per_file_;
-  common::CircularBuffer<std::string> btsnooz_buffer_;
   bool qualcomm_debug_log_enabled_ = false;
+  // Only used on the writer thread while it runs
   size_t packet_counter_ = 0;
   mutable std::recursive_mutex file_mutex_;
+
+  // Captures in full mode are queued here without locking, and written by |btsnoop_writer_thread_| in batches
+  std::vector<BtsnoopRecord> btsnoop_records_;
+  std::atomic<size_t> btsnoop_enqueue_position_{0};
+  size_t btsnoop_dequeue_position_ = 0;
+  std::thread btsnoop_writer_thread_;
+  std::mutex writer_mutex_;
+  std::condition_variable writer_cv_;
+  std::atomic<bool> writer_idle_{false};
+  bool writer_wakeup_ = false;
+  bool writer_stopping_ = false;
+
+  // Captures when btsnoop is disabled, in an anonymous ring or in a ring file
+  size_t max_packets_per_buffer_;
+  bool btsnooz_ring_file_enabled_ = false;
+  std::string btsnooz_ring_path_;
+  BtsnoozRing btsnooz_ring_;
+  size_t recovered_packets_ = 0;
+  mutable std::mutex btsnooz_mutex_;
+
+  std::atomic<uint64_t> captured_packets_{0};
+  std::atomic<uint64_t> dropped_packets_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::atomic<uint64_t> write_calls_{0};
+  std::atomic<uint64_t> sync_calls_{0};
+
   std::unique_ptr<os::RepeatingAlarm> alarm_;
   std::chrono::milliseconds snooz_log_life_time_;
   std::chrono::milliseconds snooz_log_delete_alarm_interval_;
@@ -19,6 +19,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "os/fake_timer/fake_timerfd.h"
 
 namespace testing {
@@ -69,7 +71,8 @@ class TestSnoopLoggerModule : public SnoopLogger {
       std::string snooz_log_path,
       size_t max_packets_per_file,
       const std::string& btsnoop_mode,
-      bool qualcomm_debug_log_enabled)
+      bool qualcomm_debug_log_enabled,
+      bool btsnooz_ring_file_enabled = false)
       : SnoopLogger(
             std::move(snoop_log_path),
             std::move(snooz_log_path),
@@ -77,6 +80,7 @@ class TestSnoopLoggerModule : public SnoopLogger {
             SnoopLogger::GetMaxPacketsPerBuffer(),
             btsnoop_mode,
             qualcomm_debug_log_enabled,
+            btsnooz_ring_file_enabled,
             20ms,
             5ms) {}
 
@@ -184,6 +188,36 @@ TEST_F(SnoopLoggerModuleTest, capture_one_packet_test) {
       sizeof(SnoopLogger::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size());
 }
 
+TEST_F(SnoopLoggerModuleTest, capture_from_multiple_threads_test) {
+  // Fewer packets than the writer's ring holds, so none can be dropped
+  constexpr size_t kNumThreads = 4;
+  constexpr size_t kPacketsPerThread = SnoopLogger::kBtSnoopRecordRingSize / kNumThreads;
+  auto* snoop_logger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(), temp_snooz_log_.string(), 10000, SnoopLogger::kBtSnoopLogModeFull, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&SnoopLogger::Factory, snoop_logger);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([snoop_logger] {
+      for (size_t j = 0; j < kPacketsPerThread; j++) {
+        snoop_logger->Capture(kInformationRequest, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Stopping waits for the writer thread to write every captured packet
+  test_registry.StopAll();
+
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snoop_log_),
+      sizeof(SnoopLogger::FileHeaderType) +
+          (sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size()) * kNumThreads * kPacketsPerThread);
+}
+
 TEST_F(SnoopLoggerModuleTest, capture_hci_cmd_btsnooz_test) {
   // Actual test
   auto* snoop_logger = new TestSnoopLoggerModule(
@@ -207,6 +241,29 @@ TEST_F(SnoopLoggerModuleTest, capture_hci_cmd_btsnooz_test) {
   ASSERT_FALSE(std::filesystem::exists(temp_snooz_log_));
 }
 
+TEST_F(SnoopLoggerModuleTest, capture_hci_cmd_btsnooz_ring_file_test) {
+  // Actual test
+  auto* snoop_logger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(), temp_snooz_log_.string(), 10, SnoopLogger::kBtSnoopLogModeDisabled, false, true);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&SnoopLogger::Factory, snoop_logger);
+  auto temp_snooz_ring = temp_snooz_log_.string() + ".ring";
+  ASSERT_TRUE(std::filesystem::exists(temp_snooz_ring));
+
+  snoop_logger->Capture(kInformationRequest, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+  snoop_logger->CallGetDumpsysData(builder_);
+
+  ASSERT_TRUE(std::filesystem::exists(temp_snooz_log_));
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snooz_log_),
+      sizeof(SnoopLogger::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size());
+
+  test_registry.StopAll();
+
+  // A clean stop leaves nothing to recover
+  ASSERT_FALSE(std::filesystem::exists(temp_snooz_ring));
+}
+
 TEST_F(SnoopLoggerModuleTest, capture_l2cap_signal_packet_btsnooz_test) {
   // Actual test
   auto* snoop_logger = new TestSnoopLoggerModule(
@@ -359,6 +416,29 @@ TEST_F(SnoopLoggerModuleTest, rotate_file_after_full_test) {
       sizeof(SnoopLogger::FileHeaderType) + (sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size()) * 10);
 }
 
+TEST_F(SnoopLoggerModuleTest, rotate_file_after_each_packet_when_limit_is_zero_test) {
+  auto* snoop_logger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(), temp_snooz_log_.string(), 0, SnoopLogger::kBtSnoopLogModeFull, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&SnoopLogger::Factory, snoop_logger);
+
+  for (int i = 0; i < 3; i++) {
+    snoop_logger->Capture(kInformationRequest, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+  }
+
+  test_registry.StopAll();
+
+  // Every file holds one packet
+  ASSERT_TRUE(std::filesystem::exists(temp_snoop_log_));
+  ASSERT_TRUE(std::filesystem::exists(temp_snoop_log_last_));
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snoop_log_),
+      sizeof(SnoopLogger::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size());
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snoop_log_last_),
+      sizeof(SnoopLogger::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size());
+}
+
 TEST_F(SnoopLoggerModuleTest, qualcomm_debug_log_test) {
   auto* snoop_logger = new TestSnoopLoggerModule(
       temp_snoop_log_.string(), temp_snooz_log_.string(), 10, SnoopLogger::kBtSnoopLogModeDisabled, true);
@@ -24,6 +24,7 @@
 #include "common/bidi_queue.h"
 #include "hci/acl_manager/classic_impl.h"
 #include "hci/acl_manager/connection_management_callbacks.h"
+#include "hci/acl_manager/host_flow_control.h"
 #include "hci/acl_manager/le_acl_connection.h"
 #include "hci/acl_manager/le_impl.h"
 #include "hci/acl_manager/round_robin_scheduler.h"
@@ -45,6 +46,7 @@ using common::BindOnce;
 using acl_manager::classic_impl;
 using acl_manager::ClassicAclConnection;
 using acl_manager::ConnectionCallbacks;
+using acl_manager::HostFlowControl;
 
 using acl_manager::le_impl;
 using acl_manager::LeAclConnection;
@@ -60,6 +62,7 @@ struct AclManager::impl {
     handler_ = acl_manager_.GetHandler();
     controller_ = acl_manager_.GetDependency<Controller>();
     round_robin_scheduler_ = new RoundRobinScheduler(handler_, controller_, hci_layer_->GetAclQueueEnd());
+    host_flow_control_ = new HostFlowControl(handler_, controller_, hci_layer_);
 
     hci_queue_end_ = hci_layer_->GetAclQueueEnd();
     hci_queue_end_->RegisterDequeue(
@@ -67,9 +70,10 @@ struct AclManager::impl {
     bool crash_on_unknown_handle = false;
     {
       const std::lock_guard<std::mutex> lock(dumpsys_mutex_);
-      classic_impl_ =
-          new classic_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, crash_on_unknown_handle);
-      le_impl_ = new le_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, crash_on_unknown_handle);
+      classic_impl_ = new classic_impl(
+          hci_layer_, controller_, handler_, round_robin_scheduler_, host_flow_control_, crash_on_unknown_handle);
+      le_impl_ = new le_impl(
+          hci_layer_, controller_, handler_, round_robin_scheduler_, host_flow_control_, crash_on_unknown_handle);
     }
   }
 
@@ -83,6 +87,8 @@ struct AclManager::impl {
     }
 
     hci_queue_end_->UnregisterDequeue();
+    delete host_flow_control_;
+    host_flow_control_ = nullptr;
     delete round_robin_scheduler_;
     if (enqueue_registered_.exchange(false)) {
       hci_queue_end_->UnregisterEnqueue();
@@ -109,6 +115,8 @@ struct AclManager::impl {
             handle, [&packet](struct acl_manager::assembler* assembler) { assembler->on_incoming_packet(*packet); }))
       return;
     LOG_INFO("Dropping packet of size %zu to unknown connection 0x%0hx", packet->size(), packet->GetHandle());
+    // The assemblers return the packets of known connections to the controller
+    host_flow_control_->OnPacketsCompleted(handle, 1);
   }
 
   void Dump(
@@ -122,6 +130,7 @@ struct AclManager::impl {
   Controller* controller_ = nullptr;
   HciLayer* hci_layer_ = nullptr;
   RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  HostFlowControl* host_flow_control_ = nullptr;
   common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end_ = nullptr;
   std::atomic_bool enqueue_registered_ = false;
   uint16_t default_link_policy_settings_ = 0xffff;
@@ -311,6 +320,10 @@ void AclManager::HACK_SetAclTxPriority(uint8_t handle, bool high_priority) {
   CallOn(pimpl_->round_robin_scheduler_, &RoundRobinScheduler::SetLinkPriority, handle, high_priority);
 }
 
+void AclManager::SetAclTxWeight(uint16_t handle, uint8_t weight) {
+  CallOn(pimpl_->round_robin_scheduler_, &RoundRobinScheduler::SetLinkWeight, handle, weight);
+}
+
 void AclManager::ListDependencies(ModuleList* list) const {
   list->add<HciLayer>();
   list->add<Controller>();
@@ -353,12 +366,60 @@ void AclManager::impl::Dump(
   }
   auto vecofstrings = fb_builder->CreateVector(strings, connect_list.size());
 
+  std::vector<flatbuffers::Offset<AclLinkSchedulingData>> link_scheduling_offsets;
+  if (round_robin_scheduler_ != nullptr) {
+    for (const auto& [handle, stats] : round_robin_scheduler_->GetLinkStats()) {
+      auto connection_type_offset =
+          fb_builder->CreateString(stats.connection_type == RoundRobinScheduler::ConnectionType::LE ? "LE" : "CLASSIC");
+      const auto& delay = stats.queueing_delay;
+      auto histogram_offset = fb_builder->CreateVector(delay.histogram.data(), delay.histogram.size());
+      AclLinkSchedulingDataBuilder link_builder(*fb_builder);
+      link_builder.add_handle(handle);
+      link_builder.add_connection_type(connection_type_offset);
+      link_builder.add_weight(stats.weight);
+      link_builder.add_high_priority(stats.high_priority);
+      link_builder.add_packets(stats.packets);
+      link_builder.add_bytes(stats.bytes);
+      link_builder.add_average_queueing_delay_us(delay.count == 0 ? 0 : delay.total_us / delay.count);
+      link_builder.add_max_queueing_delay_us(delay.max_us);
+      link_builder.add_queueing_delay_histogram_ms(histogram_offset);
+      link_scheduling_offsets.push_back(link_builder.Finish());
+    }
+  }
+  auto link_scheduling = fb_builder->CreateVector(link_scheduling_offsets);
+
+  std::vector<flatbuffers::Offset<AclReassemblyData>> reassembly_offsets;
+  auto add_reassembly_data = [&](const std::map<uint16_t, acl_manager::assembler_stats>& assembler_stats,
+                                 const char* transport) {
+    for (const auto& [handle, stats] : assembler_stats) {
+      auto transport_offset = fb_builder->CreateString(transport);
+      AclReassemblyDataBuilder reassembly_builder(*fb_builder);
+      reassembly_builder.add_handle(handle);
+      reassembly_builder.add_transport(transport_offset);
+      reassembly_builder.add_reassembled_pdus(stats.reassembled_pdus);
+      reassembly_builder.add_dropped_pdus(stats.dropped_pdus);
+      reassembly_builder.add_congested_pdus(stats.congested_pdus);
+      reassembly_builder.add_queued_bytes(stats.queued_bytes);
+      reassembly_builder.add_held_acl_packets(stats.held_acl_packets);
+      reassembly_offsets.push_back(reassembly_builder.Finish());
+    }
+  };
+  if (classic_impl_ != nullptr) {
+    add_reassembly_data(classic_impl_->get_assembler_stats(), "CLASSIC");
+  }
+  if (le_impl_ != nullptr) {
+    add_reassembly_data(le_impl_->get_assembler_stats(), "LE");
+  }
+  auto reassembly = fb_builder->CreateVector(reassembly_offsets);
+
   AclManagerDataBuilder builder(*fb_builder);
   builder.add_title(title);
   builder.add_le_filter_accept_list_count(connect_list.size());
   builder.add_le_filter_accept_list(vecofstrings);
   builder.add_le_connectability_state(le_connectability_state);
   builder.add_le_create_connection_timeout_alarms_count(le_create_connection_timeout_alarms_count);
+  builder.add_link_scheduling(link_scheduling);
+  builder.add_reassembly(reassembly);
 
   flatbuffers::Offset<AclManagerData> dumpsys_data = builder.Finish();
   promise.set_value(dumpsys_data);
@@ -155,6 +155,9 @@ private:
 
  virtual void HACK_SetAclTxPriority(uint8_t handle, bool high_priority);
 
+ // Share of the ACL buffers |handle| gets relative to the other links of the same transport, 1 by default
+ virtual void SetAclTxWeight(uint16_t handle, uint8_t weight);
+
  struct impl;
  std::unique_ptr<impl> pimpl_;
 };
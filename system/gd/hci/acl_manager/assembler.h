@@ -16,10 +16,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <queue>
 
+#include "common/callback.h"
 #include "hci/acl_manager/acl_connection.h"
 #include "hci/address_with_type.h"
 #include "os/handler.h"
@@ -30,42 +33,65 @@ namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
-constexpr size_t kMaxQueuedPacketsPerConnection = 10;
 constexpr size_t kL2capBasicFrameHeaderSize = 4;
 
 namespace {
-class PacketViewForRecombination : public packet::PacketView<packet::kLittleEndian> {
- public:
-  PacketViewForRecombination(const PacketView& packetView) : PacketView(packetView) {}
-  void AppendPacketView(packet::PacketView<packet::kLittleEndian> to_append) {
-    Append(to_append);
-  }
-};
-
 // Per spec 5.1 Vol 2 Part B 5.3, ACL link shall carry L2CAP data. Therefore, an ACL packet shall contain L2CAP PDU.
-// This function returns the PDU size of the L2CAP data if it's a starting packet. Returns 0 if it's invalid.
-uint16_t GetL2capPduSize(AclView packet) {
-  auto l2cap_payload = packet.GetPayload();
-  if (l2cap_payload.size() < kL2capBasicFrameHeaderSize) {
-    LOG_ERROR("Controller sent an invalid L2CAP starting packet!");
-    return 0;
-  }
-  return (l2cap_payload.at(1) << 8u) + l2cap_payload.at(0);
+// This function returns the size of the L2CAP PDU, header included, of a starting packet.
+size_t GetL2capPduSize(const packet::PacketView<packet::kLittleEndian>& l2cap_payload) {
+  return kL2capBasicFrameHeaderSize + (l2cap_payload.at(1) << 8u) + l2cap_payload.at(0);
 }
 
 }  // namespace
 
+struct assembler_stats {
+  uint64_t reassembled_pdus;
+  uint64_t dropped_pdus;
+  uint64_t congested_pdus;
+  size_t queued_bytes;
+  size_t held_acl_packets;
+};
+
+// Reassembles the L2CAP PDUs of one connection and queues them for its upper layer.
+//
+// Every ACL packet received is reported through |on_packets_completed| once the host is done with it: when the PDU it
+// belongs to is taken by the upper layer, or when it is dropped. With controller to host flow control these reports
+// become Host_Number_Of_Completed_Packets, so a connection whose upper layer falls behind makes the controller hold
+// back data instead of the host dropping it.
 struct assembler {
-  assembler(AddressWithType address_with_type, AclConnection::QueueDownEnd* down_end, os::Handler* handler)
-      : address_with_type_(address_with_type), down_end_(down_end), handler_(handler) {}
+  assembler(
+      AddressWithType address_with_type,
+      AclConnection::QueueDownEnd* down_end,
+      os::Handler* handler,
+      common::Callback<void(uint16_t)> on_packets_completed)
+      : address_with_type_(address_with_type),
+        down_end_(down_end),
+        handler_(handler),
+        on_packets_completed_(std::move(on_packets_completed)) {}
   AddressWithType address_with_type_;
   AclConnection::QueueDownEnd* down_end_;
   os::Handler* handler_;
-  PacketViewForRecombination recombination_stage_{
-      PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>())};
+  // Empty when nobody needs the reports
+  common::Callback<void(uint16_t)> on_packets_completed_;
+  // The PDU being reassembled, allocated at its full size when its first fragment comes in
+  std::shared_ptr<std::vector<uint8_t>> recombination_stage_;
   size_t remaining_sdu_continuation_packet_size_ = 0;
+  // ACL packets in |recombination_stage_|
+  uint16_t recombination_stage_packets_ = 0;
   std::shared_ptr<std::atomic_bool> enqueue_registered_ = std::make_shared<std::atomic_bool>(false);
-  std::queue<packet::PacketView<packet::kLittleEndian>> incoming_queue_;
+  struct queued_pdu {
+    packet::PacketView<packet::kLittleEndian> pdu_;
+    uint16_t acl_packets_;
+  };
+  std::queue<queued_pdu> incoming_queue_;
+  // Read by dumpsys from other threads
+  std::atomic<uint64_t> reassembled_pdus_{0};
+  std::atomic<uint64_t> dropped_pdus_{0};
+  // PDUs that had to wait behind others for the upper layer
+  std::atomic<uint64_t> congested_pdus_{0};
+  std::atomic<size_t> queued_bytes_{0};
+  // Received and not reported completed yet
+  std::atomic<size_t> held_acl_packets_{0};
 
   ~assembler() {
     if (enqueue_registered_->exchange(false)) {
@@ -73,63 +99,119 @@ struct assembler {
     }
   }
 
+  assembler_stats get_stats() const {
+    return assembler_stats{
+        .reassembled_pdus = reassembled_pdus_.load(std::memory_order_relaxed),
+        .dropped_pdus = dropped_pdus_.load(std::memory_order_relaxed),
+        .congested_pdus = congested_pdus_.load(std::memory_order_relaxed),
+        .queued_bytes = queued_bytes_.load(std::memory_order_relaxed),
+        .held_acl_packets = held_acl_packets_.load(std::memory_order_relaxed),
+    };
+  }
+
+  void complete_packets(uint16_t packets) {
+    if (packets == 0) {
+      return;
+    }
+    held_acl_packets_ -= packets;
+    if (!on_packets_completed_.is_null()) {
+      on_packets_completed_.Run(packets);
+    }
+  }
+
   // Invoked from some external Queue Reactable context
   std::unique_ptr<packet::PacketView<packet::kLittleEndian>> on_le_incoming_data_ready() {
-    auto packet = incoming_queue_.front();
+    auto queued = incoming_queue_.front();
     incoming_queue_.pop();
+    queued_bytes_ -= queued.pdu_.size();
+    complete_packets(queued.acl_packets_);
     if (incoming_queue_.empty() && enqueue_registered_->exchange(false)) {
       down_end_->UnregisterEnqueue();
     }
-    return std::make_unique<PacketView<packet::kLittleEndian>>(packet);
+    return std::make_unique<PacketView<packet::kLittleEndian>>(queued.pdu_);
+  }
+
+  void drop_recombination_stage() {
+    dropped_pdus_++;
+    complete_packets(recombination_stage_packets_);
+    recombination_stage_.reset();
+    remaining_sdu_continuation_packet_size_ = 0;
+    recombination_stage_packets_ = 0;
+  }
+
+  // Drop |packet| alone, it never became part of a PDU
+  void drop_packet() {
+    dropped_pdus_++;
+    complete_packets(1);
   }
 
   void on_incoming_packet(AclView packet) {
+    held_acl_packets_++;
     PacketView<packet::kLittleEndian> payload = packet.GetPayload();
     auto payload_size = payload.size();
     auto broadcast_flag = packet.GetBroadcastFlag();
     if (broadcast_flag == BroadcastFlag::ACTIVE_PERIPHERAL_BROADCAST) {
       LOG_WARN("Dropping broadcast from remote");
+      drop_packet();
       return;
     }
     auto packet_boundary_flag = packet.GetPacketBoundaryFlag();
     if (packet_boundary_flag == PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE) {
       LOG_ERROR("Controller is not allowed to send FIRST_NON_AUTOMATICALLY_FLUSHABLE to host except loopback mode");
+      drop_packet();
       return;
     }
+    uint16_t pdu_packets = 1;
     if (packet_boundary_flag == PacketBoundaryFlag::CONTINUING_FRAGMENT) {
-      if (remaining_sdu_continuation_packet_size_ < payload_size) {
+      if (recombination_stage_ == nullptr || remaining_sdu_continuation_packet_size_ < payload_size) {
         LOG_WARN("Remote sent unexpected L2CAP PDU. Drop the entire L2CAP PDU");
-        recombination_stage_ =
-            PacketViewForRecombination(PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>()));
-        remaining_sdu_continuation_packet_size_ = 0;
+        recombination_stage_packets_++;
+        drop_recombination_stage();
         return;
       }
       remaining_sdu_continuation_packet_size_ -= payload_size;
-      recombination_stage_.AppendPacketView(payload);
+      payload.AppendTo(recombination_stage_.get());
+      recombination_stage_packets_++;
       if (remaining_sdu_continuation_packet_size_ != 0) {
         return;
-      } else {
-        payload = recombination_stage_;
-        recombination_stage_ =
-            PacketViewForRecombination(PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>()));
       }
+      payload = PacketView<packet::kLittleEndian>(std::move(recombination_stage_));
+      pdu_packets = recombination_stage_packets_;
+      recombination_stage_packets_ = 0;
     } else if (packet_boundary_flag == PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE) {
-      if (recombination_stage_.size() > 0) {
+      if (recombination_stage_ != nullptr) {
         LOG_ERROR("Controller sent a starting packet without finishing previous packet. Drop previous one.");
+        drop_recombination_stage();
       }
-      auto l2cap_pdu_size = GetL2capPduSize(packet);
-      remaining_sdu_continuation_packet_size_ = l2cap_pdu_size - (payload_size - kL2capBasicFrameHeaderSize);
-      if (remaining_sdu_continuation_packet_size_ > 0) {
-        recombination_stage_ = payload;
+      if (payload_size < kL2capBasicFrameHeaderSize) {
+        LOG_ERROR("Controller sent an invalid L2CAP starting packet!");
+        drop_packet();
+        return;
+      }
+      auto l2cap_pdu_size = GetL2capPduSize(payload);
+      if (payload_size > l2cap_pdu_size) {
+        LOG_WARN("Remote sent a starting packet longer than its L2CAP PDU. Drop the entire L2CAP PDU");
+        drop_packet();
+        return;
+      }
+      if (payload_size < l2cap_pdu_size) {
+        // The rest of the PDU is copied in as it comes, so the upper layer gets a single contiguous buffer
+        recombination_stage_ = std::make_shared<std::vector<uint8_t>>();
+        recombination_stage_->reserve(l2cap_pdu_size);
+        payload.AppendTo(recombination_stage_.get());
+        remaining_sdu_continuation_packet_size_ = l2cap_pdu_size - payload_size;
+        recombination_stage_packets_ = 1;
         return;
       }
-    }
-    if (incoming_queue_.size() > kMaxQueuedPacketsPerConnection) {
-      LOG_ERROR("Dropping packet from %s due to congestion", address_with_type_.ToString().c_str());
-      return;
     }
 
-    incoming_queue_.push(payload);
+    // The ACL packets of a PDU stay held until the upper layer takes it
+    if (!incoming_queue_.empty()) {
+      congested_pdus_++;
+    }
+    reassembled_pdus_++;
+    queued_bytes_ += payload.size();
+    incoming_queue_.push(queued_pdu{payload, pdu_packets});
     if (!enqueue_registered_->exchange(true)) {
       down_end_->RegisterEnqueue(handler_,
                                  common::Bind(&assembler::on_le_incoming_data_ready, common::Unretained(this)));
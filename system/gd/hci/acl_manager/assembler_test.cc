@@ -0,0 +1,245 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/assembler.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include "common/bind.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+namespace {
+
+constexpr uint16_t kHandle = 0x0042;
+
+AclView MakeAclView(PacketBoundaryFlag packet_boundary_flag, const std::vector<uint8_t>& payload) {
+  auto payload_builder = std::make_unique<packet::RawBuilder>();
+  payload_builder->AddOctets(payload);
+  auto builder = AclBuilder::Create(
+      kHandle, packet_boundary_flag, BroadcastFlag::POINT_TO_POINT, std::move(payload_builder));
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  packet::BitInserter it(*bytes);
+  builder->Serialize(it);
+  auto view = AclView::Create(packet::PacketView<packet::kLittleEndian>(bytes));
+  EXPECT_TRUE(view.IsValid());
+  return view;
+}
+
+// An L2CAP basic frame on |cid| carrying |size| bytes of |value|
+std::vector<uint8_t> MakeL2capPdu(uint16_t cid, size_t size, uint8_t value) {
+  std::vector<uint8_t> pdu = {
+      static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(cid),
+      static_cast<uint8_t>(cid >> 8)};
+  pdu.insert(pdu.end(), size, value);
+  return pdu;
+}
+
+class AssemblerTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    thread_ = new Thread("thread", Thread::Priority::NORMAL);
+    handler_ = new Handler(thread_);
+    assembler_ = new assembler(
+        AddressWithType(Address::kEmpty, AddressType::PUBLIC_DEVICE_ADDRESS),
+        queue_.GetDownEnd(),
+        handler_,
+        common::Bind(&AssemblerTest::OnPacketsCompleted, common::Unretained(this)));
+  }
+
+  void TearDown() override {
+    if (dequeue_registered_) {
+      queue_.GetUpEnd()->UnregisterDequeue();
+    }
+    handler_->Post(common::BindOnce(&AssemblerTest::DeleteAssembler, common::Unretained(this)));
+    SyncHandler();
+    handler_->Clear();
+    delete handler_;
+    delete thread_;
+  }
+
+  void DeleteAssembler() {
+    delete assembler_;
+    assembler_ = nullptr;
+  }
+
+  void SyncHandler() {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->BindOnceOn(&promise, &std::promise<void>::set_value).Invoke();
+    future.wait();
+  }
+
+  void Receive(PacketBoundaryFlag packet_boundary_flag, const std::vector<uint8_t>& payload) {
+    handler_->Post(common::BindOnce(
+        &assembler::on_incoming_packet,
+        common::Unretained(assembler_),
+        MakeAclView(packet_boundary_flag, payload)));
+  }
+
+  // Collect the next |count| PDUs the assembler hands to the upper layer
+  void ExpectPdus(size_t count) {
+    pdus_expected_ = count;
+    pdus_promise_ = std::make_unique<std::promise<void>>();
+    pdus_future_ = pdus_promise_->get_future();
+    dequeue_registered_ = true;
+    queue_.GetUpEnd()->RegisterDequeue(handler_, common::Bind(&AssemblerTest::OnPdu, common::Unretained(this)));
+  }
+
+  void WaitForPdus() {
+    ASSERT_EQ(pdus_future_.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    SyncHandler();
+  }
+
+  void OnPacketsCompleted(uint16_t packets) {
+    completed_packets_ += packets;
+  }
+
+  void OnPdu() {
+    auto pdu = queue_.GetUpEnd()->TryDequeue();
+    pdus_.emplace_back(pdu->begin(), pdu->end());
+    if (--pdus_expected_ == 0) {
+      dequeue_registered_ = false;
+      queue_.GetUpEnd()->UnregisterDequeue();
+      pdus_promise_->set_value();
+    }
+  }
+
+  Thread* thread_;
+  Handler* handler_;
+  AclConnection::Queue queue_{10};
+  assembler* assembler_;
+  std::vector<std::vector<uint8_t>> pdus_;
+  size_t pdus_expected_ = 0;
+  bool dequeue_registered_ = false;
+  std::unique_ptr<std::promise<void>> pdus_promise_;
+  std::future<void> pdus_future_;
+  size_t completed_packets_ = 0;
+};
+
+TEST_F(AssemblerTest, complete_pdu) {
+  auto pdu = MakeL2capPdu(0x0040, 10, 0x11);
+  ExpectPdus(1);
+  Receive(PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, pdu);
+  WaitForPdus();
+  ASSERT_EQ(pdus_, std::vector<std::vector<uint8_t>>({pdu}));
+  ASSERT_EQ(assembler_->get_stats().reassembled_pdus, 1u);
+  ASSERT_EQ(assembler_->get_stats().dropped_pdus, 0u);
+}
+
+TEST_F(AssemblerTest, reassemble_fragments) {
+  auto pdu = MakeL2capPdu(0x0040, 100, 0x22);
+  pdu[50] = 0x33;
+  ExpectPdus(1);
+  Receive(PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, std::vector<uint8_t>(pdu.begin(), pdu.begin() + 27));
+  Receive(PacketBoundaryFlag::CONTINUING_FRAGMENT, std::vector<uint8_t>(pdu.begin() + 27, pdu.begin() + 54));
+  Receive(PacketBoundaryFlag::CONTINUING_FRAGMENT, std::vector<uint8_t>(pdu.begin() + 54, pdu.end()));
+  WaitForPdus();
+  ASSERT_EQ(pdus_, std::vector<std::vector<uint8_t>>({pdu}));
+  ASSERT_EQ(assembler_->get_stats().reassembled_pdus, 1u);
+  ASSERT_EQ(completed_packets_, 3u);
+  ASSERT_EQ(assembler_->get_stats().held_acl_packets, 0u);
+}
+
+TEST_F(AssemblerTest, malformed_pdus_are_dropped_and_counted) {
+  auto pdu = MakeL2capPdu(0x0040, 30, 0x44);
+  // Continuation without a start
+  Receive(PacketBoundaryFlag::CONTINUING_FRAGMENT, std::vector<uint8_t>(pdu.begin(), pdu.begin() + 10));
+  // Start that is never finished
+  Receive(PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, std::vector<uint8_t>(pdu.begin(), pdu.begin() + 10));
+  // Start longer than its L2CAP length
+  auto long_start = pdu;
+  long_start.push_back(0x00);
+  Receive(PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, long_start);
+  // Start too short for an L2CAP header
+  Receive(PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, {0x01, 0x00});
+  ExpectPdus(1);
+  Receive(PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, pdu);
+  WaitForPdus();
+  ASSERT_EQ(pdus_, std::vector<std::vector<uint8_t>>({pdu}));
+  ASSERT_EQ(assembler_->get_stats().reassembled_pdus, 1u);
+  ASSERT_EQ(assembler_->get_stats().dropped_pdus, 4u);
+  // Dropped packets go back to the controller right away
+  ASSERT_EQ(completed_packets_, 5u);
+  ASSERT_EQ(assembler_->get_stats().held_acl_packets, 0u);
+}
+
+TEST_F(AssemblerTest, slow_upper_layer_holds_packets_back_instead_of_dropping_pdus) {
+  constexpr size_t kPduSize = 1000;
+  constexpr size_t kPduCount = 100;
+  constexpr size_t kFirstFragmentSize = 500;
+  for (size_t i = 0; i < kPduCount; i++) {
+    auto pdu = MakeL2capPdu(0x0040, kPduSize, i);
+    Receive(
+        PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
+        std::vector<uint8_t>(pdu.begin(), pdu.begin() + kFirstFragmentSize));
+    Receive(PacketBoundaryFlag::CONTINUING_FRAGMENT, std::vector<uint8_t>(pdu.begin() + kFirstFragmentSize, pdu.end()));
+  }
+  SyncHandler();
+  // The connection queue takes a few PDUs off the assembler, the packets of the rest are not returned
+  auto stats = assembler_->get_stats();
+  ASSERT_EQ(stats.reassembled_pdus, kPduCount);
+  ASSERT_EQ(stats.dropped_pdus, 0u);
+  ASSERT_GT(stats.congested_pdus, 0u);
+  ASSERT_GT(stats.held_acl_packets, 0u);
+  ASSERT_EQ(completed_packets_ + stats.held_acl_packets, 2 * kPduCount);
+
+  ExpectPdus(kPduCount);
+  WaitForPdus();
+  ASSERT_EQ(pdus_.size(), kPduCount);
+  for (size_t i = 0; i < kPduCount; i++) {
+    ASSERT_EQ(pdus_[i], MakeL2capPdu(0x0040, kPduSize, i));
+  }
+  ASSERT_EQ(completed_packets_, 2 * kPduCount);
+  ASSERT_EQ(assembler_->get_stats().held_acl_packets, 0u);
+  ASSERT_EQ(assembler_->get_stats().queued_bytes, 0u);
+}
+
+TEST_F(AssemblerTest, largest_pdu_is_delivered) {
+  constexpr size_t kMaxL2capPduPayloadSize = 0xffff;
+  auto pdu = MakeL2capPdu(0x0040, kMaxL2capPduPayloadSize, 0x66);
+  ExpectPdus(1);
+  constexpr size_t kFragmentSize = 1021;
+  size_t fragments = 0;
+  for (size_t offset = 0; offset < pdu.size(); offset += kFragmentSize) {
+    auto fragment_end = pdu.begin() + std::min(pdu.size(), offset + kFragmentSize);
+    Receive(
+        offset == 0 ? PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE : PacketBoundaryFlag::CONTINUING_FRAGMENT,
+        std::vector<uint8_t>(pdu.begin() + offset, fragment_end));
+    fragments++;
+  }
+  WaitForPdus();
+  ASSERT_EQ(pdus_, std::vector<std::vector<uint8_t>>({pdu}));
+  ASSERT_EQ(completed_packets_, fragments);
+}
+
+}  // namespace
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
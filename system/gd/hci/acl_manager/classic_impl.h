@@ -23,6 +23,7 @@
 #include "common/bind.h"
 #include "hci/acl_manager/assembler.h"
 #include "hci/acl_manager/event_checkers.h"
+#include "hci/acl_manager/host_flow_control.h"
 #include "hci/acl_manager/round_robin_scheduler.h"
 #include "hci/controller.h"
 #include "security/security_manager_listener.h"
@@ -33,9 +34,14 @@ namespace hci {
 namespace acl_manager {
 
 struct acl_connection {
-  acl_connection(AddressWithType address_with_type, AclConnection::QueueDownEnd* queue_down_end, os::Handler* handler)
+  acl_connection(
+      AddressWithType address_with_type,
+      AclConnection::QueueDownEnd* queue_down_end,
+      os::Handler* handler,
+      common::Callback<void(uint16_t)> on_packets_completed)
       : address_with_type_(address_with_type),
-        assembler_(new acl_manager::assembler(address_with_type, queue_down_end, handler)) {}
+        assembler_(new acl_manager::assembler(
+            address_with_type, queue_down_end, handler, std::move(on_packets_completed))) {}
   ~acl_connection() {
     delete assembler_;
   }
@@ -50,8 +56,12 @@ struct classic_impl : public security::ISecurityManagerListener {
       Controller* controller,
       os::Handler* handler,
       RoundRobinScheduler* round_robin_scheduler,
+      HostFlowControl* host_flow_control,
       bool crash_on_unknown_handle)
-      : hci_layer_(hci_layer), controller_(controller), round_robin_scheduler_(round_robin_scheduler) {
+      : hci_layer_(hci_layer),
+        controller_(controller),
+        round_robin_scheduler_(round_robin_scheduler),
+        host_flow_control_(host_flow_control) {
     hci_layer_ = hci_layer;
     controller_ = controller;
     handler_ = handler;
@@ -180,6 +190,14 @@ struct classic_impl : public security::ISecurityManagerListener {
       auto callbacks = find_callbacks(address);
       if (callbacks != nullptr) execute(callbacks);
     }
+    std::map<uint16_t, assembler_stats> get_assembler_stats() const {
+      std::unique_lock<std::mutex> lock(acl_connections_guard_);
+      std::map<uint16_t, assembler_stats> stats;
+      for (const auto& [handle, connection] : acl_connections_) {
+        stats[handle] = connection.assembler_->get_stats();
+      }
+      return stats;
+    }
     bool send_packet_upward(uint16_t handle, std::function<void(struct acl_manager::assembler* assembler)> cb) {
       std::unique_lock<std::mutex> lock(acl_connections_guard_);
       auto connection = acl_connections_.find(handle);
@@ -191,12 +209,13 @@ struct classic_impl : public security::ISecurityManagerListener {
         const AddressWithType& remote_address,
         AclConnection::QueueDownEnd* queue_end,
         os::Handler* handler,
+        common::Callback<void(uint16_t)> on_packets_completed,
         ConnectionManagementCallbacks* connection_management_callbacks) {
       std::unique_lock<std::mutex> lock(acl_connections_guard_);
       auto emplace_pair = acl_connections_.emplace(
           std::piecewise_construct,
           std::forward_as_tuple(handle),
-          std::forward_as_tuple(remote_address, queue_end, handler));
+          std::forward_as_tuple(remote_address, queue_end, handler, std::move(on_packets_completed)));
       ASSERT(emplace_pair.second);  // Make sure the connection is unique
       emplace_pair.first->second.connection_management_callbacks_ = connection_management_callbacks;
     }
@@ -225,6 +244,10 @@ struct classic_impl : public security::ISecurityManagerListener {
     return connections.send_packet_upward(handle, cb);
   }
 
+  std::map<uint16_t, assembler_stats> get_assembler_stats() const {
+    return connections.get_assembler_stats();
+  }
+
   void on_incoming_connection(EventView packet) {
     ConnectionRequestView request = ConnectionRequestView::Create(packet);
     ASSERT(request.IsValid());
@@ -355,6 +378,7 @@ struct classic_impl : public security::ISecurityManagerListener {
         AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS},
         queue_down_end,
         handler_,
+        get_packets_completed_callback(handle),
         connection->GetEventCallbacks([this](uint16_t handle) { this->connections.invalidate(handle); }));
     connections.execute(address, [=](ConnectionManagementCallbacks* callbacks) {
       if (delayed_role_change_ == nullptr) {
@@ -408,6 +432,13 @@ struct classic_impl : public security::ISecurityManagerListener {
         std::move(packet), handler_->BindOnce(&check_command_complete<CreateConnectionCancelCompleteView>));
   }
 
+  common::Callback<void(uint16_t)> get_packets_completed_callback(uint16_t handle) {
+    if (host_flow_control_ == nullptr) {
+      return {};
+    }
+    return host_flow_control_->GetPacketsCompletedCallback(handle);
+  }
+
   static constexpr bool kRemoveConnectionAfterwards = true;
   void on_classic_disconnect(uint16_t handle, ErrorCode reason) {
     bool event_also_routes_to_other_receivers = connections.crash_on_unknown_handle_;
@@ -419,6 +450,9 @@ struct classic_impl : public security::ISecurityManagerListener {
           callbacks->OnDisconnection(reason);
         },
         kRemoveConnectionAfterwards);
+    if (host_flow_control_ != nullptr) {
+      host_flow_control_->OnDisconnection(handle);
+    }
     // This handle is probably for SCO, so we use the callback workaround.
     if (non_acl_disconnect_callback_ != nullptr) {
       non_acl_disconnect_callback_(handle, static_cast<uint8_t>(reason));
@@ -743,6 +777,7 @@ struct classic_impl : public security::ISecurityManagerListener {
   HciLayer* hci_layer_ = nullptr;
   Controller* controller_ = nullptr;
   RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  HostFlowControl* host_flow_control_ = nullptr;
   AclConnectionInterface* acl_connection_interface_ = nullptr;
   os::Handler* handler_ = nullptr;
   ConnectionCallbacks* client_callbacks_ = nullptr;
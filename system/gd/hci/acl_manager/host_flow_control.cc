@@ -0,0 +1,82 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/host_flow_control.h"
+
+#include <vector>
+
+#include "common/bind.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+HostFlowControl::HostFlowControl(os::Handler* handler, Controller* controller, HciLayer* hci_layer)
+    : handler_(handler), hci_layer_(hci_layer) {
+  if (!controller->IsSupported(OpCode::HOST_BUFFER_SIZE) ||
+      !controller->IsSupported(OpCode::SET_CONTROLLER_TO_HOST_FLOW_CONTROL) ||
+      !controller->IsSupported(OpCode::HOST_NUM_COMPLETED_PACKETS)) {
+    LOG_INFO("Controller to host flow control is not supported");
+    return;
+  }
+  controller->HostBufferSize(kAclDataPacketLength, 0, kTotalNumAclDataPackets, 0);
+  controller->SetControllerToHostFlowControl(true, false);
+  enabled_ = true;
+}
+
+void HostFlowControl::OnPacketsCompleted(uint16_t handle, uint16_t packets) {
+  if (!enabled_ || packets == 0) {
+    return;
+  }
+  completed_packets_[handle] += packets;
+  if (!send_scheduled_) {
+    send_scheduled_ = true;
+    handler_->Post(common::BindOnce(&HostFlowControl::send_completed_packets, common::Unretained(this)));
+  }
+}
+
+void HostFlowControl::OnDisconnection(uint16_t handle) {
+  completed_packets_.erase(handle);
+}
+
+common::Callback<void(uint16_t)> HostFlowControl::GetPacketsCompletedCallback(uint16_t handle) {
+  if (!enabled_) {
+    return {};
+  }
+  return common::Bind(&HostFlowControl::OnPacketsCompleted, common::Unretained(this), handle);
+}
+
+void HostFlowControl::send_completed_packets() {
+  send_scheduled_ = false;
+  if (completed_packets_.empty()) {
+    return;
+  }
+  std::vector<CompletedPackets> completed_packets;
+  completed_packets.reserve(completed_packets_.size());
+  for (const auto& [handle, packets] : completed_packets_) {
+    CompletedPackets entry;
+    entry.connection_handle_ = handle;
+    entry.host_num_of_completed_packets_ = packets;
+    completed_packets.push_back(entry);
+  }
+  completed_packets_.clear();
+  hci_layer_->SendHostNumCompletedPackets(std::move(completed_packets));
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+
+#include "common/callback.h"
+#include "hci/controller.h"
+#include "hci/hci_layer.h"
+#include "os/handler.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Controller to host flow control for ACL data (BT Core 5.2, Vol 4, Part E, 4.2).
+//
+// The host tells the controller it has buffers for kTotalNumAclDataPackets ACL packets, and returns them with
+// Host_Number_Of_Completed_Packets once the upper layers have taken the data. When they fall behind, the controller
+// stops sending and the remote is held back by the link layer instead of the host dropping PDUs. The buffers are
+// shared by all the connections, so one connection whose upper layer stalls holds back the others once it holds all
+// of them. The controller takes back the buffers of a connection when it disconnects.
+class HostFlowControl {
+ public:
+  // Matches the receive buffers of the HAL
+  static constexpr uint16_t kAclDataPacketLength = 1024;
+  static constexpr uint16_t kTotalNumAclDataPackets = 64;
+
+  // Turns flow control on when the controller supports it
+  HostFlowControl(os::Handler* handler, Controller* controller, HciLayer* hci_layer);
+
+  bool IsEnabled() const {
+    return enabled_;
+  }
+
+  // Returns |packets| ACL packets of |handle| to the controller. The completions of one handler iteration go out in a
+  // single command.
+  void OnPacketsCompleted(uint16_t handle, uint16_t packets);
+
+  // Forgets the packets of |handle| that were not returned yet
+  void OnDisconnection(uint16_t handle);
+
+  // Reports the packets of |handle| to OnPacketsCompleted, empty when flow control is off
+  common::Callback<void(uint16_t)> GetPacketsCompletedCallback(uint16_t handle);
+
+ private:
+  void send_completed_packets();
+
+  os::Handler* handler_;
+  HciLayer* hci_layer_;
+  bool enabled_ = false;
+  std::map<uint16_t, uint16_t> completed_packets_;
+  bool send_scheduled_ = false;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
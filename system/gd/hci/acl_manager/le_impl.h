@@ -29,6 +29,7 @@
 #include "common/init_flags.h"
 #include "crypto_toolbox/crypto_toolbox.h"
 #include "hci/acl_manager/assembler.h"
+#include "hci/acl_manager/host_flow_control.h"
 #include "hci/acl_manager/le_connection_management_callbacks.h"
 #include "hci/acl_manager/round_robin_scheduler.h"
 #include "hci/controller.h"
@@ -85,9 +86,14 @@ inline std::string connectability_state_machine_text(const ConnectabilityState&
 #undef CASE_RETURN_TEXT
 
 struct le_acl_connection {
-  le_acl_connection(AddressWithType remote_address, AclConnection::QueueDownEnd* queue_down_end, os::Handler* handler)
+  le_acl_connection(
+      AddressWithType remote_address,
+      AclConnection::QueueDownEnd* queue_down_end,
+      os::Handler* handler,
+      common::Callback<void(uint16_t)> on_packets_completed)
       : remote_address_(remote_address),
-        assembler_(new acl_manager::assembler(remote_address, queue_down_end, handler)) {}
+        assembler_(
+            new acl_manager::assembler(remote_address, queue_down_end, handler, std::move(on_packets_completed))) {}
   ~le_acl_connection() {
     delete assembler_;
   }
@@ -102,8 +108,12 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
       Controller* controller,
       os::Handler* handler,
       RoundRobinScheduler* round_robin_scheduler,
+      HostFlowControl* host_flow_control,
       bool crash_on_unknown_handle)
-      : hci_layer_(hci_layer), controller_(controller), round_robin_scheduler_(round_robin_scheduler) {
+      : hci_layer_(hci_layer),
+        controller_(controller),
+        round_robin_scheduler_(round_robin_scheduler),
+        host_flow_control_(host_flow_control) {
     hci_layer_ = hci_layer;
     controller_ = controller;
     handler_ = handler;
@@ -200,6 +210,14 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
         ASSERT_LOG(!crash_on_unknown_handle_, "Received command for unknown handle:0x%x", handle);
       if (remove_afterwards) remove(handle);
     }
+    std::map<uint16_t, assembler_stats> get_assembler_stats() const {
+      std::unique_lock<std::mutex> lock(le_acl_connections_guard_);
+      std::map<uint16_t, assembler_stats> stats;
+      for (const auto& [handle, connection] : le_acl_connections_) {
+        stats[handle] = connection.assembler_->get_stats();
+      }
+      return stats;
+    }
     bool send_packet_upward(uint16_t handle, std::function<void(struct acl_manager::assembler* assembler)> cb) {
       std::unique_lock<std::mutex> lock(le_acl_connections_guard_);
       auto connection = le_acl_connections_.find(handle);
@@ -211,12 +229,13 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
         const AddressWithType& remote_address,
         AclConnection::QueueDownEnd* queue_end,
         os::Handler* handler,
+        common::Callback<void(uint16_t)> on_packets_completed,
         LeConnectionManagementCallbacks* le_connection_management_callbacks) {
       std::unique_lock<std::mutex> lock(le_acl_connections_guard_);
       auto emplace_pair = le_acl_connections_.emplace(
           std::piecewise_construct,
           std::forward_as_tuple(handle),
-          std::forward_as_tuple(remote_address, queue_end, handler));
+          std::forward_as_tuple(remote_address, queue_end, handler, std::move(on_packets_completed)));
       ASSERT(emplace_pair.second);  // Make sure the connection is unique
       emplace_pair.first->second.le_connection_management_callbacks_ = le_connection_management_callbacks;
     }
@@ -262,6 +281,10 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     return connections.send_packet_upward(handle, cb);
   }
 
+  std::map<uint16_t, assembler_stats> get_assembler_stats() const {
+    return connections.get_assembler_stats();
+  }
+
   // connection canceled by LeAddressManager.OnPause(), will auto reconnect by LeAddressManager.OnResume()
   void on_le_connection_canceled_on_pause() {
     ASSERT_LOG(pause_connection, "Connection must be paused to ack the le address manager");
@@ -374,9 +397,12 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     connection->supervision_timeout_ = supervision_timeout;
     connection->in_filter_accept_list_ = in_filter_accept_list;
     connections.add(
-        handle, remote_address, queue_down_end, handler_, connection->GetEventCallbacks([this](uint16_t handle) {
-          this->connections.invalidate(handle);
-        }));
+        handle,
+        remote_address,
+        queue_down_end,
+        handler_,
+        get_packets_completed_callback(handle),
+        connection->GetEventCallbacks([this](uint16_t handle) { this->connections.invalidate(handle); }));
     le_client_handler_->Post(common::BindOnce(&LeConnectionCallbacks::OnLeConnectSuccess,
                                               common::Unretained(le_client_callbacks_), remote_address,
                                               std::move(connection)));
@@ -498,14 +524,24 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     connection->peer_resolvable_private_address_ = connection_complete.GetPeerResolvablePrivateAddress();
     connection->in_filter_accept_list_ = in_filter_accept_list;
     connections.add(
-        handle, remote_address, queue_down_end, handler_, connection->GetEventCallbacks([this](uint16_t handle) {
-          this->connections.invalidate(handle);
-        }));
+        handle,
+        remote_address,
+        queue_down_end,
+        handler_,
+        get_packets_completed_callback(handle),
+        connection->GetEventCallbacks([this](uint16_t handle) { this->connections.invalidate(handle); }));
     le_client_handler_->Post(common::BindOnce(&LeConnectionCallbacks::OnLeConnectSuccess,
                                               common::Unretained(le_client_callbacks_), remote_address,
                                               std::move(connection)));
   }
 
+  common::Callback<void(uint16_t)> get_packets_completed_callback(uint16_t handle) {
+    if (host_flow_control_ == nullptr) {
+      return {};
+    }
+    return host_flow_control_->GetPacketsCompletedCallback(handle);
+  }
+
   static constexpr bool kRemoveConnectionAfterwards = true;
   void on_le_disconnect(uint16_t handle, ErrorCode reason) {
     AddressWithType remote_address = connections.getAddressWithType(handle);
@@ -519,6 +555,9 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
         },
         kRemoveConnectionAfterwards);
     connections.crash_on_unknown_handle_ = event_also_routes_to_other_receivers;
+    if (host_flow_control_ != nullptr) {
+      host_flow_control_->OnDisconnection(handle);
+    }
 
     if (background_connections_.count(remote_address) == 1) {
       LOG_INFO("re-add device to connect list");
@@ -1061,6 +1100,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   Controller* controller_ = nullptr;
   os::Handler* handler_ = nullptr;
   RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  HostFlowControl* host_flow_control_ = nullptr;
   LeAddressManager* le_address_manager_ = nullptr;
   LeAclConnectionInterface* le_acl_connection_interface_ = nullptr;
   LeConnectionCallbacks* le_client_callbacks_ = nullptr;
@@ -239,7 +239,7 @@ class LeImplTest : public ::testing::Test {
     round_robin_scheduler_ = new RoundRobinScheduler(handler_, controller_, hci_queue_.GetUpEnd());
     hci_queue_.GetDownEnd()->RegisterDequeue(
         handler_, common::Bind(&LeImplTest::HciDownEndDequeue, common::Unretained(this)));
-    le_impl_ = new le_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, true);
+    le_impl_ = new le_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, nullptr, true);
     le_impl_->handle_register_le_callbacks(&mock_le_connection_callbacks_, handler_);
 
     // Set address policy
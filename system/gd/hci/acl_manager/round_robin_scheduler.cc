@@ -21,50 +21,86 @@ namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
+void RoundRobinScheduler::QueueingDelay::Add(std::chrono::microseconds delay) {
+  uint64_t delay_us = delay.count();
+  count++;
+  total_us += delay_us;
+  max_us = std::max(max_us, delay_us);
+  size_t bucket = 0;
+  for (uint64_t delay_ms = delay_us / 1000; delay_ms != 0 && bucket < kBuckets - 1; delay_ms >>= 1) {
+    bucket++;
+  }
+  histogram[bucket]++;
+}
+
 RoundRobinScheduler::RoundRobinScheduler(
     os::Handler* handler, Controller* controller, common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end)
     : handler_(handler), controller_(controller), hci_queue_end_(hci_queue_end) {
-  max_acl_packet_credits_ = controller_->GetNumAclPacketBuffers();
-  acl_packet_credits_ = max_acl_packet_credits_;
-  hci_mtu_ = controller_->GetAclPacketLength();
+  auto& classic_pool = credit_pools_[ConnectionType::CLASSIC];
+  classic_pool.max_credits_ = controller_->GetNumAclPacketBuffers();
+  classic_pool.credits_ = classic_pool.max_credits_;
+  classic_pool.mtu_ = controller_->GetAclPacketLength();
   LeBufferSize le_buffer_size = controller_->GetLeBufferSize();
-  le_max_acl_packet_credits_ = le_buffer_size.total_num_le_packets_;
-  le_acl_packet_credits_ = le_max_acl_packet_credits_;
-  le_hci_mtu_ = le_buffer_size.le_data_packet_length_;
+  auto& le_pool = credit_pools_[ConnectionType::LE];
+  le_pool.max_credits_ = le_buffer_size.total_num_le_packets_;
+  le_pool.credits_ = le_pool.max_credits_;
+  le_pool.mtu_ = le_buffer_size.le_data_packet_length_;
   controller_->RegisterCompletedAclPacketsCallback(handler->BindOn(this, &RoundRobinScheduler::incoming_acl_credits));
 }
 
 RoundRobinScheduler::~RoundRobinScheduler() {
   unregister_all_connections();
+  if (enqueue_registered_.exchange(false)) {
+    hci_queue_end_->UnregisterEnqueue();
+  }
   controller_->UnregisterCompletedAclPacketsCallback();
 }
 
 void RoundRobinScheduler::Register(ConnectionType connection_type, uint16_t handle,
                                    std::shared_ptr<acl_manager::AclConnection::Queue> queue) {
-  acl_queue_handler acl_queue_handler = {connection_type, std::move(queue), false, 0};
-  acl_queue_handlers_.insert(std::pair<uint16_t, RoundRobinScheduler::acl_queue_handler>(handle, acl_queue_handler));
-  if (fragments_to_send_.size() == 0) {
-    start_round_robin();
+  acl_queue_handler acl_queue_handler;
+  acl_queue_handler.connection_type_ = connection_type;
+  acl_queue_handler.queue_ = std::move(queue);
+  acl_queue_handlers_.emplace(handle, std::move(acl_queue_handler));
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    link_stats_[handle] = LinkStats{
+        .connection_type = connection_type,
+        .weight = kDefaultWeight,
+        .high_priority = false,
+    };
   }
+  start_round_robin();
 }
 
 void RoundRobinScheduler::Unregister(uint16_t handle) {
   ASSERT(acl_queue_handlers_.count(handle) == 1);
-  auto acl_queue_handler = acl_queue_handlers_.find(handle)->second;
+  auto& acl_queue_handler = acl_queue_handlers_.find(handle)->second;
+  auto& credit_pool = credit_pools_[acl_queue_handler.connection_type_];
   // Reclaim outstanding packets
-  if (acl_queue_handler.connection_type_ == ConnectionType::CLASSIC) {
-    acl_packet_credits_ += acl_queue_handler.number_of_sent_packets_;
-  } else {
-    le_acl_packet_credits_ += acl_queue_handler.number_of_sent_packets_;
-  }
+  credit_pool.credits_ += acl_queue_handler.number_of_sent_packets_;
   acl_queue_handler.number_of_sent_packets_ = 0;
+  // The rest of a packet to a link that is gone is of no use to the controller
+  if (!credit_pool.fragments_.empty() && credit_pool.handle_ == handle) {
+    credit_pool.fragments_.clear();
+  }
 
   if (acl_queue_handler.dequeue_is_registered_) {
     acl_queue_handler.dequeue_is_registered_ = false;
     acl_queue_handler.queue_->GetDownEnd()->UnregisterDequeue();
   }
   acl_queue_handlers_.erase(handle);
-  starting_point_ = acl_queue_handlers_.begin();
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    link_stats_.erase(handle);
+  }
+
+  start_round_robin();
+  if (has_fragment_to_send(ConnectionType::CLASSIC) || has_fragment_to_send(ConnectionType::LE)) {
+    send_next_fragment();
+  } else if (enqueue_registered_.exchange(false)) {
+    hci_queue_end_->UnregisterEnqueue();
+  }
 }
 
 void RoundRobinScheduler::SetLinkPriority(uint16_t handle, bool high_priority) {
@@ -74,95 +110,69 @@ void RoundRobinScheduler::SetLinkPriority(uint16_t handle, bool high_priority) {
     return;
   }
   acl_queue_handler->second.high_priority_ = high_priority;
+  acl_queue_handler->second.deficit_ = 0;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  link_stats_[handle].high_priority = high_priority;
+}
+
+void RoundRobinScheduler::SetLinkWeight(uint16_t handle, uint8_t weight) {
+  auto acl_queue_handler = acl_queue_handlers_.find(handle);
+  if (acl_queue_handler == acl_queue_handlers_.end()) {
+    LOG_WARN("handle %d is invalid", handle);
+    return;
+  }
+  weight = std::max(weight, kDefaultWeight);
+  acl_queue_handler->second.weight_ = weight;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  link_stats_[handle].weight = weight;
 }
 
 uint16_t RoundRobinScheduler::GetCredits() {
-  return acl_packet_credits_;
+  return credit_pools_[ConnectionType::CLASSIC].credits_;
 }
 
 uint16_t RoundRobinScheduler::GetLeCredits() {
-  return le_acl_packet_credits_;
+  return credit_pools_[ConnectionType::LE].credits_;
 }
 
-void RoundRobinScheduler::start_round_robin() {
-  if (acl_packet_credits_ == 0 && le_acl_packet_credits_ == 0) {
-    return;
-  }
-  if (!fragments_to_send_.empty()) {
-    auto connection_type = fragments_to_send_.front().first;
-    bool classic_buffer_full = acl_packet_credits_ == 0 && connection_type == ConnectionType::CLASSIC;
-    bool le_buffer_full = le_acl_packet_credits_ == 0 && connection_type == ConnectionType::LE;
-    if (classic_buffer_full || le_buffer_full) {
-      LOG_WARN("Buffer of connection_type %d is full", connection_type);
-      return;
-    }
-    send_next_fragment();
-    return;
-  }
-  if (acl_queue_handlers_.empty()) {
-    LOG_INFO("No any acl connection");
-    return;
-  }
-
-  if (acl_queue_handlers_.size() == 1 || starting_point_ == acl_queue_handlers_.end()) {
-    starting_point_ = acl_queue_handlers_.begin();
-  }
-  size_t count = acl_queue_handlers_.size();
+std::map<uint16_t, RoundRobinScheduler::LinkStats> RoundRobinScheduler::GetLinkStats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return link_stats_;
+}
 
-  for (auto acl_queue_handler = starting_point_; count > 0; count--) {
-    // Prevent registration when credits is zero
-    bool classic_buffer_full =
-        acl_packet_credits_ == 0 && acl_queue_handler->second.connection_type_ == ConnectionType::CLASSIC;
-    bool le_buffer_full =
-        le_acl_packet_credits_ == 0 && acl_queue_handler->second.connection_type_ == ConnectionType::LE;
-    if (!acl_queue_handler->second.dequeue_is_registered_ && !classic_buffer_full && !le_buffer_full) {
-      acl_queue_handler->second.dequeue_is_registered_ = true;
-      acl_queue_handler->second.queue_->GetDownEnd()->RegisterDequeue(
+// Take packets from the connection queues while their pool has credits and they have room to buffer them
+void RoundRobinScheduler::start_round_robin() {
+  for (auto acl_queue_handler = acl_queue_handlers_.begin(); acl_queue_handler != acl_queue_handlers_.end();
+       acl_queue_handler++) {
+    auto& link = acl_queue_handler->second;
+    bool dequeue = credit_pools_[link.connection_type_].credits_ > 0 &&
+                   link.buffered_packets_.size() < kMaxBufferedPacketsPerLink;
+    if (dequeue && !link.dequeue_is_registered_) {
+      link.dequeue_is_registered_ = true;
+      link.queue_->GetDownEnd()->RegisterDequeue(
           handler_, common::Bind(&RoundRobinScheduler::buffer_packet, common::Unretained(this), acl_queue_handler));
-    }
-    acl_queue_handler = std::next(acl_queue_handler);
-    if (acl_queue_handler == acl_queue_handlers_.end()) {
-      acl_queue_handler = acl_queue_handlers_.begin();
+    } else if (!dequeue && link.dequeue_is_registered_) {
+      link.dequeue_is_registered_ = false;
+      link.queue_->GetDownEnd()->UnregisterDequeue();
     }
   }
-
-  starting_point_ = std::next(starting_point_);
 }
 
 void RoundRobinScheduler::buffer_packet(std::map<uint16_t, acl_queue_handler>::iterator acl_queue_handler) {
-  BroadcastFlag broadcast_flag = BroadcastFlag::POINT_TO_POINT;
-  // Wrap packet and enqueue it
-  uint16_t handle = acl_queue_handler->first;
-  auto packet = acl_queue_handler->second.queue_->GetDownEnd()->TryDequeue();
+  auto& link = acl_queue_handler->second;
+  auto packet = link.queue_->GetDownEnd()->TryDequeue();
   ASSERT(packet != nullptr);
-
-  ConnectionType connection_type = acl_queue_handler->second.connection_type_;
-  size_t mtu = connection_type == ConnectionType::CLASSIC ? hci_mtu_ : le_hci_mtu_;
-  PacketBoundaryFlag packet_boundary_flag = (packet->IsFlushable())
-                                                ? PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE
-                                                : PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE;
-
-  int acl_priority = acl_queue_handler->second.high_priority_ ? 1 : 0;
-  if (packet->size() <= mtu) {
-    fragments_to_send_.push(
-        std::make_pair(
-            connection_type, AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(packet))),
-        acl_priority);
-  } else {
-    auto fragments = AclFragmenter(mtu, std::move(packet)).GetFragments();
-    for (size_t i = 0; i < fragments.size(); i++) {
-      fragments_to_send_.push(
-          std::make_pair(
-              connection_type,
-              AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i]))),
-          acl_priority);
-      packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
-    }
+  link.buffered_packets_.push_back(buffered_packet{std::move(packet), std::chrono::steady_clock::now()});
+  // A link that was idle joins the current round with a fresh share, unless it already got one in this round
+  auto& credit_pool = credit_pools_[link.connection_type_];
+  if (link.buffered_packets_.size() == 1 && link.round_ != credit_pool.round_) {
+    link.deficit_ = kQuantumBytes * link.weight_;
+    link.round_ = credit_pool.round_;
+  }
+  if (link.buffered_packets_.size() >= kMaxBufferedPacketsPerLink) {
+    link.dequeue_is_registered_ = false;
+    link.queue_->GetDownEnd()->UnregisterDequeue();
   }
-  ASSERT(fragments_to_send_.size() > 0);
-  unregister_all_connections();
-
-  acl_queue_handler->second.number_of_sent_packets_ += fragments_to_send_.size();
   send_next_fragment();
 }
 
@@ -177,39 +187,149 @@ void RoundRobinScheduler::unregister_all_connections() {
 }
 
 void RoundRobinScheduler::send_next_fragment() {
+  if (!has_fragment_to_send(ConnectionType::CLASSIC) && !has_fragment_to_send(ConnectionType::LE)) {
+    return;
+  }
   if (!enqueue_registered_.exchange(true)) {
     hci_queue_end_->RegisterEnqueue(
         handler_, common::Bind(&RoundRobinScheduler::handle_enqueue_next_fragment, common::Unretained(this)));
   }
 }
 
-// Invoked from some external Queue Reactable context 1
-std::unique_ptr<AclBuilder> RoundRobinScheduler::handle_enqueue_next_fragment() {
-  ConnectionType connection_type = fragments_to_send_.front().first;
-  if (connection_type == ConnectionType::CLASSIC) {
-    ASSERT(acl_packet_credits_ > 0);
-    acl_packet_credits_ -= 1;
-  } else {
-    ASSERT(le_acl_packet_credits_ > 0);
-    le_acl_packet_credits_ -= 1;
+bool RoundRobinScheduler::has_fragment_to_send(ConnectionType connection_type) {
+  const auto& credit_pool = credit_pools_[connection_type];
+  if (credit_pool.credits_ == 0) {
+    return false;
+  }
+  if (!credit_pool.fragments_.empty()) {
+    return true;
+  }
+  for (const auto& [handle, link] : acl_queue_handlers_) {
+    if (link.connection_type_ == connection_type && !link.buffered_packets_.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::map<uint16_t, RoundRobinScheduler::acl_queue_handler>::iterator RoundRobinScheduler::pick_oldest_packet(
+    ConnectionType connection_type, bool high_priority, bool check_deficit) {
+  auto oldest = acl_queue_handlers_.end();
+  for (auto acl_queue_handler = acl_queue_handlers_.begin(); acl_queue_handler != acl_queue_handlers_.end();
+       acl_queue_handler++) {
+    const auto& link = acl_queue_handler->second;
+    if (link.connection_type_ != connection_type || link.high_priority_ != high_priority ||
+        link.buffered_packets_.empty()) {
+      continue;
+    }
+    const auto& packet = link.buffered_packets_.front();
+    if (check_deficit && link.deficit_ < packet.packet_->size()) {
+      continue;
+    }
+    if (oldest == acl_queue_handlers_.end() ||
+        packet.buffered_time_ < oldest->second.buffered_packets_.front().buffered_time_) {
+      oldest = acl_queue_handler;
+    }
   }
+  return oldest;
+}
 
-  auto raw_pointer = fragments_to_send_.front().second.release();
-  fragments_to_send_.pop();
-  if (fragments_to_send_.empty()) {
-    if (enqueue_registered_.exchange(false)) {
-      hci_queue_end_->UnregisterEnqueue();
+// Move the next packet of the pool from its link to the fragments to send
+bool RoundRobinScheduler::pick_next_packet(ConnectionType connection_type) {
+  auto acl_queue_handler = pick_oldest_packet(connection_type, true, false);
+  if (acl_queue_handler == acl_queue_handlers_.end()) {
+    if (pick_oldest_packet(connection_type, false, false) == acl_queue_handlers_.end()) {
+      return false;
     }
-    handler_->Post(common::BindOnce(&RoundRobinScheduler::start_round_robin, common::Unretained(this)));
+    while ((acl_queue_handler = pick_oldest_packet(connection_type, false, true)) == acl_queue_handlers_.end()) {
+      // Every link with a packet waiting is out of deficit: start a new round. A link with nothing to send doesn't
+      // save its share for later.
+      auto& credit_pool = credit_pools_[connection_type];
+      credit_pool.round_++;
+      for (auto& [handle, link] : acl_queue_handlers_) {
+        if (link.connection_type_ != connection_type || link.high_priority_) {
+          continue;
+        }
+        if (link.buffered_packets_.empty()) {
+          link.deficit_ = 0;
+        } else {
+          link.deficit_ += kQuantumBytes * link.weight_;
+          link.round_ = credit_pool.round_;
+        }
+      }
+    }
+    acl_queue_handler->second.deficit_ -= acl_queue_handler->second.buffered_packets_.front().packet_->size();
+  }
+
+  uint16_t handle = acl_queue_handler->first;
+  auto& link = acl_queue_handler->second;
+  auto packet = std::move(link.buffered_packets_.front());
+  link.buffered_packets_.pop_front();
+
+  auto& credit_pool = credit_pools_[connection_type];
+  credit_pool.handle_ = handle;
+  credit_pool.packet_size_ = packet.packet_->size();
+  credit_pool.buffered_time_ = packet.buffered_time_;
+  credit_pool.started_ = false;
+
+  BroadcastFlag broadcast_flag = BroadcastFlag::POINT_TO_POINT;
+  PacketBoundaryFlag packet_boundary_flag = (packet.packet_->IsFlushable())
+                                                ? PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE
+                                                : PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE;
+  if (packet.packet_->size() <= credit_pool.mtu_) {
+    credit_pool.fragments_.push_back(
+        AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(packet.packet_)));
   } else {
-    ConnectionType next_connection_type = fragments_to_send_.front().first;
-    bool classic_buffer_full = next_connection_type == ConnectionType::CLASSIC && acl_packet_credits_ == 0;
-    bool le_buffer_full = next_connection_type == ConnectionType::LE && le_acl_packet_credits_ == 0;
-    if ((classic_buffer_full || le_buffer_full) && enqueue_registered_.exchange(false)) {
-      hci_queue_end_->UnregisterEnqueue();
+    auto fragments = AclFragmenter(credit_pool.mtu_, std::move(packet.packet_)).GetFragments();
+    for (size_t i = 0; i < fragments.size(); i++) {
+      credit_pool.fragments_.push_back(
+          AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i])));
+      packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
     }
   }
-  return std::unique_ptr<AclBuilder>(raw_pointer);
+  ASSERT(!credit_pool.fragments_.empty());
+  return true;
+}
+
+// Invoked from some external Queue Reactable context 1
+std::unique_ptr<AclBuilder> RoundRobinScheduler::handle_enqueue_next_fragment() {
+  // Of the pools with credits, the one whose packet waited the longest goes first
+  credit_pool* next_pool = nullptr;
+  for (auto connection_type : {ConnectionType::CLASSIC, ConnectionType::LE}) {
+    auto& credit_pool = credit_pools_[connection_type];
+    if (credit_pool.credits_ == 0 || (credit_pool.fragments_.empty() && !pick_next_packet(connection_type))) {
+      continue;
+    }
+    if (next_pool == nullptr || credit_pool.buffered_time_ < next_pool->buffered_time_) {
+      next_pool = &credit_pool;
+    }
+  }
+  ASSERT(next_pool != nullptr);
+
+  auto fragment = std::move(next_pool->fragments_.front());
+  next_pool->fragments_.pop_front();
+  next_pool->credits_ -= 1;
+  auto acl_queue_handler = acl_queue_handlers_.find(next_pool->handle_);
+  ASSERT(acl_queue_handler != acl_queue_handlers_.end());
+  acl_queue_handler->second.number_of_sent_packets_ += 1;
+
+  if (!next_pool->started_) {
+    next_pool->started_ = true;
+    auto delay = std::chrono::steady_clock::now() - next_pool->buffered_time_;
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    auto& link_stats = link_stats_[next_pool->handle_];
+    link_stats.packets++;
+    link_stats.bytes += next_pool->packet_size_;
+    link_stats.queueing_delay.Add(std::chrono::duration_cast<std::chrono::microseconds>(delay));
+  }
+
+  // A link may have room for another packet now, or the pool may have run out of credits
+  start_round_robin();
+  if (!has_fragment_to_send(ConnectionType::CLASSIC) && !has_fragment_to_send(ConnectionType::LE) &&
+      enqueue_registered_.exchange(false)) {
+    hci_queue_end_->UnregisterEnqueue();
+  }
+  return fragment;
 }
 
 void RoundRobinScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits) {
@@ -225,28 +345,19 @@ void RoundRobinScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits
     acl_queue_handler->second.number_of_sent_packets_ = 0;
   }
 
-  bool credit_was_zero = false;
-  if (acl_queue_handler->second.connection_type_ == ConnectionType::CLASSIC) {
-    if (acl_packet_credits_ == 0) {
-      credit_was_zero = true;
-    }
-    acl_packet_credits_ += credits;
-    if (acl_packet_credits_ > max_acl_packet_credits_) {
-      acl_packet_credits_ = max_acl_packet_credits_;
-      LOG_WARN("acl packet credits overflow due to receive %hx credits", credits);
-    }
-  } else {
-    if (le_acl_packet_credits_ == 0) {
-      credit_was_zero = true;
-    }
-    le_acl_packet_credits_ += credits;
-    if (le_acl_packet_credits_ > le_max_acl_packet_credits_) {
-      le_acl_packet_credits_ = le_max_acl_packet_credits_;
-      LOG_WARN("le acl packet credits overflow due to receive %hx credits", credits);
-    }
+  auto& credit_pool = credit_pools_[acl_queue_handler->second.connection_type_];
+  bool credit_was_zero = credit_pool.credits_ == 0;
+  credit_pool.credits_ += credits;
+  if (credit_pool.credits_ > credit_pool.max_credits_) {
+    credit_pool.credits_ = credit_pool.max_credits_;
+    LOG_WARN(
+        "%s acl packet credits overflow due to receive %hx credits",
+        acl_queue_handler->second.connection_type_ == ConnectionType::CLASSIC ? "classic" : "le",
+        credits);
   }
   if (credit_was_zero) {
     start_round_robin();
+    send_next_fragment();
   }
 }
 
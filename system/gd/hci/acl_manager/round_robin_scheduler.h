@@ -18,8 +18,13 @@
 
 #include <stdint.h>
 
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+
 #include "common/bidi_queue.h"
-#include "common/multi_priority_queue.h"
 #include "hci/acl_manager.h"
 #include "hci/controller.h"
 #include "hci/hci_packets.h"
@@ -29,6 +34,13 @@ namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
+// Shares the controller ACL buffers between the connections.
+//
+// BR/EDR and LE links draw from separate credit pools, so one pool running dry never holds back the other. Within a
+// pool, high priority links (A2DP) are served first, and the other links share the credits by deficit round robin:
+// every round a link may send kQuantumBytes times its weight of L2CAP payload, so a link of weight 2 gets twice the
+// bandwidth of a link of weight 1 no matter how large its packets are. Among the links that still have deficit left,
+// the oldest packet goes first. The fragments of a packet are always sent back to back.
 class RoundRobinScheduler {
  public:
   RoundRobinScheduler(
@@ -37,45 +49,99 @@ class RoundRobinScheduler {
 
   enum ConnectionType { CLASSIC, LE };
 
+  // Bytes a link of weight 1 may send per round
+  static constexpr size_t kQuantumBytes = 1024;
+  static constexpr uint8_t kDefaultWeight = 1;
+  // Packets taken from a connection queue before they are scheduled
+  static constexpr size_t kMaxBufferedPacketsPerLink = 2;
+
+  // Time from a packet leaving its connection queue to its first fragment going to the controller. Bucket 0 counts
+  // delays under 1ms, bucket i those in [2^(i-1), 2^i) ms, and the last bucket everything above.
+  struct QueueingDelay {
+    static constexpr size_t kBuckets = 12;
+
+    void Add(std::chrono::microseconds delay);
+
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+    std::array<uint64_t, kBuckets> histogram{};
+  };
+
+  struct LinkStats {
+    ConnectionType connection_type;
+    uint8_t weight;
+    bool high_priority;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    QueueingDelay queueing_delay;
+  };
+
+  struct buffered_packet {
+    std::unique_ptr<packet::BasePacketBuilder> packet_;
+    std::chrono::steady_clock::time_point buffered_time_;
+  };
+
   struct acl_queue_handler {
     ConnectionType connection_type_;
     std::shared_ptr<acl_manager::AclConnection::Queue> queue_;
     bool dequeue_is_registered_ = false;
     uint16_t number_of_sent_packets_ = 0;  // Track credits
     bool high_priority_ = false;           // For A2dp use
+    uint8_t weight_ = kDefaultWeight;
+    size_t deficit_ = 0;  // Bytes left to send in this round
+    uint64_t round_ = 0;  // Last round the link was given its share in
+    std::deque<buffered_packet> buffered_packets_;
   };
 
   void Register(ConnectionType connection_type, uint16_t handle,
                 std::shared_ptr<acl_manager::AclConnection::Queue> queue);
   void Unregister(uint16_t handle);
   void SetLinkPriority(uint16_t handle, bool high_priority);
+  // Share of the bandwidth of |handle| relative to the other links of its pool. A weight of 0 is treated as 1.
+  void SetLinkWeight(uint16_t handle, uint8_t weight);
   uint16_t GetCredits();
   uint16_t GetLeCredits();
+  // Safe to call from any thread
+  std::map<uint16_t, LinkStats> GetLinkStats() const;
 
  private:
+  struct credit_pool {
+    uint16_t max_credits_ = 0;
+    uint16_t credits_ = 0;
+    size_t mtu_ = 0;
+    // The packet being sent
+    std::deque<std::unique_ptr<AclBuilder>> fragments_;
+    uint16_t handle_ = 0;
+    size_t packet_size_ = 0;
+    std::chrono::steady_clock::time_point buffered_time_;
+    bool started_ = false;
+    // Deficit round robin rounds started so far
+    uint64_t round_ = 1;
+  };
+
   void start_round_robin();
   void buffer_packet(std::map<uint16_t, acl_queue_handler>::iterator acl_queue_handler);
   void unregister_all_connections();
   void send_next_fragment();
+  bool has_fragment_to_send(ConnectionType connection_type);
+  bool pick_next_packet(ConnectionType connection_type);
+  std::map<uint16_t, acl_queue_handler>::iterator pick_oldest_packet(
+      ConnectionType connection_type, bool high_priority, bool check_deficit);
   std::unique_ptr<AclBuilder> handle_enqueue_next_fragment();
   void incoming_acl_credits(uint16_t handle, uint16_t credits);
 
   os::Handler* handler_ = nullptr;
   Controller* controller_ = nullptr;
   std::map<uint16_t, acl_queue_handler> acl_queue_handlers_;
-  common::MultiPriorityQueue<std::pair<ConnectionType, std::unique_ptr<AclBuilder>>, 2> fragments_to_send_;
-  uint16_t max_acl_packet_credits_ = 0;
-  uint16_t acl_packet_credits_ = 0;
-  uint16_t le_max_acl_packet_credits_ = 0;
-  uint16_t le_acl_packet_credits_ = 0;
-  size_t hci_mtu_{0};
-  size_t le_hci_mtu_{0};
+  std::array<credit_pool, 2> credit_pools_;
   std::atomic_bool enqueue_registered_ = false;
   common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end_ = nullptr;
-  // first register queue end for the Round-robin schedule
-  std::map<uint16_t, acl_queue_handler>::iterator starting_point_;
+
+  mutable std::mutex stats_mutex_;
+  std::map<uint16_t, LinkStats> link_stats_;
 };
 
 }  // namespace acl_manager
 }  // namespace hci
-}  // namespace bluetooth
\ No newline at end of file
+}  // namespace bluetooth
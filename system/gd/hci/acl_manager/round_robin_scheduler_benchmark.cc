@@ -0,0 +1,226 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "hci/acl_manager.h"
+#include "hci/acl_manager/round_robin_scheduler.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+namespace {
+
+constexpr uint16_t kAclCredits = 10;
+constexpr uint16_t kAclMtu = 1021;
+constexpr size_t kPacketsPerIteration = 1000;
+
+class BenchmarkController : public Controller {
+ public:
+  uint16_t GetNumAclPacketBuffers() const {
+    return kAclCredits;
+  }
+
+  uint16_t GetAclPacketLength() const {
+    return kAclMtu;
+  }
+
+  LeBufferSize GetLeBufferSize() const {
+    LeBufferSize le_buffer_size;
+    le_buffer_size.le_data_packet_length_ = 27;
+    le_buffer_size.total_num_le_packets_ = kAclCredits;
+    return le_buffer_size;
+  }
+
+  void RegisterCompletedAclPacketsCallback(CompletedAclPacketsCallback cb) {
+    acl_credits_callback_ = cb;
+  }
+
+  void SendCompletedAclPacketsCallback(uint16_t handle, uint16_t credits) {
+    acl_credits_callback_.Invoke(handle, credits);
+  }
+
+  void UnregisterCompletedAclPacketsCallback() {
+    acl_credits_callback_ = {};
+  }
+
+ private:
+  CompletedAclPacketsCallback acl_credits_callback_;
+};
+
+// A BR/EDR link whose connection queue never runs dry
+struct Link {
+  std::string name;
+  uint8_t weight;
+  size_t packet_size;
+  std::shared_ptr<AclConnection::Queue> queue = std::make_shared<AclConnection::Queue>(10);
+  uint64_t bytes_sent = 0;
+};
+
+// Every link is backlogged and the controller completes packets as soon as it gets them, so the share of the bytes
+// each link gets is decided by the scheduler alone
+class SchedulerBench {
+ public:
+  explicit SchedulerBench(std::vector<Link>* links) : links_(links) {
+    scheduler_ = std::make_unique<RoundRobinScheduler>(&handler_, &controller_, hci_queue_.GetUpEnd());
+    hci_queue_.GetDownEnd()->RegisterDequeue(
+        &handler_, common::Bind(&SchedulerBench::OnAclPacket, common::Unretained(this)));
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_.Post(common::BindOnce(&SchedulerBench::RegisterLinks, common::Unretained(this), &promise));
+    future.wait();
+  }
+
+  ~SchedulerBench() {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_.Post(common::BindOnce(&SchedulerBench::UnregisterLinks, common::Unretained(this), &promise));
+    future.wait();
+    hci_queue_.GetDownEnd()->UnregisterDequeue();
+    scheduler_.reset();
+    handler_.Clear();
+  }
+
+  // Wait for |count| more packets to reach the controller
+  void SendPackets(size_t count) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_.Post(common::BindOnce(&SchedulerBench::WaitForPackets, common::Unretained(this), count, &promise));
+    future.wait();
+  }
+
+  std::map<uint16_t, RoundRobinScheduler::LinkStats> GetLinkStats() const {
+    return scheduler_->GetLinkStats();
+  }
+
+ private:
+  void RegisterLinks(std::promise<void>* promise) {
+    for (size_t i = 0; i < links_->size(); i++) {
+      Link& link = (*links_)[i];
+      scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, i + 1, link.queue);
+      scheduler_->SetLinkWeight(i + 1, link.weight);
+      link.queue->GetUpEnd()->RegisterEnqueue(
+          &handler_, common::Bind(&SchedulerBench::MakePacket, common::Unretained(this), link.packet_size));
+    }
+    promise->set_value();
+  }
+
+  void UnregisterLinks(std::promise<void>* promise) {
+    for (size_t i = 0; i < links_->size(); i++) {
+      (*links_)[i].queue->GetUpEnd()->UnregisterEnqueue();
+      scheduler_->Unregister(i + 1);
+    }
+    promise->set_value();
+  }
+
+  void WaitForPackets(size_t count, std::promise<void>* promise) {
+    packets_left_ = count;
+    promise_ = promise;
+  }
+
+  std::unique_ptr<packet::BasePacketBuilder> MakePacket(size_t size) {
+    auto packet = std::make_unique<packet::RawBuilder>(size);
+    packet->AddOctets(std::vector<uint8_t>(size));
+    return packet;
+  }
+
+  void OnAclPacket() {
+    auto packet = hci_queue_.GetDownEnd()->TryDequeue();
+    std::vector<uint8_t> bytes;
+    bytes.reserve(packet->size());
+    packet::BitInserter it(bytes);
+    packet->Serialize(it);
+    uint16_t handle = (bytes[0] | (bytes[1] << 8)) & 0x0fff;
+    (*links_)[handle - 1].bytes_sent += bytes.size() - 4;
+    controller_.SendCompletedAclPacketsCallback(handle, 1);
+
+    if (promise_ != nullptr && --packets_left_ == 0) {
+      promise_->set_value();
+      promise_ = nullptr;
+    }
+  }
+
+  std::vector<Link>* links_;
+  os::Thread thread_{"scheduler_benchmark", os::Thread::Priority::NORMAL};
+  os::Handler handler_{&thread_};
+  BenchmarkController controller_;
+  common::BidiQueue<AclView, AclBuilder> hci_queue_{3};
+  std::unique_ptr<RoundRobinScheduler> scheduler_;
+  size_t packets_left_ = 0;
+  std::promise<void>* promise_ = nullptr;
+};
+
+// Bulk transfer, A2DP and HID sharing the BR/EDR buffers. With equal weights every link should get the same number of
+// bytes whatever the size of its packets; with weights 1:4:2 the bytes should follow the weights.
+std::vector<Link> MakeLinks(bool weighted) {
+  return std::vector<Link>{
+      {.name = "bulk", .weight = 1, .packet_size = 1017},
+      {.name = "a2dp", .weight = static_cast<uint8_t>(weighted ? 4 : 1), .packet_size = 660},
+      {.name = "hid", .weight = static_cast<uint8_t>(weighted ? 2 : 1), .packet_size = 20},
+  };
+}
+
+void BM_SchedulerFairness(State& state) {
+  std::vector<Link> links = MakeLinks(state.range(0));
+  {
+    SchedulerBench bench(&links);
+    for (auto _ : state) {
+      bench.SendPackets(kPacketsPerIteration);
+    }
+    for (const auto& [handle, stats] : bench.GetLinkStats()) {
+      const Link& link = links[handle - 1];
+      state.counters[link.name + "_avg_delay_us"] =
+          stats.queueing_delay.count == 0 ? 0 : stats.queueing_delay.total_us / stats.queueing_delay.count;
+    }
+  }
+
+  // Jain's fairness index of the bytes each link got per unit of weight, 1 when perfectly fair
+  double sum = 0;
+  double sum_of_squares = 0;
+  uint64_t total_bytes = 0;
+  for (const auto& link : links) {
+    double normalized = static_cast<double>(link.bytes_sent) / link.weight;
+    sum += normalized;
+    sum_of_squares += normalized * normalized;
+    total_bytes += link.bytes_sent;
+  }
+  for (const auto& link : links) {
+    state.counters[link.name + "_byte_share"] = static_cast<double>(link.bytes_sent) / total_bytes;
+  }
+  state.counters["jain_index"] = sum * sum / (links.size() * sum_of_squares);
+  state.SetItemsProcessed(state.iterations() * kPacketsPerIteration);
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_SchedulerFairness)->ArgName("weighted")->Arg(0)->Arg(1)->UseRealTime();
+
+}  // namespace
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
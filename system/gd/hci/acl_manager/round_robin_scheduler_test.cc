@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+#include <vector>
+
 #include "common/bidi_queue.h"
 #include "common/callback.h"
 #include "hci/acl_manager.h"
@@ -90,6 +93,7 @@ class RoundRobinSchedulerTest : public ::testing::Test {
     delete round_robin_scheduler_;
     delete controller_;
     handler_->Clear();
+    handler_->WaitUntilStopped(std::chrono::milliseconds(2000));
     delete handler_;
     delete thread_;
   }
@@ -121,15 +125,18 @@ class RoundRobinSchedulerTest : public ::testing::Test {
     return packet_one;
   };
 
-  void HciDownEndDequeue() {
-    auto packet = hci_queue_.GetDownEnd()->TryDequeue();
+  static AclView ToView(std::unique_ptr<AclBuilder> packet) {
     // Convert from a Builder to a View
     auto bytes = std::make_shared<std::vector<uint8_t>>();
     bluetooth::packet::BitInserter i(*bytes);
     bytes->reserve(packet->size());
     packet->Serialize(i);
     auto packet_view = bluetooth::packet::PacketView<bluetooth::packet::kLittleEndian>(bytes);
-    AclView acl_packet_view = AclView::Create(packet_view);
+    return AclView::Create(packet_view);
+  }
+
+  void HciDownEndDequeue() {
+    AclView acl_packet_view = ToView(hci_queue_.GetDownEnd()->TryDequeue());
     ASSERT_TRUE(acl_packet_view.IsValid());
     PacketView<true> count_view = acl_packet_view.GetPayload();
     sent_acl_packets_.push(acl_packet_view);
@@ -158,7 +165,59 @@ class RoundRobinSchedulerTest : public ::testing::Test {
     packet_future_ = std::make_unique<std::future<void>>(packet_promise_->get_future());
   }
 
-  BidiQueue<AclView, AclBuilder> hci_queue_{3};
+  void WaitForIdle() {
+    ASSERT_TRUE(thread_->GetReactor()->WaitForIdle(std::chrono::seconds(2)));
+  }
+
+  // Stop taking fragments from the HCI queue, and fill it up with |kHciQueueCapacity| LE packets. From then on the
+  // scheduler picks a classic packet only when DequeueFragment() makes room, once every link has buffered all it can,
+  // so the order of the fragments no longer depends on thread timing
+  void HoldHciQueue() {
+    hci_queue_.GetDownEnd()->UnregisterDequeue();
+    auto le_connection_queue = std::make_shared<AclConnection::Queue>(kHciQueueCapacity);
+    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::LE, kFillerHandle, le_connection_queue);
+    for (size_t i = 0; i < kHciQueueCapacity; i++) {
+      EnqueueAclUpEnd(le_connection_queue->GetUpEnd(), {0x0f});
+    }
+    enqueue_future_->wait();
+    WaitForIdle();
+  }
+
+  // Take the oldest fragment out of the full HCI queue and give its credit back
+  AclView DequeueFragment() {
+    auto packet = hci_queue_.GetDownEnd()->TryDequeue();
+    if (packet == nullptr) {
+      ADD_FAILURE() << "HCI queue is empty";
+      return AclView::Create(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>()));
+    }
+    AclView acl_packet_view = ToView(std::move(packet));
+    EXPECT_TRUE(acl_packet_view.IsValid());
+    controller_->SendCompletedAclPacketsCallback(acl_packet_view.GetHandle(), 1);
+    WaitForIdle();
+    return acl_packet_view;
+  }
+
+  // Skip the LE packets HoldHciQueue() put in the HCI queue
+  void DequeueFillerFragments() {
+    for (size_t i = 0; i < kHciQueueCapacity; i++) {
+      ASSERT_EQ(DequeueFragment().GetHandle(), kFillerHandle);
+    }
+  }
+
+  // Drop what is left in the HCI queue and take fragments as they come again
+  void ReleaseHciQueue() {
+    round_robin_scheduler_->Unregister(kFillerHandle);
+    WaitForIdle();
+    while (hci_queue_.GetDownEnd()->TryDequeue() != nullptr) {
+    }
+    hci_queue_.GetDownEnd()->RegisterDequeue(
+        handler_, common::Bind(&RoundRobinSchedulerTest::HciDownEndDequeue, common::Unretained(this)));
+  }
+
+  static constexpr size_t kHciQueueCapacity = 3;
+  static constexpr uint16_t kFillerHandle = 0x0f;
+
+  BidiQueue<AclView, AclBuilder> hci_queue_{kHciQueueCapacity};
   Thread* thread_;
   Handler* handler_;
   TestController* controller_;
@@ -410,6 +469,181 @@ TEST_F(RoundRobinSchedulerTest, receive_le_credit_when_next_fragment_is_classic)
   round_robin_scheduler_->Unregister(le_handle);
 }
 
+TEST_F(RoundRobinSchedulerTest, link_stats) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+  round_robin_scheduler_->SetLinkWeight(handle, 3);
+
+  SetPacketFuture(3);
+  AclConnection::QueueUpEnd* queue_up_end = connection_queue->GetUpEnd();
+  std::vector<uint8_t> packet = {0x01, 0x02, 0x03};
+  std::vector<uint8_t> huge_packet(controller_->hci_mtu_ + 1);
+  EnqueueAclUpEnd(queue_up_end, packet);
+  EnqueueAclUpEnd(queue_up_end, huge_packet);
+  packet_future_->wait();
+
+  auto link_stats = round_robin_scheduler_->GetLinkStats();
+  ASSERT_EQ(link_stats.count(handle), 1u);
+  const auto& stats = link_stats[handle];
+  ASSERT_EQ(stats.connection_type, RoundRobinScheduler::ConnectionType::CLASSIC);
+  ASSERT_EQ(stats.weight, 3);
+  ASSERT_FALSE(stats.high_priority);
+  ASSERT_EQ(stats.packets, 2u);
+  ASSERT_EQ(stats.bytes, packet.size() + huge_packet.size());
+  ASSERT_EQ(stats.queueing_delay.count, 2u);
+  ASSERT_EQ(round_robin_scheduler_->GetCredits(), controller_->max_acl_packet_credits_ - 3);
+
+  round_robin_scheduler_->Unregister(handle);
+  ASSERT_EQ(round_robin_scheduler_->GetLinkStats().count(handle), 0u);
+}
+
+TEST_F(RoundRobinSchedulerTest, weighted_links_share_the_credits) {
+  uint16_t handle1 = 0x01;
+  uint16_t handle2 = 0x02;
+  auto connection_queue1 = std::make_shared<AclConnection::Queue>(20);
+  auto connection_queue2 = std::make_shared<AclConnection::Queue>(20);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle1, connection_queue1);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle2, connection_queue2);
+  round_robin_scheduler_->SetLinkWeight(handle2, 2);
+  HoldHciQueue();
+
+  // Half a quantum per packet: two packets per round for the link of weight 1, and four for the link of weight 2
+  std::vector<uint8_t> packet(RoundRobinScheduler::kQuantumBytes / 2);
+  for (int i = 0; i < 20; i++) {
+    EnqueueAclUpEnd(connection_queue1->GetUpEnd(), packet);
+  }
+  enqueue_future_->wait();
+  WaitForIdle();
+  for (int i = 0; i < 20; i++) {
+    EnqueueAclUpEnd(connection_queue2->GetUpEnd(), packet);
+  }
+  enqueue_future_->wait();
+  WaitForIdle();
+
+  DequeueFillerFragments();
+  std::vector<uint16_t> handles;
+  std::map<uint16_t, size_t> bytes;
+  for (int i = 0; i < 18; i++) {
+    auto acl_packet_view = DequeueFragment();
+    handles.push_back(acl_packet_view.GetHandle());
+    bytes[acl_packet_view.GetHandle()] += acl_packet_view.GetPayload().size();
+  }
+  std::vector<uint16_t> expected_handles;
+  for (int round = 0; round < 3; round++) {
+    expected_handles.insert(expected_handles.end(), {handle1, handle1, handle2, handle2, handle2, handle2});
+  }
+  ASSERT_EQ(handles, expected_handles);
+  ASSERT_EQ(bytes[handle2], 2 * bytes[handle1]);
+
+  round_robin_scheduler_->Unregister(handle1);
+  round_robin_scheduler_->Unregister(handle2);
+  ReleaseHciQueue();
+}
+
+TEST_F(RoundRobinSchedulerTest, links_share_bytes_not_packets) {
+  uint16_t handle1 = 0x01;
+  uint16_t handle2 = 0x02;
+  auto connection_queue1 = std::make_shared<AclConnection::Queue>(10);
+  auto connection_queue2 = std::make_shared<AclConnection::Queue>(60);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle1, connection_queue1);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle2, connection_queue2);
+  HoldHciQueue();
+
+  // Packets of two fragments that take two rounds of deficit, against packets ten times smaller than a quantum
+  std::vector<uint8_t> large_packet(2000, 0x01);
+  std::vector<uint8_t> small_packet(100, 0x02);
+  for (int i = 0; i < 10; i++) {
+    EnqueueAclUpEnd(connection_queue1->GetUpEnd(), large_packet);
+  }
+  enqueue_future_->wait();
+  WaitForIdle();
+  for (int i = 0; i < 60; i++) {
+    EnqueueAclUpEnd(connection_queue2->GetUpEnd(), small_packet);
+  }
+  enqueue_future_->wait();
+  WaitForIdle();
+
+  DequeueFillerFragments();
+  std::vector<uint16_t> handles;
+  std::map<uint16_t, size_t> bytes;
+  for (int i = 0; i < 44; i++) {
+    auto acl_packet_view = DequeueFragment();
+    handles.push_back(acl_packet_view.GetHandle());
+    bytes[acl_packet_view.GetHandle()] += acl_packet_view.GetPayload().size();
+  }
+  // A large packet goes every other round, its two fragments back to back, and ten small packets go every round
+  std::vector<uint16_t> expected_handles;
+  for (int round = 1; round <= 4; round++) {
+    if (round % 2 == 0) {
+      expected_handles.insert(expected_handles.end(), {handle1, handle1});
+    }
+    expected_handles.insert(expected_handles.end(), 10, handle2);
+  }
+  ASSERT_EQ(handles, expected_handles);
+  ASSERT_EQ(bytes[handle1], 2 * large_packet.size());
+  ASSERT_EQ(bytes[handle2], bytes[handle1]);
+
+  round_robin_scheduler_->Unregister(handle1);
+  round_robin_scheduler_->Unregister(handle2);
+  ReleaseHciQueue();
+}
+
+TEST_F(RoundRobinSchedulerTest, pools_have_separate_credits) {
+  uint16_t handle = 0x01;
+  uint16_t le_handle = 0x02;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  auto le_connection_queue = std::make_shared<AclConnection::Queue>(20);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+  round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::LE, le_handle, le_connection_queue);
+
+  // Use up every LE credit, with more LE packets waiting
+  SetPacketFuture(controller_->le_max_acl_packet_credits_);
+  std::vector<uint8_t> le_packet = {0x04, 0x05, 0x06};
+  for (uint16_t i = 0; i < controller_->le_max_acl_packet_credits_ + 2; i++) {
+    EnqueueAclUpEnd(le_connection_queue->GetUpEnd(), le_packet);
+  }
+  packet_future_->wait();
+  enqueue_future_->wait();
+  WaitForIdle();
+  ASSERT_EQ(round_robin_scheduler_->GetLeCredits(), 0);
+
+  // Classic packets still go out, and only take classic credits
+  SetPacketFuture(3);
+  std::vector<uint8_t> packet = {0x01, 0x02, 0x03};
+  for (int i = 0; i < 3; i++) {
+    EnqueueAclUpEnd(connection_queue->GetUpEnd(), packet);
+  }
+  packet_future_->wait();
+  WaitForIdle();
+  ASSERT_EQ(round_robin_scheduler_->GetCredits(), controller_->max_acl_packet_credits_ - 3);
+  ASSERT_EQ(round_robin_scheduler_->GetLeCredits(), 0);
+
+  // Classic credits coming back don't release LE packets
+  controller_->SendCompletedAclPacketsCallback(handle, 3);
+  WaitForIdle();
+  ASSERT_EQ(round_robin_scheduler_->GetCredits(), controller_->max_acl_packet_credits_);
+  ASSERT_EQ(round_robin_scheduler_->GetLeCredits(), 0);
+  for (uint16_t i = 0; i < controller_->le_max_acl_packet_credits_; i++) {
+    VerifyPacket(le_handle, le_packet);
+  }
+  for (int i = 0; i < 3; i++) {
+    VerifyPacket(handle, packet);
+  }
+  ASSERT_TRUE(sent_acl_packets_.empty());
+
+  // An LE credit releases one LE packet
+  SetPacketFuture(1);
+  controller_->SendCompletedAclPacketsCallback(le_handle, 1);
+  packet_future_->wait();
+  WaitForIdle();
+  VerifyPacket(le_handle, le_packet);
+  ASSERT_EQ(round_robin_scheduler_->GetLeCredits(), 0);
+
+  round_robin_scheduler_->Unregister(handle);
+  round_robin_scheduler_->Unregister(le_handle);
+}
+
 }  // namespace acl_manager
 }  // namespace hci
 }  // namespace bluetooth
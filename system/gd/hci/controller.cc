@@ -537,6 +537,15 @@ struct Controller::impl {
                                                 this, &Controller::impl::check_status<HostBufferSizeCompleteView>));
   }
 
+  void set_controller_to_host_flow_control(bool acl, bool synchronous) {
+    std::unique_ptr<SetControllerToHostFlowControlBuilder> packet =
+        SetControllerToHostFlowControlBuilder::Create(acl ? 1 : 0, synchronous ? 1 : 0);
+    hci_->EnqueueCommand(
+        std::move(packet),
+        module_.GetHandler()->BindOnceOn(
+            this, &Controller::impl::check_status<SetControllerToHostFlowControlCompleteView>));
+  }
+
   void le_set_event_mask(uint64_t le_event_mask) {
     std::unique_ptr<LeSetEventMaskBuilder> packet = LeSetEventMaskBuilder::Create(le_event_mask);
     hci_->EnqueueCommand(
@@ -1107,6 +1116,10 @@ void Controller::HostBufferSize(uint16_t host_acl_data_packet_length, uint8_t ho
       host_total_num_synchronous_data_packets);
 }
 
+void Controller::SetControllerToHostFlowControl(bool acl, bool synchronous) {
+  CallOn(impl_.get(), &impl::set_controller_to_host_flow_control, acl, synchronous);
+}
+
 void Controller::LeSetEventMask(uint64_t le_event_mask) {
   CallOn(impl_.get(), &impl::le_set_event_mask, le_event_mask);
 }
@@ -150,6 +150,8 @@ class Controller : public Module {
                               uint16_t host_total_num_acl_data_packets,
                               uint16_t host_total_num_synchronous_data_packets);
 
+  virtual void SetControllerToHostFlowControl(bool acl, bool synchronous);
+
   // LE controller commands
   virtual void LeSetEventMask(uint64_t le_event_mask);
 
@@ -111,6 +111,7 @@ class MockController : public Controller {
        uint8_t host_synchronous_data_packet_length,
        uint16_t host_total_num_acl_data_packets,
        uint16_t host_total_num_synchronous_data_packets));
+  MOCK_METHOD(void, SetControllerToHostFlowControl, (bool acl, bool synchronous));
   // LE controller commands
   MOCK_METHOD(void, LeSetEventMask, (uint64_t le_event_mask));
   MOCK_METHOD(LeBufferSize, GetLeBufferSize, (), (const));
@@ -67,6 +67,12 @@ class FuzzHciLayer : public HciLayer {
     }
   }
 
+  void SetCommandSerialized(OpCode op_code) override {}
+
+  void AddCommandDependency(OpCode op_code, OpCode depends_on) override {}
+
+  void SendHostNumCompletedPackets(std::vector<CompletedPackets> completed_packets) override {}
+
   common::BidiQueueEnd<hci::AclBuilder, hci::AclView>* GetAclQueueEnd() override {
     return acl_queue_.GetUpEnd();
   }
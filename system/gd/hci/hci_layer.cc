@@ -16,10 +16,17 @@
 
 #include "hci/hci_layer.h"
 
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+
 #include "common/bind.h"
 #include "common/init_flags.h"
 #include "common/stop_watch.h"
+#include "hal/hci_packet_pool.h"
 #include "hci/hci_metrics_logging.h"
+#include "hci_layer_generated.h"
 #include "os/alarm.h"
 #include "os/metrics.h"
 #include "os/queue.h"
@@ -58,6 +65,49 @@ static void abort_after_time_out(OpCode op_code) {
   ASSERT_LOG(false, "Done waiting for debug information after HCI timeout (%s)", OpCodeText(op_code).c_str());
 }
 
+static bool is_vendor_specific_command(OpCode op_code) {
+  return (static_cast<uint16_t>(op_code) >> 10) == 0x3f;
+}
+
+// Commands that change how the controller interprets the commands and events around them. They are only sent when
+// no other command is outstanding, and nothing is sent after them until they complete. Vendor specific commands are
+// always serialized, other modules can declare more with HciLayer::SetCommandSerialized.
+static constexpr OpCode kSerializedCommands[] = {
+    OpCode::RESET,
+    OpCode::SET_EVENT_MASK,
+    OpCode::SET_EVENT_MASK_PAGE_2,
+    OpCode::LE_SET_EVENT_MASK,
+    OpCode::WRITE_LE_HOST_SUPPORT,
+    OpCode::LE_SET_HOST_FEATURE,
+    OpCode::SET_CONTROLLER_TO_HOST_FLOW_CONTROL,
+    OpCode::HOST_BUFFER_SIZE,
+    OpCode::LE_SET_RANDOM_ADDRESS,
+    OpCode::LE_SET_ADDRESS_RESOLUTION_ENABLE,
+};
+
+// Round trip times of one opcode. Bucket 0 counts latencies under 1ms, bucket i those in [2^(i-1), 2^i) ms, and the
+// last bucket everything above.
+struct CommandLatency {
+  static constexpr size_t kBuckets = 12;
+
+  void Add(std::chrono::microseconds latency) {
+    uint64_t latency_us = latency.count();
+    count++;
+    total_us += latency_us;
+    max_us = std::max(max_us, latency_us);
+    size_t bucket = 0;
+    for (uint64_t latency_ms = latency_us / 1000; latency_ms != 0 && bucket < kBuckets - 1; latency_ms >>= 1) {
+      bucket++;
+    }
+    histogram[bucket]++;
+  }
+
+  uint64_t count = 0;
+  uint64_t total_us = 0;
+  uint64_t max_us = 0;
+  std::array<uint64_t, kBuckets> histogram{};
+};
+
 class CommandQueueEntry {
  public:
   CommandQueueEntry(
@@ -69,7 +119,11 @@ class CommandQueueEntry {
       : command(move(command_packet)), waiting_for_status_(true), on_status(move(on_status_function)) {}
 
   unique_ptr<CommandBuilder> command;
+  // Set when the command is serialized, right before it can be sent
+  std::shared_ptr<std::vector<uint8_t>> bytes;
   unique_ptr<CommandView> command_view;
+  OpCode op_code{OpCode::NONE};
+  std::chrono::steady_clock::time_point sent_time;
 
   bool waiting_for_status_;
   ContextualOnceCallback<void(CommandStatusView)> on_status;
@@ -92,7 +146,10 @@ class CommandQueueEntry {
 };
 
 struct HciLayer::impl {
-  impl(hal::HciHal* hal, HciLayer& module) : hal_(hal), module_(module) {
+  impl(hal::HciHal* hal, HciLayer& module)
+      : hal_(hal),
+        module_(module),
+        serialized_commands_(std::begin(kSerializedCommands), std::end(kSerializedCommands)) {
     hci_timeout_alarm_ = new Alarm(module.GetHandler());
   }
 
@@ -107,6 +164,7 @@ struct HciLayer::impl {
       delete hci_abort_alarm_;
     }
     command_queue_.clear();
+    outstanding_commands_.clear();
   }
 
   void drop(EventView event) {
@@ -115,26 +173,33 @@ struct HciLayer::impl {
 
   void on_outbound_acl_ready() {
     auto packet = acl_queue_.GetDownEnd()->TryDequeue();
-    std::vector<uint8_t> bytes;
+    hal::HciPacket bytes;
+    bytes.reserve(packet->size());
     BitInserter bi(bytes);
     packet->Serialize(bi);
-    hal_->sendAclData(bytes);
+    // Serializing copies the payload fragment once, from here the packet is moved down to the socket
+    hal::HciPacketPool::Get().CountCopy(bytes.size());
+    hal_->sendAclData(std::move(bytes));
   }
 
   void on_outbound_sco_ready() {
     auto packet = sco_queue_.GetDownEnd()->TryDequeue();
-    std::vector<uint8_t> bytes;
+    hal::HciPacket bytes;
+    bytes.reserve(packet->size());
     BitInserter bi(bytes);
     packet->Serialize(bi);
-    hal_->sendScoData(bytes);
+    hal::HciPacketPool::Get().CountCopy(bytes.size());
+    hal_->sendScoData(std::move(bytes));
   }
 
   void on_outbound_iso_ready() {
     auto packet = iso_queue_.GetDownEnd()->TryDequeue();
-    std::vector<uint8_t> bytes;
+    hal::HciPacket bytes;
+    bytes.reserve(packet->size());
     BitInserter bi(bytes);
     packet->Serialize(bi);
-    hal_->sendIsoData(bytes);
+    hal::HciPacketPool::Get().CountCopy(bytes.size());
+    hal_->sendIsoData(std::move(bytes));
   }
 
   template <typename TResponse>
@@ -174,18 +239,29 @@ struct HciLayer::impl {
     }
     bool is_status = logging_id == "status";
 
-    ASSERT_LOG(!command_queue_.empty(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(), op_code,
-               OpCodeText(op_code).c_str());
-    if (waiting_command_ == OpCode::CONTROLLER_DEBUG_INFO && op_code != OpCode::CONTROLLER_DEBUG_INFO) {
-      LOG_ERROR("Discarding event that came after timeout 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
-      return;
+    auto command = find_outstanding_command(op_code);
+    if (command == outstanding_commands_.end()) {
+      if (op_code == OpCode::HOST_NUM_COMPLETED_PACKETS) {
+        // Only sent back when the controller rejects the completed packets
+        LOG_ERROR("Controller rejected Host Number Of Completed Packets");
+        send_next_command();
+        return;
+      }
+      if (find_outstanding_command(OpCode::CONTROLLER_DEBUG_INFO) != outstanding_commands_.end()) {
+        LOG_ERROR("Discarding event that came after timeout 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
+        return;
+      }
+      ASSERT_LOG(
+          false,
+          "Unexpected %s event with OpCode 0x%02hx (%s)",
+          logging_id.c_str(),
+          op_code,
+          OpCodeText(op_code).c_str());
     }
-    ASSERT_LOG(waiting_command_ == op_code, "Waiting for 0x%02hx (%s), got 0x%02hx (%s)", waiting_command_,
-               OpCodeText(waiting_command_).c_str(), op_code, OpCodeText(op_code).c_str());
 
     bool is_vendor_specific = static_cast<int>(op_code) & (0x3f << 10);
     CommandStatusView status_view = CommandStatusView::Create(event);
-    if (is_vendor_specific && (is_status && !command_queue_.front().waiting_for_status_) &&
+    if (is_vendor_specific && (is_status && !command->waiting_for_status_) &&
         (status_view.IsValid() && status_view.GetStatus() == ErrorCode::UNKNOWN_HCI_COMMAND)) {
       // If this is a command status of a vendor specific command, and command complete is expected, we can't treat
       // this as hard failure since we have no way of probing this lack of support at earlier time. Instead we let
@@ -193,35 +269,63 @@ struct HciLayer::impl {
       // response.
       CommandCompleteView command_complete_view = CommandCompleteView::Create(
           EventView::Create(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>()))));
-      command_queue_.front().GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
+      command->GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
     } else {
-      if (command_queue_.front().waiting_for_status_ == is_status) {
-        command_queue_.front().GetCallback<TResponse>()->Invoke(move(response_view));
+      if (command->waiting_for_status_ == is_status) {
+        command->GetCallback<TResponse>()->Invoke(move(response_view));
       } else {
         CommandCompleteView command_complete_view = CommandCompleteView::Create(
             EventView::Create(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>()))));
-        command_queue_.front().GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
+        command->GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
       }
     }
 
-    command_queue_.pop_front();
-    waiting_command_ = OpCode::NONE;
+    record_latency(op_code, std::chrono::steady_clock::now() - command->sent_time);
+    bool was_oldest = command == outstanding_commands_.begin();
+    outstanding_commands_.erase(command);
     if (hci_timeout_alarm_ != nullptr) {
-      hci_timeout_alarm_->Cancel();
+      if (was_oldest) {
+        schedule_timeout();
+      }
       send_next_command();
     }
   }
 
+  // Commands with the same opcode are never outstanding together, so a response matches at most one command
+  std::list<CommandQueueEntry>::iterator find_outstanding_command(OpCode op_code) {
+    return std::find_if(outstanding_commands_.begin(), outstanding_commands_.end(), [op_code](const auto& command) {
+      return command.op_code == op_code;
+    });
+  }
+
+  void record_latency(OpCode op_code, std::chrono::steady_clock::duration latency) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    command_latencies_[op_code].Add(std::chrono::duration_cast<std::chrono::microseconds>(latency));
+  }
+
+  // The timeout alarm always tracks the oldest outstanding command
+  void schedule_timeout() {
+    if (outstanding_commands_.empty()) {
+      hci_timeout_alarm_->Cancel();
+      return;
+    }
+    const auto& oldest = outstanding_commands_.front();
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - oldest.sent_time);
+    auto delay = std::max(kHciTimeoutMs - elapsed, std::chrono::milliseconds(0));
+    hci_timeout_alarm_->Schedule(BindOnce(&impl::on_hci_timeout, common::Unretained(this), oldest.op_code), delay);
+  }
+
   void on_hci_timeout(OpCode op_code) {
     common::StopWatch::DumpStopWatchLog();
     LOG_ERROR("Timed out waiting for 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
     // TODO: LogMetricHciTimeoutEvent(static_cast<uint32_t>(op_code));
 
-    LOG_ERROR("Flushing %zd waiting commands", command_queue_.size());
+    LOG_ERROR("Flushing %zd waiting commands", command_queue_.size() + outstanding_commands_.size());
     // Clear any waiting commands (there is an abort coming anyway)
     command_queue_.clear();
+    outstanding_commands_.clear();
     command_credits_ = 1;
-    waiting_command_ = OpCode::NONE;
     enqueue_command(
         ControllerDebugInfoBuilder::Create(), module_.GetHandler()->BindOnce(&fail_if_reset_complete_not_success));
     // Don't time out for this one;
@@ -238,33 +342,96 @@ struct HciLayer::impl {
     }
   }
 
-  void send_next_command() {
-    if (command_credits_ == 0) {
-      return;
+  bool is_serialized_command(OpCode op_code) const {
+    return is_vendor_specific_command(op_code) || serialized_commands_.count(op_code) != 0;
+  }
+
+  void set_command_serialized(OpCode op_code) {
+    serialized_commands_.insert(op_code);
+  }
+
+  void add_command_dependency(OpCode op_code, OpCode depends_on) {
+    auto dependencies = command_dependencies_.equal_range(op_code);
+    for (auto it = dependencies.first; it != dependencies.second; it++) {
+      if (it->second == depends_on) {
+        return;
+      }
     }
-    if (waiting_command_ != OpCode::NONE) {
-      return;
+    command_dependencies_.emplace(op_code, depends_on);
+  }
+
+  // The command at the front of the queue can be sent alongside the outstanding ones, unless one of them is
+  // serialized, has the same opcode, or is a command it was declared to depend on. Commands are always sent in the
+  // order they were enqueued.
+  bool can_send(const CommandQueueEntry& command) const {
+    if (outstanding_commands_.empty()) {
+      return true;
     }
-    if (command_queue_.size() == 0) {
-      return;
+    if (is_serialized_command(command.op_code)) {
+      return false;
     }
-    std::shared_ptr<std::vector<uint8_t>> bytes = std::make_shared<std::vector<uint8_t>>();
+    auto dependencies = command_dependencies_.equal_range(command.op_code);
+    for (const auto& outstanding : outstanding_commands_) {
+      if (outstanding.op_code == command.op_code || is_serialized_command(outstanding.op_code)) {
+        return false;
+      }
+      for (auto it = dependencies.first; it != dependencies.second; it++) {
+        if (it->second == outstanding.op_code) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Host_Number_Of_Completed_Packets goes out right away. The controller takes it at any time without a command
+  // credit and only answers when it rejects it (BT Core 5.2, Vol 4, Part E, 7.3.40).
+  void send_host_num_completed_packets(std::vector<CompletedPackets> completed_packets) {
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    auto command = HostNumCompletedPacketsBuilder::Create(std::move(completed_packets));
+    bytes->reserve(command->size());
     BitInserter bi(*bytes);
-    command_queue_.front().command->Serialize(bi);
+    command->Serialize(bi);
     hal_->sendHciCommand(*bytes);
+  }
 
-    auto cmd_view = CommandView::Create(PacketView<kLittleEndian>(bytes));
-    ASSERT(cmd_view.IsValid());
-    OpCode op_code = cmd_view.GetOpCode();
-    command_queue_.front().command_view = std::make_unique<CommandView>(std::move(cmd_view));
-    log_link_layer_connection_command(command_queue_.front().command_view);
-    log_classic_pairing_command_status(command_queue_.front().command_view, ErrorCode::STATUS_UNKNOWN);
-    waiting_command_ = op_code;
-    command_credits_ = 0;  // Only allow one outstanding command
-    if (hci_timeout_alarm_ != nullptr) {
-      hci_timeout_alarm_->Schedule(BindOnce(&impl::on_hci_timeout, common::Unretained(this), op_code), kHciTimeoutMs);
-    } else {
-      LOG_WARN("%s sent without an hci-timeout timer", OpCodeText(op_code).c_str());
+  // Send as many queued commands as the controller has credits for
+  void send_next_command() {
+    while (command_credits_ > 0 && !command_queue_.empty()) {
+      auto& command = command_queue_.front();
+      if (command.command_view == nullptr) {
+        command.bytes = std::make_shared<std::vector<uint8_t>>();
+        command.bytes->reserve(command.command->size());
+        BitInserter bi(*command.bytes);
+        command.command->Serialize(bi);
+        auto cmd_view = CommandView::Create(PacketView<kLittleEndian>(command.bytes));
+        ASSERT(cmd_view.IsValid());
+        command.op_code = cmd_view.GetOpCode();
+        command.command_view = std::make_unique<CommandView>(std::move(cmd_view));
+      }
+      if (!can_send(command)) {
+        return;
+      }
+
+      // The serialized command is kept to match its completion, so the HAL gets a copy
+      hal::HciPacketPool::Get().CountCopy(command.bytes->size());
+      hal_->sendHciCommand(*command.bytes);
+
+      OpCode op_code = command.op_code;
+      log_link_layer_connection_command(command.command_view);
+      log_classic_pairing_command_status(command.command_view, ErrorCode::STATUS_UNKNOWN);
+      command.sent_time = std::chrono::steady_clock::now();
+      outstanding_commands_.splice(outstanding_commands_.end(), command_queue_, command_queue_.begin());
+      command_credits_--;
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        max_outstanding_commands_ = std::max(max_outstanding_commands_, outstanding_commands_.size());
+      }
+      if (hci_timeout_alarm_ == nullptr) {
+        LOG_WARN("%s sent without an hci-timeout timer", OpCodeText(op_code).c_str());
+      } else if (outstanding_commands_.size() == 1) {
+        schedule_timeout();
+      }
     }
   }
 
@@ -330,7 +497,7 @@ struct HciLayer::impl {
 
   void on_hci_event(EventView event) {
     ASSERT(event.IsValid());
-    if (command_queue_.empty()) {
+    if (outstanding_commands_.empty()) {
       auto event_code = event.GetEventCode();
       // BT Core spec 5.2 (Volume 4, Part E section 4.4) allows anytime
       // COMMAND_COMPLETE and COMMAND_STATUS with opcode 0x0 for flow control
@@ -338,7 +505,7 @@ struct HciLayer::impl {
           auto view = CommandCompleteView::Create(event);
           ASSERT(view.IsValid());
           auto op_code = view.GetCommandOpCode();
-          ASSERT_LOG(op_code == OpCode::NONE,
+          ASSERT_LOG(op_code == OpCode::NONE || op_code == OpCode::HOST_NUM_COMPLETED_PACKETS,
             "Received %s event with OpCode 0x%02hx (%s) without a waiting command"
             "(is the HAL sending commands, but not handling the events?)",
             EventCodeText(event_code).c_str(), op_code, OpCodeText(op_code).c_str());
@@ -355,7 +522,7 @@ struct HciLayer::impl {
       std::unique_ptr<CommandView> no_waiting_command{nullptr};
       log_hci_event(no_waiting_command, event, module_.GetDependency<storage::StorageModule>());
     } else {
-      log_hci_event(command_queue_.front().command_view, event, module_.GetDependency<storage::StorageModule>());
+      log_hci_event(command_view_for_event(event), event, module_.GetDependency<storage::StorageModule>());
     }
     EventCode event_code = event.GetEventCode();
     // Root Inflamation is a special case, since it aborts here
@@ -378,6 +545,27 @@ struct HciLayer::impl {
     event_handlers_[event_code].Invoke(event);
   }
 
+  // The outstanding command a Command Complete or Command Status event responds to, or the oldest one
+  std::unique_ptr<CommandView>& command_view_for_event(EventView event) {
+    OpCode op_code = OpCode::NONE;
+    if (event.GetEventCode() == EventCode::COMMAND_COMPLETE) {
+      auto view = CommandCompleteView::Create(event);
+      if (view.IsValid()) {
+        op_code = view.GetCommandOpCode();
+      }
+    } else if (event.GetEventCode() == EventCode::COMMAND_STATUS) {
+      auto view = CommandStatusView::Create(event);
+      if (view.IsValid()) {
+        op_code = view.GetCommandOpCode();
+      }
+    }
+    auto command = find_outstanding_command(op_code);
+    if (command == outstanding_commands_.end()) {
+      command = outstanding_commands_.begin();
+    }
+    return command->command_view;
+  }
+
   void on_le_meta_event(EventView event) {
     LeMetaEventView meta_event_view = LeMetaEventView::Create(event);
     ASSERT(meta_event_view.IsValid());
@@ -393,15 +581,26 @@ struct HciLayer::impl {
   HciLayer& module_;
 
   // Command Handling
+  // Commands not sent yet
   std::list<CommandQueueEntry> command_queue_;
+  // Commands sent and waiting for their Command Complete or Command Status, oldest first
+  std::list<CommandQueueEntry> outstanding_commands_;
+  // Opcodes sent only when nothing else is outstanding
+  std::set<OpCode> serialized_commands_;
+  // Opcodes held back while any of the opcodes they depend on is outstanding
+  std::multimap<OpCode, OpCode> command_dependencies_;
 
   std::map<EventCode, ContextualCallback<void(EventView)>> event_handlers_;
   std::map<SubeventCode, ContextualCallback<void(LeMetaEventView)>> subevent_handlers_;
-  OpCode waiting_command_{OpCode::NONE};
   uint8_t command_credits_{1};  // Send reset first
   Alarm* hci_timeout_alarm_{nullptr};
   Alarm* hci_abort_alarm_{nullptr};
 
+  // Read by dumpsys from another thread
+  mutable std::mutex stats_mutex_;
+  std::map<OpCode, CommandLatency> command_latencies_;
+  size_t max_outstanding_commands_{0};
+
   // Acl packets
   BidiQueue<AclView, AclBuilder> acl_queue_{3 /* TODO: Set queue depth */};
   os::EnqueueBuffer<AclView> incoming_acl_buffer_{acl_queue_.GetDownEnd()};
@@ -420,25 +619,25 @@ struct HciLayer::hal_callbacks : public hal::HciHalCallbacks {
   hal_callbacks(HciLayer& module) : module_(module) {}
 
   void hciEventReceived(hal::HciPacket event_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(event_bytes));
+    auto packet = packet::PacketView<packet::kLittleEndian>(hal::HciPacketPool::Get().Share(move(event_bytes)));
     EventView event = EventView::Create(packet);
     module_.CallOn(module_.impl_, &impl::on_hci_event, move(event));
   }
 
   void aclDataReceived(hal::HciPacket data_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes)));
+    auto packet = packet::PacketView<packet::kLittleEndian>(hal::HciPacketPool::Get().Share(move(data_bytes)));
     auto acl = std::make_unique<AclView>(AclView::Create(packet));
     module_.impl_->incoming_acl_buffer_.Enqueue(move(acl), module_.GetHandler());
   }
 
   void scoDataReceived(hal::HciPacket data_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes)));
+    auto packet = packet::PacketView<packet::kLittleEndian>(hal::HciPacketPool::Get().Share(move(data_bytes)));
     auto sco = std::make_unique<ScoView>(ScoView::Create(packet));
     module_.impl_->incoming_sco_buffer_.Enqueue(move(sco), module_.GetHandler());
   }
 
   void isoDataReceived(hal::HciPacket data_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes)));
+    auto packet = packet::PacketView<packet::kLittleEndian>(hal::HciPacketPool::Get().Share(move(data_bytes)));
     auto iso = std::make_unique<IsoView>(IsoView::Create(packet));
     module_.impl_->incoming_iso_buffer_.Enqueue(move(iso), module_.GetHandler());
   }
@@ -473,6 +672,18 @@ void HciLayer::EnqueueCommand(
   CallOn(impl_, &impl::enqueue_command<CommandStatusView>, move(command), move(on_status));
 }
 
+void HciLayer::SetCommandSerialized(OpCode op_code) {
+  CallOn(impl_, &impl::set_command_serialized, op_code);
+}
+
+void HciLayer::AddCommandDependency(OpCode op_code, OpCode depends_on) {
+  CallOn(impl_, &impl::add_command_dependency, op_code, depends_on);
+}
+
+void HciLayer::SendHostNumCompletedPackets(std::vector<CompletedPackets> completed_packets) {
+  CallOn(impl_, &impl::send_host_num_completed_packets, std::move(completed_packets));
+}
+
 void HciLayer::RegisterEventHandler(EventCode event, ContextualCallback<void(EventView)> handler) {
   CallOn(impl_, &impl::register_event, event, handler);
 }
@@ -664,5 +875,51 @@ void HciLayer::Stop() {
   delete impl_;
 }
 
+DumpsysDataFinisher HciLayer::GetDumpsysData(flatbuffers::FlatBufferBuilder* fb_builder) const {
+  ASSERT(fb_builder != nullptr);
+
+  auto pool_stats = hal::HciPacketPool::Get().GetStats();
+  HciPacketPoolDataBuilder pool_builder(*fb_builder);
+  pool_builder.add_packets(pool_stats.packets);
+  pool_builder.add_bytes_copied(pool_stats.bytes_copied);
+  pool_builder.add_average_bytes_copied_per_packet(
+      pool_stats.packets == 0 ? 0 : pool_stats.bytes_copied / pool_stats.packets);
+  pool_builder.add_buffer_allocations(pool_stats.allocations);
+  pool_builder.add_buffer_reuses(pool_stats.reuses);
+  pool_builder.add_pooled_buffers(pool_stats.pooled);
+  auto pool_offset = pool_builder.Finish();
+
+  std::vector<flatbuffers::Offset<HciCommandLatencyData>> latency_offsets;
+  size_t max_outstanding_commands;
+  {
+    std::lock_guard<std::mutex> lock(impl_->stats_mutex_);
+    max_outstanding_commands = impl_->max_outstanding_commands_;
+    for (const auto& [op_code, latency] : impl_->command_latencies_) {
+      auto op_code_offset = fb_builder->CreateString(OpCodeText(op_code));
+      auto histogram_offset = fb_builder->CreateVector(latency.histogram.data(), latency.histogram.size());
+      HciCommandLatencyDataBuilder latency_builder(*fb_builder);
+      latency_builder.add_op_code(op_code_offset);
+      latency_builder.add_count(latency.count);
+      latency_builder.add_average_latency_us(latency.total_us / latency.count);
+      latency_builder.add_max_latency_us(latency.max_us);
+      latency_builder.add_latency_histogram_ms(histogram_offset);
+      latency_offsets.push_back(latency_builder.Finish());
+    }
+  }
+  auto latencies_offset = fb_builder->CreateVector(latency_offsets);
+
+  auto title = fb_builder->CreateString(ToString());
+  HciLayerDataBuilder builder(*fb_builder);
+  builder.add_title(title);
+  builder.add_packet_pool(pool_offset);
+  builder.add_max_outstanding_commands(max_outstanding_commands);
+  builder.add_command_latencies(latencies_offset);
+  auto dumpsys_data = builder.Finish();
+
+  return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+    dumpsys_builder->add_hci_layer_dumpsys_data(dumpsys_data);
+  };
+}
+
 }  // namespace hci
 }  // namespace bluetooth
@@ -56,6 +56,17 @@ class HciLayer : public Module, public CommandInterface<CommandBuilder> {
       std::unique_ptr<CommandBuilder> command,
       common::ContextualOnceCallback<void(CommandStatusView)> on_status) override;
 
+  // Commands with |op_code| are sent only when no other command is outstanding, and hold back the commands enqueued
+  // after them until they complete
+  virtual void SetCommandSerialized(OpCode op_code);
+
+  // Commands with |op_code| are held back while a |depends_on| command is outstanding
+  virtual void AddCommandDependency(OpCode op_code, OpCode depends_on);
+
+  // Returns ACL packet credits to the controller once controller to host flow control is on. Bypasses the command
+  // queue.
+  virtual void SendHostNumCompletedPackets(std::vector<CompletedPackets> completed_packets);
+
   virtual common::BidiQueueEnd<AclBuilder, AclView>* GetAclQueueEnd();
 
   virtual common::BidiQueueEnd<ScoBuilder, ScoView>* GetScoQueueEnd();
@@ -113,6 +124,8 @@ class HciLayer : public Module, public CommandInterface<CommandBuilder> {
 
   void Stop() override;
 
+  DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const override;  // Module
+
   virtual void Disconnect(uint16_t handle, ErrorCode reason);
   virtual void ReadRemoteVersion(
       hci::ErrorCode hci_status, uint16_t handle, uint8_t version, uint16_t manufacturer_name, uint16_t sub_version);
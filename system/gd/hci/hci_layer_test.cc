@@ -621,6 +621,165 @@ TEST_F(HciTest, creditsTest) {
       ReadLocalSupportedFeaturesCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
 }
 
+TEST_F(HciTest, pipelinedCommandsTest) {
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+
+  // Allow three outstanding commands
+  uint8_t num_packets = 3;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+
+  // The first command waits for Reset to complete
+  auto first_command_future = hal->GetSentCommandFuture();
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedCommandsBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedFeaturesBuilder::Create());
+  ASSERT_EQ(first_command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Verify that all three were sent, in order
+  ASSERT_EQ(3, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+  ASSERT_TRUE(ReadLocalSupportedCommandsView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+  ASSERT_TRUE(ReadLocalSupportedFeaturesView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+
+  // Complete them out of order, each completion goes to its own command
+  num_packets = 1;
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  auto event_future = upper->GetReceivedEventFuture();
+  uint64_t lmp_features = 0x012345678abcdef;
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadLocalSupportedFeaturesCompleteBuilder::Create(num_packets, error_code, lmp_features)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(ReadLocalSupportedFeaturesCompleteView::Create(
+                  CommandCompleteView::Create(EventView::Create(upper->GetReceivedEvent())))
+                  .IsValid());
+
+  event_future = upper->GetReceivedEventFuture();
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  local_version_information.hci_revision_ = 0x1234;
+  local_version_information.lmp_version_ = LmpVersion::V_4_2;
+  local_version_information.manufacturer_name_ = 0xBAD;
+  local_version_information.lmp_subversion_ = 0x5678;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, error_code, local_version_information)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(ReadLocalVersionInformationCompleteView::Create(
+                  CommandCompleteView::Create(EventView::Create(upper->GetReceivedEvent())))
+                  .IsValid());
+
+  event_future = upper->GetReceivedEventFuture();
+  std::array<uint8_t, 64> supported_commands{};
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadLocalSupportedCommandsCompleteBuilder::Create(num_packets, error_code, supported_commands)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(ReadLocalSupportedCommandsCompleteView::Create(
+                  CommandCompleteView::Create(EventView::Create(upper->GetReceivedEvent())))
+                  .IsValid());
+}
+
+TEST_F(HciTest, serializedCommandWaitsForOutstandingCommands) {
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+
+  uint8_t num_packets = 2;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+
+  // The first command waits for Reset to complete
+  auto first_command_future = hal->GetSentCommandFuture();
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(SetEventMaskBuilder::Create(0x3dbfffffffffffff));
+  ASSERT_EQ(first_command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Set Event Mask waits for the outstanding command, even with a credit left
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+
+  auto command_future = hal->GetSentCommandFuture();
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, local_version_information)));
+
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(SetEventMaskView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+}
+
+TEST_F(HciTest, declaredDependencyWaitsForOutstandingCommand) {
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+
+  hci->AddCommandDependency(OpCode::READ_LOCAL_SUPPORTED_COMMANDS, OpCode::READ_LOCAL_VERSION_INFORMATION);
+  uint8_t num_packets = 3;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+
+  // The first command waits for Reset to complete
+  auto first_command_future = hal->GetSentCommandFuture();
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedCommandsBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedFeaturesBuilder::Create());
+  ASSERT_EQ(first_command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Read Local Supported Commands waits for the command it depends on, and the commands after it wait in order
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+
+  auto command_future = hal->GetSentCommandFuture();
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, local_version_information)));
+
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+  ASSERT_EQ(2, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalSupportedCommandsView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+  ASSERT_TRUE(ReadLocalSupportedFeaturesView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+}
+
+TEST_F(HciTest, hostNumCompletedPacketsSkipsTheCommandQueue) {
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+
+  uint8_t num_packets = 2;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+
+  auto first_command_future = hal->GetSentCommandFuture();
+  upper->SendHciCommandExpectingComplete(SetEventMaskBuilder::Create(0x3dbfffffffffffff));
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  ASSERT_EQ(first_command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(SetEventMaskView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+
+  // Goes out while a serialized command is outstanding and another one waits
+  auto completed_packets_future = hal->GetSentCommandFuture();
+  CompletedPackets completed_packets;
+  completed_packets.connection_handle_ = 0x0001;
+  completed_packets.host_num_of_completed_packets_ = 3;
+  hci->SendHostNumCompletedPackets({completed_packets});
+  ASSERT_EQ(completed_packets_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  auto view = HostNumCompletedPacketsView::Create(CommandView::Create(hal->GetSentCommand()));
+  ASSERT_TRUE(view.IsValid());
+  ASSERT_EQ(1u, view.GetCompletedPackets().size());
+  ASSERT_EQ(0x0001, view.GetCompletedPackets()[0].connection_handle_);
+  ASSERT_EQ(3, view.GetCompletedPackets()[0].host_num_of_completed_packets_);
+
+  // The controller only answers when it rejects the packets, which completes no command
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      HostNumCompletedPacketsErrorBuilder::Create(num_packets, ErrorCode::INVALID_HCI_COMMAND_PARAMETERS)));
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+
+  auto command_future = hal->GetSentCommandFuture();
+  hal->callbacks->hciEventReceived(GetPacketBytes(SetEventMaskCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS)));
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(CommandView::Create(hal->GetSentCommand())).IsValid());
+}
+
 TEST_F(HciTest, leSecurityInterfaceTest) {
   // Send LeRand to the controller
   auto command_future = hal->GetSentCommandFuture();
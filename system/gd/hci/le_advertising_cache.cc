@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_advertising_cache.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+
+AdvertisingCache::AdvertisingCache(size_t capacity) : capacity_(capacity), items_(capacity) {
+  free_buffers_.reserve(capacity);
+}
+
+const std::vector<uint8_t>& AdvertisingCache::Set(
+    const AddressWithType& address_with_type, const std::vector<uint8_t>& data) {
+  auto& cached = FindOrInsert(address_with_type);
+  size_t length = std::min(data.size(), kMaxDataLength);
+  if (length < data.size()) {
+    LOG_WARN("Truncating %zu bytes of advertising data from %s", data.size(), address_with_type.ToString().c_str());
+  }
+  cached.assign(data.begin(), data.begin() + length);
+  return cached;
+}
+
+const std::vector<uint8_t>& AdvertisingCache::Append(
+    const AddressWithType& address_with_type, const std::vector<uint8_t>& data) {
+  auto& cached = FindOrInsert(address_with_type);
+  size_t length = std::min(data.size(), kMaxDataLength - cached.size());
+  if (length < data.size()) {
+    LOG_WARN(
+        "Truncating %zu bytes of advertising data from %s",
+        cached.size() + data.size(),
+        address_with_type.ToString().c_str());
+  }
+  cached.insert(cached.end(), data.begin(), data.begin() + length);
+  return cached;
+}
+
+bool AdvertisingCache::Exist(const AddressWithType& address_with_type) {
+  return items_.contains(address_with_type);
+}
+
+void AdvertisingCache::Clear(const AddressWithType& address_with_type) {
+  auto node = items_.extract(address_with_type);
+  if (node) {
+    Recycle(std::move(node->second));
+  }
+}
+
+void AdvertisingCache::ClearAll() {
+  for (auto& item : items_) {
+    Recycle(std::move(item.second));
+  }
+  items_.clear();
+}
+
+std::vector<uint8_t>& AdvertisingCache::FindOrInsert(const AddressWithType& address_with_type) {
+  auto it = items_.find(address_with_type);
+  if (it != items_.end()) {
+    return it->second;
+  }
+
+  // Evict the coldest entry ourselves so its buffer can be reused for the new one
+  if (items_.size() == capacity_) {
+    auto coldest = std::prev(items_.end());
+    Recycle(std::move(coldest->second));
+    items_.erase(coldest);
+  }
+
+  std::vector<uint8_t> buffer;
+  if (!free_buffers_.empty()) {
+    buffer = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+  }
+  auto [inserted, success, evicted] = items_.try_emplace(address_with_type, std::move(buffer));
+  ASSERT(success && !evicted);
+  return inserted->second;
+}
+
+void AdvertisingCache::Recycle(std::vector<uint8_t> buffer) {
+  if (free_buffers_.size() < capacity_) {
+    buffer.clear();
+    free_buffers_.push_back(std::move(buffer));
+  }
+}
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/lru_cache.h"
+#include "hci/address_with_type.h"
+
+namespace bluetooth {
+namespace hci {
+
+// Advertising data received so far from advertisers whose report is not complete yet, either because the advertiser
+// is scannable and the scan response is pending, or because the extended advertising data is fragmented.
+//
+// Performance:
+//   - Look-up, insertion and removal are O(1), the least recently used advertiser is evicted when full
+//   - An entry holds at most kMaxDataLength bytes
+//   - Data buffers are recycled instead of being freed, so in steady state no allocation is done per report
+//   - NOT THREAD SAFE
+class AdvertisingCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 1000;
+  // Maximum length of the advertising data of an extended advertising set
+  static constexpr size_t kMaxDataLength = 1650;
+
+  explicit AdvertisingCache(size_t capacity = kDefaultCapacity);
+
+  // Replace the data of |address_with_type| with |data|, return the cached data
+  const std::vector<uint8_t>& Set(const AddressWithType& address_with_type, const std::vector<uint8_t>& data);
+
+  // Append |data| to the data of |address_with_type|, return the cached data
+  const std::vector<uint8_t>& Append(const AddressWithType& address_with_type, const std::vector<uint8_t>& data);
+
+  bool Exist(const AddressWithType& address_with_type);
+
+  // Clear data for device |address_with_type|
+  void Clear(const AddressWithType& address_with_type);
+
+  void ClearAll();
+
+  size_t Size() const {
+    return items_.size();
+  }
+
+ private:
+  // Return the data of |address_with_type|, making room for a new entry if there is none
+  std::vector<uint8_t>& FindOrInsert(const AddressWithType& address_with_type);
+  void Recycle(std::vector<uint8_t> buffer);
+
+  size_t capacity_;
+  common::LruCache<AddressWithType, std::vector<uint8_t>> items_;
+  std::vector<std::vector<uint8_t>> free_buffers_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
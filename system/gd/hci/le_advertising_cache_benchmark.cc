@@ -0,0 +1,113 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/le_advertising_cache.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+constexpr size_t kReportsPerIteration = 10000;
+constexpr double kReportsPerSecond = 10000;
+
+enum class ReportType {
+  NON_CONNECTABLE,
+  SCANNABLE,
+  SCAN_RESPONSE,
+};
+
+struct Report {
+  AddressWithType address_with_type;
+  ReportType type;
+  std::vector<uint8_t> data;
+};
+
+// A crowded environment: |advertiser_count| beacons and phones, half of them scannable. When |active| the scan
+// response of a scannable advertiser follows its advertisement most of the time, otherwise scannable advertisers keep
+// the cache full as their scan responses never come.
+std::vector<Report> MakeReports(size_t advertiser_count, bool active) {
+  std::mt19937 random(42);
+  std::vector<Report> reports;
+  while (reports.size() < kReportsPerIteration) {
+    uint32_t index = random() % advertiser_count;
+    AddressWithType address_with_type(
+        Address({static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8), 0x12, 0x34, 0x56, 0xc0}),
+        AddressType::RANDOM_DEVICE_ADDRESS);
+    if (index % 2 == 0) {
+      reports.push_back({address_with_type, ReportType::NON_CONNECTABLE, std::vector<uint8_t>(31, index)});
+      continue;
+    }
+    reports.push_back({address_with_type, ReportType::SCANNABLE, std::vector<uint8_t>(25, index)});
+    if (active && random() % 4 != 0) {
+      reports.push_back({address_with_type, ReportType::SCAN_RESPONSE, std::vector<uint8_t>(20, index)});
+    }
+  }
+  return reports;
+}
+
+// Same use of the cache as LeScanningManager::impl::process_advertising_package_content
+size_t ProcessReports(AdvertisingCache* cache, const std::vector<Report>& reports) {
+  size_t delivered_bytes = 0;
+  for (const auto& report : reports) {
+    switch (report.type) {
+      case ReportType::NON_CONNECTABLE:
+        delivered_bytes += cache->Append(report.address_with_type, report.data).size();
+        cache->Clear(report.address_with_type);
+        break;
+      case ReportType::SCANNABLE:
+        cache->Set(report.address_with_type, report.data);
+        break;
+      case ReportType::SCAN_RESPONSE:
+        if (cache->Exist(report.address_with_type)) {
+          delivered_bytes += cache->Append(report.address_with_type, report.data).size();
+          cache->Clear(report.address_with_type);
+        }
+        break;
+    }
+  }
+  return delivered_bytes;
+}
+
+void BM_AdvertisingCacheReplay(State& state) {
+  auto reports = MakeReports(state.range(0), state.range(1));
+  AdvertisingCache cache;
+  size_t delivered_bytes = 0;
+  for (auto _ : state) {
+    delivered_bytes += ProcessReports(&cache, reports);
+  }
+  benchmark::DoNotOptimize(delivered_bytes);
+  state.SetItemsProcessed(state.iterations() * reports.size());
+  // Share of one CPU spent in the cache when scanning at 10k reports per second
+  state.counters["cpu_share_at_10k_reports_per_s"] =
+      Counter(state.iterations() * reports.size() / kReportsPerSecond, Counter::kIsRate | Counter::kInvert);
+}
+BENCHMARK(BM_AdvertisingCacheReplay)
+    ->ArgNames({"advertisers", "active"})
+    ->Args({100, 1})
+    ->Args({1000, 1})
+    ->Args({1000, 0})
+    ->Args({5000, 0});
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_advertising_cache.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+AddressWithType MakeAddress(uint8_t index, AddressType type = AddressType::RANDOM_DEVICE_ADDRESS) {
+  return AddressWithType(Address({index, 0x00, 0x00, 0x00, 0x00, 0xc0}), type);
+}
+
+TEST(AdvertisingCacheTest, set_and_append) {
+  AdvertisingCache cache;
+  ASSERT_FALSE(cache.Exist(MakeAddress(1)));
+  ASSERT_EQ(cache.Set(MakeAddress(1), {0x02, 0x01, 0x06}), std::vector<uint8_t>({0x02, 0x01, 0x06}));
+  ASSERT_TRUE(cache.Exist(MakeAddress(1)));
+  ASSERT_EQ(cache.Append(MakeAddress(1), {0x01, 0x09}), std::vector<uint8_t>({0x02, 0x01, 0x06, 0x01, 0x09}));
+  ASSERT_EQ(cache.Set(MakeAddress(1), {0x01, 0xff}), std::vector<uint8_t>({0x01, 0xff}));
+  ASSERT_EQ(cache.Size(), 1u);
+}
+
+TEST(AdvertisingCacheTest, append_without_set_starts_a_new_entry) {
+  AdvertisingCache cache;
+  ASSERT_EQ(cache.Append(MakeAddress(1), {0x01, 0x09}), std::vector<uint8_t>({0x01, 0x09}));
+  ASSERT_TRUE(cache.Exist(MakeAddress(1)));
+}
+
+TEST(AdvertisingCacheTest, address_type_is_part_of_the_key) {
+  AdvertisingCache cache;
+  cache.Set(MakeAddress(1, AddressType::PUBLIC_DEVICE_ADDRESS), {0x01});
+  ASSERT_FALSE(cache.Exist(MakeAddress(1, AddressType::RANDOM_DEVICE_ADDRESS)));
+  ASSERT_EQ(cache.Set(MakeAddress(1, AddressType::RANDOM_DEVICE_ADDRESS), {0x02}), std::vector<uint8_t>({0x02}));
+  ASSERT_EQ(cache.Append(MakeAddress(1, AddressType::PUBLIC_DEVICE_ADDRESS), {}), std::vector<uint8_t>({0x01}));
+}
+
+TEST(AdvertisingCacheTest, clear) {
+  AdvertisingCache cache;
+  cache.Set(MakeAddress(1), {0x01});
+  cache.Set(MakeAddress(2), {0x02});
+  cache.Clear(MakeAddress(1));
+  cache.Clear(MakeAddress(3));
+  ASSERT_FALSE(cache.Exist(MakeAddress(1)));
+  ASSERT_TRUE(cache.Exist(MakeAddress(2)));
+  // A recycled buffer must not bring back old data
+  ASSERT_EQ(cache.Append(MakeAddress(1), {0x03}), std::vector<uint8_t>({0x03}));
+  cache.ClearAll();
+  ASSERT_EQ(cache.Size(), 0u);
+  ASSERT_FALSE(cache.Exist(MakeAddress(2)));
+}
+
+TEST(AdvertisingCacheTest, least_recently_used_entry_is_evicted) {
+  AdvertisingCache cache(3);
+  cache.Set(MakeAddress(1), {0x01});
+  cache.Set(MakeAddress(2), {0x02});
+  cache.Set(MakeAddress(3), {0x03});
+  // The scan response of the oldest advertiser makes it the most recently used
+  cache.Append(MakeAddress(1), {0x11});
+  cache.Set(MakeAddress(4), {0x04});
+  ASSERT_EQ(cache.Size(), 3u);
+  ASSERT_FALSE(cache.Exist(MakeAddress(2)));
+  ASSERT_TRUE(cache.Exist(MakeAddress(3)));
+  ASSERT_TRUE(cache.Exist(MakeAddress(4)));
+  ASSERT_EQ(cache.Append(MakeAddress(1), {}), std::vector<uint8_t>({0x01, 0x11}));
+  ASSERT_EQ(cache.Append(MakeAddress(4), {}), std::vector<uint8_t>({0x04}));
+}
+
+TEST(AdvertisingCacheTest, data_is_bounded) {
+  AdvertisingCache cache;
+  std::vector<uint8_t> data(AdvertisingCache::kMaxDataLength - 1, 0x01);
+  ASSERT_EQ(cache.Set(MakeAddress(1), data).size(), AdvertisingCache::kMaxDataLength - 1);
+  ASSERT_EQ(cache.Append(MakeAddress(1), {0x02, 0x03}).size(), AdvertisingCache::kMaxDataLength);
+  ASSERT_EQ(cache.Append(MakeAddress(1), {0x04}).back(), 0x02);
+  std::vector<uint8_t> too_long(AdvertisingCache::kMaxDataLength + 10, 0x05);
+  ASSERT_EQ(cache.Set(MakeAddress(2), too_long).size(), AdvertisingCache::kMaxDataLength);
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_scan_result_batcher.h"
+
+#include <algorithm>
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+void AppendUint16(std::vector<uint8_t>* bytes, uint16_t value) {
+  bytes->push_back(static_cast<uint8_t>(value));
+  bytes->push_back(static_cast<uint8_t>(value >> 8));
+}
+
+uint16_t ReadUint16(const uint8_t* bytes) {
+  return bytes[0] | (bytes[1] << 8);
+}
+
+}  // namespace
+
+ScanResultBatcher::ScanResultBatcher(ScanResultBatchingConfig config) : config_(config) {
+  results_.reserve(config_.max_batch_bytes);
+}
+
+bool ScanResultBatcher::Add(
+    Clock::time_point now,
+    uint16_t event_type,
+    uint8_t address_type,
+    const Address& address,
+    uint8_t primary_phy,
+    uint8_t secondary_phy,
+    uint8_t advertising_sid,
+    int8_t tx_power,
+    int8_t rssi,
+    uint16_t periodic_advertising_interval,
+    const std::vector<uint8_t>& advertising_data) {
+  if (config_.duplicate_window.count() > 0) {
+    if (IsDuplicate(now, AddressWithType(address, static_cast<AddressType>(address_type)), advertising_data)) {
+      suppressed_count_++;
+      return false;
+    }
+  }
+
+  if (num_results_ == 0) {
+    first_result_time_ = now;
+  }
+  num_results_++;
+  AppendUint16(&results_, event_type);
+  results_.push_back(address_type);
+  results_.insert(results_.end(), address.data(), address.data() + Address::kLength);
+  results_.push_back(primary_phy);
+  results_.push_back(secondary_phy);
+  results_.push_back(advertising_sid);
+  results_.push_back(static_cast<uint8_t>(tx_power));
+  results_.push_back(static_cast<uint8_t>(rssi));
+  AppendUint16(&results_, periodic_advertising_interval);
+  AppendUint16(&results_, static_cast<uint16_t>(advertising_data.size()));
+  results_.insert(results_.end(), advertising_data.begin(), advertising_data.end());
+  return true;
+}
+
+std::vector<uint8_t> ScanResultBatcher::TakeResults() {
+  std::vector<uint8_t> results;
+  results.reserve(config_.max_batch_bytes);
+  results.swap(results_);
+  num_results_ = 0;
+  return results;
+}
+
+bool ScanResultBatcher::ForEachResult(
+    const std::vector<uint8_t>& results, std::function<void(const BatchedScanResult&)> callback) {
+  size_t offset = 0;
+  while (offset < results.size()) {
+    if (results.size() - offset < kResultHeaderSize) {
+      return false;
+    }
+    const uint8_t* header = results.data() + offset;
+    BatchedScanResult result;
+    result.event_type = ReadUint16(header);
+    result.address_type = header[2];
+    std::copy(header + 3, header + 3 + Address::kLength, result.address.data());
+    result.primary_phy = header[9];
+    result.secondary_phy = header[10];
+    result.advertising_sid = header[11];
+    result.tx_power = static_cast<int8_t>(header[12]);
+    result.rssi = static_cast<int8_t>(header[13]);
+    result.periodic_advertising_interval = ReadUint16(header + 14);
+    result.advertising_data_length = ReadUint16(header + 16);
+    offset += kResultHeaderSize;
+    if (results.size() - offset < result.advertising_data_length) {
+      return false;
+    }
+    result.advertising_data = results.data() + offset;
+    offset += result.advertising_data_length;
+    callback(result);
+  }
+  return true;
+}
+
+bool ScanResultBatcher::IsDuplicate(
+    Clock::time_point now, const AddressWithType& address_with_type, const std::vector<uint8_t>& advertising_data) {
+  auto it = seen_results_.find(address_with_type);
+  if (it == seen_results_.end()) {
+    seen_results_.insert_or_assign(address_with_type, {advertising_data, now});
+    return false;
+  }
+  SeenResult& seen = it->second;
+  if (now - seen.time < config_.duplicate_window && seen.advertising_data == advertising_data) {
+    return true;
+  }
+  // Only a result that is delivered starts a new window, so a steady advertiser is still reported once per window.
+  // Reuse the stored buffer, advertisers mostly keep the same data length.
+  seen.advertising_data.assign(advertising_data.begin(), advertising_data.end());
+  seen.time = now;
+  return false;
+}
+
+}  // namespace hci
+}  // namespace bluetooth
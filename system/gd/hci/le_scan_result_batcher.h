@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common/lru_cache.h"
+#include "hci/address_with_type.h"
+
+namespace bluetooth {
+namespace hci {
+
+struct ScanResultBatchingConfig {
+  // Deliver the batch once it holds at least this many bytes
+  size_t max_batch_bytes = 4096;
+  // Deliver the batch at the latest this long after its first result was added
+  std::chrono::milliseconds max_latency = std::chrono::milliseconds(500);
+  // Drop a result carrying the same data as the previous result of the same advertiser if that one was added less than
+  // this long ago. Zero keeps every result.
+  std::chrono::milliseconds duplicate_window = std::chrono::milliseconds(0);
+};
+
+// A single scan result unpacked from a batch
+struct BatchedScanResult {
+  uint16_t event_type;
+  uint8_t address_type;
+  Address address;
+  uint8_t primary_phy;
+  uint8_t secondary_phy;
+  uint8_t advertising_sid;
+  int8_t tx_power;
+  int8_t rssi;
+  uint16_t periodic_advertising_interval;
+  const uint8_t* advertising_data;
+  size_t advertising_data_length;
+};
+
+// Accumulates the scan results of one scanner into a flat buffer, to be delivered together by
+// ScanningCallback::OnScanResultBatch. Every result is a header with the parameters of ScanningCallback::OnScanResult,
+// multi-byte fields little-endian, followed by the advertising data:
+//
+//   event_type (2) | address_type (1) | address (6) | primary_phy (1) | secondary_phy (1) | advertising_sid (1) |
+//   tx_power (1) | rssi (1) | periodic_advertising_interval (2) | advertising_data_length (2) | advertising_data
+//
+// NOT THREAD SAFE
+class ScanResultBatcher {
+ public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr size_t kResultHeaderSize = 18;
+  // Number of advertisers remembered for duplicate suppression
+  static constexpr size_t kDuplicateFilterCapacity = 1000;
+
+  explicit ScanResultBatcher(ScanResultBatchingConfig config);
+
+  // Add a result to the batch, return false if it was suppressed as a duplicate
+  bool Add(
+      Clock::time_point now,
+      uint16_t event_type,
+      uint8_t address_type,
+      const Address& address,
+      uint8_t primary_phy,
+      uint8_t secondary_phy,
+      uint8_t advertising_sid,
+      int8_t tx_power,
+      int8_t rssi,
+      uint16_t periodic_advertising_interval,
+      const std::vector<uint8_t>& advertising_data);
+
+  bool IsEmpty() const {
+    return num_results_ == 0;
+  }
+
+  bool IsFull() const {
+    return results_.size() >= config_.max_batch_bytes;
+  }
+
+  // Time by which the pending results must be delivered, only valid when not empty
+  Clock::time_point GetDeadline() const {
+    return first_result_time_ + config_.max_latency;
+  }
+
+  int GetNumResults() const {
+    return num_results_;
+  }
+
+  uint64_t GetSuppressedCount() const {
+    return suppressed_count_;
+  }
+
+  // Take the pending results, leaving the batch empty
+  std::vector<uint8_t> TakeResults();
+
+  // Call |callback| on every result of |results|, return false if |results| is malformed
+  static bool ForEachResult(
+      const std::vector<uint8_t>& results, std::function<void(const BatchedScanResult&)> callback);
+
+ private:
+  struct SeenResult {
+    std::vector<uint8_t> advertising_data;
+    Clock::time_point time;
+  };
+
+  bool IsDuplicate(
+      Clock::time_point now, const AddressWithType& address_with_type, const std::vector<uint8_t>& advertising_data);
+
+  ScanResultBatchingConfig config_;
+  std::vector<uint8_t> results_;
+  int num_results_ = 0;
+  Clock::time_point first_result_time_;
+  common::LruCache<AddressWithType, SeenResult> seen_results_{kDuplicateFilterCapacity};
+  uint64_t suppressed_count_ = 0;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_scan_result_batcher.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+using std::chrono_literals::operator""ms;
+
+const Address kAddress1({0x01, 0x02, 0x03, 0x04, 0x05, 0xc6});
+const Address kAddress2({0x11, 0x12, 0x13, 0x14, 0x15, 0xd6});
+
+bool AddResult(
+    ScanResultBatcher* batcher,
+    ScanResultBatcher::Clock::time_point now,
+    const Address& address,
+    const std::vector<uint8_t>& data,
+    int8_t rssi = -60) {
+  return batcher->Add(now, 0x0013, 0x01, address, 0x01, 0x00, 0xff, 0x7f, rssi, 0x0000, data);
+}
+
+std::vector<BatchedScanResult> Parse(const std::vector<uint8_t>& results) {
+  std::vector<BatchedScanResult> parsed;
+  EXPECT_TRUE(
+      ScanResultBatcher::ForEachResult(results, [&](const BatchedScanResult& result) { parsed.push_back(result); }));
+  return parsed;
+}
+
+TEST(ScanResultBatcherTest, results_round_trip) {
+  ScanResultBatcher batcher({});
+  auto now = ScanResultBatcher::Clock::now();
+  ASSERT_TRUE(batcher.IsEmpty());
+  ASSERT_TRUE(AddResult(&batcher, now, kAddress1, {0x02, 0x01, 0x06}, -42));
+  ASSERT_TRUE(AddResult(&batcher, now, kAddress2, {}, -90));
+  ASSERT_EQ(batcher.GetNumResults(), 2);
+
+  auto results = batcher.TakeResults();
+  ASSERT_EQ(results.size(), 2 * ScanResultBatcher::kResultHeaderSize + 3);
+  ASSERT_TRUE(batcher.IsEmpty());
+  auto parsed = Parse(results);
+  ASSERT_EQ(parsed.size(), 2u);
+  ASSERT_EQ(parsed[0].event_type, 0x0013);
+  ASSERT_EQ(parsed[0].address_type, 0x01);
+  ASSERT_EQ(parsed[0].address, kAddress1);
+  ASSERT_EQ(parsed[0].primary_phy, 0x01);
+  ASSERT_EQ(parsed[0].advertising_sid, 0xff);
+  ASSERT_EQ(parsed[0].tx_power, 0x7f);
+  ASSERT_EQ(parsed[0].rssi, -42);
+  ASSERT_EQ(
+      std::vector<uint8_t>(parsed[0].advertising_data, parsed[0].advertising_data + parsed[0].advertising_data_length),
+      std::vector<uint8_t>({0x02, 0x01, 0x06}));
+  ASSERT_EQ(parsed[1].address, kAddress2);
+  ASSERT_EQ(parsed[1].rssi, -90);
+  ASSERT_EQ(parsed[1].advertising_data_length, 0u);
+}
+
+TEST(ScanResultBatcherTest, malformed_results_are_rejected) {
+  ScanResultBatcher batcher({});
+  AddResult(&batcher, ScanResultBatcher::Clock::now(), kAddress1, {0x02, 0x01, 0x06});
+  auto results = batcher.TakeResults();
+  results.pop_back();
+  ASSERT_FALSE(ScanResultBatcher::ForEachResult(results, [](const BatchedScanResult&) {}));
+  results.resize(ScanResultBatcher::kResultHeaderSize - 1);
+  ASSERT_FALSE(ScanResultBatcher::ForEachResult(results, [](const BatchedScanResult&) {}));
+}
+
+TEST(ScanResultBatcherTest, full_and_deadline) {
+  ScanResultBatchingConfig config;
+  config.max_batch_bytes = 2 * ScanResultBatcher::kResultHeaderSize;
+  config.max_latency = 100ms;
+  ScanResultBatcher batcher(config);
+  auto now = ScanResultBatcher::Clock::now();
+  AddResult(&batcher, now, kAddress1, {});
+  ASSERT_FALSE(batcher.IsFull());
+  ASSERT_EQ(batcher.GetDeadline(), now + 100ms);
+  // The deadline is set by the oldest result of the batch
+  AddResult(&batcher, now + 50ms, kAddress2, {});
+  ASSERT_TRUE(batcher.IsFull());
+  ASSERT_EQ(batcher.GetDeadline(), now + 100ms);
+  batcher.TakeResults();
+  AddResult(&batcher, now + 60ms, kAddress2, {});
+  ASSERT_EQ(batcher.GetDeadline(), now + 160ms);
+}
+
+TEST(ScanResultBatcherTest, duplicates_are_kept_by_default) {
+  ScanResultBatcher batcher({});
+  auto now = ScanResultBatcher::Clock::now();
+  ASSERT_TRUE(AddResult(&batcher, now, kAddress1, {0x01}));
+  ASSERT_TRUE(AddResult(&batcher, now, kAddress1, {0x01}));
+  ASSERT_EQ(batcher.GetNumResults(), 2);
+  ASSERT_EQ(batcher.GetSuppressedCount(), 0u);
+}
+
+TEST(ScanResultBatcherTest, duplicates_are_suppressed_within_window) {
+  ScanResultBatchingConfig config;
+  config.duplicate_window = 1000ms;
+  ScanResultBatcher batcher(config);
+  auto now = ScanResultBatcher::Clock::now();
+  ASSERT_TRUE(AddResult(&batcher, now, kAddress1, {0x01}));
+  ASSERT_FALSE(AddResult(&batcher, now + 10ms, kAddress1, {0x01}, -20));
+  // Other data or another advertiser is not a duplicate
+  ASSERT_TRUE(AddResult(&batcher, now + 20ms, kAddress1, {0x02}));
+  ASSERT_TRUE(AddResult(&batcher, now + 30ms, kAddress2, {0x02}));
+  ASSERT_FALSE(AddResult(&batcher, now + 40ms, kAddress2, {0x02}));
+  // Reported again once the window has passed
+  ASSERT_TRUE(AddResult(&batcher, now + 1030ms, kAddress2, {0x02}));
+  ASSERT_EQ(batcher.GetNumResults(), 4);
+  ASSERT_EQ(batcher.GetSuppressedCount(), 2u);
+}
+
+TEST(ScanResultBatcherTest, duplicates_must_carry_the_same_bytes) {
+  ScanResultBatchingConfig config;
+  config.duplicate_window = 1000ms;
+  ScanResultBatcher batcher(config);
+  auto now = ScanResultBatcher::Clock::now();
+  ASSERT_TRUE(AddResult(&batcher, now, kAddress1, {0x01, 0x02}));
+  // Same length, a prefix, or no data at all is distinct data
+  ASSERT_TRUE(AddResult(&batcher, now + 10ms, kAddress1, {0x02, 0x01}));
+  ASSERT_TRUE(AddResult(&batcher, now + 20ms, kAddress1, {0x02}));
+  ASSERT_TRUE(AddResult(&batcher, now + 30ms, kAddress1, {}));
+  ASSERT_FALSE(AddResult(&batcher, now + 40ms, kAddress1, {}));
+  ASSERT_EQ(batcher.GetNumResults(), 4);
+  ASSERT_EQ(batcher.GetSuppressedCount(), 1u);
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
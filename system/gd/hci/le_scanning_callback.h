@@ -66,6 +66,8 @@ class ScanningCallback {
       int8_t rssi,
       uint16_t periodic_advertising_interval,
       std::vector<uint8_t> advertising_data) = 0;
+  // Results batched for a scanner that enabled scan result batching, see ScanResultBatcher for the layout of |results|
+  virtual void OnScanResultBatch(ScannerId scanner_id, int num_results, std::vector<uint8_t> results) {}
   virtual void OnTrackAdvFoundLost(AdvertisingFilterOnFoundOnLostInfo on_found_on_lost_info) = 0;
   virtual void OnBatchScanReports(
       int client_if, int status, int report_format, int num_records, std::vector<uint8_t> data) = 0;
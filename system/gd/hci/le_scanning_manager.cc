@@ -15,17 +15,21 @@
  */
 #include "hci/le_scanning_manager.h"
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 #include "hci/acl_manager.h"
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 #include "hci/hci_packets.h"
+#include "hci/le_advertising_cache.h"
 #include "hci/le_periodic_sync_manager.h"
 #include "hci/le_scanning_interface.h"
 #include "hci/vendor_specific_event_manager.h"
 #include "module.h"
+#include "os/alarm.h"
 #include "os/handler.h"
 #include "os/log.h"
 #include "storage/storage_module.h"
@@ -61,80 +65,6 @@ struct Scanner {
   bool in_use;
 };
 
-class AdvertisingCache {
- public:
-  const std::vector<uint8_t>& Set(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
-    auto it = Find(address_with_type);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(address_with_type, std::move(data));
-    return items.front().data;
-  }
-
-  bool Exist(const AddressWithType& address_with_type) {
-    auto it = Find(address_with_type);
-    if (it == items.end()) {
-      return false;
-    }
-    return true;
-  }
-
-  const std::vector<uint8_t>& Append(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
-    auto it = Find(address_with_type);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(address_with_type, std::move(data));
-    return items.front().data;
-  }
-
-  /* Clear data for device |addr_type, addr| */
-  void Clear(AddressWithType address_with_type) {
-    auto it = Find(address_with_type);
-    if (it != items.end()) {
-      items.erase(it);
-    }
-  }
-
-  void ClearAll() {
-    items.clear();
-  }
-
-  struct Item {
-    AddressWithType address_with_type;
-    std::vector<uint8_t> data;
-
-    Item(const AddressWithType& address_with_type, std::vector<uint8_t> data)
-        : address_with_type(address_with_type), data(data) {}
-  };
-
-  std::list<Item>::iterator Find(const AddressWithType& address_with_type) {
-    for (auto it = items.begin(); it != items.end(); it++) {
-      if (it->address_with_type == address_with_type) {
-        return it;
-      }
-    }
-    return items.end();
-  }
-
-  /* we keep maximum 7 devices in the cache */
-  const size_t cache_max = 1000;
-  std::list<Item> items;
-};
-
 class NullScanningCallback : public ScanningCallback {
   void OnScannerRegistered(const bluetooth::hci::Uuid app_uuid, ScannerId scanner_id, ScanningStatus status) override {
     LOG_INFO("OnScannerRegistered in NullScanningCallback");
@@ -155,6 +85,9 @@ class NullScanningCallback : public ScanningCallback {
       std::vector<uint8_t> advertising_data) override {
     LOG_INFO("OnScanResult in NullScanningCallback");
   }
+  void OnScanResultBatch(ScannerId scanner_id, int num_results, std::vector<uint8_t> results) override {
+    LOG_INFO("OnScanResultBatch in NullScanningCallback");
+  }
   void OnTrackAdvFoundLost(AdvertisingFilterOnFoundOnLostInfo on_found_on_lost_info) override {
     LOG_INFO("OnTrackAdvFoundLost in NullScanningCallback");
   }
@@ -277,6 +210,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     }
     batch_scan_config_.current_state = BatchScanState::DISABLED_STATE;
     batch_scan_config_.ref_value = kInvalidScannerId;
+    scan_result_batch_alarm_ = std::make_unique<os::Alarm>(module_handler_);
     configure_scan();
   }
 
@@ -466,7 +400,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     }
 
     if (address_type == (uint8_t)DirectAdvertisingAddressType::NO_ADDRESS) {
-      scanning_callbacks_->OnScanResult(
+      on_scan_result(
           event_type,
           address_type,
           address,
@@ -515,7 +449,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
         address_type = (uint8_t)AddressType::RANDOM_DEVICE_ADDRESS;
         break;
     }
-    scanning_callbacks_->OnScanResult(
+    on_scan_result(
         event_type,
         address_type,
         address,
@@ -530,6 +464,136 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     advertising_cache_.Clear(address_with_type);
   }
 
+  void on_scan_result(
+      uint16_t event_type,
+      uint8_t address_type,
+      Address address,
+      uint8_t primary_phy,
+      uint8_t secondary_phy,
+      uint8_t advertising_sid,
+      int8_t tx_power,
+      int8_t rssi,
+      uint16_t periodic_advertising_interval,
+      const std::vector<uint8_t>& advertising_data) {
+    if (!scan_result_batchers_.empty()) {
+      auto now = ScanResultBatcher::Clock::now();
+      for (auto& [scanner_id, batcher] : scan_result_batchers_) {
+        bool was_empty = batcher.IsEmpty();
+        if (!batcher.Add(
+                now,
+                event_type,
+                address_type,
+                address,
+                primary_phy,
+                secondary_phy,
+                advertising_sid,
+                tx_power,
+                rssi,
+                periodic_advertising_interval,
+                advertising_data)) {
+          continue;
+        }
+        if (batcher.IsFull()) {
+          deliver_scan_result_batch(scanner_id, &batcher);
+        } else if (was_empty) {
+          schedule_scan_result_batch_alarm(batcher.GetDeadline());
+        }
+      }
+    }
+
+    if (deliver_unbatched_scan_results_) {
+      scanning_callbacks_->OnScanResult(
+          event_type,
+          address_type,
+          address,
+          primary_phy,
+          secondary_phy,
+          advertising_sid,
+          tx_power,
+          rssi,
+          periodic_advertising_interval,
+          advertising_data);
+    }
+  }
+
+  void deliver_scan_result_batch(ScannerId scanner_id, ScanResultBatcher* batcher) {
+    int num_results = batcher->GetNumResults();
+    scanning_callbacks_->OnScanResultBatch(scanner_id, num_results, batcher->TakeResults());
+  }
+
+  void deliver_all_scan_result_batches() {
+    for (auto& [scanner_id, batcher] : scan_result_batchers_) {
+      if (!batcher.IsEmpty()) {
+        deliver_scan_result_batch(scanner_id, &batcher);
+      }
+    }
+  }
+
+  void schedule_scan_result_batch_alarm(ScanResultBatcher::Clock::time_point deadline) {
+    if (scan_result_batch_deadline_.has_value() && *scan_result_batch_deadline_ <= deadline) {
+      return;
+    }
+    scan_result_batch_deadline_ = deadline;
+    auto delay = std::chrono::ceil<std::chrono::milliseconds>(deadline - ScanResultBatcher::Clock::now());
+    scan_result_batch_alarm_->Schedule(
+        common::BindOnce(&impl::on_scan_result_batch_alarm, common::Unretained(this)),
+        std::max(delay, std::chrono::milliseconds(0)));
+  }
+
+  void on_scan_result_batch_alarm() {
+    scan_result_batch_deadline_.reset();
+    auto now = ScanResultBatcher::Clock::now();
+    for (auto& [scanner_id, batcher] : scan_result_batchers_) {
+      if (batcher.IsEmpty()) {
+        continue;
+      }
+      if (batcher.GetDeadline() <= now) {
+        deliver_scan_result_batch(scanner_id, &batcher);
+      } else {
+        schedule_scan_result_batch_alarm(batcher.GetDeadline());
+      }
+    }
+  }
+
+  // Results are still delivered one by one while a registered scanner has not enabled batching
+  void update_unbatched_scan_result_delivery() {
+    deliver_unbatched_scan_results_ = scan_result_batchers_.empty();
+    for (uint8_t i = 1; i <= kMaxAppNum; i++) {
+      if (scanners_[i].in_use && scan_result_batchers_.count(i) == 0) {
+        deliver_unbatched_scan_results_ = true;
+      }
+    }
+  }
+
+  void enable_scan_result_batching(ScannerId scanner_id, ScanResultBatchingConfig config) {
+    if (scanner_id <= 0 || scanner_id > kMaxAppNum || !scanners_[scanner_id].in_use) {
+      LOG_WARN("Invalid scanner id %d", (uint16_t)scanner_id);
+      return;
+    }
+    auto it = scan_result_batchers_.find(scanner_id);
+    if (it != scan_result_batchers_.end()) {
+      if (!it->second.IsEmpty()) {
+        deliver_scan_result_batch(scanner_id, &it->second);
+      }
+      scan_result_batchers_.erase(it);
+    }
+    scan_result_batchers_.emplace(scanner_id, config);
+    update_unbatched_scan_result_delivery();
+  }
+
+  void disable_scan_result_batching(ScannerId scanner_id) {
+    auto it = scan_result_batchers_.find(scanner_id);
+    if (it == scan_result_batchers_.end()) {
+      LOG_WARN("Scan result batching is not enabled for scanner id %d", (uint16_t)scanner_id);
+      return;
+    }
+    if (!it->second.IsEmpty()) {
+      deliver_scan_result_batch(scanner_id, &it->second);
+    }
+    scan_result_batchers_.erase(it);
+    update_unbatched_scan_result_delivery();
+  }
+
   void configure_scan() {
     std::vector<PhyScanParameters> parameter_vector;
     PhyScanParameters phy_scan_parameters;
@@ -583,6 +647,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       if (!scanners_[i].in_use) {
         scanners_[i].app_uuid = app_uuid;
         scanners_[i].in_use = true;
+        update_unbatched_scan_result_delivery();
         scanning_callbacks_->OnScannerRegistered(app_uuid, i, ScanningCallback::ScanningStatus::SUCCESS);
         return;
       }
@@ -601,6 +666,8 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     if (scanners_[scanner_id].in_use) {
       scanners_[scanner_id].in_use = false;
       scanners_[scanner_id].app_uuid = Uuid::kEmpty;
+      scan_result_batchers_.erase(scanner_id);
+      update_unbatched_scan_result_delivery();
     } else {
       LOG_WARN("Unregister scanner with unused scanner id");
     }
@@ -654,6 +721,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       return;
     }
     is_scanning_ = false;
+    deliver_all_scan_result_batches();
 
     switch (api_type_) {
       case ScanApiType::EXTENDED:
@@ -1566,6 +1634,10 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   LeScanningFilterPolicy filter_policy_{LeScanningFilterPolicy::ACCEPT_ALL};
   BatchScanConfig batch_scan_config_;
   std::map<ScannerId, std::vector<uint8_t>> batch_scan_result_cache_;
+  std::map<ScannerId, ScanResultBatcher> scan_result_batchers_;
+  bool deliver_unbatched_scan_results_ = true;
+  std::unique_ptr<os::Alarm> scan_result_batch_alarm_;
+  std::optional<ScanResultBatcher::Clock::time_point> scan_result_batch_deadline_;
   std::unordered_map<uint8_t, ScannerId> tracker_id_map_;
   uint16_t total_num_of_advt_tracked_ = 0x00;
 
@@ -1723,6 +1795,14 @@ void LeScanningManager::TrackAdvertiser(uint8_t filter_index, ScannerId scanner_
   CallOn(pimpl_.get(), &impl::track_advertiser, filter_index, scanner_id);
 }
 
+void LeScanningManager::EnableScanResultBatching(ScannerId scanner_id, ScanResultBatchingConfig config) {
+  CallOn(pimpl_.get(), &impl::enable_scan_result_batching, scanner_id, config);
+}
+
+void LeScanningManager::DisableScanResultBatching(ScannerId scanner_id) {
+  CallOn(pimpl_.get(), &impl::disable_scan_result_batching, scanner_id);
+}
+
 void LeScanningManager::RegisterScanningCallback(ScanningCallback* scanning_callback) {
   CallOn(pimpl_.get(), &impl::register_scanning_callback, scanning_callback);
 }
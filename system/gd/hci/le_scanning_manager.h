@@ -20,6 +20,7 @@
 #include "common/callback.h"
 #include "hci/address_with_type.h"
 #include "hci/hci_packets.h"
+#include "hci/le_scan_result_batcher.h"
 #include "hci/le_scanning_callback.h"
 #include "hci/uuid.h"
 #include "module.h"
@@ -90,6 +91,10 @@ class LeScanningManager : public bluetooth::Module {
 
   virtual void TrackAdvertiser(uint8_t filter_index, ScannerId scanner_id);
 
+  /* Scan result batching, delivered by ScanningCallback::OnScanResultBatch instead of one OnScanResult per result */
+  virtual void EnableScanResultBatching(ScannerId scanner_id, ScanResultBatchingConfig config);
+  virtual void DisableScanResultBatching(ScannerId scanner_id);
+
   virtual void RegisterScanningCallback(ScanningCallback* scanning_callback);
 
   static const ModuleFactory Factory;
@@ -34,6 +34,7 @@ class MockScanningCallback : public ScanningCallback {
       void,
       OnScanResult,
       (uint16_t, uint8_t, Address, uint8_t, uint8_t, uint8_t, int8_t, int8_t, uint16_t, std::vector<uint8_t>));
+  MOCK_METHOD(void, OnScanResultBatch, (ScannerId, int, std::vector<uint8_t>));
   MOCK_METHOD(void, OnTrackAdvFoundLost, (AdvertisingFilterOnFoundOnLostInfo));
   MOCK_METHOD(void, OnBatchScanReports, (int, int, int, int, std::vector<uint8_t>));
   MOCK_METHOD(void, OnBatchScanThresholdCrossed, (int));
@@ -61,6 +62,8 @@ class MockLeScanningManager : public LeScanningManager {
   MOCK_METHOD(void, BatchScanDisable, ());
   MOCK_METHOD(void, BatchScanReadReport, (ScannerId, BatchScanMode));
   MOCK_METHOD(void, TrackAdvertiser, (uint8_t, ScannerId));
+  MOCK_METHOD(void, EnableScanResultBatching, (ScannerId, ScanResultBatchingConfig));
+  MOCK_METHOD(void, DisableScanResultBatching, (ScannerId));
   MOCK_METHOD(void, RegisterScanningCallback, (ScanningCallback*));
   MOCK_METHOD(void, StartSync, (uint8_t, const AddressWithType&, uint16_t, uint16_t, int));
   MOCK_METHOD(void, StopSync, (uint16_t));
@@ -340,6 +340,11 @@ class LeScanningManagerTest : public ::testing::Test {
          uint16_t periodic_advertising_interval,
          std::vector<uint8_t> advertising_data),
         (override));
+    MOCK_METHOD(
+        void,
+        OnScanResultBatch,
+        (ScannerId scanner_id, int num_results, std::vector<uint8_t> results),
+        (override));
     MOCK_METHOD(
         void,
         OnTrackAdvFoundLost,
@@ -432,6 +437,41 @@ TEST_F(LeScanningManagerTest, start_scan_test) {
   test_hci_layer_->IncomingLeMetaEvent(LeAdvertisingReportBuilder::Create({report}));
 }
 
+TEST_F(LeScanningManagerTest, scan_result_batching_test) {
+  Uuid app_uuid = Uuid::From16Bit(0x1234);
+  EXPECT_CALL(mock_callbacks_, OnScannerRegistered(app_uuid, ScannerId{1}, ScanningCallback::ScanningStatus::SUCCESS));
+  le_scanning_manager->RegisterScanner(app_uuid);
+  ScanResultBatchingConfig config;
+  config.max_batch_bytes = 2 * ScanResultBatcher::kResultHeaderSize;
+  config.max_latency = std::chrono::seconds(10);
+  le_scanning_manager->EnableScanResultBatching(ScannerId{1}, config);
+
+  std::vector<LeAdvertisingResponse> reports;
+  for (auto address : {"12:34:56:78:9a:bc", "12:34:56:78:9a:bd"}) {
+    LeAdvertisingResponse report{};
+    report.event_type_ = AdvertisingEventType::ADV_NONCONN_IND;
+    report.address_type_ = AddressType::PUBLIC_DEVICE_ADDRESS;
+    Address::FromString(address, report.address_);
+    LengthAndData data_item{};
+    data_item.data_.push_back(static_cast<uint8_t>(GapDataType::FLAGS));
+    data_item.data_.push_back(0x34);
+    report.advertising_data_ = {data_item};
+    reports.push_back(report);
+  }
+
+  // The only registered scanner batches its results, so none are delivered one by one
+  EXPECT_CALL(mock_callbacks_, OnScanResult).Times(0);
+  std::vector<uint8_t> results;
+  EXPECT_CALL(mock_callbacks_, OnScanResultBatch(ScannerId{1}, 2, _)).WillOnce(::testing::SaveArg<2>(&results));
+  test_hci_layer_->IncomingLeMetaEvent(LeAdvertisingReportBuilder::Create(reports));
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+
+  std::vector<Address> addresses;
+  ASSERT_TRUE(ScanResultBatcher::ForEachResult(
+      results, [&](const BatchedScanResult& result) { addresses.push_back(result.address); }));
+  ASSERT_EQ(addresses, std::vector<Address>({reports[0].address_, reports[1].address_}));
+}
+
 TEST_F(LeAndroidHciScanningManagerTest, startup_teardown) {}
 
 TEST_F(LeAndroidHciScanningManagerTest, start_scan_test) {
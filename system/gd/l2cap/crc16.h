@@ -0,0 +1,76 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-16 with the generator polynomial x^16 + x^15 + x^2 + 1 in bit-reflected form, the L2CAP Frame Check Sequence.
+// Header only, so that the legacy stack can share it without linking the GD L2CAP sources.
+
+namespace bluetooth {
+namespace l2cap {
+
+constexpr uint16_t kCrc16Polynomial = 0xa001;
+constexpr size_t kCrc16Slices = 8;
+
+// Slice-by-8 tables. table[0] is the classic byte-at-a-time table, table[k][b] is the CRC of b followed by k zeros.
+struct Crc16Tables {
+  uint16_t table[kCrc16Slices][256];
+};
+
+constexpr Crc16Tables MakeCrc16Tables() {
+  Crc16Tables tables = {};
+  for (uint16_t byte = 0; byte < 256; byte++) {
+    uint16_t crc = byte;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ kCrc16Polynomial : crc >> 1;
+    }
+    tables.table[0][byte] = crc;
+  }
+  for (size_t slice = 1; slice < kCrc16Slices; slice++) {
+    for (uint16_t byte = 0; byte < 256; byte++) {
+      uint16_t previous = tables.table[slice - 1][byte];
+      tables.table[slice][byte] = (previous >> 8) ^ tables.table[0][previous & 0xff];
+    }
+  }
+  return tables;
+}
+
+inline constexpr Crc16Tables kCrc16Tables = MakeCrc16Tables();
+
+inline uint16_t Crc16AddByte(uint16_t crc, uint8_t byte) {
+  return (crc >> 8) ^ kCrc16Tables.table[0][(crc ^ byte) & 0xff];
+}
+
+// Continues |crc| over |size| bytes of |data|, eight bytes per step
+inline uint16_t Crc16AddBytes(uint16_t crc, const uint8_t* data, size_t size) {
+  const auto& t = kCrc16Tables.table;
+  while (size >= kCrc16Slices) {
+    crc = t[7][(data[0] ^ crc) & 0xff] ^ t[6][data[1] ^ (crc >> 8)] ^ t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^
+          t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    data += kCrc16Slices;
+    size -= kCrc16Slices;
+  }
+  while (size-- > 0) {
+    crc = Crc16AddByte(crc, *data++);
+  }
+  return crc;
+}
+
+}  // namespace l2cap
+}  // namespace bluetooth
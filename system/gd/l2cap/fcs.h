@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace bluetooth {
@@ -28,6 +29,8 @@ class Fcs {
 
   void AddByte(uint8_t byte);
 
+  void AddBytes(const uint8_t* data, size_t size);
+
   uint16_t GetChecksum() const;
 
  private:
@@ -18,6 +18,7 @@
 #include "module.h"
 #include "common/init_flags.h"
 #include "dumpsys/init_flags.h"
+#include "handler_generated.h"
 #include "os/wakelock_manager.h"
 
 using ::bluetooth::os::Handler;
@@ -143,6 +144,26 @@ void ModuleDumper::DumpState(std::string* output) const {
   auto init_flags_offset = dumpsys::InitFlags::Dump(&builder);
   auto wakelock_offset = WakelockManager::Get().GetDumpsysData(&builder);
 
+  std::vector<flatbuffers::Offset<bluetooth::os::HandlerData>> handler_offsets;
+  for (auto it = module_registry_.start_order_.begin(); it != module_registry_.start_order_.end(); it++) {
+    auto instance = module_registry_.started_modules_.find(*it);
+    ASSERT(instance != module_registry_.started_modules_.end());
+    auto stats = instance->second->handler_->GetStats();
+    auto handler_title = builder.CreateString(instance->second->ToString());
+    bluetooth::os::HandlerDataBuilder handler_builder(builder);
+    handler_builder.add_title(handler_title);
+    handler_builder.add_posted_count(stats.posted_count);
+    handler_builder.add_executed_count(stats.executed_count);
+    handler_builder.add_wakeup_count(stats.wakeup_count);
+    handler_builder.add_queue_depth(stats.queue_depth);
+    handler_builder.add_max_queue_depth(stats.max_queue_depth);
+    handler_builder.add_max_drain_batch(stats.max_drain_batch);
+    handler_builder.add_avg_latency_us(stats.executed_count == 0 ? 0 : stats.total_latency_us / stats.executed_count);
+    handler_builder.add_max_latency_us(stats.max_latency_us);
+    handler_offsets.push_back(handler_builder.Finish());
+  }
+  auto handler_data_offset = builder.CreateVector(handler_offsets);
+
   std::queue<DumpsysDataFinisher> queue;
   for (auto it = module_registry_.start_order_.rbegin(); it != module_registry_.start_order_.rend(); it++) {
     auto instance = module_registry_.started_modules_.find(*it);
@@ -154,6 +175,7 @@ void ModuleDumper::DumpState(std::string* output) const {
   data_builder.add_title(title);
   data_builder.add_init_flags(init_flags_offset);
   data_builder.add_wakelock_manager_data(wakelock_offset);
+  data_builder.add_module_handler_data(handler_data_offset);
 
   while (!queue.empty()) {
     queue.front()(&data_builder);
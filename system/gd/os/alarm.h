@@ -23,14 +23,15 @@
 #include "common/callback.h"
 #include "os/handler.h"
 #include "os/thread.h"
+#include "os/timer_queue.h"
 #include "os/utils.h"
 
 namespace bluetooth {
 namespace os {
 
-// A single-shot alarm for reactor-based thread, implemented by Linux timerfd.
-// When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
-// itself from the thread.
+// A single-shot alarm for reactor-based thread, multiplexed with the other alarms of the thread onto the thread's
+// TimerQueue. When it's constructed, it will attach itself to the timer queue of the specified thread; when it's
+// destroyed, it will detach itself from it.
 class Alarm {
  public:
   // Create and register a single-shot alarm on a given handler
@@ -51,8 +52,7 @@ class Alarm {
  private:
   common::OnceClosure task_;
   Handler* handler_;
-  int fd_ = 0;
-  Reactor::Reactable* token_;
+  TimerQueue::Timer timer_;
   mutable std::mutex mutex_;
   void on_fire();
 };
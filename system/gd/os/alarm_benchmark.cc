@@ -16,7 +16,9 @@
 
 #include <chrono>
 #include <future>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "common/bind.h"
@@ -71,6 +73,13 @@ class BM_ReactableAlarm : public ::benchmark::Fixture {
     promise_.set_value();
   }
 
+  void CountFiredTask() {
+    task_counter_++;
+    if (task_counter_ == scheduled_tasks_) {
+      promise_.set_value();
+    }
+  }
+
   int64_t scheduled_tasks_;
   int64_t task_length_;
   int64_t task_interval_;
@@ -140,3 +149,59 @@ BENCHMARK_REGISTER_F(BM_ReactableAlarm, periodic_accuracy)
     ->Args({2000, 15, 20})
     ->Iterations(1)
     ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ReactableAlarm, schedule_and_cancel_with_live_alarms)(State& state) {
+  std::vector<std::unique_ptr<Alarm>> live_alarms;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    live_alarms.emplace_back(std::make_unique<Alarm>(handler_.get()));
+    // Spread the live alarms over an hour so the heap is fully populated
+    live_alarms.back()->Schedule(
+        bluetooth::common::BindOnce([]() {}), std::chrono::milliseconds(3600000 - i * 3600000 / state.range(0)));
+  }
+  int64_t delay_ms = 0;
+  for (auto _ : state) {
+    delay_ms = (delay_ms + 7919) % 3600000;
+    alarm_->Schedule(bluetooth::common::BindOnce([]() {}), std::chrono::milliseconds(60000 + delay_ms));
+    alarm_->Cancel();
+  }
+  for (auto& alarm : live_alarms) {
+    alarm->Cancel();
+  }
+  state.SetItemsProcessed(state.iterations());
+};
+
+BENCHMARK_REGISTER_F(BM_ReactableAlarm, schedule_and_cancel_with_live_alarms)->Arg(1000)->Arg(10000);
+
+BENCHMARK_DEFINE_F(BM_ReactableAlarm, fire_all_live_alarms)(State& state) {
+  std::vector<std::unique_ptr<Alarm>> live_alarms;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    live_alarms.emplace_back(std::make_unique<Alarm>(handler_.get()));
+  }
+  thread_->GetTimerQueue()->SetSlack(std::chrono::milliseconds(state.range(1)));
+  for (auto _ : state) {
+    task_counter_ = 0;
+    scheduled_tasks_ = state.range(0);
+    promise_ = std::promise<void>();
+    auto start_time_point = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < state.range(0); i++) {
+      // Deadlines spread over 10ms, so a slack of 10ms fires every alarm in a single wakeup
+      live_alarms[i]->Schedule(
+          bluetooth::common::BindOnce(
+              &BM_ReactableAlarm_fire_all_live_alarms_Benchmark::CountFiredTask, bluetooth::common::Unretained(this)),
+          std::chrono::milliseconds(1 + i % 10));
+    }
+    promise_.get_future().get();
+    auto duration = std::chrono::steady_clock::now() - start_time_point;
+    state.SetIterationTime(std::chrono::duration_cast<std::chrono::duration<double>>(duration).count());
+  }
+  thread_->GetTimerQueue()->SetSlack(std::chrono::milliseconds(0));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+};
+
+BENCHMARK_REGISTER_F(BM_ReactableAlarm, fire_all_live_alarms)
+    ->Args({1000, 0})
+    ->Args({1000, 10})
+    ->Args({10000, 0})
+    ->Args({10000, 10})
+    ->Iterations(10)
+    ->UseManualTime();
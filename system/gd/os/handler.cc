@@ -28,40 +28,67 @@ namespace bluetooth {
 namespace os {
 using common::OnceClosure;
 
-Handler::Handler(Thread* thread) : tasks_(new std::queue<OnceClosure>()), thread_(thread) {
+namespace {
+
+void update_max(std::atomic<int64_t>* max, int64_t value) {
+  int64_t current = max->load(std::memory_order_relaxed);
+  while (value > current && !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void update_max(std::atomic<uint64_t>* max, uint64_t value) {
+  uint64_t current = max->load(std::memory_order_relaxed);
+  while (value > current && !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+Handler::Handler(Thread* thread) : inbox_head_(&inbox_stub_), inbox_tail_(&inbox_stub_), thread_(thread) {
   event_ = thread_->GetReactor()->NewEvent();
   reactable_ = thread_->GetReactor()->Register(
       event_->Id(), common::Bind(&Handler::handle_next_event, common::Unretained(this)), common::Closure());
 }
 
 Handler::~Handler() {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    ASSERT_LOG(was_cleared(), "Handlers must be cleared before they are destroyed");
+  ASSERT_LOG(was_cleared(), "Handlers must be cleared before they are destroyed");
+  // Closures posted while Clear() was running are discarded here
+  while (Task* task = pop_task()) {
+    delete task;
   }
   event_->Close();
 }
 
 void Handler::Post(OnceClosure closure) {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (was_cleared()) {
-      LOG_WARN("Posting to a handler which has been cleared");
-      return;
-    }
-    tasks_->emplace(std::move(closure));
+  if (was_cleared()) {
+    LOG_WARN("Posting to a handler which has been cleared");
+    return;
+  }
+  Task* task = new Task();
+  task->closure = std::move(closure);
+  task->posted_time = std::chrono::steady_clock::now();
+  posted_count_.fetch_add(1, std::memory_order_relaxed);
+  update_max(&max_queue_depth_, queue_depth_.fetch_add(1, std::memory_order_relaxed) + 1);
+  push_task(task);
+
+  // Only the post that makes the handler runnable wakes the reactor up
+  if (!scheduled_.exchange(true)) {
+    event_->Notify();
   }
-  event_->Notify();
 }
 
 void Handler::Clear() {
-  std::queue<OnceClosure>* tmp = nullptr;
+  bool already_cleared = cleared_.exchange(true);
+  ASSERT_LOG(!already_cleared, "Handlers must only be cleared once");
+
+  // Destroy the pending closures now, and what they hold along with them
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    ASSERT_LOG(!was_cleared(), "Handlers must only be cleared once");
-    std::swap(tasks_, tmp);
+    std::lock_guard<std::mutex> lock(consumer_mutex_);
+    while (Task* task = pop_task()) {
+      queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+      delete task;
+    }
   }
-  delete tmp;
 
   event_->Clear();
 
@@ -74,21 +101,103 @@ void Handler::WaitUntilStopped(std::chrono::milliseconds timeout) {
   ASSERT(thread_->GetReactor()->WaitForUnregisteredReactable(timeout));
 }
 
+Handler::Stats Handler::GetStats() const {
+  return Stats{
+      .posted_count = posted_count_.load(std::memory_order_relaxed),
+      .executed_count = executed_count_.load(std::memory_order_relaxed),
+      .wakeup_count = wakeup_count_.load(std::memory_order_relaxed),
+      .queue_depth = queue_depth_.load(std::memory_order_relaxed),
+      .max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed),
+      .max_drain_batch = max_drain_batch_.load(std::memory_order_relaxed),
+      .total_latency_us = total_latency_us_.load(std::memory_order_relaxed),
+      .max_latency_us = max_latency_us_.load(std::memory_order_relaxed),
+  };
+}
+
+void Handler::push_task(Task* task) {
+  task->next.store(nullptr, std::memory_order_relaxed);
+  Task* previous = inbox_head_.exchange(task, std::memory_order_acq_rel);
+  previous->next.store(task, std::memory_order_release);
+}
+
+Handler::Task* Handler::pop_task() {
+  Task* tail = inbox_tail_;
+  Task* next = tail->next.load(std::memory_order_acquire);
+  if (tail == &inbox_stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+    inbox_tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    inbox_tail_ = next;
+    return tail;
+  }
+  if (tail != inbox_head_.load(std::memory_order_acquire)) {
+    // A producer swapped the head but hasn't linked its task yet
+    return nullptr;
+  }
+  // |tail| is the last task: put the stub behind it so it can be handed out
+  push_task(&inbox_stub_);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    inbox_tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+bool Handler::inbox_empty() const {
+  return inbox_tail_ == &inbox_stub_ && inbox_head_.load() == &inbox_stub_;
+}
+
 void Handler::handle_next_event() {
-  common::OnceClosure closure;
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    bool has_data = event_->Read();
+  event_->Read();
+  wakeup_count_.fetch_add(1, std::memory_order_relaxed);
 
-    if (was_cleared()) {
-      return;
+  uint64_t batch = 0;
+  while (batch < kMaxClosuresPerWakeup) {
+    Task* task = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(consumer_mutex_);
+      if (!was_cleared()) {
+        task = pop_task();
+      }
+    }
+    if (task == nullptr) {
+      break;
     }
-    ASSERT_LOG(has_data, "Notified for work but no work available");
+    queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+    auto latency_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                std::chrono::steady_clock::now() - task->posted_time)
+                                                .count());
+    total_latency_us_.fetch_add(latency_us, std::memory_order_relaxed);
+    update_max(&max_latency_us_, latency_us);
 
-    closure = std::move(tasks_->front());
-    tasks_->pop();
+    OnceClosure closure = std::move(task->closure);
+    delete task;
+    batch++;
+    executed_count_.fetch_add(1, std::memory_order_relaxed);
+    std::move(closure).Run();
+  }
+  update_max(&max_drain_batch_, batch);
+
+  std::lock_guard<std::mutex> lock(consumer_mutex_);
+  if (was_cleared()) {
+    return;
+  }
+  if (batch == kMaxClosuresPerWakeup && !inbox_empty()) {
+    // Still scheduled, yield to the other reactables of this thread and come back
+    event_->Notify();
+    return;
+  }
+  // Go idle, then look again: a producer that saw |scheduled_| still set before the store didn't notify
+  scheduled_.store(false);
+  if (!inbox_empty() && !scheduled_.exchange(true)) {
+    event_->Notify();
   }
-  std::move(closure).Run();
 }
 
 }  // namespace os
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -33,8 +36,26 @@ namespace os {
 // A message-queue style handler for reactor-based thread to handle incoming events from different threads. When it's
 // constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister itself
 // from the thread.
+//
+// Posted closures go through a lock-free multi-producer inbox. The reactor is only notified when the handler goes from
+// idle to scheduled, and each wakeup runs up to kMaxClosuresPerWakeup closures.
 class Handler : public common::IPostableContext {
  public:
+  // Upper bound of closures run per reactor wakeup, so a busy handler can't starve the other reactables of its thread
+  static constexpr size_t kMaxClosuresPerWakeup = 32;
+
+  // Counters exposed through dumpsys
+  struct Stats {
+    uint64_t posted_count;
+    uint64_t executed_count;
+    uint64_t wakeup_count;
+    int64_t queue_depth;
+    int64_t max_queue_depth;
+    uint64_t max_drain_batch;
+    uint64_t total_latency_us;
+    uint64_t max_latency_us;
+  };
+
   // Create and register a handler on given thread
   explicit Handler(Thread* thread);
 
@@ -53,6 +74,9 @@ class Handler : public common::IPostableContext {
   // Die if the current reactable doesn't stop before the timeout.  Must be called after Clear()
   void WaitUntilStopped(std::chrono::milliseconds timeout);
 
+  // Return a snapshot of the counters of this handler
+  Stats GetStats() const;
+
   template <typename Functor, typename... Args>
   void Call(Functor&& functor, Args&&... args) {
     Post(common::BindOnce(std::forward<Functor>(functor), std::forward<Args>(args)...));
@@ -93,20 +117,51 @@ class Handler : public common::IPostableContext {
   template <typename T>
   friend class Queue;
 
+  template <typename T>
+  friend class SpscQueue;
+
   friend class Alarm;
 
   friend class RepeatingAlarm;
 
  private:
+  struct Task {
+    std::atomic<Task*> next{nullptr};
+    common::OnceClosure closure;
+    std::chrono::steady_clock::time_point posted_time;
+  };
+
   inline bool was_cleared() const {
-    return tasks_ == nullptr;
+    return cleared_.load(std::memory_order_acquire);
   };
-  std::queue<common::OnceClosure>* tasks_;
+  // Producer side of the inbox, any thread
+  void push_task(Task* task);
+  // Consumer side of the inbox, with |consumer_mutex_| held. Returns nullptr when empty or when a producer is mid-push.
+  Task* pop_task();
+  bool inbox_empty() const;
+
+  // Intrusive MPSC queue: producers exchange |inbox_head_|, the consumer advances |inbox_tail_|
+  std::atomic<Task*> inbox_head_;
+  Task* inbox_tail_;
+  Task inbox_stub_;
+  // True from the first Post() after the handler went idle until the consumer drained the inbox
+  std::atomic<bool> scheduled_{false};
+  std::atomic<bool> cleared_{false};
+  // Serializes the consumer side of the inbox between the reactor thread and Clear(). Never held while a closure runs.
+  std::mutex consumer_mutex_;
   Thread* thread_;
   std::unique_ptr<Reactor::Event> event_;
   Reactor::Reactable* reactable_;
-  mutable std::mutex mutex_;
   void handle_next_event();
+
+  std::atomic<uint64_t> posted_count_{0};
+  std::atomic<uint64_t> executed_count_{0};
+  std::atomic<uint64_t> wakeup_count_{0};
+  std::atomic<int64_t> queue_depth_{0};
+  std::atomic<int64_t> max_queue_depth_{0};
+  std::atomic<uint64_t> max_drain_batch_{0};
+  std::atomic<uint64_t> total_latency_us_{0};
+  std::atomic<uint64_t> max_latency_us_{0};
 };
 
 }  // namespace os
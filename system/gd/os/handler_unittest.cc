@@ -18,6 +18,7 @@
 
 #include <future>
 #include <thread>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -35,6 +36,7 @@ class HandlerTest : public ::testing::Test {
     handler_ = new Handler(thread_);
   }
   void TearDown() override {
+    handler_->WaitUntilStopped(std::chrono::milliseconds(2000));
     delete handler_;
     delete thread_;
   }
@@ -86,6 +88,27 @@ TEST_F(HandlerTest, post_task_cleared) {
   ASSERT_EQ(val, 1);
 }
 
+TEST_F(HandlerTest, clear_destroys_pending_closures) {
+  std::promise<void> closure_started;
+  auto closure_started_future = closure_started.get_future();
+  std::promise<void> closure_can_continue;
+  handler_->Post(common::BindOnce(
+      [](std::promise<void> closure_started, std::future<void> can_continue_future) {
+        closure_started.set_value();
+        can_continue_future.wait();
+      },
+      std::move(closure_started),
+      closure_can_continue.get_future()));
+  auto resource = std::make_shared<int>(0);
+  std::weak_ptr<int> weak_resource = resource;
+  handler_->Post(common::BindOnce([](std::shared_ptr<int> resource) { ASSERT_TRUE(false); }, std::move(resource)));
+  closure_started_future.wait();
+  handler_->Clear();
+  // Released by Clear(), not by the destruction of the handler
+  ASSERT_TRUE(weak_resource.expired());
+  closure_can_continue.set_value();
+}
+
 void check_int(std::unique_ptr<int> number, std::shared_ptr<int> to_change) {
   *to_change = *number;
 }
@@ -108,6 +131,79 @@ TEST_F(HandlerTest, callback_with_promise) {
   handler_->Clear();
 }
 
+TEST_F(HandlerTest, post_from_multiple_threads_keeps_per_thread_order) {
+  static constexpr int kNumProducers = 4;
+  static constexpr int kPostsPerProducer = 1000;
+  std::vector<int> last_received(kNumProducers, -1);
+  int total_received = 0;
+  bool in_order = true;
+  std::promise<void> all_received;
+  auto future = all_received.get_future();
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kNumProducers; producer++) {
+    producers.emplace_back([&, producer]() {
+      for (int i = 0; i < kPostsPerProducer; i++) {
+        handler_->Post(common::BindOnce(
+            [](std::vector<int>* last_received,
+               int* total_received,
+               bool* in_order,
+               std::promise<void>* all_received,
+               int producer,
+               int i) {
+              *in_order &= ((*last_received)[producer] + 1 == i);
+              (*last_received)[producer] = i;
+              if (++(*total_received) == kNumProducers * kPostsPerProducer) {
+                all_received->set_value();
+              }
+            },
+            common::Unretained(&last_received),
+            common::Unretained(&total_received),
+            common::Unretained(&in_order),
+            common::Unretained(&all_received),
+            producer,
+            i));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  future.wait();
+  EXPECT_TRUE(in_order);
+
+  auto stats = handler_->GetStats();
+  EXPECT_EQ(stats.posted_count, static_cast<uint64_t>(kNumProducers * kPostsPerProducer));
+  EXPECT_EQ(stats.executed_count, stats.posted_count);
+  EXPECT_EQ(stats.queue_depth, 0);
+  EXPECT_LE(stats.max_drain_batch, Handler::kMaxClosuresPerWakeup);
+  EXPECT_LE(stats.wakeup_count, stats.posted_count);
+  handler_->Clear();
+}
+
+TEST_F(HandlerTest, posts_while_busy_share_a_wakeup) {
+  std::promise<void> can_continue;
+  auto can_continue_future = can_continue.get_future();
+  handler_->Post(common::BindOnce([](std::future<void> future) { future.wait(); }, std::move(can_continue_future)));
+
+  constexpr int kNumPosts = 10;
+  int val = 0;
+  for (int i = 0; i < kNumPosts; i++) {
+    handler_->Post(common::BindOnce([](int* val) { (*val)++; }, common::Unretained(&val)));
+  }
+  std::promise<void> done;
+  auto done_future = done.get_future();
+  handler_->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&done)));
+  can_continue.set_value();
+  done_future.wait();
+
+  EXPECT_EQ(val, kNumPosts);
+  // Closures posted while the handler is already scheduled don't notify the reactor again. A second wakeup is only
+  // possible if the first one raced with the second post.
+  EXPECT_LE(handler_->GetStats().wakeup_count, 2u);
+  handler_->Clear();
+}
+
 // For Death tests, all the threading needs to be done in the ASSERT_DEATH call
 class HandlerDeathTest : public ::testing::Test {
  protected:
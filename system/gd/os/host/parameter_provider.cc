@@ -32,6 +32,7 @@ std::mutex parameter_mutex;
 std::string config_file_path;
 std::string snoop_log_file_path;
 std::string snooz_log_file_path;
+bool is_common_criteria_mode = false;
 }  // namespace
 
 // Write to $PWD/bt_stack.conf if $PWD can be found, otherwise, write to $HOME/bt_stack.conf
@@ -103,10 +104,14 @@ bluetooth_keystore::BluetoothKeystoreInterface* ParameterProvider::GetBtKeystore
 void ParameterProvider::SetBtKeystoreInterface(bluetooth_keystore::BluetoothKeystoreInterface* bt_keystore) {}
 
 bool ParameterProvider::IsCommonCriteriaMode() {
-  return false;
+  std::lock_guard<std::mutex> lock(parameter_mutex);
+  return is_common_criteria_mode;
 }
 
-void ParameterProvider::SetCommonCriteriaMode(bool enable) {}
+void ParameterProvider::SetCommonCriteriaMode(bool enable) {
+  std::lock_guard<std::mutex> lock(parameter_mutex);
+  is_common_criteria_mode = enable;
+}
 
 int ParameterProvider::GetCommonCriteriaConfigCompareResult() {
   return 0b11;
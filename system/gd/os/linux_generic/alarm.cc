@@ -16,72 +16,43 @@
 
 #include "os/alarm.h"
 
-#include <sys/timerfd.h>
-#include <unistd.h>
-
-#include <cstring>
-
 #include "common/bind.h"
-#include "os/linux_generic/linux.h"
 #include "os/log.h"
 #include "os/utils.h"
 
-#ifdef OS_ANDROID
-#define ALARM_CLOCK CLOCK_BOOTTIME_ALARM
-#else
-#define ALARM_CLOCK CLOCK_BOOTTIME
-#endif
-
 namespace bluetooth {
 namespace os {
-using common::Closure;
 using common::OnceClosure;
 
-Alarm::Alarm(Handler* handler) : handler_(handler), fd_(TIMERFD_CREATE(ALARM_CLOCK, 0)) {
-  ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
-
-  token_ = handler_->thread_->GetReactor()->Register(
-      fd_, common::Bind(&Alarm::on_fire, common::Unretained(this)), Closure());
+Alarm::Alarm(Handler* handler)
+    : handler_(handler), timer_(common::Bind(&Alarm::on_fire, common::Unretained(this))) {
+  handler_->thread_->GetTimerQueue()->Attach(&timer_);
 }
 
 Alarm::~Alarm() {
-  handler_->thread_->GetReactor()->Unregister(token_);
-
-  int close_status;
-  RUN_NO_INTR(close_status = TIMERFD_CLOSE(fd_));
-  ASSERT(close_status != -1);
+  handler_->thread_->GetTimerQueue()->Detach(&timer_);
 }
 
 void Alarm::Schedule(OnceClosure task, std::chrono::milliseconds delay) {
   std::lock_guard<std::mutex> lock(mutex_);
-  long delay_ms = delay.count();
-  itimerspec timer_itimerspec{{/* interval for periodic timer */}, {delay_ms / 1000, delay_ms % 1000 * 1000000}};
-  int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
-  ASSERT(result == 0);
-
+  handler_->thread_->GetTimerQueue()->Arm(&timer_, delay, std::chrono::milliseconds(0));
   task_ = std::move(task);
 }
 
 void Alarm::Cancel() {
   std::lock_guard<std::mutex> lock(mutex_);
-  itimerspec disarm_itimerspec{/* disarm timer */};
-  int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
-  ASSERT(result == 0);
+  handler_->thread_->GetTimerQueue()->Disarm(&timer_);
 }
 
 void Alarm::on_fire() {
   std::unique_lock<std::mutex> lock(mutex_);
   auto task = std::move(task_);
-  uint64_t times_invoked;
-  auto bytes_read = read(fd_, &times_invoked, sizeof(uint64_t));
   lock.unlock();
+  // A Schedule() racing with an expiration that was already being dispatched leaves nothing to run for the second one
+  if (task.is_null()) {
+    return;
+  }
   std::move(task).Run();
-  ASSERT(bytes_read == static_cast<ssize_t>(sizeof(uint64_t)));
-  ASSERT_LOG(
-      times_invoked == static_cast<uint64_t>(1),
-      "Invoked number of times:%lu fd:%d",
-      (unsigned long)times_invoked,
-      fd_);
 }
 
 }  // namespace os
@@ -17,6 +17,8 @@
 #include "os/alarm.h"
 
 #include <future>
+#include <memory>
+#include <vector>
 
 #include "common/bind.h"
 #include "gtest/gtest.h"
@@ -50,8 +52,6 @@ class AlarmTest : public ::testing::Test {
     handler_->Post(common::BindOnce(fake_timerfd_advance, ms));
   }
   Alarm* alarm_;
-
- private:
   Handler* handler_;
   Thread* thread_;
 };
@@ -99,6 +99,54 @@ TEST_F(AlarmTest, delete_while_alarm_armed) {
   std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
+TEST_F(AlarmTest, alarms_of_a_thread_fire_in_deadline_order) {
+  std::vector<std::unique_ptr<Alarm>> alarms;
+  std::vector<int> fired;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  for (int i = 0; i < 5; i++) {
+    alarms.emplace_back(std::make_unique<Alarm>(handler_));
+  }
+  for (int i = 0; i < 5; i++) {
+    alarms[i]->Schedule(
+        BindOnce(
+            [](std::vector<int>* fired, std::promise<void>* promise, int id) {
+              fired->push_back(id);
+              if (fired->size() == 5) {
+                promise->set_value();
+              }
+            },
+            common::Unretained(&fired),
+            common::Unretained(&promise),
+            i),
+        std::chrono::milliseconds(50 - i * 10));
+  }
+  ASSERT_EQ(thread_->GetTimerQueue()->GetArmedCount(), 5u);
+  fake_timer_advance(50);
+  future.get();
+  EXPECT_EQ(fired, std::vector<int>({4, 3, 2, 1, 0}));
+  EXPECT_EQ(thread_->GetTimerQueue()->GetArmedCount(), 0u);
+}
+
+TEST_F(AlarmTest, cancel_other_alarm_from_callback) {
+  Alarm other(handler_);
+  other.Schedule(BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }), std::chrono::milliseconds(10));
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  alarm_->Schedule(
+      BindOnce(
+          [](Alarm* other, std::promise<void>* promise) {
+            other->Cancel();
+            promise->set_value();
+          },
+          common::Unretained(&other),
+          common::Unretained(&promise)),
+      std::chrono::milliseconds(5));
+  fake_timer_advance(10);
+  future.get();
+  EXPECT_EQ(thread_->GetTimerQueue()->GetArmedCount(), 0u);
+}
+
 }  // namespace
 }  // namespace os
 }  // namespace bluetooth
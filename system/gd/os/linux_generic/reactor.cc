@@ -142,8 +142,13 @@ void Reactor::Run() {
     if (waiting_for_idle && count == 0) {
       timeout_ms = -1;
       waiting_for_idle = false;
-      idle_promise_->set_value();
-      idle_promise_ = nullptr;
+      // Take the promise before fulfilling it, the waiter may call WaitForIdle() again as soon as it is set
+      std::shared_ptr<std::promise<void>> idle_promise;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_promise = std::move(idle_promise_);
+      }
+      idle_promise->set_value();
     }
 
     for (int i = 0; i < count; ++i) {
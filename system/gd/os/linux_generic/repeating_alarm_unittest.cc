@@ -17,6 +17,7 @@
 #include "os/repeating_alarm.h"
 
 #include <future>
+#include <vector>
 
 #include "common/bind.h"
 #include "gtest/gtest.h"
@@ -46,8 +47,7 @@ class RepeatingAlarmTest : public ::testing::Test {
   }
 
   void VerifyMultipleDelayedTasks(int scheduled_tasks, int task_length_ms, int interval_between_tasks_ms) {
-    std::promise<void> promise;
-    auto future = promise.get_future();
+    std::vector<std::promise<void>> promises(scheduled_tasks);
     auto start_time = std::chrono::steady_clock::now();
     int counter = 0;
     alarm_->Schedule(
@@ -57,12 +57,15 @@ class RepeatingAlarmTest : public ::testing::Test {
             common::Unretained(&counter),
             start_time,
             scheduled_tasks,
-            common::Unretained(&promise),
+            common::Unretained(&promises),
             task_length_ms,
             interval_between_tasks_ms),
         std::chrono::milliseconds(interval_between_tasks_ms));
-    fake_timer_advance(interval_between_tasks_ms * scheduled_tasks);
-    future.get();
+    // Missed periods are coalesced, so let each period elapse separately
+    for (auto& promise : promises) {
+      fake_timer_advance(interval_between_tasks_ms);
+      promise.get_future().get();
+    }
     alarm_->Cancel();
   }
 
@@ -70,12 +73,12 @@ class RepeatingAlarmTest : public ::testing::Test {
       int* counter,
       std::chrono::steady_clock::time_point start_time,
       int scheduled_tasks,
-      std::promise<void>* promise,
+      std::vector<std::promise<void>>* promises,
       int task_length_ms,
       int interval_between_tasks_ms) {
     *counter = *counter + 1;
-    if (*counter == scheduled_tasks) {
-      promise->set_value();
+    if (*counter <= scheduled_tasks) {
+      (*promises)[*counter - 1].set_value();
     }
   }
 
@@ -83,6 +86,14 @@ class RepeatingAlarmTest : public ::testing::Test {
     handler_->Post(common::BindOnce(fake_timerfd_advance, ms));
   }
 
+  // Wait for the handler thread to finish what it is running, e.g. the alarm tasks of the current wakeup
+  void sync_handler() {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)));
+    future.get();
+  }
+
   RepeatingAlarm* alarm_;
 
   common::Closure should_not_happen_ = common::Bind([] { ASSERT_TRUE(false); });
@@ -138,6 +149,41 @@ TEST_F(RepeatingAlarmTest, delete_while_alarm_armed) {
   std::this_thread::sleep_for(std::chrono::milliseconds(1));
 }
 
+TEST_F(RepeatingAlarmTest, coalesce_missed_periods) {
+  std::promise<void> first_run;
+  std::promise<void> second_run;
+  int counter = 0;
+  alarm_->Schedule(
+      common::Bind(
+          [](int* counter, std::promise<void>* first_run, std::promise<void>* second_run) {
+            *counter = *counter + 1;
+            if (*counter == 1) {
+              first_run->set_value();
+            } else if (*counter == 2) {
+              second_run->set_value();
+            }
+          },
+          common::Unretained(&counter),
+          common::Unretained(&first_run),
+          common::Unretained(&second_run)),
+      std::chrono::milliseconds(10));
+
+  // A stall of ten periods runs the task once, instead of ten times back to back
+  auto first_run_future = first_run.get_future();
+  fake_timer_advance(100);
+  first_run_future.get();
+  sync_handler();
+  ASSERT_EQ(counter, 1);
+
+  // The following run keeps to the original period
+  auto second_run_future = second_run.get_future();
+  fake_timer_advance(10);
+  second_run_future.get();
+  sync_handler();
+  ASSERT_EQ(counter, 2);
+  alarm_->Cancel();
+}
+
 TEST_F(RepeatingAlarmTest, verify_small) {
   VerifyMultipleDelayedTasks(100, 1, 10);
 }
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace spsc_queue_internal {
+
+inline size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace spsc_queue_internal
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+    : capacity_(capacity),
+      mask_(spsc_queue_internal::RoundUpToPowerOfTwo(capacity) - 1),
+      ring_(spsc_queue_internal::RoundUpToPowerOfTwo(capacity)) {
+  ASSERT(capacity_ > 0);
+  // The ring starts empty, so the enqueue end is ready right away
+  enqueue_.event_.Notify();
+}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue() {
+  ASSERT_LOG(enqueue_.handler_ == nullptr, "Enqueue is not unregistered");
+  ASSERT_LOG(dequeue_.handler_ == nullptr, "Dequeue is not unregistered");
+}
+
+template <typename T>
+void SpscQueue<T>::RegisterEnqueue(Handler* handler, EnqueueCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(enqueue_.handler_ == nullptr);
+  ASSERT(enqueue_.reactable_ == nullptr);
+  enqueue_.handler_ = handler;
+  enqueue_.reactable_ = enqueue_.handler_->thread_->GetReactor()->Register(
+      enqueue_.event_.Id(),
+      base::Bind(&SpscQueue<T>::EnqueueCallbackInternal, base::Unretained(this), std::move(callback)),
+      base::Closure());
+}
+
+template <typename T>
+void SpscQueue<T>::UnregisterEnqueue() {
+  Reactor* reactor = nullptr;
+  Reactor::Reactable* to_unregister = nullptr;
+  bool wait_for_unregister = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT(enqueue_.reactable_ != nullptr);
+    reactor = enqueue_.handler_->thread_->GetReactor();
+    wait_for_unregister = (!enqueue_.handler_->thread_->IsSameThread());
+    to_unregister = enqueue_.reactable_;
+    enqueue_.reactable_ = nullptr;
+    enqueue_.handler_ = nullptr;
+  }
+  reactor->Unregister(to_unregister);
+  if (wait_for_unregister) {
+    reactor->WaitForUnregisteredReactable(std::chrono::milliseconds(1000));
+  }
+}
+
+template <typename T>
+void SpscQueue<T>::RegisterDequeue(Handler* handler, DequeueCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(dequeue_.handler_ == nullptr);
+  ASSERT(dequeue_.reactable_ == nullptr);
+  dequeue_.handler_ = handler;
+  dequeue_.reactable_ = dequeue_.handler_->thread_->GetReactor()->Register(
+      dequeue_.event_.Id(),
+      base::Bind(&SpscQueue<T>::DequeueCallbackInternal, base::Unretained(this), std::move(callback)),
+      base::Closure());
+}
+
+template <typename T>
+void SpscQueue<T>::UnregisterDequeue() {
+  Reactor* reactor = nullptr;
+  Reactor::Reactable* to_unregister = nullptr;
+  bool wait_for_unregister = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT(dequeue_.reactable_ != nullptr);
+    reactor = dequeue_.handler_->thread_->GetReactor();
+    wait_for_unregister = (!dequeue_.handler_->thread_->IsSameThread());
+    to_unregister = dequeue_.reactable_;
+    dequeue_.reactable_ = nullptr;
+    dequeue_.handler_ = nullptr;
+  }
+  reactor->Unregister(to_unregister);
+  if (wait_for_unregister) {
+    reactor->WaitForUnregisteredReactable(std::chrono::milliseconds(1000));
+  }
+}
+
+template <typename T>
+std::unique_ptr<T> SpscQueue<T>::TryDequeue() {
+  if (size_.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+
+  std::unique_ptr<T> data = std::move(ring_[head_ & mask_]);
+  head_++;
+
+  OnDequeued(size_.fetch_sub(1, std::memory_order_acq_rel), 1);
+  return data;
+}
+
+template <typename T>
+std::vector<std::unique_ptr<T>> SpscQueue<T>::TryDequeueBatch(size_t max_count) {
+  std::vector<std::unique_ptr<T>> batch;
+  size_t available = size_.load(std::memory_order_acquire);
+  size_t count = std::min(available, max_count);
+  if (count == 0) {
+    return batch;
+  }
+
+  batch.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    batch.emplace_back(std::move(ring_[head_ & mask_]));
+    head_++;
+  }
+
+  OnDequeued(size_.fetch_sub(count, std::memory_order_acq_rel), count);
+  return batch;
+}
+
+template <typename T>
+size_t SpscQueue<T>::Size() const {
+  return size_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+void SpscQueue<T>::OnDequeued(size_t previous_size, size_t count) {
+  if (previous_size == count) {
+    // Went empty. The producer may have published an element (and notified) between our decrement and this clear,
+    // so look again after clearing.
+    dequeue_.event_.Clear();
+    if (size_.load(std::memory_order_acquire) > 0) {
+      dequeue_.event_.Notify();
+    }
+  }
+  if (previous_size >= capacity_) {
+    // Was full, the enqueue end can make progress again
+    enqueue_.event_.Notify();
+  }
+}
+
+template <typename T>
+void SpscQueue<T>::EnqueueCallbackInternal(EnqueueCallback callback) {
+  if (size_.load(std::memory_order_acquire) >= capacity_) {
+    // Stale wakeup, the consumer will notify again on the full to non-full transition
+    enqueue_.event_.Clear();
+    if (size_.load(std::memory_order_acquire) < capacity_) {
+      enqueue_.event_.Notify();
+    }
+    return;
+  }
+
+  std::unique_ptr<T> data = callback.Run();
+  ASSERT(data != nullptr);
+  ring_[tail_ & mask_] = std::move(data);
+  tail_++;
+
+  size_t previous_size = size_.fetch_add(1, std::memory_order_acq_rel);
+  if (previous_size == 0) {
+    dequeue_.event_.Notify();
+  }
+  if (previous_size + 1 >= capacity_) {
+    // Went full. Same race as in OnDequeued(), in the other direction.
+    enqueue_.event_.Clear();
+    if (size_.load(std::memory_order_acquire) < capacity_) {
+      enqueue_.event_.Notify();
+    }
+  }
+}
+
+template <typename T>
+void SpscQueue<T>::DequeueCallbackInternal(DequeueCallback callback) {
+  if (size_.load(std::memory_order_acquire) == 0) {
+    // Stale wakeup, the producer will notify again on the empty to non-empty transition
+    dequeue_.event_.Clear();
+    if (size_.load(std::memory_order_acquire) > 0) {
+      dequeue_.event_.Notify();
+    }
+    return;
+  }
+  callback.Run();
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/spsc_queue.h"
+
+#include <future>
+#include <queue>
+#include <string>
+#include <thread>
+
+#include "common/bind.h"
+#include "gtest/gtest.h"
+#include "os/handler.h"
+#include "os/thread.h"
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+constexpr int kQueueSize = 10;
+
+class SpscQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    enqueue_thread_ = new Thread("enqueue_thread", Thread::Priority::NORMAL);
+    enqueue_handler_ = new Handler(enqueue_thread_);
+    dequeue_thread_ = new Thread("dequeue_thread", Thread::Priority::NORMAL);
+    dequeue_handler_ = new Handler(dequeue_thread_);
+  }
+  void TearDown() override {
+    enqueue_handler_->Clear();
+    delete enqueue_handler_;
+    delete enqueue_thread_;
+    dequeue_handler_->Clear();
+    delete dequeue_handler_;
+    delete dequeue_thread_;
+  }
+
+  void Sync(Handler* handler) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)));
+    future.wait();
+  }
+
+  Thread* enqueue_thread_;
+  Handler* enqueue_handler_;
+  Thread* dequeue_thread_;
+  Handler* dequeue_handler_;
+};
+
+class TestEnqueueEnd {
+ public:
+  TestEnqueueEnd(SpscQueue<std::string>* queue, Handler* handler) : queue_(queue), handler_(handler) {}
+
+  void Push(std::string data) {
+    buffer_.push(std::make_unique<std::string>(std::move(data)));
+  }
+
+  void RegisterEnqueue() {
+    handler_->Post(common::BindOnce(
+        [](TestEnqueueEnd* end) {
+          end->queue_->RegisterEnqueue(
+              end->handler_, common::Bind(&TestEnqueueEnd::EnqueueCallbackForTest, common::Unretained(end)));
+        },
+        common::Unretained(this)));
+  }
+
+  std::unique_ptr<std::string> EnqueueCallbackForTest() {
+    auto data = std::move(buffer_.front());
+    buffer_.pop();
+    if (buffer_.empty()) {
+      queue_->UnregisterEnqueue();
+      drained_.set_value();
+    }
+    return data;
+  }
+
+  std::queue<std::unique_ptr<std::string>> buffer_;
+  std::promise<void> drained_;
+
+ private:
+  SpscQueue<std::string>* queue_;
+  Handler* handler_;
+};
+
+TEST_F(SpscQueueTest, enqueue_then_dequeue_in_order) {
+  SpscQueue<std::string> queue(kQueueSize);
+  TestEnqueueEnd enqueue_end(&queue, enqueue_handler_);
+  for (int i = 0; i < kQueueSize; i++) {
+    enqueue_end.Push(std::to_string(i));
+  }
+  auto drained = enqueue_end.drained_.get_future();
+  enqueue_end.RegisterEnqueue();
+  drained.wait();
+  Sync(enqueue_handler_);
+  EXPECT_EQ(queue.Size(), static_cast<size_t>(kQueueSize));
+
+  std::promise<std::vector<std::string>> result;
+  auto future = result.get_future();
+  dequeue_handler_->Post(common::BindOnce(
+      [](SpscQueue<std::string>* queue, std::promise<std::vector<std::string>>* result) {
+        std::vector<std::string> data;
+        while (auto element = queue->TryDequeue()) {
+          data.push_back(*element);
+        }
+        result->set_value(data);
+      },
+      common::Unretained(&queue),
+      common::Unretained(&result)));
+  auto data = future.get();
+  ASSERT_EQ(data.size(), static_cast<size_t>(kQueueSize));
+  for (int i = 0; i < kQueueSize; i++) {
+    EXPECT_EQ(data[i], std::to_string(i));
+  }
+  EXPECT_EQ(queue.Size(), 0u);
+}
+
+TEST_F(SpscQueueTest, enqueue_stops_when_full_and_resumes_after_batch_dequeue) {
+  SpscQueue<std::string> queue(kQueueSize);
+  TestEnqueueEnd enqueue_end(&queue, enqueue_handler_);
+  for (int i = 0; i < kQueueSize * 2; i++) {
+    enqueue_end.Push(std::to_string(i));
+  }
+  auto drained = enqueue_end.drained_.get_future();
+  enqueue_end.RegisterEnqueue();
+  while (queue.Size() < static_cast<size_t>(kQueueSize)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  Sync(enqueue_handler_);
+  EXPECT_EQ(queue.Size(), static_cast<size_t>(kQueueSize));
+  EXPECT_EQ(enqueue_end.buffer_.size(), static_cast<size_t>(kQueueSize));
+
+  std::vector<std::string> received;
+  auto dequeue_batch = [&]() {
+    std::promise<void> done;
+    auto future = done.get_future();
+    dequeue_handler_->Post(common::BindOnce(
+        [](SpscQueue<std::string>* queue, std::vector<std::string>* received, std::promise<void>* done) {
+          for (auto& element : queue->TryDequeueBatch(kQueueSize)) {
+            received->push_back(*element);
+          }
+          done->set_value();
+        },
+        common::Unretained(&queue),
+        common::Unretained(&received),
+        common::Unretained(&done)));
+    future.wait();
+  };
+
+  dequeue_batch();
+  drained.wait();
+  Sync(enqueue_handler_);
+  dequeue_batch();
+
+  ASSERT_EQ(received.size(), static_cast<size_t>(kQueueSize * 2));
+  for (int i = 0; i < kQueueSize * 2; i++) {
+    EXPECT_EQ(received[i], std::to_string(i));
+  }
+}
+
+TEST_F(SpscQueueTest, dequeue_callback_runs_once_per_element) {
+  constexpr int kElements = kQueueSize * 10;
+  SpscQueue<std::string> queue(kQueueSize);
+  TestEnqueueEnd enqueue_end(&queue, enqueue_handler_);
+  for (int i = 0; i < kElements; i++) {
+    enqueue_end.Push(std::to_string(i));
+  }
+
+  int received = 0;
+  std::promise<void> all_received;
+  auto future = all_received.get_future();
+  auto dequeue_callback = [&]() {
+    auto element = queue.TryDequeue();
+    ASSERT_NE(element, nullptr);
+    EXPECT_EQ(*element, std::to_string(received));
+    if (++received == kElements) {
+      queue.UnregisterDequeue();
+      all_received.set_value();
+    }
+  };
+  std::function<void()> callback = dequeue_callback;
+  dequeue_handler_->Post(common::BindOnce(
+      [](SpscQueue<std::string>* queue, Handler* handler, std::function<void()>* callback) {
+        queue->RegisterDequeue(
+            handler, common::Bind([](std::function<void()>* callback) { (*callback)(); }, common::Unretained(callback)));
+      },
+      common::Unretained(&queue),
+      common::Unretained(dequeue_handler_),
+      common::Unretained(&callback)));
+  enqueue_end.RegisterEnqueue();
+  future.wait();
+  Sync(dequeue_handler_);
+  EXPECT_EQ(queue.Size(), 0u);
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/timer_queue.h"
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/bind.h"
+#include "os/linux_generic/linux.h"
+#include "os/log.h"
+
+#ifdef OS_ANDROID
+#define ALARM_CLOCK CLOCK_BOOTTIME_ALARM
+#else
+#define ALARM_CLOCK CLOCK_BOOTTIME
+#endif
+
+namespace bluetooth {
+namespace os {
+
+namespace {
+
+// Same time base as ALARM_CLOCK
+std::chrono::nanoseconds now() {
+#ifdef USE_FAKE_TIMERS
+  return std::chrono::milliseconds(fake_timer::fake_timerfd_get_clock());
+#else
+  timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+#endif
+}
+
+}  // namespace
+
+TimerQueue::TimerQueue(Reactor* reactor) : reactor_(reactor) {}
+
+TimerQueue::~TimerQueue() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT_LOG(attached_count_ == 0, "%zu timers are still attached", attached_count_);
+}
+
+void TimerQueue::Attach(Timer* timer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(timer->heap_index_ == Timer::kNotArmed);
+  if (attached_count_++ != 0) {
+    return;
+  }
+
+  fd_ = TIMERFD_CREATE(ALARM_CLOCK, TFD_NONBLOCK);
+  ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
+  armed_ = false;
+  token_ = reactor_->Register(
+      fd_, common::Bind(&TimerQueue::on_fire, common::Unretained(this), fd_), common::Closure());
+}
+
+void TimerQueue::Detach(Timer* timer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(attached_count_ > 0);
+  if (timer->heap_index_ != Timer::kNotArmed) {
+    heap_remove_locked(timer->heap_index_);
+  }
+  if (--attached_count_ != 0) {
+    return;
+  }
+
+  reactor_->Unregister(token_);
+  token_ = nullptr;
+  int close_status;
+  RUN_NO_INTR(close_status = TIMERFD_CLOSE(fd_));
+  ASSERT(close_status != -1);
+  fd_ = -1;
+  armed_ = false;
+}
+
+void TimerQueue::Arm(Timer* timer, std::chrono::milliseconds delay, std::chrono::milliseconds period) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(fd_ != -1);
+  if (timer->heap_index_ != Timer::kNotArmed) {
+    heap_remove_locked(timer->heap_index_);
+  }
+  timer->deadline_ = now() + delay;
+  timer->period_ = period;
+  heap_push_locked(timer);
+  rearm_locked();
+}
+
+void TimerQueue::Disarm(Timer* timer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (timer->heap_index_ == Timer::kNotArmed) {
+    return;
+  }
+  // The timerfd is left armed: an early wakeup with nothing due is cheaper than a settime per cancel
+  heap_remove_locked(timer->heap_index_);
+}
+
+void TimerQueue::SetSlack(std::chrono::milliseconds slack) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  slack_ = slack;
+}
+
+size_t TimerQueue::GetArmedCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return heap_.size();
+}
+
+void TimerQueue::on_fire(int fd) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (fd != fd_) {
+    // All timers were detached (and the fd possibly reused) since this wakeup was queued
+    return;
+  }
+  // Re-arming from another thread between the wakeup and this read resets the expiration count, so an empty read
+  // is expected here
+  uint64_t times_invoked;
+  auto bytes_read = read(fd_, &times_invoked, sizeof(uint64_t));
+  ASSERT_LOG(bytes_read != -1 || errno == EAGAIN, "cannot read timerfd: %s", strerror(errno));
+  armed_ = false;
+
+  // Fire one timer at a time, so a callback can cancel or destroy any other timer of this queue
+  for (;;) {
+    auto expiry = now() + slack_;
+    if (heap_.empty() || heap_[0]->deadline_ > expiry) {
+      break;
+    }
+    Timer* timer = heap_[0];
+    heap_remove_locked(0);
+    if (timer->period_.count() != 0) {
+      // Periods missed while the thread was stalled or the device suspended are coalesced into this run, like the
+      // expiration count of a periodic timerfd
+      auto missed_periods = (expiry - timer->deadline_) / timer->period_;
+      timer->deadline_ += (missed_periods + 1) * timer->period_;
+      heap_push_locked(timer);
+    }
+    common::Closure task = timer->on_fire_;
+    lock.unlock();
+    task.Run();
+    lock.lock();
+    if (fd != fd_) {
+      return;
+    }
+  }
+  rearm_locked();
+}
+
+void TimerQueue::rearm_locked() {
+  if (heap_.empty()) {
+    return;
+  }
+  auto deadline = heap_[0]->deadline_;
+  if (armed_ && armed_deadline_ <= deadline) {
+    return;
+  }
+
+  // timerfd treats a zero expiration as disarm, and alarms have millisecond resolution anyway
+  auto delay = std::chrono::ceil<std::chrono::milliseconds>(deadline - now());
+  long delay_ms = std::max<long>(delay.count(), 1);
+  itimerspec timer_itimerspec{{/* not periodic */}, {delay_ms / 1000, delay_ms % 1000 * 1000000}};
+  int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
+  ASSERT(result == 0);
+  armed_ = true;
+  armed_deadline_ = deadline;
+}
+
+void TimerQueue::heap_push_locked(Timer* timer) {
+  timer->heap_index_ = heap_.size();
+  heap_.push_back(timer);
+  heap_sift_up_locked(timer->heap_index_);
+}
+
+void TimerQueue::heap_remove_locked(size_t index) {
+  size_t last = heap_.size() - 1;
+  if (index != last) {
+    heap_swap_locked(index, last);
+  }
+  heap_.back()->heap_index_ = Timer::kNotArmed;
+  heap_.pop_back();
+  if (index < heap_.size()) {
+    heap_sift_up_locked(index);
+    heap_sift_down_locked(index);
+  }
+}
+
+void TimerQueue::heap_sift_up_locked(size_t index) {
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (heap_[parent]->deadline_ <= heap_[index]->deadline_) {
+      return;
+    }
+    heap_swap_locked(parent, index);
+    index = parent;
+  }
+}
+
+void TimerQueue::heap_sift_down_locked(size_t index) {
+  for (;;) {
+    size_t smallest = index;
+    size_t left = 2 * index + 1;
+    size_t right = left + 1;
+    if (left < heap_.size() && heap_[left]->deadline_ < heap_[smallest]->deadline_) {
+      smallest = left;
+    }
+    if (right < heap_.size() && heap_[right]->deadline_ < heap_[smallest]->deadline_) {
+      smallest = right;
+    }
+    if (smallest == index) {
+      return;
+    }
+    heap_swap_locked(index, smallest);
+    index = smallest;
+  }
+}
+
+void TimerQueue::heap_swap_locked(size_t a, size_t b) {
+  std::swap(heap_[a], heap_[b]);
+  heap_[a]->heap_index_ = a;
+  heap_[b]->heap_index_ = b;
+}
+
+}  // namespace os
+}  // namespace bluetooth
@@ -19,6 +19,7 @@
 #include "benchmark/benchmark.h"
 #include "os/handler.h"
 #include "os/queue.h"
+#include "os/spsc_queue.h"
 #include "os/thread.h"
 
 using ::benchmark::State;
@@ -54,13 +55,14 @@ class BM_QueuePerformance : public ::benchmark::Fixture {
   Handler* dequeue_handler_;
 };
 
+template <typename QueueType>
 class TestEnqueueEnd {
  public:
-  explicit TestEnqueueEnd(int64_t count, Queue<std::string>* queue, Handler* handler, std::promise<void>* promise)
+  explicit TestEnqueueEnd(int64_t count, QueueType* queue, Handler* handler, std::promise<void>* promise)
       : count_(count), handler_(handler), queue_(queue), promise_(promise) {}
 
   void RegisterEnqueue() {
-    handler_->Post(common::BindOnce(&TestEnqueueEnd::handle_register_enqueue, common::Unretained(this)));
+    handler_->Post(common::BindOnce(&TestEnqueueEnd<QueueType>::handle_register_enqueue, common::Unretained(this)));
   }
 
   void push(std::string data) {
@@ -95,22 +97,24 @@ class TestEnqueueEnd {
 
  private:
   Handler* handler_;
-  Queue<std::string>* queue_;
+  QueueType* queue_;
   std::promise<void>* promise_;
   std::mutex mutex_;
 
   void handle_register_enqueue() {
-    queue_->RegisterEnqueue(handler_, common::Bind(&TestEnqueueEnd::EnqueueCallbackForTest, common::Unretained(this)));
+    queue_->RegisterEnqueue(
+        handler_, common::Bind(&TestEnqueueEnd<QueueType>::EnqueueCallbackForTest, common::Unretained(this)));
   }
 };
 
+template <typename QueueType>
 class TestDequeueEnd {
  public:
-  explicit TestDequeueEnd(int64_t count, Queue<std::string>* queue, Handler* handler, std::promise<void>* promise)
+  explicit TestDequeueEnd(int64_t count, QueueType* queue, Handler* handler, std::promise<void>* promise)
       : count_(count), handler_(handler), queue_(queue), promise_(promise) {}
 
   void RegisterDequeue() {
-    handler_->Post(common::BindOnce(&TestDequeueEnd::handle_register_dequeue, common::Unretained(this)));
+    handler_->Post(common::BindOnce(&TestDequeueEnd<QueueType>::handle_register_dequeue, common::Unretained(this)));
   }
 
   void DequeueCallbackForTest() {
@@ -129,11 +133,49 @@ class TestDequeueEnd {
 
  private:
   Handler* handler_;
-  Queue<std::string>* queue_;
+  QueueType* queue_;
   std::promise<void>* promise_;
 
   void handle_register_dequeue() {
-    queue_->RegisterDequeue(handler_, common::Bind(&TestDequeueEnd::DequeueCallbackForTest, common::Unretained(this)));
+    queue_->RegisterDequeue(
+        handler_, common::Bind(&TestDequeueEnd<QueueType>::DequeueCallbackForTest, common::Unretained(this)));
+  }
+};
+
+class TestBatchDequeueEnd {
+ public:
+  explicit TestBatchDequeueEnd(
+      int64_t count, SpscQueue<std::string>* queue, Handler* handler, std::promise<void>* promise, size_t batch_size)
+      : count_(count), handler_(handler), queue_(queue), promise_(promise), batch_size_(batch_size) {}
+
+  void RegisterDequeue() {
+    handler_->Post(common::BindOnce(&TestBatchDequeueEnd::handle_register_dequeue, common::Unretained(this)));
+  }
+
+  void DequeueCallbackForTest() {
+    for (auto& data : queue_->TryDequeueBatch(batch_size_)) {
+      buffer_.push(std::move(*data));
+      count_--;
+    }
+
+    if (count_ == 0) {
+      queue_->UnregisterDequeue();
+      promise_->set_value();
+    }
+  }
+
+  std::queue<std::string> buffer_;
+  int64_t count_;
+
+ private:
+  Handler* handler_;
+  SpscQueue<std::string>* queue_;
+  std::promise<void>* promise_;
+  size_t batch_size_;
+
+  void handle_register_dequeue() {
+    queue_->RegisterDequeue(
+        handler_, common::Bind(&TestBatchDequeueEnd::DequeueCallbackForTest, common::Unretained(this)));
   }
 };
 
@@ -145,12 +187,12 @@ BENCHMARK_DEFINE_F(BM_QueuePerformance, send_packet_vary_by_packet_num)(State& s
     // register dequeue
     std::promise<void> dequeue_promise;
     auto dequeue_future = dequeue_promise.get_future();
-    TestDequeueEnd test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
+    TestDequeueEnd<Queue<std::string>> test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
     test_dequeue_end.RegisterDequeue();
 
     // Push data to enqueue end buffer and register enqueue
     std::promise<void> enqueue_promise;
-    TestEnqueueEnd test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    TestEnqueueEnd<Queue<std::string>> test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
     for (int i = 0; i < num_data_to_send_; i++) {
       std::string data = std::to_string(1);
       test_enqueue_end.push(std::move(data));
@@ -179,12 +221,12 @@ BENCHMARK_DEFINE_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)(S
     // register dequeue
     std::promise<void> dequeue_promise;
     auto dequeue_future = dequeue_promise.get_future();
-    TestDequeueEnd test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
+    TestDequeueEnd<Queue<std::string>> test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
     test_dequeue_end.RegisterDequeue();
 
     // Push data to enqueue end buffer and register enqueue
     std::promise<void> enqueue_promise;
-    TestEnqueueEnd test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    TestEnqueueEnd<Queue<std::string>> test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
     for (int i = 0; i < num_data_to_send_; i++) {
       std::string data = std::string(packet_size, 'x');
       test_enqueue_end.push(std::move(data));
@@ -202,5 +244,75 @@ BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)
     ->Iterations(100)
     ->UseRealTime();
 
+BENCHMARK_DEFINE_F(BM_QueuePerformance, spsc_send_packet_vary_by_packet_num)(State& state) {
+  for (auto _ : state) {
+    int64_t num_data_to_send_ = state.range(0);
+    SpscQueue<std::string> queue(num_data_to_send_);
+
+    // register dequeue
+    std::promise<void> dequeue_promise;
+    auto dequeue_future = dequeue_promise.get_future();
+    TestDequeueEnd<SpscQueue<std::string>> test_dequeue_end(
+        num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
+    test_dequeue_end.RegisterDequeue();
+
+    // Push data to enqueue end buffer and register enqueue
+    std::promise<void> enqueue_promise;
+    TestEnqueueEnd<SpscQueue<std::string>> test_enqueue_end(
+        num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    for (int i = 0; i < num_data_to_send_; i++) {
+      std::string data = std::to_string(1);
+      test_enqueue_end.push(std::move(data));
+    }
+    dequeue_future.wait();
+  }
+
+  state.SetBytesProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0));
+};
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, spsc_send_packet_vary_by_packet_num)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Iterations(100)
+    ->UseRealTime();
+
+// Producer and consumer on different threads, with a queue much smaller than the number of packets so both the
+// full and the empty transitions are exercised. Arg is the dequeue batch size.
+BENCHMARK_DEFINE_F(BM_QueuePerformance, spsc_send_10000_packet_cross_thread_vary_by_batch_size)(State& state) {
+  for (auto _ : state) {
+    int64_t num_data_to_send_ = 10000;
+    SpscQueue<std::string> queue(64);
+
+    // register dequeue
+    std::promise<void> dequeue_promise;
+    auto dequeue_future = dequeue_promise.get_future();
+    TestBatchDequeueEnd test_dequeue_end(num_data_to_send_, &queue, dequeue_handler_, &dequeue_promise, state.range(0));
+    test_dequeue_end.RegisterDequeue();
+
+    // Push data to enqueue end buffer and register enqueue
+    std::promise<void> enqueue_promise;
+    TestEnqueueEnd<SpscQueue<std::string>> test_enqueue_end(
+        num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    for (int i = 0; i < num_data_to_send_; i++) {
+      std::string data = std::to_string(1);
+      test_enqueue_end.push(std::move(data));
+    }
+    dequeue_future.wait();
+  }
+
+  state.SetItemsProcessed(static_cast<int_fast64_t>(state.iterations()) * 10000);
+};
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, spsc_send_10000_packet_cross_thread_vary_by_batch_size)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(64)
+    ->Iterations(100)
+    ->UseRealTime();
+
 }  // namespace os
 }  // namespace bluetooth
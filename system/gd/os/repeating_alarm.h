@@ -23,14 +23,15 @@
 #include "common/callback.h"
 #include "os/handler.h"
 #include "os/thread.h"
+#include "os/timer_queue.h"
 #include "os/utils.h"
 
 namespace bluetooth {
 namespace os {
 
-// A repeating alarm for reactor-based thread, implemented by Linux timerfd.
-// When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
-// itself from the thread.
+// A repeating alarm for reactor-based thread, multiplexed with the other alarms of the thread onto the thread's
+// TimerQueue. When it's constructed, it will attach itself to the timer queue of the specified thread; when it's
+// destroyed, it will detach itself from it.
 class RepeatingAlarm {
  public:
   // Create and register a repeating alarm on a given handler
@@ -51,8 +52,7 @@ class RepeatingAlarm {
  private:
   common::Closure task_;
   Handler* handler_;
-  int fd_ = 0;
-  Reactor::Reactable* token_;
+  TimerQueue::Timer timer_;
   mutable std::mutex mutex_;
   void on_fire();
 };
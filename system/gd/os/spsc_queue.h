@@ -0,0 +1,115 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/bind.h"
+#include "common/callback.h"
+#include "os/handler.h"
+#include "os/log.h"
+#include "os/queue.h"
+#include "os/reactor.h"
+
+namespace bluetooth {
+namespace os {
+
+// A bounded single-producer/single-consumer alternative to |Queue|.
+//
+// Elements live in a preallocated ring, so enqueue and dequeue do not allocate and do not take a lock. Only the
+// enqueue handler may run the EnqueueCallback and only the dequeue handler may call TryDequeue()/TryDequeueBatch().
+// The reactor is woken up only when the ring goes from empty to non-empty (dequeue end) or from full to non-full
+// (enqueue end), instead of once per element as |Queue| does.
+//
+// Callback semantics are the same as |Queue|: a registered DequeueCallback is called while at least one element is
+// ready, and a registered EnqueueCallback is called while there is room for at least one element.
+template <typename T>
+class SpscQueue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
+ public:
+  using EnqueueCallback = common::Callback<std::unique_ptr<T>()>;
+  using DequeueCallback = common::Callback<void()>;
+  // Create a queue with |capacity| is the maximum number of messages a queue can contain
+  explicit SpscQueue(size_t capacity);
+  ~SpscQueue();
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Register |callback| that will be called on |handler| when the queue is able to enqueue one piece of data.
+  // This will cause a crash if handler or callback has already been registered before.
+  void RegisterEnqueue(Handler* handler, EnqueueCallback callback) override;
+  // Unregister current EnqueueCallback from this queue, this will cause a crash if not registered yet.
+  void UnregisterEnqueue() override;
+  // Register |callback| that will be called on |handler| when the queue has at least one piece of data ready
+  // for dequeue. This will cause a crash if handler or callback has already been registered before.
+  void RegisterDequeue(Handler* handler, DequeueCallback callback) override;
+  // Unregister current DequeueCallback from this queue, this will cause a crash if not registered yet.
+  void UnregisterDequeue() override;
+
+  // Try to dequeue an item from this queue. Return nullptr when there is nothing in the queue.
+  std::unique_ptr<T> TryDequeue() override;
+
+  // Dequeue up to |max_count| items at once, paying for at most one wakeup transition. Returns an empty vector
+  // when there is nothing in the queue.
+  std::vector<std::unique_ptr<T>> TryDequeueBatch(size_t max_count);
+
+  // Number of elements currently in the queue. Only a snapshot when called from outside the two endpoints.
+  size_t Size() const;
+
+ private:
+  void EnqueueCallbackInternal(EnqueueCallback callback);
+  void DequeueCallbackInternal(DequeueCallback callback);
+  // Called by the consumer after taking |count| elements out of a queue that held |previous_size| elements
+  void OnDequeued(size_t previous_size, size_t count);
+
+  const size_t capacity_;
+  // Ring storage, sized to the next power of two of |capacity_| so indices can be masked
+  const size_t mask_;
+  std::vector<std::unique_ptr<T>> ring_;
+  // Only touched by the producer
+  size_t tail_ = 0;
+  // Only touched by the consumer
+  size_t head_ = 0;
+  // Number of elements in the ring; publishes slot writes from producer to consumer and slot reads back
+  std::atomic<size_t> size_ = 0;
+  // A mutex that guards registration only
+  std::mutex mutex_;
+
+  class QueueEndpoint {
+   public:
+    QueueEndpoint() : handler_(nullptr), reactable_(nullptr) {}
+    Reactor::Event event_;
+    Handler* handler_;
+    Reactor::Reactable* reactable_;
+  };
+
+  // Readable while the ring is not full
+  QueueEndpoint enqueue_;
+  // Readable while the ring is not empty
+  QueueEndpoint dequeue_;
+};
+
+#ifdef OS_LINUX_GENERIC
+#include "os/linux_generic/spsc_queue.tpp"
+#endif
+
+}  // namespace os
+}  // namespace bluetooth
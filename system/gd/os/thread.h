@@ -21,6 +21,7 @@
 #include <thread>
 
 #include "os/reactor.h"
+#include "os/timer_queue.h"
 #include "os/utils.h"
 
 namespace bluetooth {
@@ -64,11 +65,15 @@ class Thread {
   // Return the pointer of underlying reactor. The ownership is NOT transferred.
   Reactor* GetReactor() const;
 
+  // Return the pointer of the timer queue shared by all alarms of this thread. The ownership is NOT transferred.
+  TimerQueue* GetTimerQueue() const;
+
  private:
   void run(Priority priority);
   mutable std::mutex mutex_;
   const std::string name_;
   mutable Reactor reactor_;
+  mutable TimerQueue timer_queue_;
   std::thread running_thread_;
 };
 
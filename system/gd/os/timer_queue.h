@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "common/callback.h"
+#include "os/reactor.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace os {
+
+// Multiplexes every Alarm and RepeatingAlarm of a thread onto a single timerfd.
+//
+// Armed timers are kept in an indexed min-heap ordered by deadline, so Arm() and Disarm() are O(log n) and only touch
+// the timerfd when the earliest deadline moves earlier. When the timerfd fires, every timer due within |slack| of now
+// runs in the same wakeup, in deadline order, on the reactor thread. A periodic timer runs at most once per wakeup: the
+// periods it missed are skipped.
+//
+// The timerfd only exists while at least one timer is attached.
+class TimerQueue {
+ public:
+  class Timer {
+   public:
+    // |on_fire| runs on the reactor thread each time the timer expires
+    explicit Timer(common::Closure on_fire) : on_fire_(std::move(on_fire)) {}
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+   private:
+    friend class TimerQueue;
+    static constexpr size_t kNotArmed = std::numeric_limits<size_t>::max();
+
+    common::Closure on_fire_;
+    std::chrono::nanoseconds deadline_{};
+    std::chrono::nanoseconds period_{};
+    size_t heap_index_ = kNotArmed;
+  };
+
+  explicit TimerQueue(Reactor* reactor);
+
+  TimerQueue(const TimerQueue&) = delete;
+  TimerQueue& operator=(const TimerQueue&) = delete;
+
+  ~TimerQueue();
+
+  // Make |timer| known to this queue. Must be called before Arm().
+  void Attach(Timer* timer);
+
+  // Disarm |timer| and forget about it
+  void Detach(Timer* timer);
+
+  // Arm |timer| to expire after |delay|, and then every |period| if |period| is not zero. Re-arming an armed timer
+  // replaces its previous deadline.
+  void Arm(Timer* timer, std::chrono::milliseconds delay, std::chrono::milliseconds period);
+
+  // Disarm |timer|. No-op if it's not armed.
+  void Disarm(Timer* timer);
+
+  // Timers due within |slack| of a wakeup are fired together with it. Zero by default.
+  void SetSlack(std::chrono::milliseconds slack);
+
+  // Number of armed timers
+  size_t GetArmedCount() const;
+
+ private:
+  void on_fire(int fd);
+  void rearm_locked();
+  void heap_push_locked(Timer* timer);
+  void heap_remove_locked(size_t index);
+  void heap_sift_up_locked(size_t index);
+  void heap_sift_down_locked(size_t index);
+  void heap_swap_locked(size_t a, size_t b);
+
+  Reactor* reactor_;
+  mutable std::mutex mutex_;
+  int fd_ = -1;
+  Reactor::Reactable* token_ = nullptr;
+  size_t attached_count_ = 0;
+  std::vector<Timer*> heap_;
+  std::chrono::nanoseconds slack_{};
+  bool armed_ = false;
+  std::chrono::nanoseconds armed_deadline_{};
+};
+
+}  // namespace os
+}  // namespace bluetooth
@@ -78,5 +78,29 @@ TEST(BitInserterTest, observerTest) {
   ASSERT_EQ(result.size(), copy.size());
 }
 
+TEST(BitInserterTest, batchedObserverTest) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  std::vector<uint8_t> copy;
+  size_t calls = 0;
+
+  it.RegisterObserver(ByteObserver(
+      [&copy, &calls](const uint8_t* data, size_t size) {
+        copy.insert(copy.end(), data, data + size);
+        calls++;
+      },
+      [&copy]() { return copy.size(); }));
+
+  for (size_t i = 0; i < 200; i++) {
+    it.insert_byte(static_cast<uint8_t>(i));
+  }
+  ASSERT_LT(copy.size(), bytes.size());
+
+  ByteObserver observer = it.UnregisterObserver();
+  ASSERT_EQ(bytes.size(), observer.GetValue());
+  ASSERT_EQ(bytes, copy);
+  ASSERT_LT(calls, bytes.size());
+}
+
 }  // namespace packet
 }  // namespace bluetooth
@@ -22,13 +22,33 @@ namespace packet {
 ByteObserver::ByteObserver(const std::function<void(uint8_t)>& on_byte, const std::function<uint64_t()>& get_value)
     : on_byte_(on_byte), get_value_(get_value) {}
 
+ByteObserver::ByteObserver(
+    const std::function<void(const uint8_t* data, size_t size)>& on_bytes,
+    const std::function<uint64_t()>& get_value)
+    : on_bytes_(on_bytes), get_value_(get_value) {}
+
 void ByteObserver::OnByte(uint8_t byte) {
-  on_byte_(byte);
+  if (!on_bytes_) {
+    on_byte_(byte);
+    return;
+  }
+  buffer_[buffered_++] = byte;
+  if (buffered_ == kBufferSize) {
+    Flush();
+  }
 }
 
 uint64_t ByteObserver::GetValue() {
+  Flush();
   return get_value_();
 }
 
+void ByteObserver::Flush() {
+  if (buffered_ > 0) {
+    on_bytes_(buffer_.data(), buffered_);
+    buffered_ = 0;
+  }
+}
+
 }  // namespace packet
 }  // namespace bluetooth
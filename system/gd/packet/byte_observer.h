@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 
@@ -26,13 +28,25 @@ class ByteObserver {
  public:
   ByteObserver(const std::function<void(uint8_t)>& on_byte_, const std::function<uint64_t()>& get_value_);
 
+  // Buffers observed bytes and hands them to |on_bytes| in blocks, at the latest when the value is read
+  ByteObserver(
+      const std::function<void(const uint8_t* data, size_t size)>& on_bytes,
+      const std::function<uint64_t()>& get_value);
+
   void OnByte(uint8_t byte);
 
   uint64_t GetValue();
 
  private:
+  static constexpr size_t kBufferSize = 64;
+
+  void Flush();
+
   std::function<void(uint8_t)> on_byte_;
+  std::function<void(const uint8_t* data, size_t size)> on_bytes_;
   std::function<uint64_t()> get_value_;
+  std::array<uint8_t, kBufferSize> buffer_;
+  size_t buffered_ = 0;
 };
 
 }  // namespace packet
@@ -0,0 +1,370 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Views and builders generated by bluetooth_packetgen for the packets seen most on a busy link. Run with
+//   bluetooth_benchmark_gd --benchmark_filter=BM_Generated --benchmark_out=generated_packets.json
+// to record the results as JSON, the default --benchmark_out_format, and compare runs with benchmark's compare.py.
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/address.h"
+#include "hci/hci_packets.h"
+#include "l2cap/l2cap_packets.h"
+#include "packet/bit_inserter.h"
+#include "packet/packet_view.h"
+#include "packet/raw_builder.h"
+#include "security/smp_packets.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace packet {
+namespace {
+
+constexpr uint16_t kHandle = 0x0040;
+constexpr uint16_t kAttCid = 0x0004;
+constexpr uint16_t kDynamicCid = 0x0041;
+constexpr uint8_t kAttHandleValueNotification = 0x1b;
+
+std::vector<uint8_t> Payload(size_t size) {
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < size; i++) {
+    payload[i] = static_cast<uint8_t>(i);
+  }
+  return payload;
+}
+
+std::vector<uint8_t> Serialize(const BasePacketBuilder& builder) {
+  std::vector<uint8_t> bytes;
+  bytes.reserve(builder.size());
+  BitInserter it(bytes);
+  builder.Serialize(it);
+  return bytes;
+}
+
+PacketView<kLittleEndian> MakeView(const BasePacketBuilder& builder) {
+  return PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(Serialize(builder)));
+}
+
+void SerializeLoop(State& state, const BasePacketBuilder& builder) {
+  std::vector<uint8_t> bytes;
+  for (auto _ : state) {
+    bytes.clear();
+    bytes.reserve(builder.size());
+    BitInserter it(bytes);
+    builder.Serialize(it);
+    benchmark::DoNotOptimize(bytes.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void SizeLoop(State& state, const BasePacketBuilder& builder) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(builder.size());
+  }
+}
+
+// ACL packets with a payload of state.range(0) bytes
+
+std::unique_ptr<hci::AclBuilder> MakeAcl(size_t payload_size) {
+  return hci::AclBuilder::Create(
+      kHandle,
+      hci::PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
+      hci::BroadcastFlag::POINT_TO_POINT,
+      std::make_unique<RawBuilder>(Payload(payload_size)));
+}
+
+void BM_GeneratedAclParse(State& state) {
+  auto view = MakeView(*MakeAcl(state.range(0)));
+  for (auto _ : state) {
+    auto acl = hci::AclView::Create(view);
+    if (!acl.IsValid()) {
+      state.SkipWithError("invalid ACL packet");
+      break;
+    }
+    benchmark::DoNotOptimize(acl.GetHandle());
+    benchmark::DoNotOptimize(acl.GetPacketBoundaryFlag());
+    benchmark::DoNotOptimize(acl.GetBroadcastFlag());
+    benchmark::DoNotOptimize(acl.GetPayload().size());
+  }
+  state.SetBytesProcessed(state.iterations() * view.size());
+}
+BENCHMARK(BM_GeneratedAclParse)->Arg(27)->Arg(1021);
+
+void BM_GeneratedAclBuild(State& state) {
+  auto payload = Payload(state.range(0));
+  for (auto _ : state) {
+    auto acl = hci::AclBuilder::Create(
+        kHandle,
+        hci::PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
+        hci::BroadcastFlag::POINT_TO_POINT,
+        std::make_unique<RawBuilder>(payload));
+    benchmark::DoNotOptimize(acl.get());
+  }
+}
+BENCHMARK(BM_GeneratedAclBuild)->Arg(27)->Arg(1021);
+
+void BM_GeneratedAclSerialize(State& state) {
+  SerializeLoop(state, *MakeAcl(state.range(0)));
+}
+BENCHMARK(BM_GeneratedAclSerialize)->Arg(27)->Arg(1021);
+
+// LE advertising report events with state.range(0) reports of flags, a 128-bit service UUID and a local name
+
+std::unique_ptr<hci::LeAdvertisingReportBuilder> MakeLeAdvertisingReport(size_t report_count) {
+  std::vector<hci::LeAdvertisingResponse> responses(report_count);
+  for (size_t i = 0; i < report_count; i++) {
+    auto& response = responses[i];
+    response.event_type_ = hci::AdvertisingEventType::ADV_IND;
+    response.address_type_ = hci::AddressType::RANDOM_DEVICE_ADDRESS;
+    response.address_ = hci::Address({static_cast<uint8_t>(i), 0x22, 0x33, 0x44, 0x55, 0xc6});
+    response.advertising_data_.resize(3);
+    response.advertising_data_[0].data_ = {static_cast<uint8_t>(hci::GapDataType::FLAGS), 0x06};
+    response.advertising_data_[1].data_ = Payload(17);
+    response.advertising_data_[1].data_[0] = static_cast<uint8_t>(hci::GapDataType::COMPLETE_LIST_128_BIT_UUIDS);
+    response.advertising_data_[2].data_ = {
+        static_cast<uint8_t>(hci::GapDataType::COMPLETE_LOCAL_NAME), 'b', 'e', 'n', 'c', 'h', '0', '1'};
+    response.rssi_ = 0xc4;
+  }
+  return hci::LeAdvertisingReportBuilder::Create(responses);
+}
+
+void BM_GeneratedLeAdvertisingReportParse(State& state) {
+  auto view = MakeView(*MakeLeAdvertisingReport(state.range(0)));
+  for (auto _ : state) {
+    auto report = hci::LeAdvertisingReportView::Create(hci::LeMetaEventView::Create(hci::EventView::Create(view)));
+    if (!report.IsValid()) {
+      state.SkipWithError("invalid advertising report");
+      break;
+    }
+    for (const auto& response : report.GetResponses()) {
+      benchmark::DoNotOptimize(response.address_);
+      benchmark::DoNotOptimize(response.advertising_data_.size());
+      benchmark::DoNotOptimize(response.rssi_);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GeneratedLeAdvertisingReportParse)->Arg(1)->Arg(5);
+
+void BM_GeneratedLeAdvertisingReportSize(State& state) {
+  SizeLoop(state, *MakeLeAdvertisingReport(state.range(0)));
+}
+BENCHMARK(BM_GeneratedLeAdvertisingReportSize)->Arg(1)->Arg(5);
+
+void BM_GeneratedLeAdvertisingReportSerialize(State& state) {
+  SerializeLoop(state, *MakeLeAdvertisingReport(state.range(0)));
+}
+BENCHMARK(BM_GeneratedLeAdvertisingReportSerialize)->Arg(1)->Arg(5);
+
+// Number of Completed Packets events for state.range(0) connections
+
+std::unique_ptr<hci::NumberOfCompletedPacketsBuilder> MakeNumberOfCompletedPackets(size_t handle_count) {
+  std::vector<hci::CompletedPackets> completed_packets(handle_count);
+  for (size_t i = 0; i < handle_count; i++) {
+    completed_packets[i].connection_handle_ = kHandle + i;
+    completed_packets[i].host_num_of_completed_packets_ = 1;
+  }
+  return hci::NumberOfCompletedPacketsBuilder::Create(completed_packets);
+}
+
+void BM_GeneratedNumberOfCompletedPacketsParse(State& state) {
+  auto view = MakeView(*MakeNumberOfCompletedPackets(state.range(0)));
+  for (auto _ : state) {
+    auto event = hci::NumberOfCompletedPacketsView::Create(hci::EventView::Create(view));
+    if (!event.IsValid()) {
+      state.SkipWithError("invalid Number of Completed Packets event");
+      break;
+    }
+    for (const auto& completed_packets : event.GetCompletedPackets()) {
+      benchmark::DoNotOptimize(completed_packets.connection_handle_);
+      benchmark::DoNotOptimize(completed_packets.host_num_of_completed_packets_);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GeneratedNumberOfCompletedPacketsParse)->Arg(1)->Arg(4);
+
+void BM_GeneratedNumberOfCompletedPacketsSerialize(State& state) {
+  SerializeLoop(state, *MakeNumberOfCompletedPackets(state.range(0)));
+}
+BENCHMARK(BM_GeneratedNumberOfCompletedPacketsSerialize)->Arg(1)->Arg(4);
+
+// L2CAP basic frames with a payload of state.range(0) bytes
+
+void BM_GeneratedL2capBasicFrameParse(State& state) {
+  auto view = MakeView(*l2cap::BasicFrameBuilder::Create(
+      kDynamicCid, std::make_unique<RawBuilder>(Payload(state.range(0)))));
+  for (auto _ : state) {
+    auto frame = l2cap::BasicFrameView::Create(view);
+    if (!frame.IsValid()) {
+      state.SkipWithError("invalid basic frame");
+      break;
+    }
+    benchmark::DoNotOptimize(frame.GetChannelId());
+    benchmark::DoNotOptimize(frame.GetPayload().size());
+  }
+  state.SetBytesProcessed(state.iterations() * view.size());
+}
+BENCHMARK(BM_GeneratedL2capBasicFrameParse)->Arg(23)->Arg(1017);
+
+void BM_GeneratedL2capBasicFrameSerialize(State& state) {
+  SerializeLoop(
+      state, *l2cap::BasicFrameBuilder::Create(kDynamicCid, std::make_unique<RawBuilder>(Payload(state.range(0)))));
+}
+BENCHMARK(BM_GeneratedL2capBasicFrameSerialize)->Arg(23)->Arg(1017);
+
+// ERTM I-frames with FCS and a payload of state.range(0) bytes, IsValid() and Serialize() both compute the FCS
+
+std::unique_ptr<l2cap::EnhancedInformationFrameWithFcsBuilder> MakeIFrame(size_t payload_size) {
+  return l2cap::EnhancedInformationFrameWithFcsBuilder::Create(
+      kDynamicCid,
+      5,
+      l2cap::Final::NOT_SET,
+      3,
+      l2cap::SegmentationAndReassembly::UNSEGMENTED,
+      std::make_unique<RawBuilder>(Payload(payload_size)));
+}
+
+void BM_GeneratedL2capIFrameParse(State& state) {
+  auto view = MakeView(*MakeIFrame(state.range(0)));
+  for (auto _ : state) {
+    auto frame = l2cap::EnhancedInformationFrameWithFcsView::Create(
+        l2cap::StandardFrameWithFcsView::Create(l2cap::BasicFrameWithFcsView::Create(view)));
+    if (!frame.IsValid()) {
+      state.SkipWithError("invalid I-frame");
+      break;
+    }
+    benchmark::DoNotOptimize(frame.GetTxSeq());
+    benchmark::DoNotOptimize(frame.GetReqSeq());
+    benchmark::DoNotOptimize(frame.GetSar());
+    benchmark::DoNotOptimize(frame.GetPayload().size());
+  }
+  state.SetBytesProcessed(state.iterations() * view.size());
+}
+BENCHMARK(BM_GeneratedL2capIFrameParse)->Arg(64)->Arg(1011);
+
+void BM_GeneratedL2capIFrameSerialize(State& state) {
+  SerializeLoop(state, *MakeIFrame(state.range(0)));
+}
+BENCHMARK(BM_GeneratedL2capIFrameSerialize)->Arg(64)->Arg(1011);
+
+// ATT Handle Value Notifications of state.range(0) value bytes, from the ACL header down to the attribute handle
+
+std::unique_ptr<hci::AclBuilder> MakeAttNotification(size_t value_size) {
+  std::vector<uint8_t> att = {kAttHandleValueNotification, 0x2a, 0x00};
+  auto value = Payload(value_size);
+  att.insert(att.end(), value.begin(), value.end());
+  return hci::AclBuilder::Create(
+      kHandle,
+      hci::PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
+      hci::BroadcastFlag::POINT_TO_POINT,
+      l2cap::BasicFrameBuilder::Create(kAttCid, std::make_unique<RawBuilder>(att)));
+}
+
+void BM_GeneratedAttNotificationParse(State& state) {
+  auto view = MakeView(*MakeAttNotification(state.range(0)));
+  for (auto _ : state) {
+    auto acl = hci::AclView::Create(view);
+    if (!acl.IsValid()) {
+      state.SkipWithError("invalid ACL packet");
+      break;
+    }
+    auto frame = l2cap::BasicFrameView::Create(acl.GetPayload());
+    if (!frame.IsValid() || frame.GetChannelId() != kAttCid) {
+      state.SkipWithError("invalid ATT basic frame");
+      break;
+    }
+    auto att = frame.GetPayload();
+    auto it = att.begin();
+    benchmark::DoNotOptimize(it.extract<uint8_t>());
+    benchmark::DoNotOptimize(it.extract<uint16_t>());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GeneratedAttNotificationParse)->Arg(20)->Arg(244);
+
+void BM_GeneratedAttNotificationSerialize(State& state) {
+  SerializeLoop(state, *MakeAttNotification(state.range(0)));
+}
+BENCHMARK(BM_GeneratedAttNotificationSerialize)->Arg(20)->Arg(244);
+
+// SMP Pairing Request and Pairing Public Key commands, the fixed size and the largest command of LE Secure Connections
+
+std::unique_ptr<security::PairingRequestBuilder> MakePairingRequest() {
+  return security::PairingRequestBuilder::Create(
+      security::IoCapability::KEYBOARD_DISPLAY, security::OobDataFlag::NOT_PRESENT, 0x2d, 16, 0x0f, 0x0f);
+}
+
+std::unique_ptr<security::PairingPublicKeyBuilder> MakePairingPublicKey() {
+  std::array<uint8_t, 32> public_key_x;
+  std::array<uint8_t, 32> public_key_y;
+  for (size_t i = 0; i < public_key_x.size(); i++) {
+    public_key_x[i] = static_cast<uint8_t>(i);
+    public_key_y[i] = static_cast<uint8_t>(0xff - i);
+  }
+  return security::PairingPublicKeyBuilder::Create(public_key_x, public_key_y);
+}
+
+void BM_GeneratedSmpPairingRequestParse(State& state) {
+  auto view = MakeView(*MakePairingRequest());
+  for (auto _ : state) {
+    auto request = security::PairingRequestView::Create(security::CommandView::Create(view));
+    if (!request.IsValid()) {
+      state.SkipWithError("invalid Pairing Request");
+      break;
+    }
+    benchmark::DoNotOptimize(request.GetIoCapability());
+    benchmark::DoNotOptimize(request.GetAuthReq());
+    benchmark::DoNotOptimize(request.GetMaximumEncryptionKeySize());
+    benchmark::DoNotOptimize(request.GetInitiatorKeyDistribution());
+    benchmark::DoNotOptimize(request.GetResponderKeyDistribution());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GeneratedSmpPairingRequestParse);
+
+void BM_GeneratedSmpPairingRequestSerialize(State& state) {
+  SerializeLoop(state, *MakePairingRequest());
+}
+BENCHMARK(BM_GeneratedSmpPairingRequestSerialize);
+
+void BM_GeneratedSmpPairingPublicKeyParse(State& state) {
+  auto view = MakeView(*MakePairingPublicKey());
+  for (auto _ : state) {
+    auto public_key = security::PairingPublicKeyView::Create(security::CommandView::Create(view));
+    if (!public_key.IsValid()) {
+      state.SkipWithError("invalid Pairing Public Key");
+      break;
+    }
+    benchmark::DoNotOptimize(public_key.GetPublicKeyX());
+    benchmark::DoNotOptimize(public_key.GetPublicKeyY());
+  }
+  state.SetBytesProcessed(state.iterations() * view.size());
+}
+BENCHMARK(BM_GeneratedSmpPairingPublicKeyParse);
+
+void BM_GeneratedSmpPairingPublicKeySerialize(State& state) {
+  SerializeLoop(state, *MakePairingPublicKey());
+}
+BENCHMARK(BM_GeneratedSmpPairingPublicKeySerialize);
+
+}  // namespace
+}  // namespace packet
+}  // namespace bluetooth
@@ -16,6 +16,8 @@
 
 #include "packet/iterator.h"
 
+#include <iterator>
+
 #include "os/log.h"
 
 namespace bluetooth {
@@ -23,13 +25,20 @@ namespace packet {
 
 template <bool little_endian>
 Iterator<little_endian>::Iterator(const std::forward_list<View>& data, size_t offset) {
-  data_ = data;
+  contiguous_data_ = nullptr;
   index_ = offset;
   begin_ = 0;
   end_ = 0;
   for (auto& view : data) {
     end_ += view.size();
   }
+  if (!data.empty() && std::next(data.begin()) == data.end()) {
+    const View& view = data.front();
+    contiguous_buffer_ = view.data_;
+    contiguous_data_ = view.data_->data() + view.begin_;
+  } else {
+    data_ = data;
+  }
 }
 
 template <bool little_endian>
@@ -81,6 +90,8 @@ template <bool little_endian>
 Iterator<little_endian>& Iterator<little_endian>::operator=(const Iterator<little_endian>& itr) {
   if (this == &itr) return *this;
   this->data_ = itr.data_;
+  this->contiguous_buffer_ = itr.contiguous_buffer_;
+  this->contiguous_data_ = itr.contiguous_data_;
   this->begin_ = itr.begin_;
   this->end_ = itr.end_;
   this->index_ = itr.index_;
@@ -120,6 +131,9 @@ bool Iterator<little_endian>::operator>=(const Iterator<little_endian>& itr) con
 template <bool little_endian>
 uint8_t Iterator<little_endian>::operator*() const {
   ASSERT_LOG(index_ < end_ && !(begin_ > index_), "Index %zu out of bounds: [%zu,%zu)", index_, begin_, end_);
+  if (contiguous_data_ != nullptr) {
+    return contiguous_data_[index_];
+  }
   size_t index = index_;
 
   for (auto view : data_) {
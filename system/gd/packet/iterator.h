@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <forward_list>
 #include <memory>
 #include <type_traits>
@@ -69,6 +71,16 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
     FixedWidthPODType extracted_value{};
     uint8_t* value_ptr = (uint8_t*)&extracted_value;
 
+    const uint8_t* bytes = ContiguousBytes(sizeof(FixedWidthPODType));
+    if (bytes != nullptr) {
+      std::memcpy(value_ptr, bytes, sizeof(FixedWidthPODType));
+      index_ += sizeof(FixedWidthPODType);
+      if (!little_endian) {
+        SwapBytes(value_ptr, sizeof(FixedWidthPODType));
+      }
+      return extracted_value;
+    }
+
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
       size_t index = (little_endian ? i : sizeof(FixedWidthPODType) - i - 1);
       value_ptr[index] = this->operator*();
@@ -80,8 +92,21 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
   template <typename T, typename std::enable_if<std::is_base_of_v<CustomFieldFixedSizeInterface<T>, T>, int>::type = 0>
   T extract() {
     T extracted_value{};
-    for (size_t i = 0; i < CustomFieldFixedSizeInterface<T>::length(); i++) {
-      size_t index = (little_endian ? i : CustomFieldFixedSizeInterface<T>::length() - i - 1);
+    const size_t length = CustomFieldFixedSizeInterface<T>::length();
+
+    const uint8_t* bytes = ContiguousBytes(length);
+    if (bytes != nullptr) {
+      if (little_endian) {
+        std::copy(bytes, bytes + length, extracted_value.data());
+      } else {
+        std::reverse_copy(bytes, bytes + length, extracted_value.data());
+      }
+      index_ += length;
+      return extracted_value;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+      size_t index = (little_endian ? i : length - i - 1);
       extracted_value.data()[index] = this->operator*();
       this->operator++();
     }
@@ -89,7 +114,50 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
   }
 
  private:
+  // Pointer to the |length| bytes at the current position when they are all in bounds and the iterator runs over a
+  // single fragment, nullptr otherwise
+  const uint8_t* ContiguousBytes(size_t length) const {
+    // Same bounds as NumBytesRemaining(), without overflowing for a large |length| or an |index_| before begin()
+    if (contiguous_data_ == nullptr || index_ < begin_ || index_ > end_ || length > end_ - index_) {
+      return nullptr;
+    }
+    return contiguous_data_ + index_;
+  }
+
+  static void SwapBytes(uint8_t* value, size_t length) {
+    switch (length) {
+      case 2: {
+        uint16_t swapped;
+        std::memcpy(&swapped, value, sizeof(swapped));
+        swapped = __builtin_bswap16(swapped);
+        std::memcpy(value, &swapped, sizeof(swapped));
+        break;
+      }
+      case 4: {
+        uint32_t swapped;
+        std::memcpy(&swapped, value, sizeof(swapped));
+        swapped = __builtin_bswap32(swapped);
+        std::memcpy(value, &swapped, sizeof(swapped));
+        break;
+      }
+      case 8: {
+        uint64_t swapped;
+        std::memcpy(&swapped, value, sizeof(swapped));
+        swapped = __builtin_bswap64(swapped);
+        std::memcpy(value, &swapped, sizeof(swapped));
+        break;
+      }
+      default:
+        std::reverse(value, value + length);
+        break;
+    }
+  }
+
+  // Only populated when the iterator runs over more than one fragment
   std::forward_list<View> data_;
+  // Keeps the bytes of a single-fragment iterator alive, |contiguous_data_| points at its first byte
+  std::shared_ptr<const std::vector<uint8_t>> contiguous_buffer_;
+  const uint8_t* contiguous_data_;
   size_t index_;
   size_t begin_;
   size_t end_;
@@ -99,6 +99,24 @@ PacketView<false> PacketView<little_endian>::GetBigEndianSubview(size_t begin, s
   return PacketView<false>(GetSubviewList(begin, end));
 }
 
+template <bool little_endian>
+void PacketView<little_endian>::AppendTo(std::vector<uint8_t>* bytes) const {
+  bytes->reserve(bytes->size() + length_);
+  for (const auto& fragment : fragments_) {
+    fragment.AppendTo(bytes);
+  }
+}
+
+template <bool little_endian>
+void PacketView<little_endian>::ForEachFragment(
+    const std::function<void(const uint8_t* data, size_t size)>& on_fragment) const {
+  for (const auto& fragment : fragments_) {
+    if (fragment.size() > 0) {
+      on_fragment(fragment.data(), fragment.size());
+    }
+  }
+}
+
 template <bool little_endian>
 void PacketView<little_endian>::Append(PacketView to_add) {
   auto insertion_point = fragments_.begin();
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <forward_list>
+#include <functional>
 
 #include "packet/iterator.h"
 #include "packet/view.h"
@@ -53,6 +54,12 @@ class PacketView {
 
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
 
+  // Append the bytes of the packet to |bytes|, a fragment at a time
+  void AppendTo(std::vector<uint8_t>* bytes) const;
+
+  // Call |on_fragment| with the contiguous bytes of each fragment, in order
+  void ForEachFragment(const std::function<void(const uint8_t* data, size_t size)>& on_fragment) const;
+
  protected:
   void Append(PacketView to_add);
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "l2cap/l2cap_packets.h"
+#include "packet/packet_view.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace packet {
+namespace {
+
+// Single fragment views take the contiguous fast path, views split in three fragments take the per-byte path that
+// every view used before
+PacketView<kLittleEndian> MakeView(const std::vector<uint8_t>& bytes, bool fragmented) {
+  auto buffer = std::make_shared<const std::vector<uint8_t>>(bytes);
+  if (!fragmented) {
+    return PacketView<kLittleEndian>(std::forward_list<View>{View(buffer, 0, buffer->size())});
+  }
+  size_t first = buffer->size() / 3;
+  size_t second = 2 * buffer->size() / 3;
+  return PacketView<kLittleEndian>(std::forward_list<View>{
+      View(buffer, 0, first), View(buffer, first, second), View(buffer, second, buffer->size())});
+}
+
+// LE Meta event carrying one legacy advertising report with flags, a 128-bit service UUID and a local name
+std::vector<uint8_t> MakeLeAdvertisingReportEvent() {
+  std::vector<uint8_t> advertising_data = {
+      0x02, 0x01, 0x06,  // flags
+      0x11, 0x07, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+      0x08, 0x09, 'b', 'e', 'n', 'c', 'h', '0', '1',  // complete local name
+  };
+  std::vector<uint8_t> parameters = {
+      0x02,                                // subevent code: advertising report
+      0x01,                                // number of reports
+      0x00,                                // ADV_IND
+      0x00,                                // public address
+      0x11, 0x22, 0x33, 0x44, 0x55, 0x66,  // address
+      static_cast<uint8_t>(advertising_data.size()),
+  };
+  parameters.insert(parameters.end(), advertising_data.begin(), advertising_data.end());
+  parameters.push_back(0xc4);  // rssi
+
+  std::vector<uint8_t> event = {0x3e, static_cast<uint8_t>(parameters.size())};
+  event.insert(event.end(), parameters.begin(), parameters.end());
+  return event;
+}
+
+// ACL packet carrying a full 27 byte LE L2CAP basic frame on the ATT channel
+std::vector<uint8_t> MakeAclPacket() {
+  std::vector<uint8_t> l2cap = {0x17, 0x00, 0x04, 0x00};
+  for (uint8_t i = 0; i < 23; i++) {
+    l2cap.push_back(i);
+  }
+  std::vector<uint8_t> acl = {0x40, 0x20, static_cast<uint8_t>(l2cap.size()), 0x00};
+  acl.insert(acl.end(), l2cap.begin(), l2cap.end());
+  return acl;
+}
+
+void BM_ParseLeAdvertisingReport(State& state) {
+  auto view = MakeView(MakeLeAdvertisingReportEvent(), state.range(0));
+  for (auto _ : state) {
+    auto report = hci::LeAdvertisingReportView::Create(hci::LeMetaEventView::Create(hci::EventView::Create(view)));
+    if (!report.IsValid()) {
+      state.SkipWithError("invalid advertising report");
+      break;
+    }
+    for (const auto& response : report.GetResponses()) {
+      benchmark::DoNotOptimize(response.address_);
+      benchmark::DoNotOptimize(response.rssi_);
+    }
+  }
+  state.SetLabel(state.range(0) ? "fragmented" : "contiguous");
+}
+BENCHMARK(BM_ParseLeAdvertisingReport)->Arg(false)->Arg(true);
+
+void BM_ParseAclHeader(State& state) {
+  auto view = MakeView(MakeAclPacket(), state.range(0));
+  for (auto _ : state) {
+    auto acl = hci::AclView::Create(view);
+    if (!acl.IsValid()) {
+      state.SkipWithError("invalid ACL packet");
+      break;
+    }
+    benchmark::DoNotOptimize(acl.GetHandle());
+    benchmark::DoNotOptimize(acl.GetPacketBoundaryFlag());
+    auto basic_frame = l2cap::BasicFrameView::Create(acl.GetPayload());
+    if (!basic_frame.IsValid()) {
+      state.SkipWithError("invalid L2CAP basic frame");
+      break;
+    }
+    benchmark::DoNotOptimize(basic_frame.GetChannelId());
+  }
+  state.SetLabel(state.range(0) ? "fragmented" : "contiguous");
+}
+BENCHMARK(BM_ParseAclHeader)->Arg(false)->Arg(true);
+
+void BM_IteratorExtract(State& state) {
+  auto view = MakeView(MakeAclPacket(), state.range(0));
+  for (auto _ : state) {
+    auto it = view.begin();
+    uint32_t sum = 0;
+    while (it.NumBytesRemaining() >= sizeof(uint16_t)) {
+      sum += it.extract<uint16_t>();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetLabel(state.range(0) ? "fragmented" : "contiguous");
+}
+BENCHMARK(BM_IteratorExtract)->Arg(false)->Arg(true);
+
+}  // namespace
+}  // namespace packet
+}  // namespace bluetooth
@@ -552,6 +552,61 @@ TEST_F(PacketViewMultiViewTest, arrayOperatorTest) {
   ASSERT_DEATH(multi_view[single_view.size()], "");
 }
 
+TEST_F(PacketViewMultiViewTest, extractAtEveryOffsetTest) {
+  for (size_t offset = 0; offset + sizeof(uint64_t) <= single_view.size(); offset++) {
+    auto single_itr = single_view.begin() + offset;
+    auto multi_itr = multi_view.begin() + offset;
+    ASSERT_EQ(single_itr.extract<uint16_t>(), multi_itr.extract<uint16_t>());
+    ASSERT_EQ(single_itr, multi_itr);
+    single_itr = single_view.begin() + offset;
+    multi_itr = multi_view.begin() + offset;
+    ASSERT_EQ(single_itr.extract<uint32_t>(), multi_itr.extract<uint32_t>());
+    single_itr = single_view.begin() + offset;
+    multi_itr = multi_view.begin() + offset;
+    ASSERT_EQ(single_itr.extract<uint64_t>(), multi_itr.extract<uint64_t>());
+    ASSERT_EQ(single_itr, multi_itr);
+  }
+}
+
+TEST_F(PacketViewMultiViewTest, extractBigEndianAtEveryOffsetTest) {
+  PacketView<false> single_be = PacketView<false>(single_view.GetBigEndianSubview(0, single_view.size()));
+  PacketView<false> multi_be = PacketView<false>(multi_view.GetBigEndianSubview(0, multi_view.size()));
+  for (size_t offset = 0; offset + Address::kLength <= single_be.size(); offset++) {
+    auto single_itr = single_be.begin() + offset;
+    auto multi_itr = multi_be.begin() + offset;
+    ASSERT_EQ(single_itr.extract<uint32_t>(), multi_itr.extract<uint32_t>());
+    single_itr = single_be.begin() + offset;
+    multi_itr = multi_be.begin() + offset;
+    ASSERT_EQ(single_itr.extract<Address>(), multi_itr.extract<Address>());
+    ASSERT_EQ(single_itr, multi_itr);
+  }
+}
+
+TEST_F(PacketViewMultiViewTest, extractPastSubrangeDeathTest) {
+  auto subrange = single_view.begin().Subrange(4, 3);
+  ASSERT_EQ(0x0504, subrange.extract<uint16_t>());
+  ASSERT_DEATH(subrange.extract<uint16_t>(), "");
+}
+
+TEST_F(PacketViewMultiViewTest, appendToTest) {
+  std::vector<uint8_t> bytes = {0xff};
+  multi_view.AppendTo(&bytes);
+  std::vector<uint8_t> expected = {0xff};
+  expected.insert(expected.end(), count_all.begin(), count_all.end());
+  ASSERT_EQ(bytes, expected);
+
+  bytes.clear();
+  single_view.GetLittleEndianSubview(3, 7).AppendTo(&bytes);
+  ASSERT_EQ(bytes, std::vector<uint8_t>(count_all.begin() + 3, count_all.begin() + 7));
+}
+
+TEST_F(PacketViewMultiViewTest, extractBeforeBeginDeathTest) {
+  auto itr = single_view.begin() - 1;
+  ASSERT_DEATH(itr.extract<uint16_t>(), "");
+  itr = single_view.begin() - 2;
+  ASSERT_DEATH(itr.extract<uint64_t>(), "");
+}
+
 TEST_F(PacketViewMultiViewAppendTest, sizeTestAppend) {
   ASSERT_EQ(single_view.size(), multi_view.size());
 }
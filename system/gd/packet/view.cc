@@ -40,5 +40,13 @@ uint8_t View::operator[](size_t i) const {
 size_t View::size() const {
   return end_ - begin_;
 }
+
+void View::AppendTo(std::vector<uint8_t>* bytes) const {
+  bytes->insert(bytes->end(), data_->begin() + begin_, data_->begin() + end_);
+}
+
+const uint8_t* View::data() const {
+  return data_->data() + begin_;
+}
 }  // namespace packet
 }  // namespace bluetooth
@@ -23,6 +23,9 @@
 namespace bluetooth {
 namespace packet {
 
+template <bool little_endian>
+class Iterator;
+
 // Base class that holds a shared pointer to data with bounds.
 class View {
  public:
@@ -35,7 +38,17 @@ class View {
 
   size_t size() const;
 
+  // Append the bytes of the view to |bytes|
+  void AppendTo(std::vector<uint8_t>* bytes) const;
+
+  // The first of the size() contiguous bytes of the view
+  const uint8_t* data() const;
+
  private:
+  // Iterators read the bytes of single-fragment packets directly
+  template <bool little_endian>
+  friend class Iterator;
+
   std::shared_ptr<const std::vector<uint8_t>> data_;
   size_t begin_;
   size_t end_;
@@ -107,6 +107,113 @@ TEST(SmpEccValidationTest, test_invalid_points) {
   EXPECT_FALSE(ECC_ValidatePoint(p));
 }
 
+// Sample data of Bluetooth Core Specification Version 5.0 | Vol 2, Part G | 7.1.2, least significant word first
+constexpr uint32_t kPrivateKeyA[KEY_LENGTH_DWORDS_P256] = {
+    0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b, 0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+constexpr uint32_t kPublicKeyAX[KEY_LENGTH_DWORDS_P256] = {
+    0x0e359de6, 0xcc030148, 0xacf4fddb, 0xeff49111, 0xe9f9a5b9, 0x5e2c83a7, 0xf297be2c, 0x20b003d2};
+constexpr uint32_t kPublicKeyAY[KEY_LENGTH_DWORDS_P256] = {
+    0x1589d28b, 0x741c8ed0, 0x8fed3024, 0x766345c2, 0x5a52155c, 0x63329abf, 0x652aeb6d, 0xdc809c49};
+constexpr uint32_t kPrivateKeyB[KEY_LENGTH_DWORDS_P256] = {
+    0xf47fc5fd, 0x6b4fdd49, 0xf19d7cfb, 0x59cb9ac2, 0xeed4e72a, 0x900afcfb, 0x32f6bb9a, 0x55188b3d};
+constexpr uint32_t kPublicKeyBX[KEY_LENGTH_DWORDS_P256] = {
+    0x2faaa190, 0x559077b2, 0x8615a69f, 0x47b58afd, 0xf19e4c00, 0x09592284, 0x1faf1d96, 0x1ea1f0f0};
+constexpr uint32_t kPublicKeyBY[KEY_LENGTH_DWORDS_P256] = {
+    0x15b1214a, 0x5f89aff9, 0xe28e3676, 0x472d1130, 0x9ab85160, 0x7356703a, 0x429dad37, 0x4c55f33e};
+constexpr uint32_t kDhKey[KEY_LENGTH_DWORDS_P256] = {
+    0x73bfa698, 0x868d34f3, 0xb4f866f1, 0x99796b13, 0x0a397d9b, 0x341010a6, 0x57c8ad05, 0xec0234a3};
+
+Point MakeAffinePoint(const uint32_t* x, const uint32_t* y) {
+  Point p;
+  multiprecision_copy(p.x, x);
+  multiprecision_copy(p.y, y);
+  multiprecision_init(p.z);
+  p.z[0] = 1;
+  return p;
+}
+
+// ECC_PointMult destroys the scalar on targets without 128-bit integers
+void PointMult(Point* q, const Point* p, const uint32_t* n) {
+  uint32_t n_copy[KEY_LENGTH_DWORDS_P256];
+  multiprecision_copy(n_copy, n);
+  ECC_PointMult(q, p, n_copy);
+}
+
+TEST(SmpEccMultiplicationTest, test_spec_sample_data) {
+  Point public_key_a;
+  PointMult(&public_key_a, &curve_p256.G, kPrivateKeyA);
+  EXPECT_EQ(0, multiprecision_compare(public_key_a.x, kPublicKeyAX));
+  EXPECT_EQ(0, multiprecision_compare(public_key_a.y, kPublicKeyAY));
+
+  Point public_key_b;
+  PointMult(&public_key_b, &curve_p256.G, kPrivateKeyB);
+  EXPECT_EQ(0, multiprecision_compare(public_key_b.x, kPublicKeyBX));
+  EXPECT_EQ(0, multiprecision_compare(public_key_b.y, kPublicKeyBY));
+
+  Point dh_key_a, dh_key_b;
+  Point peer_b = MakeAffinePoint(kPublicKeyBX, kPublicKeyBY);
+  Point peer_a = MakeAffinePoint(kPublicKeyAX, kPublicKeyAY);
+  PointMult(&dh_key_a, &peer_b, kPrivateKeyA);
+  PointMult(&dh_key_b, &peer_a, kPrivateKeyB);
+  EXPECT_EQ(0, multiprecision_compare(dh_key_a.x, kDhKey));
+  EXPECT_EQ(0, multiprecision_compare(dh_key_b.x, kDhKey));
+}
+
+#ifdef __SIZEOF_INT128__
+// The fixed window implementation must give the same points as the reference one
+TEST(SmpEccMultiplicationTest, test_matches_reference) {
+  Point peer = MakeAffinePoint(kPublicKeyBX, kPublicKeyBY);
+  uint32_t seed = 1;
+  for (int i = 0; i < 20; i++) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    for (auto& word : n) {
+      seed = seed * 1103515245 + 12345;
+      word = seed ^ (seed << 16);
+    }
+    // Small scalars, which leave most windows empty
+    if (i < 3) {
+      multiprecision_init(n);
+      n[0] = i + 1;
+    }
+
+    for (const Point* base : {&curve_p256.G, static_cast<const Point*>(&peer)}) {
+      uint32_t n_copy[KEY_LENGTH_DWORDS_P256];
+      multiprecision_copy(n_copy, n);
+      Point expected, result;
+      ECC_PointMult_Bin_NAF(&expected, base, n_copy);
+      ECC_PointMult_Fixed_Window(&result, base, n);
+      EXPECT_EQ(0, multiprecision_compare(result.x, expected.x)) << "scalar " << i;
+      EXPECT_EQ(0, multiprecision_compare(result.y, expected.y)) << "scalar " << i;
+      EXPECT_TRUE(ECC_ValidatePoint(result));
+    }
+  }
+}
+
+// Scalars at or past the order of the group reach the point at infinity and the doubling case of the additions
+TEST(SmpEccMultiplicationTest, test_scalars_around_order) {
+  constexpr uint32_t kOrder[KEY_LENGTH_DWORDS_P256] = {
+      0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff};
+  for (int delta : {-1, 0, 1}) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    multiprecision_copy(n, kOrder);
+    n[0] += delta;
+    Point result;
+    ECC_PointMult_Fixed_Window(&result, &curve_p256.G, n);
+    if (delta == 0) {
+      EXPECT_EQ(0u, result.z[0]);
+      continue;
+    }
+    EXPECT_EQ(0, multiprecision_compare(result.x, curve_p256.G.x)) << "order + " << delta;
+    uint32_t expected_y[KEY_LENGTH_DWORDS_P256];
+    multiprecision_copy(expected_y, curve_p256.G.y);
+    if (delta < 0) {
+      multiprecision_sub(expected_y, curve_p256.p, curve_p256.G.y);
+    }
+    EXPECT_EQ(0, multiprecision_compare(result.y, expected_y)) << "order + " << delta;
+  }
+}
+#endif  // __SIZEOF_INT128__
+
 }  // namespace ecc
 }  // namespace security
 }  // namespace bluetooth
@@ -67,9 +67,19 @@ static constexpr elliptic_curve_t curve_p256{
 /* This function checks that point is on the elliptic curve*/
 bool ECC_ValidatePoint(const Point& point);
 
+// Reference implementation with 32-bit limbs and a binary NAF. Destroys |n|.
 void ECC_PointMult_Bin_NAF(Point* q, const Point* p, uint32_t* n);
 
+#ifdef __SIZEOF_INT128__
+// q = n * p in constant time, with 64-bit limbs in the Montgomery domain. |p| must be affine (z = 1), and |q| is
+// returned affine. Multiples of the base point curve_p256.G use a precomputed comb.
+void ECC_PointMult_Fixed_Window(Point* q, const Point* p, const uint32_t* n);
+
+#define ECC_PointMult(q, p, n) ECC_PointMult_Fixed_Window(q, p, n)
+#else
+// The 64-bit limbs need a 128-bit integer type, other targets keep the reference implementation
 #define ECC_PointMult(q, p, n) ECC_PointMult_Bin_NAF(q, p, n)
+#endif  // __SIZEOF_INT128__
 
 }  // namespace ecc
 }  // namespace security
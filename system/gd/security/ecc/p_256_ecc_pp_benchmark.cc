@@ -0,0 +1,88 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "security/ecc/p_256_ecc_pp.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+namespace {
+
+// Private key A of the sample data of the Core Specification, least significant word first
+constexpr uint32_t kPrivateKey[KEY_LENGTH_DWORDS_P256] = {
+    0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b, 0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+
+// Public key B of the same sample data, the peer key of a DHKey computation
+Point PeerPublicKey() {
+  Point peer = {
+      .x = {0x2faaa190, 0x559077b2, 0x8615a69f, 0x47b58afd, 0xf19e4c00, 0x09592284, 0x1faf1d96, 0x1ea1f0f0},
+      .y = {0x15b1214a, 0x5f89aff9, 0xe28e3676, 0x472d1130, 0x9ab85160, 0x7356703a, 0x429dad37, 0x4c55f33e},
+      .z = {1},
+  };
+  return peer;
+}
+
+// The binary NAF implementation that ECC_PointMult used before
+void RunReference(State& state, const Point& base) {
+  Point result;
+  for (auto _ : state) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    multiprecision_copy(n, kPrivateKey);
+    ECC_PointMult_Bin_NAF(&result, &base, n);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+// ECC_PointMult, the fixed window implementation on targets with 128-bit integers
+void RunPointMult(State& state, const Point& base) {
+  Point result;
+  for (auto _ : state) {
+    uint32_t n[KEY_LENGTH_DWORDS_P256];
+    multiprecision_copy(n, kPrivateKey);
+    ECC_PointMult(&result, &base, n);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+// Public key generation
+void BM_PointMult_Reference_BasePoint(State& state) {
+  RunReference(state, curve_p256.G);
+}
+BENCHMARK(BM_PointMult_Reference_BasePoint)->Unit(benchmark::kMicrosecond);
+
+void BM_PointMult_BasePoint(State& state) {
+  RunPointMult(state, curve_p256.G);
+}
+BENCHMARK(BM_PointMult_BasePoint)->Unit(benchmark::kMicrosecond);
+
+// DHKey computation
+void BM_PointMult_Reference_PeerKey(State& state) {
+  RunReference(state, PeerPublicKey());
+}
+BENCHMARK(BM_PointMult_Reference_PeerKey)->Unit(benchmark::kMicrosecond);
+
+void BM_PointMult_PeerKey(State& state) {
+  RunPointMult(state, PeerPublicKey());
+}
+BENCHMARK(BM_PointMult_PeerKey)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
@@ -0,0 +1,436 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// P-256 scalar multiplication with 64-bit limbs in the Montgomery domain. Nothing below branches on, or indexes memory
+// with, the scalar or values derived from it, except for the exceptional doubling case of point_add() that no scalar
+// below the order of the group reaches.
+
+#include <cstring>
+
+#include "security/ecc/p_256_ecc_pp.h"
+
+#ifdef __SIZEOF_INT128__
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+
+namespace {
+
+using u128 = unsigned __int128;
+
+constexpr size_t kLimbs = 4;
+
+// Field element mod p in Montgomery form, a * 2^256 mod p, least significant limb first
+struct FieldElement {
+  uint64_t limb[kLimbs];
+};
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+constexpr FieldElement kP = {{0xffffffffffffffff, 0x00000000ffffffff, 0x0000000000000000, 0xffffffff00000001}};
+// 2^512 mod p, converts into the Montgomery domain
+constexpr FieldElement kRR = {{0x0000000000000003, 0xfffffffbffffffff, 0xfffffffffffffffe, 0x00000004fffffffd}};
+// 1 in the Montgomery domain, 2^256 mod p
+constexpr FieldElement kOne = {{0x0000000000000001, 0xffffffff00000000, 0xffffffffffffffff, 0x00000000fffffffe}};
+
+// 0 if |a| is zero, all ones otherwise
+uint64_t mask_nonzero(uint64_t a) {
+  return 0 - ((a | (0 - a)) >> 63);
+}
+
+// out = mask ? a : out, where |mask| is all zeros or all ones
+void fe_cmov(FieldElement* out, const FieldElement& a, uint64_t mask) {
+  for (size_t i = 0; i < kLimbs; i++) {
+    out->limb[i] ^= mask & (out->limb[i] ^ a.limb[i]);
+  }
+}
+
+// Reduce the 257-bit value |carry|:|t| below p
+void fe_reduce_once(FieldElement* out, const uint64_t t[kLimbs], uint64_t carry) {
+  FieldElement reduced;
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < kLimbs; i++) {
+    u128 diff = static_cast<u128>(t[i]) - kP.limb[i] - borrow;
+    reduced.limb[i] = static_cast<uint64_t>(diff);
+    borrow = static_cast<uint64_t>(diff >> 64) & 1;
+  }
+  // Keep t if it was below p, that is if the subtraction borrowed more than the carry
+  uint64_t keep_t = 0 - (borrow & ~carry & 1);
+  for (size_t i = 0; i < kLimbs; i++) {
+    out->limb[i] = (t[i] & keep_t) | (reduced.limb[i] & ~keep_t);
+  }
+}
+
+void fe_add(FieldElement* out, const FieldElement& a, const FieldElement& b) {
+  uint64_t t[kLimbs];
+  uint64_t carry = 0;
+  for (size_t i = 0; i < kLimbs; i++) {
+    u128 sum = static_cast<u128>(a.limb[i]) + b.limb[i] + carry;
+    t[i] = static_cast<uint64_t>(sum);
+    carry = static_cast<uint64_t>(sum >> 64);
+  }
+  fe_reduce_once(out, t, carry);
+}
+
+void fe_sub(FieldElement* out, const FieldElement& a, const FieldElement& b) {
+  uint64_t t[kLimbs];
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < kLimbs; i++) {
+    u128 diff = static_cast<u128>(a.limb[i]) - b.limb[i] - borrow;
+    t[i] = static_cast<uint64_t>(diff);
+    borrow = static_cast<uint64_t>(diff >> 64) & 1;
+  }
+  // Add p back if the subtraction wrapped around
+  uint64_t mask = 0 - borrow;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < kLimbs; i++) {
+    u128 sum = static_cast<u128>(t[i]) + (kP.limb[i] & mask) + carry;
+    out->limb[i] = static_cast<uint64_t>(sum);
+    carry = static_cast<uint64_t>(sum >> 64);
+  }
+}
+
+// Returns the low limb of a * b + c + *carry and stores the high one in |carry|, which cannot overflow
+uint64_t mac(uint64_t a, uint64_t b, uint64_t c, uint64_t* carry) {
+  u128 result = static_cast<u128>(a) * b + c + *carry;
+  *carry = static_cast<uint64_t>(result >> 64);
+  return static_cast<uint64_t>(result);
+}
+
+// One step of the Montgomery multiplication, t = (t + a * b) / 2^64 mod p. Since p = -1 mod 2^64, the Montgomery
+// factor m is the low limb itself, and adding m * p reduces to m * 2^32 + m * p[3] * 2^128 after the division.
+void fe_mul_step(uint64_t t[kLimbs + 1], const FieldElement& a, uint64_t b) {
+  uint64_t carry = 0;
+  t[0] = mac(a.limb[0], b, t[0], &carry);
+  t[1] = mac(a.limb[1], b, t[1], &carry);
+  t[2] = mac(a.limb[2], b, t[2], &carry);
+  t[3] = mac(a.limb[3], b, t[3], &carry);
+  u128 sum = static_cast<u128>(t[4]) + carry;
+  t[4] = static_cast<uint64_t>(sum);
+  uint64_t top = static_cast<uint64_t>(sum >> 64);
+
+  uint64_t m = t[0];
+  u128 m_p3 = static_cast<u128>(m) * kP.limb[3];
+  sum = static_cast<u128>(t[1]) + (m << 32);
+  t[0] = static_cast<uint64_t>(sum);
+  sum = static_cast<u128>(t[2]) + (m >> 32) + static_cast<uint64_t>(sum >> 64);
+  t[1] = static_cast<uint64_t>(sum);
+  sum = static_cast<u128>(t[3]) + static_cast<uint64_t>(m_p3) + static_cast<uint64_t>(sum >> 64);
+  t[2] = static_cast<uint64_t>(sum);
+  sum = static_cast<u128>(t[4]) + static_cast<uint64_t>(m_p3 >> 64) + static_cast<uint64_t>(sum >> 64);
+  t[3] = static_cast<uint64_t>(sum);
+  t[4] = top + static_cast<uint64_t>(sum >> 64);
+}
+
+// out = a * b / 2^256 mod p, unrolled since the compiler does not always do it
+void fe_mul(FieldElement* out, const FieldElement& a, const FieldElement& b) {
+  uint64_t t[kLimbs + 1] = {};
+  fe_mul_step(t, a, b.limb[0]);
+  fe_mul_step(t, a, b.limb[1]);
+  fe_mul_step(t, a, b.limb[2]);
+  fe_mul_step(t, a, b.limb[3]);
+  fe_reduce_once(out, t, t[kLimbs]);
+}
+
+void fe_sqr(FieldElement* out, const FieldElement& a) {
+  fe_mul(out, a, a);
+}
+
+// All ones if |a| is zero, 0 otherwise
+uint64_t fe_zero_mask(const FieldElement& a) {
+  return ~mask_nonzero(a.limb[0] | a.limb[1] | a.limb[2] | a.limb[3]);
+}
+
+// out = a^(2^n) * b
+void fe_sqr_n_mul(FieldElement* out, const FieldElement& a, size_t n, const FieldElement& b) {
+  FieldElement t = a;
+  for (size_t i = 0; i < n; i++) {
+    fe_sqr(&t, t);
+  }
+  fe_mul(out, t, b);
+}
+
+// out = a^(p - 2) = 1 / a, with an addition chain of 255 squarings and 13 multiplications. x_k stands for
+// a^(2^k - 1), k ones in the exponent.
+void fe_inv(FieldElement* out, const FieldElement& a) {
+  FieldElement x2, x3, x6, x12, x15, x30, x32, t;
+  fe_sqr_n_mul(&x2, a, 1, a);
+  fe_sqr_n_mul(&x3, x2, 1, a);
+  fe_sqr_n_mul(&x6, x3, 3, x3);
+  fe_sqr_n_mul(&x12, x6, 6, x6);
+  fe_sqr_n_mul(&x15, x12, 3, x3);
+  fe_sqr_n_mul(&x30, x15, 15, x15);
+  fe_sqr_n_mul(&x32, x30, 2, x2);
+
+  // p - 2 = ffffffff 00000001 00000000 00000000 00000000 ffffffff ffffffff fffffffd
+  fe_sqr_n_mul(&t, x32, 32, a);
+  fe_sqr_n_mul(&t, t, 96 + 32, x32);
+  fe_sqr_n_mul(&t, t, 32, x32);
+  fe_sqr_n_mul(&t, t, 30, x30);
+  fe_sqr_n_mul(out, t, 2, a);
+}
+
+void fe_from_words(FieldElement* out, const uint32_t words[KEY_LENGTH_DWORDS_P256]) {
+  FieldElement plain;
+  for (size_t i = 0; i < kLimbs; i++) {
+    plain.limb[i] = static_cast<uint64_t>(words[2 * i]) | (static_cast<uint64_t>(words[2 * i + 1]) << 32);
+  }
+  fe_mul(out, plain, kRR);
+}
+
+void fe_to_words(uint32_t words[KEY_LENGTH_DWORDS_P256], const FieldElement& a) {
+  FieldElement plain;
+  constexpr FieldElement kPlainOne = {{1, 0, 0, 0}};
+  fe_mul(&plain, a, kPlainOne);
+  for (size_t i = 0; i < kLimbs; i++) {
+    words[2 * i] = static_cast<uint32_t>(plain.limb[i]);
+    words[2 * i + 1] = static_cast<uint32_t>(plain.limb[i] >> 32);
+  }
+}
+
+// Point in Jacobian coordinates, (X / Z^2, Y / Z^3), the point at infinity has Z = 0
+struct JacobianPoint {
+  FieldElement x;
+  FieldElement y;
+  FieldElement z;
+};
+
+void point_cmov(JacobianPoint* out, const JacobianPoint& a, uint64_t mask) {
+  fe_cmov(&out->x, a.x, mask);
+  fe_cmov(&out->y, a.y, mask);
+  fe_cmov(&out->z, a.z, mask);
+}
+
+// dbl-2001-b for a = -3, which maps the point at infinity to itself
+void point_double(JacobianPoint* out, const JacobianPoint& a) {
+  FieldElement delta, gamma, beta, alpha, t0, t1;
+  fe_sqr(&delta, a.z);
+  fe_sqr(&gamma, a.y);
+  fe_mul(&beta, a.x, gamma);
+
+  fe_sub(&t0, a.x, delta);
+  fe_add(&t1, a.x, delta);
+  fe_mul(&alpha, t0, t1);
+  fe_add(&t0, alpha, alpha);
+  fe_add(&alpha, t0, alpha);  // alpha = 3 * (x - delta) * (x + delta)
+
+  fe_add(&t0, a.y, a.z);
+  fe_sqr(&t0, t0);
+  fe_sub(&t0, t0, gamma);
+  fe_sub(&out->z, t0, delta);  // z3 = (y + z)^2 - gamma - delta
+
+  fe_add(&beta, beta, beta);
+  fe_add(&beta, beta, beta);  // beta = 4 * x * gamma
+  fe_sqr(&t0, alpha);
+  fe_add(&t1, beta, beta);
+  fe_sub(&out->x, t0, t1);  // x3 = alpha^2 - 8 * beta
+
+  fe_sub(&t0, beta, out->x);
+  fe_mul(&t0, alpha, t0);
+  fe_sqr(&gamma, gamma);
+  fe_add(&gamma, gamma, gamma);
+  fe_add(&gamma, gamma, gamma);
+  fe_add(&gamma, gamma, gamma);
+  fe_sub(&out->y, t0, gamma);  // y3 = alpha * (4 * beta - x3) - 8 * gamma^2
+}
+
+// add-2007-bl, with the point at infinity on either side handled by constant-time selection
+void point_add(JacobianPoint* out, const JacobianPoint& a, const JacobianPoint& b) {
+  FieldElement z1z1, z2z2, u1, u2, s1, s2, h, i, j, r, v, t0;
+  fe_sqr(&z1z1, a.z);
+  fe_sqr(&z2z2, b.z);
+  fe_mul(&u1, a.x, z2z2);
+  fe_mul(&u2, b.x, z1z1);
+  fe_mul(&t0, b.z, z2z2);
+  fe_mul(&s1, a.y, t0);
+  fe_mul(&t0, a.z, z1z1);
+  fe_mul(&s2, b.y, t0);
+  fe_sub(&h, u2, u1);
+  fe_sub(&r, s2, s1);
+  fe_add(&r, r, r);
+
+  uint64_t a_is_infinity = fe_zero_mask(a.z);
+  uint64_t b_is_infinity = fe_zero_mask(b.z);
+  if (fe_zero_mask(h) & fe_zero_mask(r) & ~a_is_infinity & ~b_is_infinity) {
+    // a == b, the formulas below do not work for doubling
+    point_double(out, a);
+    return;
+  }
+
+  JacobianPoint sum;
+  fe_add(&i, h, h);
+  fe_sqr(&i, i);
+  fe_mul(&j, h, i);
+  fe_mul(&v, u1, i);
+
+  fe_sqr(&sum.x, r);
+  fe_sub(&sum.x, sum.x, j);
+  fe_sub(&sum.x, sum.x, v);
+  fe_sub(&sum.x, sum.x, v);  // x3 = r^2 - j - 2 * v
+
+  fe_sub(&t0, v, sum.x);
+  fe_mul(&sum.y, r, t0);
+  fe_mul(&t0, s1, j);
+  fe_add(&t0, t0, t0);
+  fe_sub(&sum.y, sum.y, t0);  // y3 = r * (v - x3) - 2 * s1 * j
+
+  fe_add(&t0, a.z, b.z);
+  fe_sqr(&t0, t0);
+  fe_sub(&t0, t0, z1z1);
+  fe_sub(&t0, t0, z2z2);
+  fe_mul(&sum.z, t0, h);  // z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h
+
+  point_cmov(&sum, b, a_is_infinity);
+  point_cmov(&sum, a, b_is_infinity);
+  *out = sum;
+}
+
+// Window width of the variable base multiplication
+constexpr size_t kWindowBits = 4;
+constexpr size_t kTableSize = 1 << kWindowBits;
+constexpr size_t kScalarBits = 256;
+
+// Read every entry so that the memory access pattern does not depend on |index|
+void table_lookup(JacobianPoint* out, const JacobianPoint table[kTableSize], uint32_t index) {
+  memset(out, 0, sizeof(*out));
+  for (uint32_t i = 0; i < kTableSize; i++) {
+    point_cmov(out, table[i], ~mask_nonzero(i ^ index));
+  }
+}
+
+uint32_t scalar_bit(const uint32_t* n, size_t bit) {
+  return (n[bit / 32] >> (bit % 32)) & 1;
+}
+
+void point_from_affine(JacobianPoint* out, const Point& p) {
+  fe_from_words(&out->x, p.x);
+  fe_from_words(&out->y, p.y);
+  out->z = kOne;
+}
+
+void point_to_affine(Point* out, const JacobianPoint& a) {
+  FieldElement z_inv, z_inv2, x, y;
+  fe_inv(&z_inv, a.z);
+  fe_sqr(&z_inv2, z_inv);
+  fe_mul(&x, a.x, z_inv2);
+  fe_mul(&z_inv2, z_inv2, z_inv);
+  fe_mul(&y, a.y, z_inv2);
+  fe_to_words(out->x, x);
+  fe_to_words(out->y, y);
+  // The point at infinity has no affine coordinates, its inverse of zero gives (0, 0)
+  memset(out->z, 0, sizeof(out->z));
+  out->z[0] = fe_zero_mask(a.z) ? 0 : 1;
+}
+
+// Fixed window: 256 doublings and 64 additions of table entries 0 to 15 times p
+void mult_variable_base(JacobianPoint* out, const JacobianPoint& p, const uint32_t* n) {
+  JacobianPoint table[kTableSize];
+  memset(&table[0], 0, sizeof(table[0]));
+  table[1] = p;
+  for (size_t i = 2; i < kTableSize; i++) {
+    if (i % 2 == 0) {
+      point_double(&table[i], table[i / 2]);
+    } else {
+      point_add(&table[i], table[i - 1], p);
+    }
+  }
+
+  JacobianPoint acc;
+  memset(&acc, 0, sizeof(acc));
+  JacobianPoint entry;
+  for (size_t window = kScalarBits / kWindowBits; window-- > 0;) {
+    for (size_t i = 0; i < kWindowBits; i++) {
+      point_double(&acc, acc);
+    }
+    uint32_t digit = 0;
+    for (size_t i = 0; i < kWindowBits; i++) {
+      digit |= scalar_bit(n, window * kWindowBits + i) << i;
+    }
+    table_lookup(&entry, table, digit);
+    point_add(&acc, acc, entry);
+  }
+  *out = acc;
+}
+
+// Comb of the base point: entry i is the sum of 2^(64 * k) * G over the bits k set in i
+constexpr size_t kCombSpacing = kScalarBits / kWindowBits;
+
+struct CombTable {
+  JacobianPoint entries[kTableSize];
+};
+
+CombTable make_comb_table() {
+  CombTable comb;
+  memset(&comb.entries[0], 0, sizeof(comb.entries[0]));
+  JacobianPoint tooth;
+  point_from_affine(&tooth, curve_p256.G);
+  for (size_t k = 0; k < kWindowBits; k++) {
+    comb.entries[1 << k] = tooth;
+    for (size_t i = 0; i < kCombSpacing; i++) {
+      point_double(&tooth, tooth);
+    }
+  }
+  for (size_t i = 1; i < kTableSize; i++) {
+    size_t low_bit = i & (0 - i);
+    if (i != low_bit) {
+      point_add(&comb.entries[i], comb.entries[i - low_bit], comb.entries[low_bit]);
+    }
+  }
+  return comb;
+}
+
+// Comb method: 64 doublings and 64 additions
+void mult_base(JacobianPoint* out, const uint32_t* n) {
+  static const CombTable comb = make_comb_table();
+
+  JacobianPoint acc;
+  memset(&acc, 0, sizeof(acc));
+  JacobianPoint entry;
+  for (size_t column = kCombSpacing; column-- > 0;) {
+    point_double(&acc, acc);
+    uint32_t digit = 0;
+    for (size_t k = 0; k < kWindowBits; k++) {
+      digit |= scalar_bit(n, k * kCombSpacing + column) << k;
+    }
+    table_lookup(&entry, comb.entries, digit);
+    point_add(&acc, acc, entry);
+  }
+  *out = acc;
+}
+
+bool is_base_point(const Point& p) {
+  return memcmp(p.x, curve_p256.G.x, sizeof(p.x)) == 0 && memcmp(p.y, curve_p256.G.y, sizeof(p.y)) == 0;
+}
+
+}  // namespace
+
+void ECC_PointMult_Fixed_Window(Point* q, const Point* p, const uint32_t* n) {
+  JacobianPoint result;
+  if (is_base_point(*p)) {
+    mult_base(&result, n);
+  } else {
+    JacobianPoint base;
+    point_from_affine(&base, *p);
+    mult_variable_base(&result, base, n);
+  }
+  point_to_affine(q, result);
+}
+
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
+
+#endif  // __SIZEOF_INT128__
@@ -16,8 +16,10 @@
 
 #include "storage/config_cache.h"
 
-#include <ios>
-#include <sstream>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
 #include <utility>
 
 #include "hci/enum_helper.h"
@@ -30,7 +32,6 @@ const std::unordered_set<std::string_view> kEncryptKeyNameList = {
     "LinkKey", "LE_KEY_PENC", "LE_KEY_PID", "LE_KEY_LID", "LE_KEY_PCSRK", "LE_KEY_LENC", "LE_KEY_LCSRK"};
 
 bool TrimAfterNewLine(std::string& value) {
-  std::string value_no_newline;
   size_t newline_position = value.find_first_of('\n');
   if (newline_position != std::string::npos) {
     value.erase(newline_position);
@@ -39,10 +40,27 @@ bool TrimAfterNewLine(std::string& value) {
   return false;
 }
 
-bool InEncryptKeyNameList(std::string key) {
+bool TrimAfterNewLine(std::string_view& value) {
+  size_t newline_position = value.find_first_of('\n');
+  if (newline_position != std::string_view::npos) {
+    value = value.substr(0, newline_position);
+    return true;
+  }
+  return false;
+}
+
+bool InEncryptKeyNameList(std::string_view key) {
   return kEncryptKeyNameList.find(key) != kEncryptKeyNameList.end();
 }
 
+// Name of the key in the keystore for |property| of |section|
+std::string KeystoreKey(std::string_view section, std::string_view property) {
+  std::string key;
+  key.reserve(section.size() + 1 + property.size());
+  key.append(section).append("-").append(property);
+  return key;
+}
+
 }  // namespace
 
 namespace bluetooth {
@@ -62,41 +80,65 @@ ConfigCache::ConfigCache(size_t temp_device_capacity, std::unordered_set<std::st
     : persistent_property_names_(std::move(persistent_property_names)),
       information_sections_(),
       persistent_devices_(),
-      temporary_devices_(temp_device_capacity) {}
+      temporary_devices_(temp_device_capacity) {
+  for (const auto& property : persistent_property_names_) {
+    persistent_property_keys_.insert(PropertyKey::Intern(property));
+  }
+}
 
 void ConfigCache::SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   persistent_config_changed_callback_ = std::move(persistent_config_changed_callback);
 }
 
+void ConfigCache::SetPersistentMutationCallback(PersistentMutationCallback persistent_mutation_callback) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  persistent_mutation_callback_ = std::move(persistent_mutation_callback);
+}
+
 ConfigCache::ConfigCache(ConfigCache&& other) noexcept
     : persistent_config_changed_callback_(std::move(other.persistent_config_changed_callback_)),
+      persistent_mutation_callback_(std::move(other.persistent_mutation_callback_)),
       persistent_property_names_(std::move(other.persistent_property_names_)),
+      persistent_property_keys_(std::move(other.persistent_property_keys_)),
       information_sections_(std::move(other.information_sections_)),
       persistent_devices_(std::move(other.persistent_devices_)),
-      temporary_devices_(std::move(other.temporary_devices_)) {
+      temporary_devices_(std::move(other.temporary_devices_)),
+      sections_by_property_(std::move(other.sections_by_property_)),
+      section_order_(std::move(other.section_order_)),
+      next_section_order_(other.next_section_order_) {
   // std::function will be in a valid but unspecified state after std::move(), hence resetting it
   other.persistent_config_changed_callback_ = {};
+  other.persistent_mutation_callback_ = {};
 }
 
 ConfigCache& ConfigCache::operator=(ConfigCache&& other) noexcept {
   if (&other == this) {
     return *this;
   }
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(other.mutex_);
+  std::scoped_lock<std::shared_mutex, std::shared_mutex> lock(mutex_, other.mutex_);
   persistent_config_changed_callback_.swap(other.persistent_config_changed_callback_);
   other.persistent_config_changed_callback_ = {};
+  persistent_mutation_callback_.swap(other.persistent_mutation_callback_);
+  other.persistent_mutation_callback_ = {};
   persistent_property_names_ = std::move(other.persistent_property_names_);
+  persistent_property_keys_ = std::move(other.persistent_property_keys_);
   information_sections_ = std::move(other.information_sections_);
   persistent_devices_ = std::move(other.persistent_devices_);
   temporary_devices_ = std::move(other.temporary_devices_);
+  sections_by_property_ = std::move(other.sections_by_property_);
+  section_order_ = std::move(other.section_order_);
+  next_section_order_ = other.next_section_order_;
   return *this;
 }
 
 bool ConfigCache::operator==(const ConfigCache& rhs) const {
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(rhs.mutex_);
+  if (&rhs == this) {
+    return true;
+  }
+  std::shared_lock<std::shared_mutex> my_lock(mutex_, std::defer_lock);
+  std::shared_lock<std::shared_mutex> others_lock(rhs.mutex_, std::defer_lock);
+  std::lock(my_lock, others_lock);
   return persistent_property_names_ == rhs.persistent_property_names_ &&
          information_sections_ == rhs.information_sections_ && persistent_devices_ == rhs.persistent_devices_ &&
          temporary_devices_ == rhs.temporary_devices_;
@@ -107,202 +149,305 @@ bool ConfigCache::operator!=(const ConfigCache& rhs) const {
 }
 
 void ConfigCache::Clear() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   if (information_sections_.size() > 0) {
+    for (const auto& section : information_sections_) {
+      PersistentMutation(MutationEntry::EntryType::REMOVE_SECTION, section.first.Name());
+    }
     information_sections_.clear();
     PersistentConfigChangedCallback();
   }
   if (persistent_devices_.size() > 0) {
+    for (const auto& section : persistent_devices_) {
+      PersistentMutation(MutationEntry::EntryType::REMOVE_SECTION, section.first.Name());
+    }
     persistent_devices_.clear();
     PersistentConfigChangedCallback();
   }
   if (temporary_devices_.size() > 0) {
     temporary_devices_.clear();
   }
+  sections_by_property_.clear();
+  section_order_.clear();
 }
 
-bool ConfigCache::HasSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return information_sections_.contains(section) || persistent_devices_.contains(section) ||
-         temporary_devices_.contains(section);
+const ConfigCache::Properties* ConfigCache::FindSavedSection(SectionKey section) const {
+  // sections are unique among all three maps, device sections are never information sections
+  if (!section.IsDevice()) {
+    auto section_iter = information_sections_.find(section);
+    return section_iter != information_sections_.end() ? &section_iter->second : nullptr;
+  }
+  auto section_iter = persistent_devices_.find(section);
+  return section_iter != persistent_devices_.end() ? &section_iter->second : nullptr;
 }
 
-bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
-  if (section_iter != information_sections_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
-  }
-  section_iter = persistent_devices_.find(section);
-  if (section_iter != persistent_devices_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
+template <typename Visitor>
+auto ConfigCache::VisitSection(SectionKey section, Visitor visitor) const {
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto* properties = FindSavedSection(section);
+    if (properties != nullptr || !section.IsDevice()) {
+      return visitor(properties, properties != nullptr);
+    }
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
+  // LruCache::find() warms up the section, hence the exclusive lock. The section might have become persistent while
+  // no lock was held
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const auto* properties = FindSavedSection(section);
+  if (properties != nullptr) {
+    return visitor(properties, true);
   }
-  return false;
+  auto section_iter = temporary_devices_.find(section);
+  return visitor(section_iter != temporary_devices_.end() ? &section_iter->second : nullptr, false);
 }
 
-std::optional<std::string> ConfigCache::GetProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
-  if (section_iter != information_sections_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
-    }
-  }
-  section_iter = persistent_devices_.find(section);
-  if (section_iter != persistent_devices_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      std::string value = property_iter->second;
-      if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && value == kEncryptedStr) {
-        return os::ParameterProvider::GetBtKeystoreInterface()->get_key(section + "-" + property);
-      }
-      return value;
-    }
+bool ConfigCache::HasSection(std::string_view section) const {
+  auto section_key = SectionKey::Find(section);
+  if (!section_key) {
+    return false;
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
-    }
+  return VisitSection(*section_key, [](const Properties* properties, bool) { return properties != nullptr; });
+}
+
+bool ConfigCache::HasProperty(std::string_view section, std::string_view property) const {
+  auto section_key = SectionKey::Find(section);
+  auto property_key = PropertyKey::Find(property);
+  if (!section_key || !property_key) {
+    return false;
   }
-  return std::nullopt;
+  return VisitSection(*section_key, [&property_key](const Properties* properties, bool) {
+    return properties != nullptr && properties->contains(*property_key);
+  });
 }
 
-void ConfigCache::SetProperty(std::string section, std::string property, std::string value) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+std::optional<std::string> ConfigCache::GetProperty(std::string_view section, std::string_view property) const {
+  auto section_key = SectionKey::Find(section);
+  auto property_key = PropertyKey::Find(property);
+  if (!section_key || !property_key) {
+    return std::nullopt;
+  }
+  bool is_persistent_device = false;
+  auto value = VisitSection(
+      *section_key,
+      [&property_key, &section_key, &is_persistent_device](
+          const Properties* properties, bool is_saved) -> std::optional<std::string> {
+        if (properties == nullptr) {
+          return std::nullopt;
+        }
+        auto property_iter = properties->find(*property_key);
+        if (property_iter == properties->end()) {
+          return std::nullopt;
+        }
+        is_persistent_device = is_saved && section_key->IsDevice();
+        return property_iter->second;
+      });
+  if (value && is_persistent_device && os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
+      *value == kEncryptedStr) {
+    return os::ParameterProvider::GetBtKeystoreInterface()->get_key(KeystoreKey(section, property));
+  }
+  return value;
+}
+
+void ConfigCache::SetProperty(std::string_view section, std::string_view property, std::string value) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  SetPropertyLocked(section, property, std::move(value));
+}
+
+void ConfigCache::SetPropertyLocked(std::string_view section, std::string_view property, std::string value) {
   if (TrimAfterNewLine(section) || TrimAfterNewLine(property) || TrimAfterNewLine(value)) {
     android_errorWriteLog(0x534e4554, "70808273");
   }
   ASSERT_LOG(!section.empty(), "Empty section name not allowed");
   ASSERT_LOG(!property.empty(), "Empty property name not allowed");
-  if (!IsDeviceSection(section)) {
-    auto section_iter = information_sections_.find(section);
+  auto section_key = SectionKey::Intern(section);
+  auto property_key = PropertyKey::Intern(property);
+  if (!section_key.IsDevice()) {
+    auto section_iter = information_sections_.find(section_key);
     if (section_iter == information_sections_.end()) {
-      section_iter = information_sections_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
+      section_iter = information_sections_.try_emplace_back(section_key, Properties{}).first;
+      section_order_[section_key] = next_section_order_++;
     }
-    section_iter->second.insert_or_assign(property, std::move(value));
+    PersistentMutation(MutationEntry::EntryType::SET, section, property, value);
+    section_iter->second.insert_or_assign(property_key, std::move(value));
+    IndexProperty(section_key, property_key);
     PersistentConfigChangedCallback();
     return;
   }
-  auto section_iter = persistent_devices_.find(section);
-  if (section_iter == persistent_devices_.end() && IsPersistentProperty(property)) {
+  auto section_iter = persistent_devices_.find(section_key);
+  if (section_iter == persistent_devices_.end() && persistent_property_keys_.count(property_key) > 0) {
     // move paired devices or create new paired device when a link key is set
-    auto section_properties = temporary_devices_.extract(section);
+    auto section_properties = temporary_devices_.extract(section_key);
     if (section_properties) {
-      section_iter = persistent_devices_.try_emplace_back(section, std::move(section_properties->second)).first;
+      section_iter = persistent_devices_.try_emplace_back(section_key, std::move(section_properties->second)).first;
+      // temporary properties were never saved, they become persistent along with the section
+      for (const auto& moved_property : section_iter->second) {
+        PersistentMutation(MutationEntry::EntryType::SET, section, moved_property.first.Name(), moved_property.second);
+      }
     } else {
-      section_iter = persistent_devices_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
+      section_iter = persistent_devices_.try_emplace_back(section_key, Properties{}).first;
     }
+    section_order_[section_key] = next_section_order_++;
   }
   if (section_iter != persistent_devices_.end()) {
     bool is_encrypted = value == kEncryptedStr;
     if ((!value.empty()) && os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
         os::ParameterProvider::IsCommonCriteriaMode() && InEncryptKeyNameList(property) && !is_encrypted) {
       if (os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
-              section + "-" + property, value)) {
+              KeystoreKey(section, property), value)) {
         value = kEncryptedStr;
       }
     }
-    section_iter->second.insert_or_assign(property, std::move(value));
+    PersistentMutation(MutationEntry::EntryType::SET, section, property, value);
+    section_iter->second.insert_or_assign(property_key, std::move(value));
+    IndexProperty(section_key, property_key);
     PersistentConfigChangedCallback();
     return;
   }
-  section_iter = temporary_devices_.find(section);
+  section_iter = temporary_devices_.find(section_key);
   if (section_iter == temporary_devices_.end()) {
-    auto triple = temporary_devices_.try_emplace(section, common::ListMap<std::string, std::string>{});
+    auto triple = temporary_devices_.try_emplace(section_key, Properties{});
     section_iter = std::get<0>(triple);
+    const auto& evicted_section = std::get<2>(triple);
+    if (evicted_section) {
+      UnindexSection(evicted_section->first, evicted_section->second);
+    }
   }
-  section_iter->second.insert_or_assign(property, std::move(value));
+  section_iter->second.insert_or_assign(property_key, std::move(value));
+  IndexProperty(section_key, property_key);
 }
 
-bool ConfigCache::RemoveSection(const std::string& section) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+bool ConfigCache::RemoveSection(std::string_view section) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemoveSectionLocked(section);
+}
+
+bool ConfigCache::RemoveSectionLocked(std::string_view section) {
+  auto section_key = SectionKey::Find(section);
+  if (!section_key) {
+    return false;
+  }
   // sections are unique among all three maps, hence removing from one of them is enough
-  if (information_sections_.extract(section) || persistent_devices_.extract(section)) {
-    PersistentConfigChangedCallback();
+  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
+    auto section_properties = config_section->extract(*section_key);
+    if (section_properties) {
+      UnindexSection(*section_key, section_properties->second);
+      section_order_.erase(*section_key);
+      PersistentMutation(MutationEntry::EntryType::REMOVE_SECTION, section);
+      PersistentConfigChangedCallback();
+      return true;
+    }
+  }
+  auto section_properties = temporary_devices_.extract(*section_key);
+  if (section_properties) {
+    UnindexSection(*section_key, section_properties->second);
     return true;
-  } else {
-    return temporary_devices_.extract(section).has_value();
   }
+  return false;
+}
+
+bool ConfigCache::RemoveProperty(std::string_view section, std::string_view property) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemovePropertyLocked(section, property);
 }
 
-bool ConfigCache::RemoveProperty(const std::string& section, const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
+bool ConfigCache::RemovePropertyLocked(std::string_view section, std::string_view property) {
+  auto section_key = SectionKey::Find(section);
+  auto property_key = PropertyKey::Find(property);
+  if (!section_key || !property_key) {
+    return false;
+  }
+  auto section_iter = information_sections_.find(*section_key);
   if (section_iter != information_sections_.end()) {
-    auto value = section_iter->second.extract(property);
+    auto value = section_iter->second.extract(*property_key);
     // if section is empty after removal, remove the whole section as empty section is not allowed
     if (section_iter->second.size() == 0) {
       information_sections_.erase(section_iter);
+      section_order_.erase(*section_key);
     }
     if (value.has_value()) {
+      UnindexProperty(*section_key, *property_key);
+      PersistentMutation(MutationEntry::EntryType::REMOVE_PROPERTY, section, property);
       PersistentConfigChangedCallback();
       return true;
     } else {
       return false;
     }
   }
-  section_iter = persistent_devices_.find(section);
+  section_iter = persistent_devices_.find(*section_key);
   if (section_iter != persistent_devices_.end()) {
-    auto value = section_iter->second.extract(property);
+    auto value = section_iter->second.extract(*property_key);
     // if section is empty after removal, remove the whole section as empty section is not allowed
     if (section_iter->second.size() == 0) {
       persistent_devices_.erase(section_iter);
-    } else if (value && IsPersistentProperty(property)) {
+      section_order_.erase(*section_key);
+    } else if (value && persistent_property_keys_.count(*property_key) > 0) {
       // move unpaired device
-      auto section_properties = persistent_devices_.extract(section);
-      temporary_devices_.insert_or_assign(section, std::move(section_properties->second));
+      auto section_properties = persistent_devices_.extract(*section_key);
+      section_order_.erase(*section_key);
+      auto evicted_section = temporary_devices_.insert_or_assign(*section_key, std::move(section_properties->second));
+      if (evicted_section) {
+        UnindexSection(evicted_section->first, evicted_section->second);
+      }
     }
     if (value.has_value()) {
+      UnindexProperty(*section_key, *property_key);
+      PersistentMutation(MutationEntry::EntryType::REMOVE_PROPERTY, section, property);
       PersistentConfigChangedCallback();
       if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && os::ParameterProvider::IsCommonCriteriaMode() &&
           InEncryptKeyNameList(property)) {
-        os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(section + "-" + property, "");
+        os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
+            KeystoreKey(section, property), "");
       }
       return true;
     } else {
       return false;
     }
   }
-  section_iter = temporary_devices_.find(section);
+  section_iter = temporary_devices_.find(*section_key);
   if (section_iter != temporary_devices_.end()) {
-    auto value = section_iter->second.extract(property);
+    auto value = section_iter->second.extract(*property_key);
     if (section_iter->second.size() == 0) {
       temporary_devices_.erase(section_iter);
     }
-    return value.has_value();
+    if (value.has_value()) {
+      UnindexProperty(*section_key, *property_key);
+      return true;
+    }
   }
   return false;
 }
 
 void ConfigCache::ConvertEncryptOrDecryptKeyIfNeeded() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   LOG_INFO("%s", __func__);
-  auto persistent_sections = GetPersistentSections();
-  for (const auto& section : persistent_sections) {
-    auto section_iter = persistent_devices_.find(section);
+  std::vector<SectionKey> persistent_sections;
+  persistent_sections.reserve(persistent_devices_.size());
+  for (const auto& elem : persistent_devices_) {
+    persistent_sections.push_back(elem.first);
+  }
+  for (const auto& section_key : persistent_sections) {
+    auto section_iter = persistent_devices_.find(section_key);
+    auto section = section_key.Name();
     for (const auto& property : kEncryptKeyNameList) {
-      auto property_iter = section_iter->second.find(std::string(property));
+      auto property_key = PropertyKey::Find(property);
+      if (!property_key) {
+        continue;
+      }
+      auto property_iter = section_iter->second.find(*property_key);
       if (property_iter != section_iter->second.end()) {
         bool is_encrypted = property_iter->second == kEncryptedStr;
         if ((!property_iter->second.empty()) && os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
             os::ParameterProvider::IsCommonCriteriaMode() && !is_encrypted) {
           if (os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
-                  section + "-" + std::string(property), property_iter->second)) {
-            SetProperty(section, std::string(property), kEncryptedStr);
+                  KeystoreKey(section, property), property_iter->second)) {
+            SetPropertyLocked(section, property, kEncryptedStr);
           }
         }
         if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && is_encrypted) {
           std::string value_str =
-              os::ParameterProvider::GetBtKeystoreInterface()->get_key(section + "-" + std::string(property));
+              os::ParameterProvider::GetBtKeystoreInterface()->get_key(KeystoreKey(section, property));
           if (!os::ParameterProvider::IsCommonCriteriaMode()) {
-            SetProperty(section, std::string(property), value_str);
+            SetPropertyLocked(section, property, value_str);
           }
         }
       }
@@ -314,31 +459,45 @@ bool ConfigCache::IsDeviceSection(const std::string& section) {
   return hci::Address::IsValidAddress(section);
 }
 
-bool ConfigCache::IsPersistentProperty(const std::string& property) const {
+bool ConfigCache::IsPersistentProperty(std::string_view property) const {
   return persistent_property_names_.find(property) != persistent_property_names_.end();
 }
 
-void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+void ConfigCache::RemoveSectionWithProperty(std::string_view property) {
+  auto property_key = PropertyKey::Find(property);
+  if (!property_key) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto index_iter = sections_by_property_.find(*property_key);
+  if (index_iter == sections_by_property_.end()) {
+    return;
+  }
+  // removing the sections below updates the index
+  auto sections = index_iter->second;
   size_t num_persistent_removed = 0;
-  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (auto it = config_section->begin(); it != config_section->end();) {
-      if (it->second.contains(property)) {
-        LOG_INFO("Removing persistent section %s with property %s", it->first.c_str(), property.c_str());
-        it = config_section->erase(it);
-        num_persistent_removed++;
-        continue;
+  for (const auto& section_key : sections) {
+    auto section = section_key.Name();
+    std::optional<std::pair<SectionKey, Properties>> section_properties;
+    for (auto* config_section : {&information_sections_, &persistent_devices_}) {
+      section_properties = config_section->extract(section_key);
+      if (section_properties) {
+        break;
       }
-      it++;
     }
-  }
-  for (auto it = temporary_devices_.begin(); it != temporary_devices_.end();) {
-    if (it->second.contains(property)) {
-      LOG_INFO("Removing temporary section %s with property %s", it->first.c_str(), property.c_str());
-      it = temporary_devices_.erase(it);
-      continue;
+    if (section_properties) {
+      LOG_INFO("Removing persistent section %s with property %s", section.c_str(), std::string(property).c_str());
+      PersistentMutation(MutationEntry::EntryType::REMOVE_SECTION, section);
+      section_order_.erase(section_key);
+      num_persistent_removed++;
+    } else {
+      section_properties = temporary_devices_.extract(section_key);
+      if (!section_properties) {
+        continue;
+      }
+      LOG_INFO("Removing temporary section %s with property %s", section.c_str(), std::string(property).c_str());
     }
-    it++;
+    UnindexSection(section_key, section_properties->second);
   }
   if (num_persistent_removed > 0) {
     PersistentConfigChangedCallback();
@@ -346,29 +505,29 @@ void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
 }
 
 std::vector<std::string> ConfigCache::GetPersistentSections() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::vector<std::string> paired_devices;
   paired_devices.reserve(persistent_devices_.size());
   for (const auto& elem : persistent_devices_) {
-    paired_devices.emplace_back(elem.first);
+    paired_devices.emplace_back(elem.first.Name());
   }
   return paired_devices;
 }
 
 void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   while (!mutation_entries.empty()) {
     auto entry = std::move(mutation_entries.front());
     mutation_entries.pop();
     switch (entry.entry_type) {
       case MutationEntry::EntryType::SET:
-        SetProperty(std::move(entry.section), std::move(entry.property), std::move(entry.value));
+        SetPropertyLocked(entry.section, entry.property, std::move(entry.value));
         break;
       case MutationEntry::EntryType::REMOVE_PROPERTY:
-        RemoveProperty(entry.section, entry.property);
+        RemovePropertyLocked(entry.section, entry.property);
         break;
       case MutationEntry::EntryType::REMOVE_SECTION:
-        RemoveSection(entry.section);
+        RemoveSectionLocked(entry.section);
         break;
         // do not write a default case so that when a new enum is defined, compilation would fail automatically
     }
@@ -376,51 +535,94 @@ void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
 }
 
 std::string ConfigCache::SerializeToLegacyFormat() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  std::stringstream serialized;
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::string serialized;
   for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (const auto& section : *config_section) {
-      serialized << "[" << section.first << "]" << std::endl;
+      serialized.push_back('[');
+      section.first.AppendName(serialized);
+      serialized.append("]\n");
       for (const auto& property : section.second) {
-        serialized << property.first << " = " << property.second << std::endl;
+        serialized.append(property.first.Name()).append(" = ").append(property.second).push_back('\n');
       }
-      serialized << std::endl;
+      serialized.push_back('\n');
     }
   }
-  return serialized.str();
+  return serialized;
 }
 
 std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWithProperty(
-    const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string_view property) const {
   std::vector<SectionAndPropertyValue> result;
-  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (const auto& elem : *config_section) {
-      auto it = elem.second.find(property);
+  auto property_key = PropertyKey::Find(property);
+  if (!property_key) {
+    return result;
+  }
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto index_iter = sections_by_property_.find(*property_key);
+  if (index_iter == sections_by_property_.end()) {
+    return result;
+  }
+  // (is persistent device, order added, value) of information and persistent sections
+  std::vector<std::tuple<bool, uint64_t, SectionKey, const std::string*>> saved_sections;
+  bool has_temporary_section = false;
+  for (const auto& section_key : index_iter->second) {
+    const auto* properties = FindSavedSection(section_key);
+    if (properties == nullptr) {
+      has_temporary_section = true;
+      continue;
+    }
+    saved_sections.emplace_back(
+        section_key.IsDevice(), section_order_.at(section_key), section_key, &properties->find(*property_key)->second);
+  }
+  std::sort(saved_sections.begin(), saved_sections.end(), [](const auto& lhs, const auto& rhs) {
+    return std::tie(std::get<0>(lhs), std::get<1>(lhs)) < std::tie(std::get<0>(rhs), std::get<1>(rhs));
+  });
+  result.reserve(index_iter->second.size());
+  for (const auto& elem : saved_sections) {
+    result.emplace_back(SectionAndPropertyValue{.section = std::get<2>(elem).Name(), .property = *std::get<3>(elem)});
+  }
+  // iterating does not warm up temporary sections
+  if (has_temporary_section) {
+    for (const auto& elem : temporary_devices_) {
+      auto it = elem.second.find(*property_key);
       if (it != elem.second.end()) {
-        result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = it->second});
-        continue;
+        result.emplace_back(SectionAndPropertyValue{.section = elem.first.Name(), .property = it->second});
       }
     }
   }
-  for (const auto& elem : temporary_devices_) {
-    auto it = elem.second.find(property);
-    if (it != elem.second.end()) {
-      result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = it->second});
-      continue;
-    }
-  }
   return result;
 }
 
+void ConfigCache::IndexProperty(SectionKey section, PropertyKey property) {
+  sections_by_property_[property].insert(section);
+}
+
+void ConfigCache::UnindexProperty(SectionKey section, PropertyKey property) {
+  auto index_iter = sections_by_property_.find(property);
+  if (index_iter == sections_by_property_.end()) {
+    return;
+  }
+  index_iter->second.erase(section);
+  if (index_iter->second.empty()) {
+    sections_by_property_.erase(index_iter);
+  }
+}
+
+void ConfigCache::UnindexSection(SectionKey section, const Properties& properties) {
+  for (const auto& property : properties) {
+    UnindexProperty(section, property.first);
+  }
+}
+
 namespace {
 
 bool FixDeviceTypeInconsistencyInSection(
-    const std::string& section_name, common::ListMap<std::string, std::string>& device_section_entries) {
-  if (!hci::Address::IsValidAddress(section_name)) {
+    SectionKey section, common::ListMap<PropertyKey, std::string>& device_section_entries, PropertyKey dev_type) {
+  if (!section.IsDevice()) {
     return false;
   }
-  auto device_type_iter = device_section_entries.find("DevType");
+  auto device_type_iter = device_section_entries.find(dev_type);
   if (device_type_iter != device_section_entries.end() &&
       device_type_iter->second == std::to_string(hci::DeviceType::DUAL)) {
     // We might only have one of classic/LE keys for a dual device, but it is still a dual device,
@@ -435,10 +637,11 @@ bool FixDeviceTypeInconsistencyInSection(
   // default
   hci::DeviceType device_type = hci::DeviceType::BR_EDR;
   for (const auto& entry : device_section_entries) {
-    if (kLePropertyNames.find(entry.first) != kLePropertyNames.end()) {
+    auto name = entry.first.Name();
+    if (kLePropertyNames.find(name) != kLePropertyNames.end()) {
       is_le = true;
     }
-    if (kClassicPropertyNames.find(entry.first) != kClassicPropertyNames.end()) {
+    if (kClassicPropertyNames.find(name) != kClassicPropertyNames.end()) {
       is_classic = true;
     }
   }
@@ -457,7 +660,7 @@ bool FixDeviceTypeInconsistencyInSection(
       device_type_iter->second = std::move(device_type_str);
     }
   } else {
-    device_section_entries.insert_or_assign("DevType", std::move(device_type_str));
+    device_section_entries.insert_or_assign(dev_type, std::move(device_type_str));
   }
   return inconsistent;
 }
@@ -465,18 +668,23 @@ bool FixDeviceTypeInconsistencyInSection(
 }  // namespace
 
 bool ConfigCache::FixDeviceTypeInconsistencies() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  auto dev_type = PropertyKey::Intern("DevType");
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   bool persistent_device_changed = false;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (auto& elem : *config_section) {
-      if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
+      if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second, dev_type)) {
+        IndexProperty(elem.first, dev_type);
+        PersistentMutation(
+            MutationEntry::EntryType::SET, elem.first.Name(), dev_type.Name(), elem.second.find(dev_type)->second);
         persistent_device_changed = true;
       }
     }
   }
   bool temp_device_changed = false;
   for (auto& elem : temporary_devices_) {
-    if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
+    if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second, dev_type)) {
+      IndexProperty(elem.first, dev_type);
       temp_device_changed = true;
     }
   }
@@ -487,37 +695,32 @@ bool ConfigCache::FixDeviceTypeInconsistencies() {
 }
 
 bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
-    const std::string& section, const std::unordered_set<std::string_view>& property_names) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  const common::ListMap<std::string, std::string>* section_ptr;
-  if (!IsDeviceSection(section)) {
-    auto section_iter = information_sections_.find(section);
-    if (section_iter == information_sections_.end()) {
+    std::string_view section, const std::unordered_set<std::string_view>& property_names) const {
+  auto section_key = SectionKey::Find(section);
+  if (!section_key) {
+    return false;
+  }
+  return VisitSection(*section_key, [&property_names](const Properties* properties, bool) {
+    if (properties == nullptr) {
       return false;
     }
-    section_ptr = &section_iter->second;
-  } else {
-    auto section_iter = persistent_devices_.find(section);
-    if (section_iter == persistent_devices_.end()) {
-      section_iter = temporary_devices_.find(section);
-      if (section_iter == temporary_devices_.end()) {
-        return false;
+    for (const auto& property : *properties) {
+      if (property_names.count(property.first.Name()) > 0) {
+        return true;
       }
     }
-    section_ptr = &section_iter->second;
-  }
-  for (const auto& property : *section_ptr) {
-    if (property_names.count(property.first) > 0) {
-      return true;
-    }
-  }
-  return false;
+    return false;
+  });
 }
 
-bool ConfigCache::IsPersistentSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return persistent_devices_.contains(section);
+bool ConfigCache::IsPersistentSection(std::string_view section) const {
+  auto section_key = SectionKey::Find(section);
+  if (!section_key) {
+    return false;
+  }
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return persistent_devices_.contains(*section_key);
 }
 
 }  // namespace storage
-}  // namespace bluetooth
\ No newline at end of file
+}  // namespace bluetooth
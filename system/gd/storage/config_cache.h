@@ -20,8 +20,10 @@
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -30,6 +32,7 @@
 #include "common/lru_cache.h"
 #include "hci/address.h"
 #include "os/utils.h"
+#include "storage/config_key.h"
 #include "storage/mutation_entry.h"
 
 namespace bluetooth {
@@ -48,7 +51,10 @@ class Mutation;
 // The definition of persistent sections is up to the user and is defined through the |persistent_property_names|
 // argument. When these properties are link key properties, then persistent sections is equal to bonded devices
 //
-// This class is thread safe
+// Section and property names are stored as interned keys, see storage/config_key.h
+//
+// This class is thread safe. Reading information and persistent sections takes a shared lock; reading a temporary
+// section takes an exclusive lock as it warms up the section in the LRU cache
 class ConfigCache {
  public:
   ConfigCache(size_t temp_device_capacity, std::unordered_set<std::string_view> persistent_property_names);
@@ -69,19 +75,19 @@ class ConfigCache {
   bool operator!=(const ConfigCache& rhs) const;
 
   // observers
-  virtual bool HasSection(const std::string& section) const;
-  virtual bool HasProperty(const std::string& section, const std::string& property) const;
+  virtual bool HasSection(std::string_view section) const;
+  virtual bool HasProperty(std::string_view section, std::string_view property) const;
   // Get property, return std::nullopt if section or property does not exist
-  virtual std::optional<std::string> GetProperty(const std::string& section, const std::string& property) const;
+  virtual std::optional<std::string> GetProperty(std::string_view section, std::string_view property) const;
   // Returns a copy of persistent device MAC addresses
   virtual std::vector<std::string> GetPersistentSections() const;
   // Return true if a section is persistent
-  virtual bool IsPersistentSection(const std::string& section) const;
+  virtual bool IsPersistentSection(std::string_view section) const;
   // Return true if a section has one of the properties in |property_names|
   virtual bool HasAtLeastOneMatchingPropertiesInSection(
-      const std::string& section, const std::unordered_set<std::string_view>& property_names) const;
+      std::string_view section, const std::unordered_set<std::string_view>& property_names) const;
   // Return true if a property is part of persistent_property_names_
-  virtual bool IsPersistentProperty(const std::string& property) const;
+  virtual bool IsPersistentProperty(std::string_view property) const;
   // Serialize to legacy config format
   virtual std::string SerializeToLegacyFormat() const;
   // Return a copy of pair<section_name, property_value> with property
@@ -95,22 +101,32 @@ class ConfigCache {
       return !(*this == rhs);
     }
   };
-  virtual std::vector<SectionAndPropertyValue> GetSectionNamesWithProperty(const std::string& property) const;
+  // Information and persistent sections come first in the order they were added, followed by temporary sections
+  virtual std::vector<SectionAndPropertyValue> GetSectionNamesWithProperty(std::string_view property) const;
 
   // modifiers
   // Commit all mutation entries in sequence while holding the config mutex
   virtual void Commit(std::queue<MutationEntry>& mutation);
-  virtual void SetProperty(std::string section, std::string property, std::string value);
-  virtual bool RemoveSection(const std::string& section);
-  virtual bool RemoveProperty(const std::string& section, const std::string& property);
+  virtual void SetProperty(std::string_view section, std::string_view property, std::string value);
+  virtual bool RemoveSection(std::string_view section);
+  virtual bool RemoveProperty(std::string_view section, std::string_view property);
   virtual void ConvertEncryptOrDecryptKeyIfNeeded();
   // TODO: have a systematic way of doing this instead of specialized methods
   // Remove sections with |property| set
-  virtual void RemoveSectionWithProperty(const std::string& property);
+  virtual void RemoveSectionWithProperty(std::string_view property);
   // remove all content in this config cache, restore it to the state after the explicit constructor
   virtual void Clear();
   // Set a callback to notify interested party that a persistent config change has just happened
   virtual void SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback);
+  // Describes one persistent change as the SetProperty(), RemoveProperty() or RemoveSection() call that redoes it
+  using PersistentMutationCallback = std::function<void(
+      MutationEntry::EntryType entry_type,
+      std::string_view section,
+      std::string_view property,
+      std::string_view value)>;
+  // Set a callback that receives every persistent change while the config mutex is held, in the order they happen.
+  // Redoing these changes in order on top of the last saved persistent content reproduces the current one
+  virtual void SetPersistentMutationCallback(PersistentMutationCallback persistent_mutation_callback);
 
   // Device config specific methods
   // TODO: methods here should be moved to a device specific config cache if this config cache is supposed to be generic
@@ -125,19 +141,45 @@ class ConfigCache {
   static const std::string kDefaultSectionName;
 
  private:
-  mutable std::recursive_mutex mutex_;
+  using Properties = common::ListMap<PropertyKey, std::string>;
+
+  mutable std::shared_mutex mutex_;
   // A callback to notify interested party that a persistent config change has just happened, empty by default
   std::function<void()> persistent_config_changed_callback_;
+  // A callback to describe each persistent change, empty by default
+  PersistentMutationCallback persistent_mutation_callback_;
   // A set of property names that if set would make a section persistent and if non of these properties are set, a
   // section would become temporary again
   std::unordered_set<std::string_view> persistent_property_names_;
+  // Interned persistent_property_names_
+  std::unordered_set<PropertyKey> persistent_property_keys_;
   // Common section that does not relate to remote device, will be written to disk
-  common::ListMap<std::string, common::ListMap<std::string, std::string>> information_sections_;
+  common::ListMap<SectionKey, Properties> information_sections_;
   // Information about persistent devices, normally paired, will be written to disk
-  common::ListMap<std::string, common::ListMap<std::string, std::string>> persistent_devices_;
+  common::ListMap<SectionKey, Properties> persistent_devices_;
   // Information about temporary devices, normally unpaired, will not be written to disk, will be evicted automatically
   // if capacity exceeds given value during initialization
-  common::LruCache<std::string, common::ListMap<std::string, std::string>> temporary_devices_;
+  common::LruCache<SectionKey, Properties> temporary_devices_;
+  // Secondary index of all sections above that have a given property
+  std::unordered_map<PropertyKey, std::unordered_set<SectionKey>> sections_by_property_;
+  // Order in which information and persistent sections were added, used to list indexed sections in config order
+  std::unordered_map<SectionKey, uint64_t> section_order_;
+  uint64_t next_section_order_ = 0;
+
+  // Call |visitor| with the properties of |section|, or nullptr if it does not exist, and whether it is persistent.
+  // Information and persistent sections are visited under a shared lock, temporary sections under an exclusive lock
+  template <typename Visitor>
+  auto VisitSection(SectionKey section, Visitor visitor) const;
+  // Return the properties of an information or persistent section, nullptr otherwise. Expects mutex_ to be held
+  const Properties* FindSavedSection(SectionKey section) const;
+
+  // The following methods expect mutex_ to be held exclusively
+  void SetPropertyLocked(std::string_view section, std::string_view property, std::string value);
+  bool RemoveSectionLocked(std::string_view section);
+  bool RemovePropertyLocked(std::string_view section, std::string_view property);
+  void IndexProperty(SectionKey section, PropertyKey property);
+  void UnindexProperty(SectionKey section, PropertyKey property);
+  void UnindexSection(SectionKey section, const Properties& properties);
 
   // Convenience method to check if the callback is valid before calling it
   inline void PersistentConfigChangedCallback() const {
@@ -145,6 +187,17 @@ class ConfigCache {
       persistent_config_changed_callback_();
     }
   }
+
+  // Convenience method to check if the callback is valid before calling it
+  inline void PersistentMutation(
+      MutationEntry::EntryType entry_type,
+      std::string_view section,
+      std::string_view property = {},
+      std::string_view value = {}) const {
+    if (persistent_mutation_callback_) {
+      persistent_mutation_callback_(entry_type, section, property, value);
+    }
+  }
 };
 
 }  // namespace storage
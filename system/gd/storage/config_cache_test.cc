@@ -413,4 +413,53 @@ TEST(ConfigCacheTest, test_empty_persistent_properties) {
   ASSERT_THAT(config.GetPersistentSections(), ElementsAre());
 }
 
-}  // namespace testing
\ No newline at end of file
+TEST(ConfigCacheTest, test_get_section_with_property_follows_changes) {
+  ConfigCache config(2, Device::kLinkKeyProperties);
+  config.SetProperty("AA:BB:CC:DD:EE:01", "LinkKey", "AABBAABBCCDDEE");
+  config.SetProperty("AA:BB:CC:DD:EE:01", "B", "1");
+  config.SetProperty("A", "B", "2");
+  config.SetProperty("AA:BB:CC:DD:EE:02", "B", "3");
+  config.SetProperty("aa:bb:cc:dd:ee:03", "B", "4");
+  config.SetProperty("aa:bb:cc:dd:ee:03", "LinkKey", "AABBAABBCCDDEE");
+  ASSERT_THAT(
+      config.GetSectionNamesWithProperty("B"),
+      ElementsAre(
+          SectionAndPropertyValue{.section = "A", .property = "2"},
+          SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:01", .property = "1"},
+          SectionAndPropertyValue{.section = "aa:bb:cc:dd:ee:03", .property = "4"},
+          SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:02", .property = "3"}));
+  // unpaired device becomes temporary, the oldest temporary device is evicted
+  config.RemoveProperty("AA:BB:CC:DD:EE:01", "LinkKey");
+  config.SetProperty("AA:BB:CC:DD:EE:04", "C", "5");
+  config.RemoveProperty("A", "B");
+  ASSERT_THAT(
+      config.GetSectionNamesWithProperty("B"),
+      ElementsAre(
+          SectionAndPropertyValue{.section = "aa:bb:cc:dd:ee:03", .property = "4"},
+          SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:01", .property = "1"}));
+  config.RemoveSectionWithProperty("B");
+  ASSERT_THAT(config.GetSectionNamesWithProperty("B"), ElementsAre());
+  ASSERT_THAT(
+      config.GetSectionNamesWithProperty("C"),
+      ElementsAre(SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:04", .property = "5"}));
+  ASSERT_THAT(config.GetSectionNamesWithProperty("never_set"), ElementsAre());
+}
+
+TEST(ConfigCacheTest, section_names_serialize_as_written_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  config.SetProperty("01:02:03:ab:cd:ea", "LinkKey", "1");
+  config.SetProperty("01:02:03:AB:CD:EA", "LinkKey", "2");
+  config.SetProperty("01:02:03:Ab:cD:eA", "LinkKey", "3");
+  ASSERT_TRUE(config.IsPersistentSection("01:02:03:Ab:cD:eA"));
+  ASSERT_FALSE(config.HasSection("01:02:03:ab:cd:eb"));
+  ASSERT_THAT(config.GetProperty("01:02:03:AB:CD:EA", "LinkKey"), Optional(StrEq("2")));
+  ASSERT_EQ(
+      config.SerializeToLegacyFormat(),
+      "[Adapter]\nAddress = 01:02:03:ab:cd:ef\n\n"
+      "[01:02:03:ab:cd:ea]\nLinkKey = 1\n\n"
+      "[01:02:03:AB:CD:EA]\nLinkKey = 2\n\n"
+      "[01:02:03:Ab:cD:eA]\nLinkKey = 3\n\n");
+}
+
+}  // namespace testing
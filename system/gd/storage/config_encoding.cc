@@ -0,0 +1,110 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_encoding.h"
+
+#include <array>
+
+namespace {
+
+// Slice-by-8 tables: kCrc32Tables[0] is the usual byte table and kCrc32Tables[n][byte] is the CRC of |byte| followed
+// by n zero bytes, so that 8 bytes are folded in with 8 independent lookups
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Crc32Tables MakeCrc32Tables() {
+  Crc32Tables tables = {};
+  for (uint32_t byte = 0; byte < 256; byte++) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+    }
+    tables[0][byte] = crc;
+  }
+  for (uint32_t byte = 0; byte < 256; byte++) {
+    for (size_t slice = 1; slice < tables.size(); slice++) {
+      uint32_t previous = tables[slice - 1][byte];
+      tables[slice][byte] = (previous >> 8) ^ tables[0][previous & 0xff];
+    }
+  }
+  return tables;
+}
+
+constexpr Crc32Tables kCrc32Tables = MakeCrc32Tables();
+
+}  // namespace
+
+namespace bluetooth {
+namespace storage {
+
+uint32_t ConfigCrc32(const char* data, size_t size) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  uint32_t crc = 0xffffffff;
+  for (; size >= 8; size -= 8, bytes += 8) {
+    uint32_t low = crc ^ (bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24));
+    crc = kCrc32Tables[7][low & 0xff] ^ kCrc32Tables[6][(low >> 8) & 0xff] ^ kCrc32Tables[5][(low >> 16) & 0xff] ^
+          kCrc32Tables[4][low >> 24] ^ kCrc32Tables[3][bytes[4]] ^ kCrc32Tables[2][bytes[5]] ^
+          kCrc32Tables[1][bytes[6]] ^ kCrc32Tables[0][bytes[7]];
+  }
+  for (; size > 0; size--, bytes++) {
+    crc = (crc >> 8) ^ kCrc32Tables[0][(crc ^ *bytes) & 0xff];
+  }
+  return ~crc;
+}
+
+void PutUint32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void PutUint64(std::string& out, uint64_t value) {
+  PutUint32(out, static_cast<uint32_t>(value));
+  PutUint32(out, static_cast<uint32_t>(value >> 32));
+}
+
+uint32_t GetUint32(const char* data) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+uint64_t GetUint64(const char* data) {
+  return GetUint32(data) | (static_cast<uint64_t>(GetUint32(data + 4)) << 32);
+}
+
+void PutString(std::string& out, std::string_view value) {
+  PutUint32(out, value.size());
+  out.append(value);
+}
+
+std::optional<std::string_view> GetString(std::string_view data, size_t& offset) {
+  if (data.size() - offset < 4) {
+    return std::nullopt;
+  }
+  uint32_t size = GetUint32(data.data() + offset);
+  offset += 4;
+  if (data.size() - offset < size) {
+    return std::nullopt;
+  }
+  auto value = data.substr(offset, size);
+  offset += size;
+  return value;
+}
+
+}  // namespace storage
+}  // namespace bluetooth
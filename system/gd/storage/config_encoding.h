@@ -0,0 +1,43 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace bluetooth {
+namespace storage {
+
+// Little endian binary encoding shared by the config journal and the config snapshot
+
+// CRC-32 (IEEE 802.3) of |size| bytes at |data|
+uint32_t ConfigCrc32(const char* data, size_t size);
+
+void PutUint32(std::string& out, uint32_t value);
+void PutUint64(std::string& out, uint64_t value);
+uint32_t GetUint32(const char* data);
+uint64_t GetUint64(const char* data);
+
+// A string is encoded as its uint32_t size followed by its bytes
+void PutString(std::string& out, std::string_view value);
+// Decode the string at |offset| in |data| and move |offset| past it, std::nullopt if |data| is too short
+std::optional<std::string_view> GetString(std::string_view data, size_t& offset);
+
+}  // namespace storage
+}  // namespace bluetooth
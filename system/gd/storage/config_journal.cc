@@ -0,0 +1,252 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "os/files.h"
+#include "os/log.h"
+#include "storage/config_encoding.h"
+
+namespace {
+
+using bluetooth::storage::ConfigCrc32;
+using bluetooth::storage::GetString;
+using bluetooth::storage::GetUint32;
+using bluetooth::storage::MutationEntry;
+using bluetooth::storage::PutString;
+using bluetooth::storage::PutUint32;
+
+// A record is framed as
+//   uint32_t payload size | uint32_t CRC-32 of the payload | payload
+// where the payload is
+//   uint8_t entry type | uint32_t size + bytes for each of section, property and value
+// and all integers are little endian
+constexpr size_t kRecordHeaderSize = 8;
+
+// Apply one record payload to |cache|, return false if it does not decode
+bool ApplyPayload(std::string_view payload, bluetooth::storage::ConfigCache* cache) {
+  if (payload.empty()) {
+    return false;
+  }
+  auto entry_type = static_cast<MutationEntry::EntryType>(payload[0]);
+  size_t offset = 1;
+  auto section = GetString(payload, offset);
+  auto property = GetString(payload, offset);
+  auto value = GetString(payload, offset);
+  if (!section || !property || !value || offset != payload.size() || section->empty()) {
+    return false;
+  }
+  switch (entry_type) {
+    case MutationEntry::EntryType::SET:
+      if (property->empty()) {
+        return false;
+      }
+      cache->SetProperty(*section, *property, std::string(*value));
+      return true;
+    case MutationEntry::EntryType::REMOVE_PROPERTY:
+      if (property->empty()) {
+        return false;
+      }
+      cache->RemoveProperty(*section, *property);
+      return true;
+    case MutationEntry::EntryType::REMOVE_SECTION:
+      cache->RemoveSection(*section);
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+namespace bluetooth {
+namespace storage {
+
+ConfigJournal::ConfigJournal(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+}
+
+ConfigJournal::~ConfigJournal() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Close();
+}
+
+size_t ConfigJournal::Replay(ConfigCache* cache) {
+  ASSERT(cache != nullptr);
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_ = 0;
+  if (!os::FileExists(path_)) {
+    return 0;
+  }
+  auto journal = os::ReadSmallFile(path_);
+  if (!journal) {
+    return 0;
+  }
+  size_t num_records = 0;
+  size_t offset = 0;
+  while (journal->size() - offset >= kRecordHeaderSize) {
+    uint32_t payload_size = GetUint32(journal->data() + offset);
+    uint32_t crc = GetUint32(journal->data() + offset + 4);
+    if (journal->size() - offset - kRecordHeaderSize < payload_size) {
+      break;
+    }
+    auto payload = std::string_view(*journal).substr(offset + kRecordHeaderSize, payload_size);
+    if (ConfigCrc32(payload.data(), payload.size()) != crc || !ApplyPayload(payload, cache)) {
+      break;
+    }
+    offset += kRecordHeaderSize + payload_size;
+    num_records++;
+  }
+  if (offset != journal->size()) {
+    LOG_WARN(
+        "dropping %zu bytes of torn or corrupted records at the end of '%s'", journal->size() - offset, path_.c_str());
+  }
+  size_ = offset;
+  return num_records;
+}
+
+bool ConfigJournal::Open() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Close();
+  fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd_ < 0) {
+    LOG_ERROR("unable to open file '%s', error: %s", path_.c_str(), strerror(errno));
+    size_ = 0;
+    return false;
+  }
+  // Anything after the intact records would hide the records appended from now on
+  if (ftruncate(fd_, size_) != 0) {
+    LOG_ERROR("unable to truncate file '%s', error: %s", path_.c_str(), strerror(errno));
+    Close();
+    size_ = 0;
+    return false;
+  }
+  return true;
+}
+
+void ConfigJournal::Append(
+    MutationEntry::EntryType entry_type,
+    std::string_view section,
+    std::string_view property,
+    std::string_view value) {
+  std::string payload;
+  payload.reserve(1 + 12 + section.size() + property.size() + value.size());
+  payload.push_back(static_cast<char>(entry_type));
+  PutString(payload, section);
+  PutString(payload, property);
+  PutString(payload, value);
+  std::lock_guard<std::mutex> lock(mutex_);
+  PutUint32(pending_, payload.size());
+  PutUint32(pending_, ConfigCrc32(payload.data(), payload.size()));
+  pending_.append(payload);
+}
+
+bool ConfigJournal::Sync() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pending_.empty()) {
+    return true;
+  }
+  if (fd_ < 0) {
+    return false;
+  }
+  size_t written = 0;
+  while (written < pending_.size()) {
+    ssize_t result = write(fd_, pending_.data() + written, pending_.size() - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      LOG_ERROR("unable to write to file '%s', error: %s", path_.c_str(), strerror(errno));
+      // Do not leave a partial record behind, later records would not be replayed
+      if (ftruncate(fd_, size_) != 0) {
+        LOG_ERROR("unable to truncate file '%s', error: %s", path_.c_str(), strerror(errno));
+        Close();
+      }
+      return false;
+    }
+    written += result;
+  }
+  if (fdatasync(fd_) != 0) {
+    LOG_WARN("unable to fdatasync file '%s', error: %s", path_.c_str(), strerror(errno));
+    // Allow fdatasync to fail and continue, same as os::WriteToFile()
+  }
+  size_ += pending_.size();
+  pending_.clear();
+  return true;
+}
+
+size_t ConfigJournal::PendingSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_.size();
+}
+
+bool ConfigJournal::Reset(size_t pending_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(pending_size <= pending_.size());
+  pending_.erase(0, pending_size);
+  if (fd_ < 0) {
+    return false;
+  }
+  if (ftruncate(fd_, 0) != 0) {
+    LOG_ERROR("unable to truncate file '%s', error: %s", path_.c_str(), strerror(errno));
+    return false;
+  }
+  if (fdatasync(fd_) != 0) {
+    LOG_WARN("unable to fdatasync file '%s', error: %s", path_.c_str(), strerror(errno));
+  }
+  size_ = 0;
+  return true;
+}
+
+size_t ConfigJournal::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+bool ConfigJournal::Delete() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Close();
+  size_ = 0;
+  pending_.clear();
+  if (!os::FileExists(path_)) {
+    LOG_WARN("Config journal at \"%s\" does not exist", path_.c_str());
+    return false;
+  }
+  return os::RemoveFile(path_);
+}
+
+void ConfigJournal::Close() {
+  if (fd_ < 0) {
+    return;
+  }
+  if (close(fd_) != 0) {
+    LOG_ERROR("unable to close file '%s', error: %s", path_.c_str(), strerror(errno));
+  }
+  fd_ = -1;
+}
+
+}  // namespace storage
+}  // namespace bluetooth
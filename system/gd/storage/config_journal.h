@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "storage/config_cache.h"
+#include "storage/mutation_entry.h"
+
+namespace bluetooth {
+namespace storage {
+
+// Append-only log of the persistent changes made since the legacy config file was last written in full
+//
+// Each change is one record that is checksummed on its own, so that a record torn by a crash or power loss is detected
+// and dropped together with everything after it. Records are queued in memory by Append() and reach the disk in a
+// single write() and fdatasync() per Sync(), which is a few dozen bytes per change instead of the whole config.
+//
+// Once the config file has been written in full, Reset() starts a new journal. Replaying a journal on top of a config
+// file that already holds its changes is harmless as every record sets or removes a value, hence a crash between the
+// two steps does not lose nor corrupt anything.
+//
+// This class is thread safe
+class ConfigJournal {
+ public:
+  explicit ConfigJournal(std::string path);
+  ConfigJournal(const ConfigJournal&) = delete;
+  ConfigJournal& operator=(const ConfigJournal&) = delete;
+  ~ConfigJournal();
+
+  // Apply every intact record on disk to |cache| in order and return the number of records applied. Reading stops at
+  // the first torn or corrupted record
+  size_t Replay(ConfigCache* cache);
+  // Open the journal for appending, keeping only the intact records found by the last Replay(), or none if Replay()
+  // was not called. Return true on success
+  bool Open();
+  // Queue a change in memory, matches ConfigCache::PersistentMutationCallback
+  void Append(
+      MutationEntry::EntryType entry_type,
+      std::string_view section,
+      std::string_view property,
+      std::string_view value);
+  // Write all queued records to disk and wait for them to be synced. Records stay queued on failure
+  // Return true on success
+  bool Sync();
+  // Number of queued bytes, to be passed to Reset() once the config file has been written in full
+  size_t PendingSize() const;
+  // Empty the journal on disk and forget the first |pending_size| queued bytes, as the config file written after
+  // PendingSize() returned |pending_size| already holds those changes. Return true on success
+  bool Reset(size_t pending_size);
+  // Size of the journal on disk in bytes
+  size_t Size() const;
+  // Close and delete the journal file, return true on success
+  bool Delete();
+
+ private:
+  void Close();
+
+  std::string path_;
+  mutable std::mutex mutex_;
+  int fd_ = -1;
+  // Bytes on disk made of intact records
+  size_t size_ = 0;
+  // Encoded records waiting for Sync()
+  std::string pending_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
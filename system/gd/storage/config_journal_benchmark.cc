@@ -0,0 +1,182 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of persisting one config change with 1000 bonded devices, and of loading that config at startup. The
+// bytes_per_change counter over the size of the changed "property = value" line is the write amplification.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "storage/config_cache.h"
+#include "storage/config_journal.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace storage {
+namespace {
+
+constexpr size_t kNumDevices = 1000;
+// Same limit as StorageModule
+constexpr size_t kConfigJournalCompactionSize = 64 * 1024;
+// Size of the line a change updates in the config file
+constexpr size_t kChangedLineSize = sizeof("Timestamp = 1640995200\n") - 1;
+
+std::string DeviceSection(size_t index) {
+  char address[18];
+  std::snprintf(
+      address, sizeof(address), "aa:bb:cc:%02zx:%02zx:%02zx", (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+  return address;
+}
+
+// A dual mode device bonded over both transports, as written by the legacy stack
+ConfigCache MakeConfig() {
+  ConfigCache config(kNumDevices, Device::kLinkKeyProperties);
+  config.SetProperty("Info", "FileSource", "Empty");
+  config.SetProperty("Info", "TimeCreated", "2022-01-01 00:00:00");
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  config.SetProperty("Adapter", "LE_LOCAL_KEY_IRK", "fedcba0987654321fedcba0987654321");
+  config.SetProperty("Adapter", "ScanMode", "2");
+  for (size_t i = 0; i < kNumDevices; i++) {
+    auto section = DeviceSection(i);
+    config.SetProperty(section, "Name", "Device " + std::to_string(i));
+    config.SetProperty(section, "DevClass", "2360344");
+    config.SetProperty(section, "DevType", "3");
+    config.SetProperty(section, "AddrType", "0");
+    config.SetProperty(section, "Timestamp", "1640995200");
+    config.SetProperty(
+        section,
+        "Service",
+        "0000110b-0000-1000-8000-00805f9b34fb 0000110e-0000-1000-8000-00805f9b34fb "
+        "0000111e-0000-1000-8000-00805f9b34fb 00001800-0000-1000-8000-00805f9b34fb");
+    config.SetProperty(section, "LinkKeyType", "8");
+    config.SetProperty(section, "PinLength", "0");
+    config.SetProperty(section, "LinkKey", "fedcba0987654321fedcba0987654328");
+    config.SetProperty(section, "LE_KEY_PENC", "00112233445566778899aabbccddeeff0011223344556677889900");
+    config.SetProperty(section, "LE_KEY_PID", "00112233445566778899aabbccddeeff00aabbccddeeff00");
+  }
+  return config;
+}
+
+class ConfigFiles {
+ public:
+  ConfigFiles() {
+    auto temp_dir = std::filesystem::temp_directory_path();
+    config_ = (temp_dir / "bt_config_benchmark.conf").string();
+    backup_ = (temp_dir / "bt_config_benchmark.bak").string();
+    journal_ = (temp_dir / "bt_config_benchmark.journal").string();
+  }
+  ~ConfigFiles() {
+    for (const auto* path : {&config_, &backup_, &journal_}) {
+      std::filesystem::remove(*path);
+    }
+  }
+  std::string config_;
+  std::string backup_;
+  std::string journal_;
+};
+
+// What StorageModule::SaveImmediately() writes
+size_t SaveInFull(const ConfigFiles& files, const ConfigCache& config) {
+  LegacyConfigFile::FromPath(files.config_).Write(config);
+  LegacyConfigFile::FromPath(files.backup_).Write(config);
+  return 2 * std::filesystem::file_size(files.config_);
+}
+
+std::string ChangedValue(size_t iteration) {
+  return std::to_string(1640995200 + iteration);
+}
+
+void SetCounters(State& state, size_t bytes_written, size_t num_changes) {
+  state.counters["bytes_per_change"] = Counter(static_cast<double>(bytes_written) / num_changes);
+  state.counters["write_amplification"] = Counter(static_cast<double>(bytes_written) / num_changes / kChangedLineSize);
+}
+
+// Every change rewrites the config and its backup, as before the journal
+void BM_ConfigSaveInFull(State& state) {
+  ConfigFiles files;
+  auto config = MakeConfig();
+  size_t bytes_written = 0;
+  size_t num_changes = 0;
+  for (auto _ : state) {
+    config.SetProperty(DeviceSection(num_changes % kNumDevices), "Timestamp", ChangedValue(num_changes));
+    bytes_written += SaveInFull(files, config);
+    num_changes++;
+  }
+  SetCounters(state, bytes_written, num_changes);
+}
+BENCHMARK(BM_ConfigSaveInFull)->Unit(benchmark::kMicrosecond);
+
+// Every change is synced to the journal, which is compacted into the config once it outgrows its limit
+void BM_ConfigJournalAppend(State& state) {
+  ConfigFiles files;
+  auto config = MakeConfig();
+  SaveInFull(files, config);
+  ConfigJournal journal(files.journal_);
+  journal.Open();
+  config.SetPersistentMutationCallback(
+      [&journal](
+          MutationEntry::EntryType entry_type,
+          std::string_view section,
+          std::string_view property,
+          std::string_view value) { journal.Append(entry_type, section, property, value); });
+  size_t bytes_written = 0;
+  size_t num_changes = 0;
+  for (auto _ : state) {
+    config.SetProperty(DeviceSection(num_changes % kNumDevices), "Timestamp", ChangedValue(num_changes));
+    size_t size_before = journal.Size();
+    journal.Sync();
+    bytes_written += journal.Size() - size_before;
+    if (journal.Size() > kConfigJournalCompactionSize) {
+      bytes_written += SaveInFull(files, config);
+      journal.Reset(journal.PendingSize());
+    }
+    num_changes++;
+  }
+  SetCounters(state, bytes_written, num_changes);
+}
+BENCHMARK(BM_ConfigJournalAppend)->Unit(benchmark::kMicrosecond);
+
+// Load the config at startup and redo |state.range(0)| journaled changes on top of it
+void BM_ConfigStartupLoad(State& state) {
+  ConfigFiles files;
+  auto config = MakeConfig();
+  SaveInFull(files, config);
+  {
+    ConfigJournal journal(files.journal_);
+    journal.Open();
+    for (int64_t i = 0; i < state.range(0); i++) {
+      journal.Append(MutationEntry::EntryType::SET, DeviceSection(i % kNumDevices), "Timestamp", ChangedValue(i));
+    }
+    journal.Sync();
+  }
+  for (auto _ : state) {
+    auto loaded = LegacyConfigFile::FromPath(files.config_).Read(kNumDevices);
+    ConfigJournal journal(files.journal_);
+    benchmark::DoNotOptimize(journal.Replay(&loaded.value()));
+  }
+  state.counters["journal_bytes"] = Counter(std::filesystem::file_size(files.journal_));
+}
+BENCHMARK(BM_ConfigStartupLoad)->Arg(0)->Arg(100)->Arg(1000)->Arg(2000)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace storage
+}  // namespace bluetooth
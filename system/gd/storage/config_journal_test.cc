@@ -0,0 +1,242 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "os/files.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+namespace testing {
+
+using bluetooth::os::ReadSmallFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
+using bluetooth::storage::Device;
+using bluetooth::storage::LegacyConfigFile;
+using bluetooth::storage::MutationEntry;
+
+class ConfigJournalTest : public Test {
+ protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path();
+    temp_config_ = temp_dir_ / "temp_config.txt";
+    temp_journal_ = temp_dir_ / "temp_config.journal";
+    DeleteFiles();
+  }
+
+  void TearDown() override {
+    DeleteFiles();
+  }
+
+  void DeleteFiles() {
+    for (const auto& path : {temp_config_, temp_journal_}) {
+      if (std::filesystem::exists(path)) {
+        ASSERT_TRUE(std::filesystem::remove(path));
+      }
+    }
+  }
+
+  // Journal every persistent change of |config| into |journal|
+  static void Attach(ConfigCache& config, ConfigJournal& journal) {
+    config.SetPersistentMutationCallback(
+        [&journal](
+            MutationEntry::EntryType entry_type,
+            std::string_view section,
+            std::string_view property,
+            std::string_view value) { journal.Append(entry_type, section, property, value); });
+  }
+
+  // Load the config file and redo the journal on top of it, as StorageModule::Start() does
+  std::optional<ConfigCache> Recover(size_t* num_replayed = nullptr) {
+    auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(100);
+    if (!config) {
+      return std::nullopt;
+    }
+    size_t replayed = ConfigJournal(temp_journal_.string()).Replay(&config.value());
+    if (num_replayed != nullptr) {
+      *num_replayed = replayed;
+    }
+    return config;
+  }
+
+  std::filesystem::path temp_dir_;
+  std::filesystem::path temp_config_;
+  std::filesystem::path temp_journal_;
+};
+
+TEST_F(ConfigJournalTest, replay_reproduces_persistent_config_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  config.SetProperty("01:02:03:ab:cd:ea", "name", "hello world");
+  config.SetProperty("01:02:03:ab:cd:ea", "LinkKey", "fedcba0987654321fedcba0987654328");
+  config.SetProperty("01:02:03:ab:cd:eb", "LinkKey", "fedcba0987654321fedcba0987654329");
+  ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(config));
+
+  ConfigJournal journal(temp_journal_.string());
+  ASSERT_TRUE(journal.Open());
+  Attach(config, journal);
+  // information section
+  config.SetProperty("Adapter", "ScanMode", "2");
+  config.SetProperty("Adapter", "Name", "");
+  config.RemoveProperty("Adapter", "Address");
+  // a temporary device whose properties were never saved becomes persistent
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "name", "foo");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "DevType", "1");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "AABBAABBCCDDEE");
+  // a persistent device becomes temporary
+  config.RemoveProperty("01:02:03:ab:cd:ea", "LinkKey");
+  // a persistent device is removed
+  config.SetProperty("01:02:03:ab:cd:eb", "Restricted", "1");
+  config.RemoveSectionWithProperty("Restricted");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  config.RemoveSection("CC:DD:EE:FF:00:11");
+  // temporary devices are not journaled
+  config.SetProperty("CC:DD:EE:FF:00:22", "name", "bar");
+  ASSERT_TRUE(journal.Sync());
+  ASSERT_EQ(journal.PendingSize(), 0u);
+  ASSERT_EQ(journal.Size(), std::filesystem::file_size(temp_journal_));
+
+  auto recovered = Recover();
+  ASSERT_TRUE(recovered);
+  ASSERT_EQ(recovered->SerializeToLegacyFormat(), config.SerializeToLegacyFormat());
+  ASSERT_THAT(recovered->GetPersistentSections(), ElementsAre("AA:BB:CC:DD:EE:FF"));
+  ASSERT_THAT(recovered->GetProperty("AA:BB:CC:DD:EE:FF", "name"), Optional(StrEq("foo")));
+  ASSERT_THAT(recovered->GetProperty("Adapter", "Name"), Optional(StrEq("")));
+  ASSERT_FALSE(recovered->HasSection("CC:DD:EE:FF:00:22"));
+}
+
+TEST_F(ConfigJournalTest, replay_twice_is_harmless_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  ConfigJournal journal(temp_journal_.string());
+  ASSERT_TRUE(journal.Open());
+  Attach(config, journal);
+  config.SetProperty("01:02:03:ab:cd:ea", "LinkKey", "fedcba0987654321fedcba0987654328");
+  config.RemoveSection("01:02:03:ab:cd:ea");
+  config.SetProperty("01:02:03:ab:cd:ea", "name", "hello world");
+  config.SetProperty("01:02:03:ab:cd:ea", "LinkKey", "fedcba0987654321fedcba0987654329");
+  ASSERT_TRUE(journal.Sync());
+  // Crash after writing the config file in full but before the journal is reset
+  ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(config));
+
+  size_t num_replayed = 0;
+  auto recovered = Recover(&num_replayed);
+  ASSERT_TRUE(recovered);
+  ASSERT_EQ(num_replayed, 4u);
+  ASSERT_EQ(recovered->SerializeToLegacyFormat(), config.SerializeToLegacyFormat());
+}
+
+TEST_F(ConfigJournalTest, torn_record_is_dropped_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(config));
+  {
+    ConfigJournal journal(temp_journal_.string());
+    ASSERT_TRUE(journal.Open());
+    journal.Append(MutationEntry::EntryType::SET, "Adapter", "ScanMode", "2");
+    journal.Append(MutationEntry::EntryType::SET, "Adapter", "DiscoveryTimeout", "120");
+    ASSERT_TRUE(journal.Sync());
+  }
+  // Power loss in the middle of the second record
+  std::filesystem::resize_file(temp_journal_, std::filesystem::file_size(temp_journal_) - 3);
+
+  size_t num_replayed = 0;
+  auto recovered = Recover(&num_replayed);
+  ASSERT_TRUE(recovered);
+  ASSERT_EQ(num_replayed, 1u);
+  ASSERT_THAT(recovered->GetProperty("Adapter", "ScanMode"), Optional(StrEq("2")));
+  ASSERT_FALSE(recovered->HasProperty("Adapter", "DiscoveryTimeout"));
+
+  // Records appended after recovery must not be hidden behind the torn one
+  {
+    ConfigJournal journal(temp_journal_.string());
+    ASSERT_EQ(journal.Replay(&recovered.value()), 1u);
+    ASSERT_TRUE(journal.Open());
+    journal.Append(MutationEntry::EntryType::SET, "Adapter", "Name", "foo");
+    ASSERT_TRUE(journal.Sync());
+  }
+  recovered = Recover(&num_replayed);
+  ASSERT_TRUE(recovered);
+  ASSERT_EQ(num_replayed, 2u);
+  ASSERT_THAT(recovered->GetProperty("Adapter", "Name"), Optional(StrEq("foo")));
+}
+
+TEST_F(ConfigJournalTest, corrupted_record_stops_replay_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(config));
+  {
+    ConfigJournal journal(temp_journal_.string());
+    ASSERT_TRUE(journal.Open());
+    journal.Append(MutationEntry::EntryType::SET, "Adapter", "ScanMode", "2");
+    ASSERT_TRUE(journal.Sync());
+    journal.Append(MutationEntry::EntryType::SET, "Adapter", "DiscoveryTimeout", "120");
+    journal.Append(MutationEntry::EntryType::REMOVE_SECTION, "Adapter", "", "");
+    ASSERT_TRUE(journal.Sync());
+  }
+  auto journal_bytes = ReadSmallFile(temp_journal_.string());
+  ASSERT_TRUE(journal_bytes);
+  journal_bytes->back() ^= 0x01;
+  std::ofstream(temp_journal_, std::ios::binary | std::ios::trunc) << *journal_bytes;
+
+  size_t num_replayed = 0;
+  auto recovered = Recover(&num_replayed);
+  ASSERT_TRUE(recovered);
+  ASSERT_EQ(num_replayed, 2u);
+  ASSERT_THAT(recovered->GetProperty("Adapter", "DiscoveryTimeout"), Optional(StrEq("120")));
+}
+
+TEST_F(ConfigJournalTest, reset_keeps_changes_queued_later_test) {
+  ConfigJournal journal(temp_journal_.string());
+  ASSERT_TRUE(journal.Open());
+  journal.Append(MutationEntry::EntryType::SET, "Adapter", "ScanMode", "2");
+  ASSERT_TRUE(journal.Sync());
+  journal.Append(MutationEntry::EntryType::SET, "Adapter", "ScanMode", "3");
+  size_t written_in_full = journal.PendingSize();
+  journal.Append(MutationEntry::EntryType::SET, "Adapter", "Name", "foo");
+  ASSERT_TRUE(journal.Reset(written_in_full));
+  ASSERT_EQ(journal.Size(), 0u);
+  ASSERT_EQ(std::filesystem::file_size(temp_journal_), 0u);
+  ASSERT_TRUE(journal.Sync());
+
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ASSERT_EQ(ConfigJournal(temp_journal_.string()).Replay(&config), 1u);
+  ASSERT_FALSE(config.HasProperty("Adapter", "ScanMode"));
+  ASSERT_THAT(config.GetProperty("Adapter", "Name"), Optional(StrEq("foo")));
+}
+
+TEST_F(ConfigJournalTest, open_without_replay_discards_records_test) {
+  {
+    ConfigJournal journal(temp_journal_.string());
+    ASSERT_TRUE(journal.Open());
+    journal.Append(MutationEntry::EntryType::SET, "Adapter", "ScanMode", "2");
+    ASSERT_TRUE(journal.Sync());
+  }
+  ConfigJournal journal(temp_journal_.string());
+  ASSERT_TRUE(journal.Open());
+  ASSERT_EQ(std::filesystem::file_size(temp_journal_), 0u);
+  ASSERT_TRUE(journal.Delete());
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+}
+
+}  // namespace testing
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_key.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "hci/address.h"
+#include "os/log.h"
+
+namespace {
+
+struct NameEntry {
+  std::string name;
+  size_t hash;
+  uint32_t index;
+  bool is_address;
+};
+
+// Open addressing hash table of the interned names, at most half full so that every probe ends on an empty slot.
+// Entries are only ever added: a slot goes from nullptr to its entry once, hence readers need no lock
+struct NameTableSnapshot {
+  explicit NameTableSnapshot(size_t capacity)
+      : capacity(capacity),
+        slots(new std::atomic<const NameEntry*>[capacity]),
+        entries(new std::atomic<const NameEntry*>[capacity / 2]) {
+    for (size_t i = 0; i < capacity; i++) {
+      slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < capacity / 2; i++) {
+      entries[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // Only called with the NameTable mutex held
+  void Insert(const NameEntry* entry) {
+    entries[entry->index].store(entry, std::memory_order_release);
+    size_t mask = capacity - 1;
+    size_t slot = entry->hash & mask;
+    while (slots[slot].load(std::memory_order_relaxed) != nullptr) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot].store(entry, std::memory_order_release);
+  }
+
+  const NameEntry* Find(std::string_view name, size_t hash) const {
+    size_t mask = capacity - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+      auto* entry = slots[slot].load(std::memory_order_acquire);
+      if (entry == nullptr) {
+        return nullptr;
+      }
+      if (entry->hash == hash && entry->name == name) {
+        return entry;
+      }
+    }
+  }
+
+  const size_t capacity;
+  std::unique_ptr<std::atomic<const NameEntry*>[]> slots;
+  // Entries by index
+  std::unique_ptr<std::atomic<const NameEntry*>[]> entries;
+};
+
+// Adding a name takes |mutex|. When the snapshot is half full, a copy twice as large replaces it. Snapshots and entries
+// are never freed, since a reader may still be probing an older snapshot; the superseded ones add up to less than the
+// current one.
+struct NameTable {
+  static constexpr size_t kInitialCapacity = 256;
+
+  std::mutex mutex;
+  std::atomic<NameTableSnapshot*> snapshot{new NameTableSnapshot(kInitialCapacity)};
+  // Guarded by |mutex|
+  uint32_t size = 0;
+};
+
+NameTable& GetNameTable() {
+  static auto* table = new NameTable();
+  return *table;
+}
+
+const NameEntry& GetEntry(uint32_t index) {
+  auto* snapshot = GetNameTable().snapshot.load(std::memory_order_acquire);
+  ASSERT(index < snapshot->capacity / 2);
+  auto* entry = snapshot->entries[index].load(std::memory_order_acquire);
+  ASSERT(entry != nullptr);
+  return *entry;
+}
+
+size_t HashName(std::string_view name) {
+  return std::hash<std::string_view>{}(name);
+}
+
+int HexDigitValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+// "xx:xx:xx:xx:xx:xx"
+constexpr size_t kAddressStringLength = 17;
+
+}  // namespace
+
+namespace bluetooth {
+namespace storage {
+
+uint32_t ConfigNameTable::Intern(std::string_view name) {
+  auto index = Find(name);
+  if (index) {
+    return *index;
+  }
+  auto& table = GetNameTable();
+  size_t hash = HashName(name);
+  std::lock_guard<std::mutex> lock(table.mutex);
+  auto* snapshot = table.snapshot.load(std::memory_order_relaxed);
+  auto* entry = snapshot->Find(name, hash);
+  if (entry != nullptr) {
+    return entry->index;
+  }
+  ASSERT(table.size < UINT32_MAX);
+  if (table.size + 1 > snapshot->capacity / 2) {
+    auto* larger = new NameTableSnapshot(snapshot->capacity * 2);
+    for (uint32_t i = 0; i < table.size; i++) {
+      larger->Insert(snapshot->entries[i].load(std::memory_order_relaxed));
+    }
+    table.snapshot.store(larger, std::memory_order_release);
+    snapshot = larger;
+  }
+  // Upper case and other spellings that hci::Address accepts are still device sections, see SectionKey::IsDevice()
+  bool is_address = name.size() == kAddressStringLength && hci::Address::IsValidAddress(std::string(name));
+  uint32_t new_index = table.size++;
+  snapshot->Insert(new NameEntry{std::string(name), hash, new_index, is_address});
+  return new_index;
+}
+
+std::optional<uint32_t> ConfigNameTable::Find(std::string_view name) {
+  auto* snapshot = GetNameTable().snapshot.load(std::memory_order_acquire);
+  auto* entry = snapshot->Find(name, HashName(name));
+  if (entry == nullptr) {
+    return std::nullopt;
+  }
+  return entry->index;
+}
+
+std::string_view ConfigNameTable::Name(uint32_t index) {
+  return GetEntry(index).name;
+}
+
+bool ConfigNameTable::IsAddress(uint32_t index) {
+  return GetEntry(index).is_address;
+}
+
+SectionKey SectionKey::Intern(std::string_view name) {
+  auto key = FromCanonicalAddress(name);
+  if (key) {
+    return *key;
+  }
+  return FromIndex(ConfigNameTable::Intern(name));
+}
+
+std::optional<SectionKey> SectionKey::Find(std::string_view name) {
+  auto key = FromCanonicalAddress(name);
+  if (key) {
+    return key;
+  }
+  auto index = ConfigNameTable::Find(name);
+  if (!index) {
+    return std::nullopt;
+  }
+  return FromIndex(*index);
+}
+
+std::string SectionKey::Name() const {
+  std::string name;
+  AppendName(name);
+  return name;
+}
+
+void SectionKey::AppendName(std::string& out) const {
+  if (value_ & kInternedFlag) {
+    out.append(ConfigNameTable::Name(static_cast<uint32_t>(value_)));
+    return;
+  }
+  // Most significant byte first, same as hci::Address::ToString()
+  for (int shift = 40; shift >= 0; shift -= 8) {
+    uint8_t byte = (value_ >> shift) & 0xff;
+    out.push_back(kHexDigits[byte >> 4]);
+    out.push_back(kHexDigits[byte & 0xf]);
+    if (shift != 0) {
+      out.push_back(':');
+    }
+  }
+}
+
+std::optional<SectionKey> SectionKey::FromCanonicalAddress(std::string_view name) {
+  if (name.size() != kAddressStringLength) {
+    return std::nullopt;
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < kAddressStringLength; i += 3) {
+    int high = HexDigitValue(name[i]);
+    int low = HexDigitValue(name[i + 1]);
+    if (high < 0 || low < 0 || (i + 2 < kAddressStringLength && name[i + 2] != ':')) {
+      return std::nullopt;
+    }
+    value = (value << 8) | (high << 4) | low;
+  }
+  return SectionKey(value);
+}
+
+SectionKey SectionKey::FromIndex(uint32_t index) {
+  uint64_t value = kInternedFlag | index;
+  if (ConfigNameTable::IsAddress(index)) {
+    value |= kInternedDeviceFlag;
+  }
+  return SectionKey(value);
+}
+
+}  // namespace storage
+}  // namespace bluetooth
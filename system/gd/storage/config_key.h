@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace bluetooth {
+namespace storage {
+
+// Config section and property names are interned: every distinct name is stored once for the life of the process in a
+// table shared by all config caches and is referred to by its index. Finding the key of a name never allocates, and
+// keys compare and hash as integers.
+//
+// This class is thread safe. Only adding a name takes a lock, looking names and indexes up is lock free.
+class ConfigNameTable {
+ public:
+  // Return the index of |name|, adding it to the table if it is new
+  static uint32_t Intern(std::string_view name);
+  // Return the index of |name| if it was interned before, std::nullopt otherwise
+  static std::optional<uint32_t> Find(std::string_view name);
+  // Return the name at |index|, valid for the life of the process
+  static std::string_view Name(uint32_t index);
+  // Return true if the name at |index| is accepted by hci::Address::IsValidAddress(), computed once when interned
+  static bool IsAddress(uint32_t index);
+};
+
+// Interned property name
+class PropertyKey {
+ public:
+  static PropertyKey Intern(std::string_view name) {
+    return PropertyKey(ConfigNameTable::Intern(name));
+  }
+  static std::optional<PropertyKey> Find(std::string_view name) {
+    auto index = ConfigNameTable::Find(name);
+    if (!index) {
+      return std::nullopt;
+    }
+    return PropertyKey(*index);
+  }
+
+  std::string_view Name() const {
+    return ConfigNameTable::Name(index_);
+  }
+  uint32_t Value() const {
+    return index_;
+  }
+
+  bool operator==(const PropertyKey& rhs) const {
+    return index_ == rhs.index_;
+  }
+  bool operator!=(const PropertyKey& rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  explicit PropertyKey(uint32_t index) : index_(index) {}
+  uint32_t index_;
+};
+
+// Section name. A device section spelled the way hci::Address::ToString() does, e.g. "01:02:03:ab:cd:ef", is keyed by
+// its 48 bit address. Any other name is interned so that it serializes back byte for byte.
+class SectionKey {
+ public:
+  static SectionKey Intern(std::string_view name);
+  static std::optional<SectionKey> Find(std::string_view name);
+
+  std::string Name() const;
+  // Append Name() to |out| without a temporary string
+  void AppendName(std::string& out) const;
+  // True if the name is a valid MAC address, see ConfigCache::IsDeviceSection()
+  bool IsDevice() const {
+    return (value_ & kInternedFlag) == 0 || (value_ & kInternedDeviceFlag) != 0;
+  }
+  uint64_t Value() const {
+    return value_;
+  }
+
+  bool operator==(const SectionKey& rhs) const {
+    return value_ == rhs.value_;
+  }
+  bool operator!=(const SectionKey& rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  static constexpr uint64_t kInternedFlag = uint64_t{1} << 63;
+  static constexpr uint64_t kInternedDeviceFlag = uint64_t{1} << 62;
+
+  explicit SectionKey(uint64_t value) : value_(value) {}
+  static std::optional<SectionKey> FromCanonicalAddress(std::string_view name);
+  static SectionKey FromIndex(uint32_t index);
+
+  uint64_t value_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
+
+namespace std {
+
+template <>
+struct hash<bluetooth::storage::PropertyKey> {
+  size_t operator()(const bluetooth::storage::PropertyKey& key) const {
+    return std::hash<uint32_t>{}(key.Value());
+  }
+};
+
+template <>
+struct hash<bluetooth::storage::SectionKey> {
+  size_t operator()(const bluetooth::storage::SectionKey& key) const {
+    return std::hash<uint64_t>{}(key.Value());
+  }
+};
+
+}  // namespace std
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_key.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace testing {
+
+using bluetooth::storage::PropertyKey;
+using bluetooth::storage::SectionKey;
+
+TEST(ConfigKeyTest, property_key_test) {
+  ASSERT_FALSE(PropertyKey::Find("ConfigKeyTestProperty"));
+  auto key = PropertyKey::Intern("ConfigKeyTestProperty");
+  ASSERT_EQ(PropertyKey::Intern("ConfigKeyTestProperty"), key);
+  ASSERT_EQ(PropertyKey::Find("ConfigKeyTestProperty"), key);
+  ASSERT_NE(PropertyKey::Intern("configkeytestproperty"), key);
+  ASSERT_EQ(key.Name(), "ConfigKeyTestProperty");
+}
+
+TEST(ConfigKeyTest, canonical_address_section_key_test) {
+  // addresses spelled as hci::Address::ToString() does are never interned
+  auto key = SectionKey::Find("01:23:45:67:89:ab");
+  ASSERT_TRUE(key);
+  ASSERT_EQ(key->Value(), 0x0123456789abu);
+  ASSERT_TRUE(key->IsDevice());
+  ASSERT_EQ(key->Name(), "01:23:45:67:89:ab");
+  ASSERT_EQ(SectionKey::Intern("01:23:45:67:89:ab"), *key);
+}
+
+TEST(ConfigKeyTest, other_section_key_test) {
+  ASSERT_FALSE(SectionKey::Find("01:23:45:67:89:AB"));
+  auto upper_case = SectionKey::Intern("01:23:45:67:89:AB");
+  ASSERT_TRUE(upper_case.IsDevice());
+  ASSERT_EQ(upper_case.Name(), "01:23:45:67:89:AB");
+  ASSERT_NE(upper_case, SectionKey::Intern("01:23:45:67:89:ab"));
+
+  auto adapter = SectionKey::Intern("ConfigKeyTestSection");
+  ASSERT_FALSE(adapter.IsDevice());
+  ASSERT_EQ(adapter.Name(), "ConfigKeyTestSection");
+  ASSERT_FALSE(SectionKey::Intern("01:23:45:67:89:a").IsDevice());
+  ASSERT_FALSE(SectionKey::Intern("01-23-45-67-89-ab").IsDevice());
+}
+
+TEST(ConfigKeyTest, name_table_grows_while_being_read_test) {
+  auto first = PropertyKey::Intern("ConfigKeyTestGrowth");
+  std::thread writer([] {
+    for (int i = 0; i < 2000; i++) {
+      auto name = "ConfigKeyTestGrowth" + std::to_string(i);
+      ASSERT_EQ(PropertyKey::Intern(name).Name(), name);
+    }
+  });
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_EQ(PropertyKey::Find("ConfigKeyTestGrowth"), first);
+    ASSERT_EQ(first.Name(), "ConfigKeyTestGrowth");
+  }
+  writer.join();
+  for (int i = 0; i < 2000; i++) {
+    auto name = "ConfigKeyTestGrowth" + std::to_string(i);
+    auto key = PropertyKey::Find(name);
+    ASSERT_TRUE(key);
+    ASSERT_EQ(key->Name(), name);
+  }
+}
+
+}  // namespace testing
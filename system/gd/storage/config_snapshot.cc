@@ -0,0 +1,273 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string_view>
+#include <utility>
+
+#include "os/files.h"
+#include "os/log.h"
+#include "storage/config_encoding.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+namespace {
+
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigCrc32;
+using bluetooth::storage::GetString;
+using bluetooth::storage::GetUint32;
+using bluetooth::storage::GetUint64;
+using bluetooth::storage::PutString;
+using bluetooth::storage::PutUint32;
+using bluetooth::storage::PutUint64;
+
+// A snapshot is
+//   uint32_t magic | uint32_t version | uint64_t config file size | uint64_t config file modification time in ns |
+//   uint64_t config file inode | uint32_t payload size | uint32_t CRC-32 of the payload | payload
+// where the payload is, for each section in config file order
+//   uint32_t size + bytes of the section name | uint32_t number of properties |
+//   uint32_t size + bytes for each of property name and value, for each property
+// and all integers are little endian
+constexpr uint32_t kSnapshotMagic = 0x53435442;  // "BTCS"
+// Bump on any change to the layout above, snapshots of other versions are ignored
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr size_t kSnapshotHeaderSize = 40;
+
+// Identifies one version of the config file, os::WriteToFile() replaces the file by renaming a new one over it
+struct ConfigFileId {
+  uint64_t size;
+  uint64_t modification_time_ns;
+  uint64_t inode;
+
+  bool operator==(const ConfigFileId& rhs) const {
+    return size == rhs.size && modification_time_ns == rhs.modification_time_ns && inode == rhs.inode;
+  }
+  bool operator!=(const ConfigFileId& rhs) const {
+    return !(*this == rhs);
+  }
+};
+
+std::optional<ConfigFileId> GetConfigFileId(const std::string& path) {
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0) {
+    return std::nullopt;
+  }
+  return ConfigFileId{
+      .size = static_cast<uint64_t>(file_stat.st_size),
+      .modification_time_ns = static_cast<uint64_t>(file_stat.st_mtim.tv_sec) * 1000000000 +
+                              static_cast<uint64_t>(file_stat.st_mtim.tv_nsec),
+      .inode = static_cast<uint64_t>(file_stat.st_ino),
+  };
+}
+
+// Load |payload| into a new config cache, std::nullopt if it does not decode
+std::optional<ConfigCache> DecodePayload(std::string_view payload, size_t temp_devices_capacity) {
+  ConfigCache cache(temp_devices_capacity, bluetooth::storage::Device::kLinkKeyProperties);
+  size_t offset = 0;
+  while (offset < payload.size()) {
+    auto section = GetString(payload, offset);
+    if (!section || section->empty() || payload.size() - offset < 4) {
+      return std::nullopt;
+    }
+    uint32_t num_properties = GetUint32(payload.data() + offset);
+    offset += 4;
+    for (uint32_t i = 0; i < num_properties; i++) {
+      auto property = GetString(payload, offset);
+      auto value = GetString(payload, offset);
+      if (!property || !value || property->empty()) {
+        return std::nullopt;
+      }
+      cache.SetProperty(*section, *property, std::string(*value));
+    }
+  }
+  return cache;
+}
+
+bool WriteFully(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace bluetooth {
+namespace storage {
+
+ConfigSnapshot::ConfigSnapshot(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+}
+
+std::optional<ConfigCache> ConfigSnapshot::Read(const std::string& config_file_path, size_t temp_devices_capacity)
+    const {
+  auto config_file_id = GetConfigFileId(config_file_path);
+  if (!config_file_id) {
+    return std::nullopt;
+  }
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      LOG_WARN("unable to open file '%s', error: %s", path_.c_str(), strerror(errno));
+    }
+    return std::nullopt;
+  }
+  struct stat snapshot_stat;
+  if (fstat(fd, &snapshot_stat) != 0 || static_cast<size_t>(snapshot_stat.st_size) < kSnapshotHeaderSize) {
+    close(fd);
+    return std::nullopt;
+  }
+  size_t snapshot_size = snapshot_stat.st_size;
+  void* mapped = mmap(nullptr, snapshot_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    LOG_WARN("unable to map file '%s', error: %s", path_.c_str(), strerror(errno));
+    return std::nullopt;
+  }
+  std::string_view snapshot(static_cast<const char*>(mapped), snapshot_size);
+  std::optional<ConfigCache> config;
+  ConfigFileId snapshot_file_id = {
+      .size = GetUint64(snapshot.data() + 8),
+      .modification_time_ns = GetUint64(snapshot.data() + 16),
+      .inode = GetUint64(snapshot.data() + 24),
+  };
+  uint32_t payload_size = GetUint32(snapshot.data() + 32);
+  uint32_t crc = GetUint32(snapshot.data() + 36);
+  auto payload = snapshot.substr(kSnapshotHeaderSize);
+  if (GetUint32(snapshot.data()) != kSnapshotMagic || GetUint32(snapshot.data() + 4) != kSnapshotVersion) {
+    LOG_INFO("ignoring '%s' of another format", path_.c_str());
+  } else if (snapshot_file_id != *config_file_id) {
+    LOG_INFO("ignoring '%s' as '%s' changed since", path_.c_str(), config_file_path.c_str());
+  } else if (payload_size != payload.size() || ConfigCrc32(payload.data(), payload.size()) != crc) {
+    LOG_WARN("ignoring corrupted '%s'", path_.c_str());
+  } else {
+    config = DecodePayload(payload, temp_devices_capacity);
+    if (!config) {
+      LOG_WARN("ignoring '%s' that does not decode", path_.c_str());
+    }
+  }
+  munmap(mapped, snapshot_size);
+  return config;
+}
+
+bool ConfigSnapshot::Write(const std::string& config_file_path) const {
+  auto config_file_id = GetConfigFileId(config_file_path);
+  auto content = os::ReadSmallFile(config_file_path);
+  if (!config_file_id || !content) {
+    return false;
+  }
+  std::string payload;
+  payload.reserve(content->size());
+  std::string current_section;
+  size_t num_properties_offset = 0;
+  uint32_t num_properties = 0;
+  auto end_section = [&payload, &num_properties_offset, &num_properties] {
+    if (num_properties > 0) {
+      std::string count;
+      PutUint32(count, num_properties);
+      payload.replace(num_properties_offset, count.size(), count);
+    }
+  };
+  std::istringstream content_stream(*content);
+  bool parsed = LegacyConfigFile::Parse(
+      content_stream, [&](const std::string& section, const std::string& property, std::string value) {
+        if (num_properties == 0 || section != current_section) {
+          end_section();
+          current_section = section;
+          PutString(payload, section);
+          num_properties_offset = payload.size();
+          PutUint32(payload, 0);
+          num_properties = 0;
+        }
+        PutString(payload, property);
+        PutString(payload, value);
+        num_properties++;
+      });
+  if (!parsed) {
+    return false;
+  }
+  end_section();
+  // The config file must not have changed while it was read
+  if (GetConfigFileId(config_file_path) != config_file_id) {
+    LOG_WARN("'%s' changed while taking a snapshot", config_file_path.c_str());
+    return false;
+  }
+
+  std::string snapshot;
+  snapshot.reserve(kSnapshotHeaderSize + payload.size());
+  PutUint32(snapshot, kSnapshotMagic);
+  PutUint32(snapshot, kSnapshotVersion);
+  PutUint64(snapshot, config_file_id->size);
+  PutUint64(snapshot, config_file_id->modification_time_ns);
+  PutUint64(snapshot, config_file_id->inode);
+  PutUint32(snapshot, payload.size());
+  PutUint32(snapshot, ConfigCrc32(payload.data(), payload.size()));
+  snapshot.append(payload);
+
+  // Replace the snapshot atomically. Unlike the config file, the directory is not synced: losing the new snapshot
+  // only means the next start reads the config file
+  const std::string temp_path = path_ + ".new";
+  int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd < 0) {
+    LOG_ERROR("unable to open file '%s', error: %s", temp_path.c_str(), strerror(errno));
+    return false;
+  }
+  bool written = WriteFully(fd, snapshot);
+  if (!written) {
+    LOG_ERROR("unable to write to file '%s', error: %s", temp_path.c_str(), strerror(errno));
+  } else if (fdatasync(fd) != 0) {
+    LOG_WARN("unable to fdatasync file '%s', error: %s", temp_path.c_str(), strerror(errno));
+  }
+  if (close(fd) != 0) {
+    LOG_ERROR("unable to close file '%s', error: %s", temp_path.c_str(), strerror(errno));
+    written = false;
+  }
+  if (!written || !os::RenameFile(temp_path, path_)) {
+    os::RemoveFile(temp_path);
+    return false;
+  }
+  return true;
+}
+
+bool ConfigSnapshot::Delete() const {
+  if (!os::FileExists(path_)) {
+    LOG_WARN("Config snapshot at \"%s\" does not exist", path_.c_str());
+    return false;
+  }
+  return os::RemoveFile(path_);
+}
+
+}  // namespace storage
+}  // namespace bluetooth
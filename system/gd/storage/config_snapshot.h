@@ -0,0 +1,50 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "storage/config_cache.h"
+
+namespace bluetooth {
+namespace storage {
+
+// Binary copy of the legacy config file that loads without parsing text
+//
+// The legacy config file stays the source of truth. A snapshot records the size, modification time and inode of the
+// config file it was taken from and is only used while the config file on disk is still that one; after a crash
+// between writing the two, an edit by hand or a restore from backup, the config file is read instead. The snapshot
+// is versioned and checksummed, and is memory mapped when loaded.
+class ConfigSnapshot {
+ public:
+  explicit ConfigSnapshot(std::string path);
+
+  // Load the config in the snapshot of |config_file_path|. Return std::nullopt if there is no usable snapshot of the
+  // config file as it is on disk now, in which case the config file must be read instead
+  std::optional<ConfigCache> Read(const std::string& config_file_path, size_t temp_devices_capacity) const;
+  // Take a snapshot of |config_file_path| holding what LegacyConfigFile::Read() loads from it. Return true on success
+  bool Write(const std::string& config_file_path) const;
+  // Delete the snapshot, return true on success
+  bool Delete() const;
+
+ private:
+  std::string path_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Time StorageModule::Start() spends loading the config of |state.range(0)| bonded devices, from the legacy config file
+// and from its snapshot, and the cold start of the whole StorageModule::Start()
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "module.h"
+#include "os/parameter_provider.h"
+#include "storage/config_cache.h"
+#include "storage/config_snapshot.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+#include "storage/storage_module.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace storage {
+namespace {
+
+// Same capacity as StorageModule
+constexpr size_t kTempDevicesCapacity = 10000;
+
+std::string DeviceSection(size_t index) {
+  char address[18];
+  std::snprintf(
+      address, sizeof(address), "aa:bb:cc:%02zx:%02zx:%02zx", (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+  return address;
+}
+
+// A dual mode device bonded over both transports, as written by the legacy stack
+ConfigCache MakeConfig(size_t num_devices) {
+  ConfigCache config(kTempDevicesCapacity, Device::kLinkKeyProperties);
+  config.SetProperty("Info", "FileSource", "Empty");
+  config.SetProperty("Info", "TimeCreated", "2022-01-01 00:00:00");
+  config.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  config.SetProperty("Adapter", "LE_LOCAL_KEY_IRK", "fedcba0987654321fedcba0987654321");
+  config.SetProperty("Adapter", "ScanMode", "2");
+  for (size_t i = 0; i < num_devices; i++) {
+    auto section = DeviceSection(i);
+    config.SetProperty(section, "Name", "Device " + std::to_string(i));
+    config.SetProperty(section, "DevClass", "2360344");
+    config.SetProperty(section, "DevType", "3");
+    config.SetProperty(section, "AddrType", "0");
+    config.SetProperty(section, "Timestamp", "1640995200");
+    config.SetProperty(
+        section,
+        "Service",
+        "0000110b-0000-1000-8000-00805f9b34fb 0000110e-0000-1000-8000-00805f9b34fb "
+        "0000111e-0000-1000-8000-00805f9b34fb 00001800-0000-1000-8000-00805f9b34fb");
+    config.SetProperty(section, "LinkKeyType", "8");
+    config.SetProperty(section, "PinLength", "0");
+    config.SetProperty(section, "LinkKey", "fedcba0987654321fedcba0987654328");
+    config.SetProperty(section, "LE_KEY_PENC", "00112233445566778899aabbccddeeff0011223344556677889900");
+    config.SetProperty(section, "LE_KEY_PID", "00112233445566778899aabbccddeeff00aabbccddeeff00");
+  }
+  return config;
+}
+
+class ConfigFiles {
+ public:
+  explicit ConfigFiles(size_t num_devices) {
+    auto temp_dir = std::filesystem::temp_directory_path();
+    config_ = (temp_dir / "bt_config_benchmark.conf").string();
+    // Same names as StorageModule derives from |config_|
+    backup_ = (temp_dir / "bt_config_benchmark.bak").string();
+    journal_ = (temp_dir / "bt_config_benchmark.journal").string();
+    snapshot_ = (temp_dir / "bt_config_benchmark.snapshot").string();
+    LegacyConfigFile::FromPath(config_).Write(MakeConfig(num_devices));
+    ConfigSnapshot(snapshot_).Write(config_);
+  }
+  ~ConfigFiles() {
+    for (const auto* path : {&config_, &backup_, &journal_, &snapshot_}) {
+      std::filesystem::remove(*path);
+    }
+  }
+  std::string config_;
+  std::string backup_;
+  std::string journal_;
+  std::string snapshot_;
+};
+
+void BM_ConfigLoadFromFile(State& state) {
+  ConfigFiles files(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacyConfigFile::FromPath(files.config_).Read(kTempDevicesCapacity));
+  }
+  state.counters["file_bytes"] = Counter(std::filesystem::file_size(files.config_));
+}
+BENCHMARK(BM_ConfigLoadFromFile)->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+void BM_ConfigLoadFromSnapshot(State& state) {
+  ConfigFiles files(state.range(0));
+  for (auto _ : state) {
+    auto config = ConfigSnapshot(files.snapshot_).Read(files.config_, kTempDevicesCapacity);
+    if (!config) {
+      state.SkipWithError("snapshot not used");
+      break;
+    }
+    benchmark::DoNotOptimize(config);
+  }
+  state.counters["file_bytes"] = Counter(std::filesystem::file_size(files.snapshot_));
+}
+BENCHMARK(BM_ConfigLoadFromSnapshot)->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+class BenchmarkStorageModule : public StorageModule {
+ public:
+  explicit BenchmarkStorageModule(std::string config_file_path)
+      : StorageModule(std::move(config_file_path), std::chrono::milliseconds(3000), kTempDevicesCapacity, false, false) {
+  }
+};
+
+// Everything StorageModule::Start() does after a reboot, with the snapshot left by the previous Stop(), or without it in
+// common criteria mode if state.range(1) is set. Stop() is not timed
+void BM_StorageModuleStart(State& state) {
+  ConfigFiles files(state.range(0));
+  os::ParameterProvider::SetCommonCriteriaMode(state.range(1) != 0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto registry = std::make_unique<TestModuleRegistry>();
+    auto* storage = new BenchmarkStorageModule(files.config_);
+    state.ResumeTiming();
+    registry->InjectTestModule(&StorageModule::Factory, storage);
+    state.PauseTiming();
+    registry->StopAll();
+    registry.reset();
+    state.ResumeTiming();
+  }
+  os::ParameterProvider::SetCommonCriteriaMode(false);
+}
+BENCHMARK(BM_StorageModuleStart)
+    ->ArgsProduct({{10, 100, 1000}, {0, 1}})
+    ->ArgNames({"devices", "common_criteria"})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace storage
+}  // namespace bluetooth
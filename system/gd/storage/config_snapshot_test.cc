@@ -0,0 +1,154 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_snapshot.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "os/files.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+namespace testing {
+
+using bluetooth::os::ReadSmallFile;
+using bluetooth::os::WriteToFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigSnapshot;
+using bluetooth::storage::Device;
+using bluetooth::storage::LegacyConfigFile;
+
+// Comments, blank lines, extra spaces and properties before the first section, as allowed by LegacyConfigFile
+const std::string kTestConfig =
+    "# comment\n"
+    "Global_key = global value\n"
+    "\n"
+    "[Info]\n"
+    "FileSource = Empty\n"
+    "TimeCreated = 2020-05-20 01:20:56\n"
+    "\n"
+    "[Adapter]\n"
+    "  Address=01:02:03:ab:cd:ef  \n"
+    "LE_LOCAL_KEY_IRK = fedcba0987654321fedcba0987654321\n"
+    "Name =\n"
+    "\n"
+    "[01:02:03:ab:cd:ea]\n"
+    "name = hello world\n"
+    "LinkKey = fedcba0987654321fedcba0987654328\n"
+    "\n"
+    "[01:02:03:AB:CD:EB]\n"
+    "LinkKey = fedcba0987654321fedcba0987654329\n"
+    "\n"
+    "[Adapter]\n"
+    "ScanMode = 2\n";
+
+class ConfigSnapshotTest : public Test {
+ protected:
+  void SetUp() override {
+    temp_dir_ = std::filesystem::temp_directory_path();
+    temp_config_ = temp_dir_ / "temp_config.txt";
+    temp_snapshot_ = temp_dir_ / "temp_config.snapshot";
+    DeleteFiles();
+  }
+
+  void TearDown() override {
+    DeleteFiles();
+  }
+
+  void DeleteFiles() {
+    for (const auto& path : {temp_config_, temp_snapshot_}) {
+      if (std::filesystem::exists(path)) {
+        ASSERT_TRUE(std::filesystem::remove(path));
+      }
+    }
+  }
+
+  std::optional<ConfigCache> ReadSnapshot() {
+    return ConfigSnapshot(temp_snapshot_.string()).Read(temp_config_.string(), 100);
+  }
+
+  std::filesystem::path temp_dir_;
+  std::filesystem::path temp_config_;
+  std::filesystem::path temp_snapshot_;
+};
+
+TEST_F(ConfigSnapshotTest, read_loads_same_config_as_config_file_test) {
+  ASSERT_TRUE(WriteToFile(temp_config_.string(), kTestConfig));
+  ASSERT_TRUE(ConfigSnapshot(temp_snapshot_.string()).Write(temp_config_.string()));
+
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(100);
+  ASSERT_TRUE(config);
+  auto snapshot_config = ReadSnapshot();
+  ASSERT_TRUE(snapshot_config);
+  ASSERT_EQ(*snapshot_config, *config);
+  ASSERT_EQ(snapshot_config->SerializeToLegacyFormat(), config->SerializeToLegacyFormat());
+  ASSERT_THAT(snapshot_config->GetProperty("Adapter", "Address"), Optional(StrEq("01:02:03:ab:cd:ef")));
+  ASSERT_THAT(snapshot_config->GetProperty("Adapter", "Name"), Optional(StrEq("")));
+  ASSERT_THAT(snapshot_config->GetPersistentSections(), ElementsAre("01:02:03:ab:cd:ea", "01:02:03:AB:CD:EB"));
+}
+
+TEST_F(ConfigSnapshotTest, snapshot_of_replaced_config_file_is_not_used_test) {
+  ASSERT_TRUE(WriteToFile(temp_config_.string(), kTestConfig));
+  ASSERT_TRUE(ConfigSnapshot(temp_snapshot_.string()).Write(temp_config_.string()));
+  ASSERT_TRUE(WriteToFile(temp_config_.string(), kTestConfig + "Name = foo\n"));
+  ASSERT_FALSE(ReadSnapshot());
+
+  ASSERT_TRUE(ConfigSnapshot(temp_snapshot_.string()).Write(temp_config_.string()));
+  auto snapshot_config = ReadSnapshot();
+  ASSERT_TRUE(snapshot_config);
+  ASSERT_THAT(snapshot_config->GetProperty("Adapter", "Name"), Optional(StrEq("foo")));
+
+  ASSERT_TRUE(std::filesystem::remove(temp_config_));
+  ASSERT_FALSE(ReadSnapshot());
+}
+
+TEST_F(ConfigSnapshotTest, corrupted_snapshot_is_not_used_test) {
+  ASSERT_TRUE(WriteToFile(temp_config_.string(), kTestConfig));
+  ASSERT_TRUE(ConfigSnapshot(temp_snapshot_.string()).Write(temp_config_.string()));
+  auto snapshot = ReadSmallFile(temp_snapshot_.string());
+  ASSERT_TRUE(snapshot);
+
+  auto corrupted = *snapshot;
+  corrupted[corrupted.size() / 2] ^= 0x01;
+  std::ofstream(temp_snapshot_, std::ios::binary | std::ios::trunc) << corrupted;
+  ASSERT_FALSE(ReadSnapshot());
+
+  std::ofstream(temp_snapshot_, std::ios::binary | std::ios::trunc) << snapshot->substr(0, snapshot->size() - 1);
+  ASSERT_FALSE(ReadSnapshot());
+
+  // another version
+  auto other_version = *snapshot;
+  other_version[4] ^= 0x01;
+  std::ofstream(temp_snapshot_, std::ios::binary | std::ios::trunc) << other_version;
+  ASSERT_FALSE(ReadSnapshot());
+
+  std::ofstream(temp_snapshot_, std::ios::binary | std::ios::trunc) << *snapshot;
+  ASSERT_TRUE(ReadSnapshot());
+}
+
+TEST_F(ConfigSnapshotTest, malformed_config_file_is_not_snapshotted_test) {
+  ASSERT_FALSE(ConfigSnapshot(temp_snapshot_.string()).Write(temp_config_.string()));
+  ASSERT_TRUE(WriteToFile(temp_config_.string(), "[Adapter\n"));
+  ASSERT_FALSE(ConfigSnapshot(temp_snapshot_.string()).Write(temp_config_.string()));
+  ASSERT_FALSE(std::filesystem::exists(temp_snapshot_));
+  ASSERT_FALSE(ReadSnapshot());
+}
+
+}  // namespace testing
@@ -15,6 +15,8 @@
  */
 #pragma once
 
+#include <functional>
+#include <istream>
 #include <string>
 #include <utility>
 
@@ -31,6 +33,11 @@ class LegacyConfigFile {
   }
   explicit LegacyConfigFile(std::string path);
   std::optional<ConfigCache> Read(size_t temp_devices_capacity);
+  // Call |on_property| with the section, name and value of each property in |content|, in order. Return false if
+  // |content| is malformed
+  using PropertyCallback =
+      std::function<void(const std::string& section, const std::string& property, std::string value)>;
+  static bool Parse(std::istream& content, const PropertyCallback& on_property);
   bool Write(const ConfigCache& cache);
   bool Delete();
 
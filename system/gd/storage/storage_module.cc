@@ -20,6 +20,7 @@
 #include <ctime>
 #include <iomanip>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "common/bind.h"
@@ -30,6 +31,8 @@
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
+#include "storage/config_snapshot.h"
 #include "storage/legacy_config_file.h"
 #include "storage/mutation.h"
 
@@ -49,6 +52,9 @@ static const std::chrono::milliseconds kDefaultConfigSaveDelay = std::chrono::mi
 // Writing a config to disk takes a minimum 10 ms on a decent x86_64 machine, and 20 ms if including backup file
 // The config saving delay must be bigger than this value to avoid overwhelming the disk
 static const std::chrono::milliseconds kMinConfigSaveDelay = std::chrono::milliseconds(20);
+// A change takes a few dozen bytes in the journal, so this is about a thousand changes between two full writes of the
+// config, and replaying a full journal adds about a millisecond to loading a config with a thousand bonded devices
+static const size_t kConfigJournalCompactionSize = 64 * 1024;
 
 const int kConfigFileComparePass = 1;
 const int kConfigBackupComparePass = 2;
@@ -75,6 +81,10 @@ StorageModule::StorageModule(
       is_single_user_mode_(is_single_user_mode) {
   // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.bak"
   config_backup_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".bak";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.journal"
+  config_journal_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".journal";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.snapshot"
+  config_snapshot_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".snapshot";
   ASSERT_LOG(
       config_save_delay > kMinConfigSaveDelay,
       "Config save delay of %lld ms is not enough, must be at least %lld ms to avoid overwhelming the disk",
@@ -93,11 +103,17 @@ const ModuleFactory StorageModule::Factory = ModuleFactory([]() {
 });
 
 struct StorageModule::impl {
-  explicit impl(Handler* handler, ConfigCache cache, size_t in_memory_cache_size_limit)
-      : config_save_alarm_(handler), cache_(std::move(cache)), memory_only_cache_(in_memory_cache_size_limit, {}) {}
+  explicit impl(
+      Handler* handler, ConfigCache cache, size_t in_memory_cache_size_limit, std::unique_ptr<ConfigJournal> journal)
+      : config_save_alarm_(handler),
+        cache_(std::move(cache)),
+        memory_only_cache_(in_memory_cache_size_limit, {}),
+        journal_(std::move(journal)) {}
   Alarm config_save_alarm_;
   ConfigCache cache_;
   ConfigCache memory_only_cache_;
+  // Null in common criteria mode, where changes are not journaled
+  std::unique_ptr<ConfigJournal> journal_;
   bool has_pending_config_save_ = false;
 };
 
@@ -132,6 +148,8 @@ void StorageModule::SaveImmediately() {
     pimpl_->config_save_alarm_.Cancel();
     pimpl_->has_pending_config_save_ = false;
   }
+  // Changes queued after this point may or may not make it into the config file, keep them for the next journal
+  size_t journaled_size = pimpl_->journal_ ? pimpl_->journal_->PendingSize() : 0;
   // 1. rename old config to backup name
   if (os::FileExists(config_file_path_)) {
     ASSERT(os::RenameFile(config_file_path_, config_backup_path_));
@@ -146,6 +164,27 @@ void StorageModule::SaveImmediately() {
     bluetooth::os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
         kConfigFilePrefix, kConfigFileHash);
   }
+  // 5. snapshot the config file for the next start, it is only used as long as the config file is left untouched
+  if (!bluetooth::os::ParameterProvider::IsCommonCriteriaMode() &&
+      !ConfigSnapshot(config_snapshot_path_).Write(config_file_path_)) {
+    LOG_WARN("unable to write config snapshot at %s", config_snapshot_path_.c_str());
+  }
+  // 6. all journaled changes are in the config file now, start a new journal
+  if (pimpl_->journal_) {
+    pimpl_->journal_->Reset(journaled_size);
+  }
+}
+
+void StorageModule::SyncJournal() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (!pimpl_->journal_->Sync()) {
+    LOG_WARN("unable to sync config journal at %s, saving config in full", config_journal_path_.c_str());
+    SaveDelayed();
+    return;
+  }
+  if (pimpl_->journal_->Size() > kConfigJournalCompactionSize) {
+    SaveDelayed();
+  }
 }
 
 void StorageModule::ListDependencies(ModuleList* list) const {
@@ -159,6 +198,8 @@ void StorageModule::Start() {
     LOG_INFO("%s is true, delete config files", kFactoryResetProperty.c_str());
     LegacyConfigFile::FromPath(config_file_path_).Delete();
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
+    ConfigJournal(config_journal_path_).Delete();
+    ConfigSnapshot(config_snapshot_path_).Delete();
     os::SetSystemProperty(kFactoryResetProperty, "false");
   }
   if (!is_config_checksum_pass(kConfigFileComparePass)) {
@@ -167,12 +208,40 @@ void StorageModule::Start() {
   if (!is_config_checksum_pass(kConfigBackupComparePass)) {
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
   }
-  auto config = LegacyConfigFile::FromPath(config_file_path_).Read(temp_devices_capacity_);
+  // The snapshot is only used if it was taken from the config file as it is on disk now. In common criteria mode it is
+  // not covered by the checksum held in the keystore, so the config file that is checked is always parsed instead
+  std::optional<ConfigCache> config;
+  if (bluetooth::os::ParameterProvider::IsCommonCriteriaMode()) {
+    ConfigSnapshot(config_snapshot_path_).Delete();
+  } else {
+    config = ConfigSnapshot(config_snapshot_path_).Read(config_file_path_, temp_devices_capacity_);
+  }
+  if (!config) {
+    config = LegacyConfigFile::FromPath(config_file_path_).Read(temp_devices_capacity_);
+  }
   if (!config || !config->HasSection(kAdapterSection)) {
     LOG_WARN("cannot load config at %s, using backup at %s.", config_file_path_.c_str(), config_backup_path_.c_str());
     config = LegacyConfigFile::FromPath(config_backup_path_).Read(temp_devices_capacity_);
     file_source = "Backup";
   }
+  // In common criteria mode only the config file is covered by the checksum held in the keystore, so changes are not
+  // journaled and the config is saved in full on every change
+  auto journal = std::make_unique<ConfigJournal>(config_journal_path_);
+  if (bluetooth::os::ParameterProvider::IsCommonCriteriaMode()) {
+    journal->Delete();
+    journal.reset();
+  } else {
+    // Redo changes made after the config was last written in full, they are only kept if there is a config to apply to
+    if (config && config->HasSection(kAdapterSection)) {
+      size_t num_replayed = journal->Replay(&config.value());
+      if (num_replayed > 0) {
+        LOG_INFO("replayed %zu config changes from %s", num_replayed, config_journal_path_.c_str());
+      }
+    }
+    if (!journal->Open()) {
+      LOG_WARN("cannot open config journal at %s, saving config in full on every change", config_journal_path_.c_str());
+    }
+  }
   if (!config || !config->HasSection(kAdapterSection)) {
     LOG_WARN("cannot load backup config at %s; creating new empty ones", config_backup_path_.c_str());
     config.emplace(temp_devices_capacity_, Device::kLinkKeyProperties);
@@ -195,9 +264,20 @@ void StorageModule::Start() {
     config->SetProperty(kInfoSection, kTimeCreatedProperty, ss.str());
   }
   config->FixDeviceTypeInconsistencies();
-  config->SetPersistentConfigChangedCallback([this] { this->CallOn(this, &StorageModule::SaveDelayed); });
+  if (journal) {
+    auto* config_journal = journal.get();
+    config->SetPersistentMutationCallback(
+        [config_journal](
+            MutationEntry::EntryType entry_type,
+            std::string_view section,
+            std::string_view property,
+            std::string_view value) { config_journal->Append(entry_type, section, property, value); });
+    config->SetPersistentConfigChangedCallback([this] { this->CallOn(this, &StorageModule::SyncJournal); });
+  } else {
+    config->SetPersistentConfigChangedCallback([this] { this->CallOn(this, &StorageModule::SaveDelayed); });
+  }
   // TODO (b/158035889) Migrate metrics module to GD
-  pimpl_ = std::make_unique<impl>(GetHandler(), std::move(config.value()), temp_devices_capacity_);
+  pimpl_ = std::make_unique<impl>(GetHandler(), std::move(config.value()), temp_devices_capacity_, std::move(journal));
   SaveDelayed();
   if (bluetooth::os::ParameterProvider::GetBtKeystoreInterface() != nullptr) {
     bluetooth::os::ParameterProvider::GetBtKeystoreInterface()->ConvertEncryptOrDecryptKeyIfNeeded();
@@ -119,15 +119,19 @@ class StorageModule : public bluetooth::Module {
   ConfigCache* GetConfigCache();
   // For unit test only
   ConfigCache* GetMemoryOnlyConfigCache();
-  // Normally, underlying config will be saved at most 3 seconds after the first config change in a series of changes
+  // Normally, underlying config will be saved in full at most 3 seconds after the journal outgrows its limit
   // This method triggers the delayed saving automatically, the delay is equal to |config_save_delay_|
   void SaveDelayed();
   // In some cases, one may want to save the config immediately to disk. Call this method with caution as it runs
   // immediately on the calling thread
   void SaveImmediately();
+  // Persistent config changes are appended to a journal next to the config file and synced to disk right away. Once
+  // the journal grows past |kConfigJournalCompactionSize|, SaveDelayed() compacts it into the config file
+  void SyncJournal();
 
   // Create the storage module where:
-  // - config_file_path is the path to the config file on disk, a .bak file will be created with the original
+  // - config_file_path is the path to the config file on disk, a .bak file will be created with the original and a
+  //   .journal file holds the changes made since the config file was last written
   // - config_save_delay is the duration after which to dump config to disk after SaveDelayed() is called
   // - temp_devices_capacity is the number of temporary, typically unpaired devices to hold in a memory based LRU
   // - is_restricted_mode and is_single_user_mode are flags from upper layer
@@ -144,6 +148,8 @@ class StorageModule : public bluetooth::Module {
   std::unique_ptr<impl> pimpl_;
   std::string config_file_path_;
   std::string config_backup_path_;
+  std::string config_journal_path_;
+  std::string config_snapshot_path_;
   std::chrono::milliseconds config_save_delay_;
   size_t temp_devices_capacity_;
   bool is_restricted_mode_;
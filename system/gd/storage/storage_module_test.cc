@@ -29,7 +29,9 @@
 
 #include "module.h"
 #include "os/files.h"
+#include "os/parameter_provider.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/device.h"
 #include "storage/legacy_config_file.h"
 
@@ -38,8 +40,10 @@ namespace testing {
 using bluetooth::TestModuleRegistry;
 using bluetooth::hci::Address;
 using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
 using bluetooth::storage::Device;
 using bluetooth::storage::LegacyConfigFile;
+using bluetooth::storage::MutationEntry;
 using bluetooth::storage::StorageModule;
 
 static const std::chrono::milliseconds kTestConfigSaveDelay = std::chrono::milliseconds(100);
@@ -108,12 +112,15 @@ class StorageModuleTest : public Test {
     temp_dir_ = std::filesystem::temp_directory_path();
     temp_config_ = temp_dir_ / "temp_config.txt";
     temp_backup_config_ = temp_dir_ / "temp_config.bak";
+    temp_config_journal_ = temp_dir_ / "temp_config.journal";
+    temp_config_snapshot_ = temp_dir_ / "temp_config.snapshot";
     DeleteConfigFiles();
     ASSERT_FALSE(std::filesystem::exists(temp_config_));
     ASSERT_FALSE(std::filesystem::exists(temp_backup_config_));
   }
 
   void TearDown() override {
+    bluetooth::os::ParameterProvider::SetCommonCriteriaMode(false);
     DeleteConfigFiles();
   }
 
@@ -124,11 +131,28 @@ class StorageModuleTest : public Test {
     if (std::filesystem::exists(temp_backup_config_)) {
       ASSERT_TRUE(std::filesystem::remove(temp_backup_config_));
     }
+    if (std::filesystem::exists(temp_config_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_config_journal_));
+    }
+    if (std::filesystem::exists(temp_config_snapshot_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_config_snapshot_));
+    }
+  }
+
+  // Changes reach the journal first and the config file only when the journal is compacted
+  std::optional<ConfigCache> ReadSavedConfig() {
+    auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+    if (config) {
+      ConfigJournal(temp_config_journal_.string()).Replay(&config.value());
+    }
+    return config;
   }
 
   std::filesystem::path temp_dir_;
   std::filesystem::path temp_config_;
   std::filesystem::path temp_backup_config_;
+  std::filesystem::path temp_config_journal_;
+  std::filesystem::path temp_config_snapshot_;
 };
 
 TEST_F(StorageModuleTest, empty_config_no_op_test) {
@@ -251,21 +275,21 @@ TEST_F(StorageModuleTest, save_config_test) {
   storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
   ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  auto config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
 
   // Remove a property
   storage->GetConfigCachePublic()->RemoveProperty("01:02:03:ab:cd:ea", "name");
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasProperty("01:02:03:ab:cd:ea", "name"));
 
   // Remove a section
   storage->GetConfigCachePublic()->RemoveSection("01:02:03:ab:cd:ea");
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasSection("01:02:03:ab:cd:ea"));
 
@@ -281,6 +305,157 @@ TEST_F(StorageModuleTest, save_config_test) {
 
   // Verify states after test
   ASSERT_TRUE(std::filesystem::exists(temp_config_));
+  ASSERT_EQ(std::filesystem::file_size(temp_config_journal_), 0u);
+}
+
+TEST_F(StorageModuleTest, replay_config_journal_test) {
+  // Prepare config file and changes journaled after it was written
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  {
+    ConfigJournal journal(temp_config_journal_.string());
+    ASSERT_TRUE(journal.Open());
+    journal.Append(MutationEntry::EntryType::SET, "01:02:03:ab:cd:ea", "name", "foo");
+    journal.Append(MutationEntry::EntryType::SET, "01:02:03:ab:cd:eb", "LinkKey", "123456");
+    journal.Append(MutationEntry::EntryType::REMOVE_PROPERTY, "Adapter", "ScanMode", "");
+    ASSERT_TRUE(journal.Sync());
+  }
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Test
+  ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_THAT(
+      storage->GetConfigCachePublic()->GetPersistentSections(), ElementsAre("01:02:03:ab:cd:ea", "01:02:03:ab:cd:eb"));
+  ASSERT_FALSE(storage->GetConfigCachePublic()->HasProperty("Adapter", "ScanMode"));
+
+  // Tear down
+  test_registry.StopAll();
+
+  // Verify the journal was compacted into the config file
+  ASSERT_EQ(std::filesystem::file_size(temp_config_journal_), 0u);
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:eb", "LinkKey"), Optional(StrEq("123456")));
+}
+
+TEST_F(StorageModuleTest, common_criteria_mode_config_journal_test) {
+  // Prepare config file and a journal that is not covered by the keystore checksum
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  {
+    ConfigJournal journal(temp_config_journal_.string());
+    ASSERT_TRUE(journal.Open());
+    journal.Append(MutationEntry::EntryType::SET, "01:02:03:ab:cd:ea", "name", "foo");
+    ASSERT_TRUE(journal.Sync());
+  }
+  bluetooth::os::ParameterProvider::SetCommonCriteriaMode(true);
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Test
+  ASSERT_THAT(
+      storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("hello world")));
+  ASSERT_FALSE(std::filesystem::exists(temp_config_journal_));
+
+  // Changes are saved in full
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_FALSE(std::filesystem::exists(temp_config_journal_));
+
+  // Tear down
+  test_registry.StopAll();
+}
+
+TEST_F(StorageModuleTest, load_config_snapshot_test) {
+  // Prepare config file and its snapshot
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  {
+    auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+    TestModuleRegistry test_registry;
+    test_registry.InjectTestModule(&StorageModule::Factory, storage);
+    storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
+    test_registry.StopAll();
+  }
+  ASSERT_TRUE(std::filesystem::exists(temp_config_snapshot_));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Test
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_EQ(storage->GetConfigCachePublic()->SerializeToLegacyFormat(), config->SerializeToLegacyFormat());
+  ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+
+  // Tear down
+  test_registry.StopAll();
+}
+
+TEST_F(StorageModuleTest, ignore_stale_config_snapshot_test) {
+  // Prepare a snapshot of a config file that was replaced since
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  {
+    auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+    TestModuleRegistry test_registry;
+    test_registry.InjectTestModule(&StorageModule::Factory, storage);
+    test_registry.StopAll();
+  }
+  ASSERT_TRUE(std::filesystem::exists(temp_config_snapshot_));
+  auto edited_config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(edited_config);
+  edited_config->SetProperty("01:02:03:ab:cd:ea", "name", "edited");
+  ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(*edited_config));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Test
+  ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("edited")));
+
+  // Tear down
+  test_registry.StopAll();
+}
+
+TEST_F(StorageModuleTest, common_criteria_mode_config_snapshot_test) {
+  // Prepare config file and a snapshot that is not covered by the keystore checksum
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  {
+    auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+    TestModuleRegistry test_registry;
+    test_registry.InjectTestModule(&StorageModule::Factory, storage);
+    test_registry.StopAll();
+  }
+  ASSERT_TRUE(std::filesystem::exists(temp_config_snapshot_));
+  bluetooth::os::ParameterProvider::SetCommonCriteriaMode(true);
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Test
+  ASSERT_FALSE(std::filesystem::exists(temp_config_snapshot_));
+  ASSERT_THAT(
+      storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("hello world")));
+
+  // Tear down
+  test_registry.StopAll();
+
+  // Verify no snapshot was taken
+  ASSERT_TRUE(std::filesystem::exists(temp_config_));
+  ASSERT_FALSE(std::filesystem::exists(temp_config_snapshot_));
 }
 
 TEST_F(StorageModuleTest, get_bonded_devices_test) {
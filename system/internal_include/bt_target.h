@@ -396,12 +396,21 @@
  *
  *****************************************************************************/
 
-/* The maximum number of simultaneous links that L2CAP can support. */
+/* The maximum number of simultaneous links that L2CAP can support. Builds that
+ * need more links can raise it, handle lookups on the data path do not scan
+ * the link pool.
+ *
+ * This and MAX_L2CAP_CHANNELS are build-time only. They size the static l2cb
+ * pools, and MAX_L2CAP_LINKS also sizes the ACL database in stack/acl, which
+ * walks it with uint8_t indices. Making them runtime configurable would mean
+ * allocating those pools at init; that is not supported.
+ */
 #ifndef MAX_L2CAP_LINKS
 #define MAX_L2CAP_LINKS 16
 #endif
 
-/* The maximum number of simultaneous channels that L2CAP can support. */
+/* The maximum number of simultaneous channels that L2CAP can support. Remote
+ * CID lookups are hashed over this many buckets. */
 #ifndef MAX_L2CAP_CHANNELS
 #define MAX_L2CAP_CHANNELS 64
 #endif
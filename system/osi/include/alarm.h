@@ -102,4 +102,6 @@ void alarm_cleanup(void);
 
 // Dump alarm-related statistics and debug info to the |fd| file descriptor.
 // The information is in user-readable text format. The |fd| must be valid.
+// Per-alarm statistics are only collected after the first call, for the
+// alarms set from then on.
 void alarm_debug_dump(int fd);
@@ -35,12 +35,14 @@
 
 #include <hardware/bluetooth.h>
 
+#include <algorithm>
+#include <limits>
 #include <mutex>
+#include <vector>
 
 #include "check.h"
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
@@ -61,9 +63,8 @@ typedef struct {
   uint64_t max_ms;
 } stat_t;
 
-// Alarm-related information and statistics
+// Alarm-related statistics
 typedef struct {
-  const char* name;
   size_t scheduled_count;
   size_t canceled_count;
   size_t rescheduled_count;
@@ -84,6 +85,8 @@ struct CancelableClosureInStruct {
   }
 };
 
+static const size_t ALARM_NOT_SCHEDULED = std::numeric_limits<size_t>::max();
+
 struct alarm_t {
   // The mutex is held while the callback for this alarm is being executed.
   // It allows us to release the coarse-grained monitor lock while a
@@ -97,10 +100,13 @@ struct alarm_t {
   uint64_t prev_deadline_ms;  // Previous deadline - used for accounting of
                               // periodic timers
   bool is_periodic;
+  size_t heap_index;     // Position in |alarms|, or ALARM_NOT_SCHEDULED
   fixed_queue_t* queue;  // The processing queue to add this alarm to
   alarm_callback_t callback;
   void* data;
-  alarm_stats_t stats;
+  char* name;
+  // NULL until the alarm is set while |alarm_stats_enabled|
+  alarm_stats_t* stats;
 
   bool for_msg_loop;  // True, if the alarm should be processed on message loop
   CancelableClosureInStruct closure;  // posted to message loop for processing
@@ -113,11 +119,25 @@ struct alarm_t {
 int64_t TIMER_INTERVAL_FOR_WAKELOCK_IN_MS = 3000;
 static const clockid_t CLOCK_ID = CLOCK_BOOTTIME;
 
+// Entry of the |alarms| min-heap. The deadline is copied next to the alarm
+// pointer so that sifting only touches the heap array. |sequence| breaks ties
+// between equal deadlines so alarms keep firing in the order they were set.
+typedef struct {
+  uint64_t deadline_ms;
+  uint64_t sequence;
+  alarm_t* alarm;
+} alarm_heap_entry_t;
+
 // This mutex ensures that the |alarm_set|, |alarm_cancel|, and alarm callback
 // functions execute serially and not concurrently. As a result, this mutex
-// also protects the |alarms| list.
+// also protects the |alarms| heap.
 static std::mutex alarms_mutex;
-static list_t* alarms;
+// Pending alarms, as a binary min-heap ordered by deadline.
+static std::vector<alarm_heap_entry_t>* alarms;
+static uint64_t alarms_sequence;
+// Statistics are only kept once |alarm_debug_dump| has been called, so setting,
+// canceling and firing alarms do no bookkeeping nobody reads.
+static bool alarm_stats_enabled;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -139,6 +159,9 @@ static void alarm_set_internal(alarm_t* alarm, uint64_t period_ms,
                                fixed_queue_t* queue, bool for_msg_loop);
 static void alarm_cancel_internal(alarm_t* alarm);
 static void remove_pending_alarm(alarm_t* alarm);
+static alarm_t* alarms_front(void);
+static void alarms_push(alarm_t* alarm);
+static void alarms_remove(alarm_t* alarm);
 static void schedule_next_instance(alarm_t* alarm);
 static void reschedule_root_alarm(void);
 static void alarm_queue_ready(fixed_queue_t* queue, void* context);
@@ -176,14 +199,13 @@ static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
   std::shared_ptr<std::recursive_mutex> ptr(new std::recursive_mutex());
   ret->callback_mutex = ptr;
   ret->is_periodic = is_periodic;
-  ret->stats.name = osi_strdup(name);
+  ret->heap_index = ALARM_NOT_SCHEDULED;
+  ret->name = osi_strdup(name);
 
   ret->for_msg_loop = false;
   // placement new
   new (&ret->closure) CancelableClosureInStruct();
 
-  // NOTE: The stats were reset by osi_calloc() above
-
   return ret;
 }
 
@@ -192,7 +214,8 @@ void alarm_free(alarm_t* alarm) {
 
   alarm_cancel(alarm);
 
-  osi_free((void*)alarm->stats.name);
+  osi_free(alarm->name);
+  osi_free(alarm->stats);
   alarm->closure.~CancelableClosureInStruct();
   alarm->callback_mutex.reset();
   osi_free(alarm);
@@ -239,7 +262,11 @@ static void alarm_set_internal(alarm_t* alarm, uint64_t period_ms,
   alarm->for_msg_loop = for_msg_loop;
 
   schedule_next_instance(alarm);
-  alarm->stats.scheduled_count++;
+  if (alarm_stats_enabled && alarm->stats == NULL) {
+    alarm->stats =
+        static_cast<alarm_stats_t*>(osi_calloc(sizeof(alarm_stats_t)));
+  }
+  if (alarm->stats != NULL) alarm->stats->scheduled_count++;
 }
 
 void alarm_cancel(alarm_t* alarm) {
@@ -260,8 +287,7 @@ void alarm_cancel(alarm_t* alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |alarms_mutex|
 static void alarm_cancel_internal(alarm_t* alarm) {
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (alarms_front() == alarm);
 
   remove_pending_alarm(alarm);
 
@@ -269,7 +295,7 @@ static void alarm_cancel_internal(alarm_t* alarm) {
   alarm->prev_deadline_ms = 0;
   alarm->callback = NULL;
   alarm->data = NULL;
-  alarm->stats.canceled_count++;
+  if (alarm->stats != NULL) alarm->stats->canceled_count++;
   alarm->queue = NULL;
 
   if (needs_reschedule) reschedule_root_alarm();
@@ -301,7 +327,7 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
+  delete alarms;
   alarms = NULL;
 }
 
@@ -315,11 +341,8 @@ static bool lazy_initialize(void) {
 
   std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  alarms = list_new(NULL);
-  if (!alarms) {
-    LOG_ERROR("%s unable to allocate alarm list.", __func__);
-    goto error;
-  }
+  alarms = new std::vector<alarm_heap_entry_t>();
+  alarms_sequence = 0;
 
   if (!timer_create_internal(CLOCK_ID, &timer)) goto error;
   timer_initialized = true;
@@ -380,7 +403,7 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
-  list_free(alarms);
+  delete alarms;
   alarms = NULL;
 
   return false;
@@ -398,10 +421,82 @@ static uint64_t now_ms(void) {
   return (ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL);
 }
 
-// Remove alarm from internal alarm list and the processing queue
+// Returns the alarm with the earliest deadline, or NULL if none is pending.
+// The caller must hold the |alarms_mutex|
+static alarm_t* alarms_front(void) {
+  return alarms->empty() ? NULL : alarms->front().alarm;
+}
+
+static bool alarms_entry_less(const alarm_heap_entry_t& a,
+                              const alarm_heap_entry_t& b) {
+  if (a.deadline_ms != b.deadline_ms) return a.deadline_ms < b.deadline_ms;
+  return a.sequence < b.sequence;
+}
+
+static void alarms_set_entry(size_t index, const alarm_heap_entry_t& entry) {
+  (*alarms)[index] = entry;
+  entry.alarm->heap_index = index;
+}
+
+static void alarms_sift_up(size_t index) {
+  alarm_heap_entry_t entry = (*alarms)[index];
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!alarms_entry_less(entry, (*alarms)[parent])) break;
+    alarms_set_entry(index, (*alarms)[parent]);
+    index = parent;
+  }
+  alarms_set_entry(index, entry);
+}
+
+static void alarms_sift_down(size_t index) {
+  alarm_heap_entry_t entry = (*alarms)[index];
+  const size_t size = alarms->size();
+  while (true) {
+    size_t child = 2 * index + 1;
+    if (child >= size) break;
+    if (child + 1 < size &&
+        alarms_entry_less((*alarms)[child + 1], (*alarms)[child]))
+      child++;
+    if (!alarms_entry_less((*alarms)[child], entry)) break;
+    alarms_set_entry(index, (*alarms)[child]);
+    index = child;
+  }
+  alarms_set_entry(index, entry);
+}
+
+// Inserts |alarm| using its current |deadline_ms|. O(log n).
+// The caller must hold the |alarms_mutex|
+static void alarms_push(alarm_t* alarm) {
+  CHECK(alarm->heap_index == ALARM_NOT_SCHEDULED);
+  alarms->push_back({alarm->deadline_ms, alarms_sequence++, alarm});
+  alarms_sift_up(alarms->size() - 1);
+}
+
+// Removes |alarm| if it is pending, no-op otherwise. O(log n).
+// The caller must hold the |alarms_mutex|
+static void alarms_remove(alarm_t* alarm) {
+  size_t index = alarm->heap_index;
+  if (index == ALARM_NOT_SCHEDULED) return;
+  CHECK(index < alarms->size() && (*alarms)[index].alarm == alarm);
+
+  alarm->heap_index = ALARM_NOT_SCHEDULED;
+  alarm_heap_entry_t last = alarms->back();
+  alarms->pop_back();
+  if (index == alarms->size()) return;
+
+  alarms_set_entry(index, last);
+  if (index > 0 && alarms_entry_less(last, (*alarms)[(index - 1) / 2])) {
+    alarms_sift_up(index);
+  } else {
+    alarms_sift_down(index);
+  }
+}
+
+// Remove alarm from internal alarm heap and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  alarms_remove(alarm);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -416,10 +511,9 @@ static void remove_pending_alarm(alarm_t* alarm) {
 
 // Must be called with |alarms_mutex| held
 static void schedule_next_instance(alarm_t* alarm) {
-  // If the alarm is currently set and it's at the start of the list,
+  // If the alarm is currently set and it's at the top of the heap,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (alarms_front() == alarm);
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -430,26 +524,12 @@ static void schedule_next_instance(alarm_t* alarm) {
         ((just_now_ms - alarm->creation_time_ms) % alarm->period_ms);
   alarm->deadline_ms = just_now_ms + (alarm->period_ms - ms_into_period);
 
-  // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t*)list_front(alarms))->deadline_ms > alarm->deadline_ms) {
-    list_prepend(alarms, alarm);
-  } else {
-    for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-         node = list_next(node)) {
-      list_node_t* next = list_next(node);
-      if (next == list_end(alarms) ||
-          ((alarm_t*)list_node(next))->deadline_ms > alarm->deadline_ms) {
-        list_insert_after(alarms, node, alarm);
-        break;
-      }
-    }
-  }
+  // Add it into the timer heap ordered by deadline (earliest deadline first).
+  alarms_push(alarm);
 
   // If the new alarm has the earliest deadline, we need to re-evaluate our
   // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
+  if (needs_reschedule || alarms_front() == alarm) {
     reschedule_root_alarm();
   }
 }
@@ -466,9 +546,9 @@ static void reschedule_root_alarm(void) {
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  next = alarms_front();
+  if (next == NULL) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
   next_expiration = next->deadline_ms - now_ms();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
@@ -565,11 +645,12 @@ static void alarm_ready_generic(alarm_t* alarm,
   //
   if (!alarm->callback) {
     LOG(FATAL) << __func__
-               << ": timer callback is NULL! Name=" << alarm->stats.name;
+               << ": timer callback is NULL! Name=" << alarm->name;
   }
   alarm_callback_t callback = alarm->callback;
   void* data = alarm->data;
   uint64_t deadline_ms = alarm->deadline_ms;
+  alarm_stats_t* stats = alarm->stats;
   if (alarm->is_periodic) {
     // The periodic alarm has been rescheduled and alarm->deadline has been
     // updated, hence we need to use the previous deadline.
@@ -588,7 +669,7 @@ static void alarm_ready_generic(alarm_t* alarm,
   lock.unlock();
 
   // Update the statistics
-  update_scheduling_stats(&alarm->stats, now_ms(), deadline_ms);
+  if (stats != NULL) update_scheduling_stats(stats, now_ms(), deadline_ms);
 
   // NOTE: Do NOT access "alarm" after the callback, as a safety precaution
   // in case the callback itself deleted the alarm.
@@ -628,19 +709,18 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
     // Take into account that the alarm may get cancelled before we get to it.
     // We're done here if there are no alarms or the alarm at the front is in
     // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline_ms >
-            now_ms()) {
+    alarm = alarms_front();
+    if (alarm == NULL || alarm->deadline_ms > now_ms()) {
       reschedule_root_alarm();
       continue;
     }
 
-    list_remove(alarms, alarm);
+    alarms_remove(alarm);
 
     if (alarm->is_periodic) {
       alarm->prev_deadline_ms = alarm->deadline_ms;
       schedule_next_instance(alarm);
-      alarm->stats.rescheduled_count++;
+      if (alarm->stats != NULL) alarm->stats->rescheduled_count++;
     }
     reschedule_root_alarm();
 
@@ -648,7 +728,7 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
     if (alarm->for_msg_loop) {
       if (!get_main_thread()) {
         LOG_ERROR("%s: message loop already NULL. Alarm: %s", __func__,
-                  alarm->stats.name);
+                  alarm->name);
         continue;
       }
 
@@ -732,19 +812,36 @@ void alarm_debug_dump(int fd) {
     return;
   }
 
+  if (!alarm_stats_enabled) {
+    alarm_stats_enabled = true;
+    dprintf(fd, "  Statistics are collected from now on\n");
+  }
+
   uint64_t just_now_ms = now_ms();
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n\n", alarms->size());
 
-  // Dump info for each alarm
-  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
-    alarm_stats_t* stats = &alarm->stats;
+  // Dump info for each alarm, earliest deadline first
+  std::vector<alarm_heap_entry_t> sorted_alarms(*alarms);
+  std::sort(sorted_alarms.begin(), sorted_alarms.end(), alarms_entry_less);
+  for (const alarm_heap_entry_t& entry : sorted_alarms) {
+    alarm_t* alarm = entry.alarm;
+    alarm_stats_t* stats = alarm->stats;
 
-    dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
+    dprintf(fd, "  Alarm : %s (%s)\n", alarm->name,
             (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
 
+    dprintf(fd, "%-51s: %llu / %llu / %lld\n",
+            "    Time in ms (since creation/interval/remaining)",
+            (unsigned long long)(just_now_ms - alarm->creation_time_ms),
+            (unsigned long long)alarm->period_ms,
+            (long long)(alarm->deadline_ms - just_now_ms));
+
+    if (stats == NULL) {
+      dprintf(fd, "    No statistics, set before they were collected\n\n");
+      continue;
+    }
+
     dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
             "    Action counts (sched/resched/exec/cancel)",
             stats->scheduled_count, stats->rescheduled_count,
@@ -754,12 +851,6 @@ void alarm_debug_dump(int fd) {
             "    Deviation counts (overdue/premature)",
             stats->overdue_scheduling.count, stats->premature_scheduling.count);
 
-    dprintf(fd, "%-51s: %llu / %llu / %lld\n",
-            "    Time in ms (since creation/interval/remaining)",
-            (unsigned long long)(just_now_ms - alarm->creation_time_ms),
-            (unsigned long long)alarm->period_ms,
-            (long long)(alarm->deadline_ms - just_now_ms));
-
     dump_stat(fd, &stats->overdue_scheduling,
               "    Overdue scheduling time in ms (total/max/avg)");
 
@@ -107,6 +107,7 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
                               const RawAddress& new_pseudo_addr) {
   if (p_dev_rec->ble.pseudo_addr.IsEmpty()) {
     p_dev_rec->ble.pseudo_addr = new_pseudo_addr;
+    btm_sec_dev_rec_changed();
     return true;
   }
 
@@ -116,25 +117,13 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
 /* Return true if given Resolvable Privae Address |rpa| matches Identity
  * Resolving Key |irk| */
 static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
-  /* use the 3 MSB of bd address as prand */
-  uint8_t rand[3];
-  rand[0] = rpa.address[2];
-  rand[1] = rpa.address[1];
-  rand[2] = rpa.address[0];
+  /* use the 3 MSB of bd address as prand and the 3 LSB as hash */
+  uint32_t prand =
+      (rpa.address[0] << 16) | (rpa.address[1] << 8) | rpa.address[2];
+  uint32_t hash =
+      (rpa.address[3] << 16) | (rpa.address[4] << 8) | rpa.address[5];
 
-  /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-  Octet16 x = crypto_toolbox::aes_128(irk, &rand[0], 3);
-
-  rand[0] = rpa.address[5];
-  rand[1] = rpa.address[4];
-  rand[2] = rpa.address[3];
-
-  if (memcmp(x.data(), &rand[0], 3) == 0) {
-    // match
-    return true;
-  }
-  // not a match
-  return false;
+  return crypto_toolbox::ah(irk, prand) == hash;
 }
 
 /** This function checks if a RPA is resolvable by the device key.
@@ -29,7 +29,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <unordered_map>
+#include <vector>
+
 #include "btm_api.h"
+#include "common/lru.h"
 #include "device/include/controller.h"
 #include "l2c_api.h"
 #include "main/shim/btm_api.h"
@@ -37,11 +41,14 @@
 #include "main/shim/shim.h"
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/bt_octets.h"
 #include "types/raw_address.h"
 
 extern tBTM_CB btm_cb;
+extern bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
+                                     const RawAddress& new_pseudo_addr);
 
 /*******************************************************************************
  *
@@ -74,6 +81,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
         PRIVATE_ADDRESS(bd_addr), key_type, bd_name);
 
     p_dev_rec->bd_addr = bd_addr;
+    btm_sec_dev_rec_changed();
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
 
     /* use default value for background connection params */
@@ -134,6 +142,7 @@ void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
   p_dev_rec->link_key.fill(0);
   memset(&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
   list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_sec_dev_rec_changed();
 }
 
 /** Removes the device from acceptlist */
@@ -259,6 +268,7 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
   memset(&p_dev_rec->conn_params, 0xff, sizeof(tBTM_LE_CONN_PRAMS));
 
   p_dev_rec->bd_addr = bd_addr;
+  btm_sec_dev_rec_changed();
 
   p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
@@ -352,6 +362,153 @@ bool is_address_equal(void* data, void* context) {
   return true;
 }
 
+namespace {
+
+/* Number of random resolvable addresses whose resolution is remembered */
+constexpr size_t kRpaCacheSize = 256;
+
+/* Index of btm_cb.sec_dev_rec giving the same result as walking the list with
+ * is_address_equal, without computing an AES per record for every random
+ * resolvable address.
+ *
+ * Records are modified in place all over the stack, so the index is rebuilt
+ * lazily whenever btm_cb.sec_dev_rec_generation moved since it was built, and
+ * a cached resolution is checked against the record before it is returned. */
+class DevRecIndex {
+ public:
+  tBTM_SEC_DEV_REC* Find(const RawAddress& bd_addr) {
+    if (list_ != btm_cb.sec_dev_rec ||
+        generation_ != btm_cb.sec_dev_rec_generation) {
+      Rebuild();
+    }
+
+    /* Position of the first record with |bd_addr| as identity or pseudo
+     * address, past the end if there is none */
+    size_t position = records_.size();
+    auto it = by_address_.find(bd_addr);
+    if (it != by_address_.end()) {
+      position = it->second;
+      if (!IsAddressOf(bd_addr, records_[position])) {
+        /* A record was modified without btm_sec_dev_rec_changed() */
+        Rebuild();
+        it = by_address_.find(bd_addr);
+        position = (it != by_address_.end()) ? it->second : records_.size();
+      }
+    }
+
+    if (!BTM_BLE_IS_RESOLVE_BDA(bd_addr)) {
+      return (position < records_.size()) ? records_[position] : nullptr;
+    }
+
+    RpaResolution* resolution = resolved_rpas_.Find(bd_addr);
+    if (resolution != nullptr && IsValid(bd_addr, *resolution)) {
+      if (resolution->resolved_by_irk) {
+        btm_ble_init_pseudo_addr(resolution->p_dev_rec, bd_addr);
+      }
+      return resolution->p_dev_rec;
+    }
+
+    /* Like is_address_equal, a record before |position| whose IRK resolves
+     * |bd_addr| comes first. The address is hashed with all the IRKs at once,
+     * as btm_ble_addr_resolvable() would for each record. */
+    RpaResolution new_resolution = {};
+    candidates_.clear();
+    irks_.clear();
+    for (size_t i = 0; i < position; i++) {
+      tBTM_SEC_DEV_REC* p_dev_rec = records_[i];
+      if ((p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+          (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
+        candidates_.push_back(p_dev_rec);
+        irks_.push_back(p_dev_rec->ble.keys.irk);
+      }
+    }
+    hashes_.resize(irks_.size());
+    uint32_t prand = (bd_addr.address[0] << 16) | (bd_addr.address[1] << 8) |
+                     bd_addr.address[2];
+    uint32_t hash = (bd_addr.address[3] << 16) | (bd_addr.address[4] << 8) |
+                    bd_addr.address[5];
+    crypto_toolbox::ah(irks_.data(), irks_.size(), prand, hashes_.data());
+    for (size_t i = 0; i < candidates_.size(); i++) {
+      if (hashes_[i] == hash) {
+        btm_ble_init_pseudo_addr(candidates_[i], bd_addr);
+        new_resolution = {candidates_[i], true, irks_[i]};
+        break;
+      }
+    }
+    if (new_resolution.p_dev_rec == nullptr && position < records_.size()) {
+      new_resolution = {records_[position], false, {}};
+    }
+
+    /* Resolving may have set the pseudo address of the record, which rebuilds
+     * the index and drops the cache on the next lookup */
+    if (generation_ == btm_cb.sec_dev_rec_generation) {
+      resolved_rpas_.Put(bd_addr, new_resolution);
+    }
+    return new_resolution.p_dev_rec;
+  }
+
+ private:
+  struct RpaResolution {
+    /* Record found for the address, nullptr if none */
+    tBTM_SEC_DEV_REC* p_dev_rec;
+    /* Whether the record was found by its IRK rather than by its address */
+    bool resolved_by_irk;
+    /* IRK that resolved the address */
+    Octet16 irk;
+  };
+
+  static bool IsAddressOf(const RawAddress& bd_addr,
+                          const tBTM_SEC_DEV_REC* p_dev_rec) {
+    return p_dev_rec->bd_addr == bd_addr ||
+           p_dev_rec->ble.pseudo_addr == bd_addr;
+  }
+
+  static bool IsValid(const RawAddress& bd_addr,
+                      const RpaResolution& resolution) {
+    const tBTM_SEC_DEV_REC* p_dev_rec = resolution.p_dev_rec;
+    if (p_dev_rec == nullptr) return true;
+    if (!resolution.resolved_by_irk) return IsAddressOf(bd_addr, p_dev_rec);
+    return (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+           (p_dev_rec->ble.key_type & BTM_LE_KEY_PID) &&
+           p_dev_rec->ble.keys.irk == resolution.irk;
+  }
+
+  void Rebuild() {
+    list_ = btm_cb.sec_dev_rec;
+    generation_ = btm_cb.sec_dev_rec_generation;
+    records_.clear();
+    by_address_.clear();
+    resolved_rpas_.Clear();
+
+    list_node_t* end = list_end(list_);
+    for (list_node_t* node = list_begin(list_); node != end;
+         node = list_next(node)) {
+      tBTM_SEC_DEV_REC* p_dev_rec =
+          static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+      /* emplace keeps the first record with a given address */
+      by_address_.emplace(p_dev_rec->bd_addr, records_.size());
+      by_address_.emplace(p_dev_rec->ble.pseudo_addr, records_.size());
+      records_.push_back(p_dev_rec);
+    }
+  }
+
+  const list_t* list_ = nullptr;
+  uint64_t generation_ = 0;
+  /* Records in list order */
+  std::vector<tBTM_SEC_DEV_REC*> records_;
+  std::unordered_map<RawAddress, size_t> by_address_;
+  bluetooth::common::LegacyLruCache<RawAddress, RpaResolution> resolved_rpas_{
+      kRpaCacheSize, "btm_dev_rpa"};
+  /* Scratch space of Find(), kept to avoid allocations */
+  std::vector<tBTM_SEC_DEV_REC*> candidates_;
+  std::vector<Octet16> irks_;
+  std::vector<uint32_t> hashes_;
+};
+
+DevRecIndex dev_rec_index;
+
+}  // namespace
+
 /*******************************************************************************
  *
  * Function         btm_find_dev
@@ -365,13 +522,11 @@ bool is_address_equal(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
   if (btm_cb.sec_dev_rec == nullptr) return nullptr;
 
-  list_node_t* n =
-      list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
-
-  return NULL;
+  return dev_rec_index.Find(bd_addr);
 }
 
+void btm_sec_dev_rec_changed(void) { btm_cb.sec_dev_rec_generation++; }
+
 /*******************************************************************************
  *
  * Function         btm_consolidate_dev
@@ -427,6 +582,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
       }
     }
   }
+  btm_sec_dev_rec_changed();
 }
 
 /*******************************************************************************
@@ -518,6 +674,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
   p_dev_rec =
       static_cast<tBTM_SEC_DEV_REC*>(osi_calloc(sizeof(tBTM_SEC_DEV_REC)));
   list_append(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_sec_dev_rec_changed();
 
   // Initialize defaults
   p_dev_rec->sec_flags = BTM_SEC_IN_USE;
@@ -109,6 +109,21 @@ bool is_address_equal(void* data, void* context);
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr);
 
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_rec_changed
+ *
+ * Description      Invalidate the address index used by btm_find_dev. Must be
+ *                  called after a record is added to or removed from the
+ *                  device database, or after any of its bd_addr,
+ *                  ble.pseudo_addr, device_type, ble.key_type or ble.keys.irk
+ *                  is modified.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void btm_sec_dev_rec_changed(void);
+
 /*******************************************************************************
  *
  * Function         btm_consolidate_dev
@@ -279,6 +279,8 @@ typedef struct tBTM_CB {
   uint8_t disc_reason{0};           /* for legacy devices */
   tBTM_SEC_SERV_REC sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
   list_t* sec_dev_rec{nullptr}; /* list of tBTM_SEC_DEV_REC */
+  /* Bumped on every change of sec_dev_rec that affects btm_find_dev */
+  uint64_t sec_dev_rec_generation{0};
   tBTM_SEC_SERV_REC* p_out_serv{nullptr};
   tBTM_MKEY_CALLBACK* mkey_cback{nullptr};
 
@@ -342,6 +344,7 @@ typedef struct tBTM_CB {
     security_mode = initial_security_mode;
     pairing_bda = RawAddress::kAny;
     sec_dev_rec = list_new(osi_free);
+    sec_dev_rec_generation++;
 
     /* Initialize BTM component structures */
     btm_inq_vars.Init(); /* Inquiry Database and Structures */
@@ -370,6 +373,7 @@ typedef struct tBTM_CB {
 
     list_free(sec_dev_rec);
     sec_dev_rec = nullptr;
+    sec_dev_rec_generation++;
 
     alarm_free(sec_collision_timer);
     sec_collision_timer = nullptr;
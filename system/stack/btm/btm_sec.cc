@@ -3338,6 +3338,7 @@ void btm_sec_encrypt_change(uint16_t handle, tHCI_STATUS status,
       p_dev_rec->sec_flags &= ~(BTM_SEC_LE_LINK_KEY_KNOWN);
       p_dev_rec->ble.key_type = BTM_LE_KEY_NONE;
       p_dev_rec->sec_status = status;
+      btm_sec_dev_rec_changed();
     }
     btm_ble_link_encrypted(p_dev_rec->ble.pseudo_addr, encr_enable);
     return;
@@ -4932,6 +4933,7 @@ void btm_sec_clear_ble_keys(tBTM_SEC_DEV_REC* p_dev_rec) {
   BTM_TRACE_DEBUG("%s() Clearing BLE Keys", __func__);
   p_dev_rec->ble.key_type = BTM_LE_KEY_NONE;
   memset(&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
+  btm_sec_dev_rec_changed();
 
   btm_ble_resolving_list_remove_dev(p_dev_rec);
 }
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/* The AES backend is shared with the GD stack, which builds the same
+ * gd/crypto_toolbox/aes_backend.cc. */
+#include "gd/crypto_toolbox/aes_backend.h"
+
+namespace crypto_toolbox {
+
+using bluetooth::crypto_toolbox::Aes128KeySchedule;
+using bluetooth::crypto_toolbox::aes128_encrypt;
+using bluetooth::crypto_toolbox::aes128_encrypt_blocks;
+using bluetooth::crypto_toolbox::aes128_expand_key;
+using bluetooth::crypto_toolbox::AesImplementation;
+using bluetooth::crypto_toolbox::GetAesImplementation;
+using bluetooth::crypto_toolbox::IsAesImplementationSupported;
+using bluetooth::crypto_toolbox::kAes128Rounds;
+using bluetooth::crypto_toolbox::kAesBlockSize;
+
+}  // namespace crypto_toolbox
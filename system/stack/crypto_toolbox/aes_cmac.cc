@@ -25,8 +25,10 @@
 #include <base/logging.h>
 #include <base/strings/string_number_conversions.h>
 
+#include <algorithm>
+
 #include "check.h"
-#include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/aes_backend.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 #include "stack/include/bt_octets.h"
 
@@ -58,24 +60,32 @@ static void xor_128(Octet16* a, const Octet16& b) {
     aa[i] = aa[i] ^ bb[i];
   }
 }
-}  // namespace
 
-/* This function computes AES_128(key, message) */
-Octet16 aes_128(const Octet16& key, const Octet16& message) {
+/** The AES backend takes keys and blocks MSB first, the toolbox LSB first */
+void expand_key(const Octet16& key, Aes128KeySchedule* schedule) {
   Octet16 key_reversed;
+  std::reverse_copy(key.begin(), key.end(), key_reversed.begin());
+  aes128_expand_key(key_reversed.data(), schedule);
+}
+
+Octet16 encrypt(const Aes128KeySchedule& schedule, const uint8_t* message) {
   Octet16 message_reversed;
   Octet16 output;
 
-  std::reverse_copy(key.begin(), key.end(), key_reversed.begin());
-  std::reverse_copy(message.begin(), message.end(), message_reversed.begin());
-
-  aes_context ctx;
-  aes_set_key(key_reversed.data(), key_reversed.size(), &ctx);
-  aes_encrypt(message_reversed.data(), output.data(), &ctx);
+  std::reverse_copy(message, message + OCTET16_LEN, message_reversed.begin());
+  aes128_encrypt(schedule, message_reversed.data(), output.data());
 
   std::reverse(output.begin(), output.end());
   return output;
 }
+}  // namespace
+
+/* This function computes AES_128(key, message) */
+Octet16 aes_128(const Octet16& key, const Octet16& message) {
+  Aes128KeySchedule schedule;
+  expand_key(key, &schedule);
+  return encrypt(schedule, message.data());
+}
 
 /** utility function to padding the given text to be a 128 bits data. The
  * parameter dest is input and output parameter, it must point to a
@@ -101,19 +111,19 @@ static void leftshift_onebit(uint8_t* input, uint8_t* output) {
 }
 
 /** This function is the calculation of block cipher using AES-128. */
-static Octet16 cmac_aes_k_calculate(const Octet16& key) {
+static Octet16 cmac_aes_k_calculate(const Aes128KeySchedule& schedule) {
   Octet16 output;
   Octet16 x{0};  // zero initialized
 
   DVLOG(2) << __func__;
 
-  uint8_t i = 1;
+  uint16_t i = 1;
   while (i <= cmac_cb.round) {
     /* Mi' := Mi (+) X  */
     xor_128((Octet16*)&cmac_cb.text[(cmac_cb.round - i) * OCTET16_LEN], x);
 
-    output = aes_128(key, &cmac_cb.text[(cmac_cb.round - i) * OCTET16_LEN],
-                     OCTET16_LEN);
+    output =
+        encrypt(schedule, &cmac_cb.text[(cmac_cb.round - i) * OCTET16_LEN]);
     x = output;
     i++;
   }
@@ -145,13 +155,13 @@ static void cmac_prepare_last_block(const Octet16& k1, const Octet16& k2) {
 }
 
 /** This is the function to generate the two subkeys.
- * |key| is CMAC key, expect SRK when used by SMP.
+ * |schedule| is the expanded CMAC key, expect SRK when used by SMP.
  */
-static void cmac_generate_subkey(const Octet16& key) {
+static void cmac_generate_subkey(const Aes128KeySchedule& schedule) {
   DVLOG(2) << __func__;
 
   Octet16 zero{};
-  Octet16 p = aes_128(key, zero.data(), OCTET16_LEN);
+  Octet16 p = encrypt(schedule, zero.data());
 
   Octet16 k1, k2;
   uint8_t* pp = p.data();
@@ -205,10 +215,14 @@ Octet16 aes_cmac(const Octet16& key, const uint8_t* input, uint16_t length) {
     cmac_cb.len = 0;
   }
 
+  /* the key schedule is expanded once per message and shared by all blocks */
+  Aes128KeySchedule schedule;
+  expand_key(key, &schedule);
+
   /* prepare calculation for subkey s and last block of data */
-  cmac_generate_subkey(key);
+  cmac_generate_subkey(schedule);
   /* start calculation */
-  Octet16 signature = cmac_aes_k_calculate(key);
+  Octet16 signature = cmac_aes_k_calculate(schedule);
 
   /* clean up */
   memset(&cmac_cb, 0, sizeof(tCMAC_CB));
@@ -25,6 +25,7 @@
 
 #include <list>
 #include <queue>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -302,6 +303,26 @@ typedef struct {
   bool is_primary;
 } tGATT_SRV_LIST_ELEM;
 
+/* Read By Group Type attribute data of a started primary service */
+typedef struct {
+  uint16_t s_hdl;       /* service starting handle */
+  bluetooth::Uuid uuid; /* service UUID */
+  uint8_t len;          /* length of the attribute data */
+  uint8_t value[4 + bluetooth::Uuid::kNumBytes128]; /* attribute data */
+} tGATT_SRV_GRP_RSP;
+
+/* Lookup tables over the started services, so that requests do not have to
+ * walk every service and attribute. Rebuilt by gatt_sr_update_srv_index()
+ * whenever a service is started or stopped. */
+typedef struct {
+  /* all of srv_list_info, sorted by handle */
+  std::vector<std::list<tGATT_SRV_LIST_ELEM>::iterator> services;
+  /* attributes of the started services by type, sorted by handle */
+  std::unordered_map<bluetooth::Uuid, std::vector<tGATT_ATTR*>> attrs_by_type;
+  /* prebuilt Read By Group Type response data, sorted by handle */
+  std::vector<tGATT_SRV_GRP_RSP> primary_services;
+} tGATT_SRV_INDEX;
+
 typedef struct {
   std::queue<tGATT_CLCB*> pending_enc_clcb; /* pending encryption channel q */
   tGATT_SEC_ACTION sec_act;
@@ -413,6 +434,7 @@ typedef struct {
   tGATT_IF gatt_if;
   std::list<tGATT_HDL_LIST_ELEM>* hdl_list_info;
   std::list<tGATT_SRV_LIST_ELEM>* srv_list_info;
+  tGATT_SRV_INDEX srv_index; /* lookup tables over srv_list_info */
 
   fixed_queue_t* srv_chg_clt_q; /* service change clients queue */
   tGATT_REG cl_rcb[GATT_MAX_APPS];
@@ -555,6 +577,9 @@ extern bool gatt_auto_connect_dev_remove(tGATT_IF gatt_if,
 /* server function */
 extern std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle);
+extern std::list<tGATT_SRV_LIST_ELEM>::iterator
+gatt_sr_lower_bound_rcb_by_handle(uint16_t handle);
+extern void gatt_sr_update_srv_index(void);
 extern tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
                                             uint32_t trans_id, uint8_t op_code,
                                             tGATT_STATUS status,
@@ -660,10 +685,10 @@ extern uint16_t gatts_add_char_ext_prop_descr(tGATT_SVC_DB& db,
 extern uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
                                      const bluetooth::Uuid& dscp_uuid);
 extern tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, uint16_t cid, tGATT_SVC_DB* p_db, uint8_t op_code,
-    BT_HDR* p_rsp, uint16_t s_handle, uint16_t e_handle,
-    const bluetooth::Uuid& type, uint16_t* p_len, tGATT_SEC_FLAG sec_flag,
-    uint8_t key_size, uint32_t trans_id, uint16_t* p_cur_handle);
+    tGATT_TCB& tcb, uint16_t cid, const std::vector<tGATT_ATTR*>& attrs,
+    uint8_t op_code, BT_HDR* p_rsp, uint16_t s_handle, uint16_t e_handle,
+    uint16_t* p_len, tGATT_SEC_FLAG sec_flag, uint8_t key_size,
+    uint32_t trans_id, uint16_t* p_cur_handle);
 extern tGATT_STATUS gatts_read_attr_value_by_handle(
     tGATT_TCB& tcb, uint16_t cid, tGATT_SVC_DB* p_db, uint8_t op_code,
     uint16_t handle, uint16_t offset, uint8_t* p_value, uint16_t* p_len,
@@ -676,6 +701,7 @@ extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
                                                tGATT_SEC_FLAG sec_flag,
                                                uint8_t key_size);
 extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
+extern tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle);
 
 /* gatt_sr_hash.cc */
 extern Octet16 gatts_calculate_database_hash(
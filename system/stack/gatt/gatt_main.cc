@@ -179,6 +179,7 @@ void gatt_free(void) {
   gatt_cb.srv_list_info->clear();
   delete gatt_cb.srv_list_info;
   gatt_cb.srv_list_info = nullptr;
+  gatt_sr_update_srv_index();
 
   EattExtension::GetInstance()->Stop();
 }
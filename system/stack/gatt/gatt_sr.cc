@@ -23,6 +23,8 @@
  ******************************************************************************/
 #include <string.h>
 
+#include <algorithm>
+
 #include "bt_target.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
@@ -523,17 +525,13 @@ static tGATT_STATUS gatt_build_primary_service_rsp(
 
   uint16_t payload_size = gatt_tcb_get_payload_size_tx(tcb, cid);
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl < s_hdl || el.s_hdl > e_hdl ||
-        el.type != GATT_UUID_PRI_SERVICE) {
-      continue;
-    }
-
-    Uuid* p_uuid = gatts_get_service_uuid(el.p_db);
-    if (!p_uuid) continue;
-
-    if (op_code == GATT_REQ_READ_BY_GRP_TYPE)
-      handle_len = 4 + gatt_build_uuid_to_stream_len(*p_uuid);
+  const auto& services = gatt_cb.srv_index.primary_services;
+  auto it = std::lower_bound(services.begin(), services.end(), s_hdl,
+                             [](const tGATT_SRV_GRP_RSP& rsp, uint16_t handle) {
+                               return rsp.s_hdl < handle;
+                             });
+  for (; it != services.end() && it->s_hdl <= e_hdl; it++) {
+    if (op_code == GATT_REQ_READ_BY_GRP_TYPE) handle_len = it->len;
 
     /* get the length byte in the repsonse */
     if (p_msg->offset == 0) {
@@ -552,21 +550,10 @@ static tGATT_STATUS gatt_build_primary_service_rsp(
       break;
     }
 
-    if (op_code == GATT_REQ_FIND_TYPE_VALUE && value != *p_uuid) continue;
-
-    UINT16_TO_STREAM(p, el.s_hdl);
-
-    if (gatt_cb.last_service_handle &&
-        gatt_cb.last_service_handle == el.s_hdl) {
-      VLOG(1) << "Use 0xFFFF for the last primary attribute";
-      /* see GATT ERRATA 4065, 4063, ATT ERRATA 4062 */
-      UINT16_TO_STREAM(p, 0xFFFF);
-    } else {
-      UINT16_TO_STREAM(p, el.e_hdl);
-    }
+    if (op_code == GATT_REQ_FIND_TYPE_VALUE && value != it->uuid) continue;
 
-    if (op_code == GATT_REQ_READ_BY_GRP_TYPE)
-      gatt_build_uuid_to_stream(&p, *p_uuid);
+    /* handle range, and the UUID for ReadByGroupType */
+    ARRAY_TO_STREAM(p, it->value, handle_len);
 
     status = GATT_SUCCESS;
     p_msg->len += p_msg->offset;
@@ -593,11 +580,15 @@ static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SRV_LIST_ELEM& el,
 
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
-  for (auto& attr : el.p_db->attr_list) {
+  auto& attrs = el.p_db->attr_list;
+  auto it = std::lower_bound(attrs.begin(), attrs.end(), s_hdl,
+                             [](const tGATT_ATTR& attr, uint16_t handle) {
+                               return attr.handle < handle;
+                             });
+  for (; it != attrs.end(); it++) {
+    tGATT_ATTR& attr = *it;
     if (attr.handle > e_hdl) break;
 
-    if (attr.handle < s_hdl) continue;
-
     uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
     if (p_msg->offset == 0)
       p_msg->offset = (uuid_len == Uuid::kNumBytes16) ? GATT_INFO_TYPE_PAIR_16
@@ -765,13 +756,12 @@ static void gatts_process_find_info(tGATT_TCB& tcb, uint16_t cid,
 
   buf_len = payload_size - 2;
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      reason = gatt_build_find_info_rsp(el, p_msg, buf_len, s_hdl, e_hdl);
-      if (reason == GATT_NO_RESOURCES) {
-        reason = GATT_SUCCESS;
-        break;
-      }
+  for (auto it = gatt_sr_lower_bound_rcb_by_handle(s_hdl);
+       it != gatt_cb.srv_list_info->end() && it->s_hdl <= e_hdl; it++) {
+    reason = gatt_build_find_info_rsp(*it, p_msg, buf_len, s_hdl, e_hdl);
+    if (reason == GATT_NO_RESOURCES) {
+      reason = GATT_SUCCESS;
+      break;
     }
   }
 
@@ -897,24 +887,19 @@ static void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint16_t cid,
   uint16_t buf_len = payload_size - 2;
 
   reason = GATT_NOT_FOUND;
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      tGATT_SEC_FLAG sec_flag;
-      uint8_t key_size;
-      gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
-
-      tGATT_STATUS ret = gatts_db_read_attr_value_by_type(
-          tcb, cid, el.p_db, op_code, p_msg, s_hdl, e_hdl, uuid, &buf_len,
-          sec_flag, key_size, 0, &err_hdl);
-      if (ret != GATT_NOT_FOUND) {
-        reason = ret;
-        if (ret == GATT_NO_RESOURCES) reason = GATT_SUCCESS;
-      }
-
-      if (ret != GATT_SUCCESS && ret != GATT_NOT_FOUND) {
-        s_hdl = err_hdl;
-        break;
-      }
+  auto attrs = gatt_cb.srv_index.attrs_by_type.find(uuid);
+  if (attrs != gatt_cb.srv_index.attrs_by_type.end()) {
+    tGATT_SEC_FLAG sec_flag;
+    uint8_t key_size;
+    gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
+
+    reason = gatts_db_read_attr_value_by_type(tcb, cid, attrs->second, op_code,
+                                              p_msg, s_hdl, e_hdl, &buf_len,
+                                              sec_flag, key_size, 0, &err_hdl);
+    if (reason == GATT_NO_RESOURCES) {
+      reason = GATT_SUCCESS;
+    } else if (reason != GATT_SUCCESS && reason != GATT_NOT_FOUND) {
+      s_hdl = err_hdl;
     }
   }
   *p = (uint8_t)p_msg->offset;
@@ -1117,32 +1102,28 @@ void gatts_process_attribute_req(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code,
 #endif
 
   if (GATT_HANDLE_IS_VALID(handle)) {
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        for (const auto& attr : el.p_db->attr_list) {
-          if (attr.handle == handle) {
-            switch (op_code) {
-              case GATT_REQ_READ: /* read char/char descriptor value */
-              case GATT_REQ_READ_BLOB:
-                gatts_process_read_req(tcb, cid, el, op_code, handle, len, p);
-                break;
-
-              case GATT_REQ_WRITE: /* write char/char descriptor value */
-              case GATT_CMD_WRITE:
-              case GATT_SIGN_CMD_WRITE:
-              case GATT_REQ_PREPARE_WRITE:
-                gatts_process_write_req(tcb, cid, el, handle, op_code, len, p,
-                                        attr.gatt_type);
-                break;
-              default:
-                break;
-            }
-            status = GATT_SUCCESS;
-            break;
-          }
-        }
-        break;
+    auto it = gatt_sr_find_i_rcb_by_handle(handle);
+    tGATT_ATTR* p_attr = (it != gatt_cb.srv_list_info->end())
+                             ? find_attr_by_handle(it->p_db, handle)
+                             : nullptr;
+    if (p_attr) {
+      switch (op_code) {
+        case GATT_REQ_READ: /* read char/char descriptor value */
+        case GATT_REQ_READ_BLOB:
+          gatts_process_read_req(tcb, cid, *it, op_code, handle, len, p);
+          break;
+
+        case GATT_REQ_WRITE: /* write char/char descriptor value */
+        case GATT_CMD_WRITE:
+        case GATT_SIGN_CMD_WRITE:
+        case GATT_REQ_PREPARE_WRITE:
+          gatts_process_write_req(tcb, cid, *it, handle, op_code, len, p,
+                                  p_attr->gatt_type);
+          break;
+        default:
+          break;
       }
+      status = GATT_SUCCESS;
     }
   }
 
@@ -1253,13 +1234,12 @@ void gatts_process_value_conf(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code) {
   if (continue_processing) {
     tGATTS_DATA gatts_data;
     gatts_data.handle = handle;
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        uint32_t trans_id = gatt_sr_enqueue_cmd(tcb, cid, op_code, handle);
-        uint16_t conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, el.gatt_if);
-        gatt_sr_send_req_callback(conn_id, trans_id, GATTS_REQ_TYPE_CONF,
-                                  &gatts_data);
-      }
+    auto it = gatt_sr_find_i_rcb_by_handle(handle);
+    if (it != gatt_cb.srv_list_info->end()) {
+      uint32_t trans_id = gatt_sr_enqueue_cmd(tcb, cid, op_code, handle);
+      uint16_t conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, it->gatt_if);
+      gatt_sr_send_req_callback(conn_id, trans_id, GATTS_REQ_TYPE_CONF,
+                                &gatts_data);
     }
   }
 }
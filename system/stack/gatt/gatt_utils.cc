@@ -26,6 +26,7 @@
 #include <base/logging.h>
 #include <base/strings/stringprintf.h>
 
+#include <algorithm>
 #include <cstdint>
 
 #include "bt_target.h"  // Must be first to define build configuration
@@ -744,15 +745,86 @@ void  gatt_ind_ack_timeout(void* data) {
  ******************************************************************************/
 std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle) {
-  auto it = gatt_cb.srv_list_info->begin();
+  auto it = gatt_sr_lower_bound_rcb_by_handle(handle);
+  if (it != gatt_cb.srv_list_info->end() && it->s_hdl <= handle) return it;
 
-  for (; it != gatt_cb.srv_list_info->end(); it++) {
-    if (it->s_hdl <= handle && it->e_hdl >= handle) {
-      return it;
+  return gatt_cb.srv_list_info->end();
+}
+
+/*******************************************************************************
+ *
+ * Description      Search for the first service that ends at or after a
+ *                  specific handle. Services follow it in srv_list_info in
+ *                  handle order.
+ *
+ * Returns          srv_list_info end if not found.
+ *
+ ******************************************************************************/
+std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_lower_bound_rcb_by_handle(
+    uint16_t handle) {
+  const auto& services = gatt_cb.srv_index.services;
+
+  auto it = std::lower_bound(
+      services.begin(), services.end(), handle,
+      [](std::list<tGATT_SRV_LIST_ELEM>::iterator el, uint16_t handle) {
+        return el->e_hdl < handle;
+      });
+  if (it == services.end()) return gatt_cb.srv_list_info->end();
+
+  return *it;
+}
+
+/*******************************************************************************
+ *
+ * Description      Rebuild the lookup tables over srv_list_info. Must be
+ *                  called whenever a service is started or stopped, and after
+ *                  last_service_handle is updated.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_update_srv_index(void) {
+  tGATT_SRV_INDEX& index = gatt_cb.srv_index;
+  index.services.clear();
+  index.attrs_by_type.clear();
+  index.primary_services.clear();
+
+  if (!gatt_cb.srv_list_info) return;
+
+  /* srv_list_info is kept sorted by handle, and services do not overlap */
+  for (auto it = gatt_cb.srv_list_info->begin();
+       it != gatt_cb.srv_list_info->end(); it++) {
+    index.services.push_back(it);
+    if (!it->p_db) continue;
+
+    for (tGATT_ATTR& attr : it->p_db->attr_list) {
+      index.attrs_by_type[attr.uuid].push_back(&attr);
     }
-  }
 
-  return it;
+    if (it->type != GATT_UUID_PRI_SERVICE) continue;
+
+    Uuid* p_uuid = gatts_get_service_uuid(it->p_db);
+    if (!p_uuid) continue;
+
+    tGATT_SRV_GRP_RSP rsp;
+    memset(rsp.value, 0, sizeof(rsp.value));
+    rsp.s_hdl = it->s_hdl;
+    rsp.uuid = *p_uuid;
+    rsp.len = 4 + gatt_build_uuid_to_stream_len(*p_uuid);
+
+    uint8_t* p = rsp.value;
+    UINT16_TO_STREAM(p, it->s_hdl);
+    if (gatt_cb.last_service_handle &&
+        gatt_cb.last_service_handle == it->s_hdl) {
+      /* see GATT ERRATA 4065, 4063, ATT ERRATA 4062 */
+      UINT16_TO_STREAM(p, 0xFFFF);
+    } else {
+      UINT16_TO_STREAM(p, it->e_hdl);
+    }
+    gatt_build_uuid_to_stream(&p, *p_uuid);
+
+    index.primary_services.push_back(rsp);
+  }
 }
 
 /*******************************************************************************
@@ -51,6 +51,22 @@ constexpr uint16_t L2CAP_CREDIT_BASED_MIN_MTU = 64;
 constexpr uint16_t L2CAP_CREDIT_BASED_MIN_MPS = 64;
 #define L2CAP_NO_IDLE_TIMEOUT 0xFFFF
 
+/* HCI connection handles are 12 bits, so every valid handle has a slot in the
+ * direct-mapped handle to LCB index.
+ */
+#define L2CAP_LCB_HANDLE_INDEX_SIZE 0x1000
+
+static_assert(MAX_L2CAP_LINKS < 0xFFFF,
+              "LCB indices must fit lcb_index_by_handle entries");
+static_assert(MAX_L2CAP_CHANNELS <= 0xFFFF - L2CAP_BASE_APPL_CID + 1,
+              "local CIDs are allocated by CCB index");
+
+/* Remote CIDs are chosen by the peer over the whole 16-bit range, so the
+ * (LCB, remote CID) to CCB index is hashed instead of direct-mapped. One
+ * bucket per channel keeps the chains short.
+ */
+#define L2CAP_CCB_REMOTE_CID_BUCKETS MAX_L2CAP_CHANNELS
+
 /*
  * Timeout values (in milliseconds).
  */
@@ -298,12 +314,13 @@ typedef struct t_l2c_ccb {
                               segment or not */
   BT_HDR* ble_sdu;         /* Buffer for storing unassembled sdu*/
   uint16_t ble_sdu_length; /* Length of unassembled sdu length*/
-  struct t_l2c_ccb* p_next_ccb; /* Next CCB in the chain */
-  struct t_l2c_ccb* p_prev_ccb; /* Previous CCB in the chain */
-  struct t_l2c_linkcb* p_lcb;   /* Link this CCB is assigned to */
+  struct t_l2c_ccb* p_next_ccb;      /* Next CCB in the chain */
+  struct t_l2c_ccb* p_prev_ccb;      /* Previous CCB in the chain */
+  struct t_l2c_linkcb* p_lcb;        /* Link this CCB is assigned to */
+  struct t_l2c_ccb* p_next_rcid_ccb; /* Next CCB in the remote CID bucket */
 
   uint16_t local_cid;  /* Local CID */
-  uint16_t remote_cid; /* Remote CID */
+  uint16_t remote_cid; /* Remote CID, set with l2cu_set_ccb_remote_cid() */
 
   alarm_t* l2c_ccb_timer; /* CCB Timer Entry */
 
@@ -594,6 +611,17 @@ typedef struct {
   tL2C_CCB ccb_pool[MAX_L2CAP_CHANNELS]; /* Channel Control Block pool */
   tL2C_RCB rcb_pool[MAX_L2CAP_CLIENTS];  /* Registration info pool */
 
+  /* Handle to LCB lookup for the receive path, lcb_pool index plus one or 0
+   * when unused. Maintained by l2cu_set_lcb_handle() and l2cu_release_lcb().
+   */
+  uint16_t lcb_index_by_handle[L2CAP_LCB_HANDLE_INDEX_SIZE];
+
+  /* (LCB, remote CID) to CCB lookup for the signalling path, chained through
+   * p_next_rcid_ccb. Holds the dynamic channels of every link.
+   * Maintained by l2cu_set_ccb_remote_cid() and l2cu_release_ccb().
+   */
+  tL2C_CCB* ccb_by_remote_cid[L2CAP_CCB_REMOTE_CID_BUCKETS];
+
   tL2C_CCB* p_free_ccb_first; /* Pointer to first free CCB */
   tL2C_CCB* p_free_ccb_last;  /* Pointer to last  free CCB */
 
@@ -705,6 +733,7 @@ extern void l2cu_release_ccb(tL2C_CCB* p_ccb);
 extern tL2C_CCB* l2cu_find_ccb_by_cid(tL2C_LCB* p_lcb, uint16_t local_cid);
 extern tL2C_CCB* l2cu_find_ccb_by_remote_cid(tL2C_LCB* p_lcb,
                                              uint16_t remote_cid);
+extern void l2cu_set_ccb_remote_cid(tL2C_CCB* p_ccb, uint16_t remote_cid);
 extern bool l2c_is_cmd_rejected(uint8_t cmd_code, uint8_t id, tL2C_LCB* p_lcb);
 
 extern void l2cu_send_peer_cmd_reject(tL2C_LCB* p_lcb, uint16_t reason,
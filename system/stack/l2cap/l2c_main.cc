@@ -409,7 +409,7 @@ static void process_l2cap_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len) {
         }
         p_ccb->remote_id = id;
         p_ccb->p_rcb = p_rcb;
-        p_ccb->remote_cid = rcid;
+        l2cu_set_ccb_remote_cid(p_ccb, rcid);
         p_ccb->connection_initiator = L2CAP_INITIATOR_REMOTE;
 
         l2c_csm_execute(p_ccb, L2CEVT_L2CAP_CONNECT_REQ, &con_info);
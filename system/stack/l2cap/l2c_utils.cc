@@ -100,12 +100,30 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
   return (NULL);
 }
 
+/* Drop the handle index entry of |p_lcb|, if it still owns one. Handles
+ * invalidated without going through here leave a stale entry behind, which
+ * l2cu_find_lcb_by_handle() rejects.
+ */
+static void l2cu_unindex_lcb_handle(const tL2C_LCB& p_lcb) {
+  uint16_t handle = p_lcb.Handle();
+  if (handle >= L2CAP_LCB_HANDLE_INDEX_SIZE) return;
+
+  uint16_t index = (uint16_t)(&p_lcb - l2cb.lcb_pool) + 1;
+  if (l2cb.lcb_index_by_handle[handle] == index)
+    l2cb.lcb_index_by_handle[handle] = 0;
+}
+
 void l2cu_set_lcb_handle(struct t_l2c_linkcb& p_lcb, uint16_t handle) {
   if (p_lcb.Handle() != HCI_INVALID_HANDLE) {
     LOG_WARN("Should not replace active handle:%hu with new handle:%hu",
              p_lcb.Handle(), handle);
   }
+  l2cu_unindex_lcb_handle(p_lcb);
   p_lcb.SetHandle(handle);
+  if (handle < L2CAP_LCB_HANDLE_INDEX_SIZE) {
+    l2cb.lcb_index_by_handle[handle] =
+        (uint16_t)(&p_lcb - l2cb.lcb_pool) + 1;
+  }
 }
 
 /*******************************************************************************
@@ -151,6 +169,7 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   tL2C_CCB* p_ccb;
 
   p_lcb->in_use = false;
+  l2cu_unindex_lcb_handle(*p_lcb);
   p_lcb->ResetBonding();
 
   /* Stop and free timers */
@@ -1565,6 +1584,7 @@ void l2cu_release_ccb(tL2C_CCB* p_ccb) {
 
   /* Channel may not be assigned to any LCB if it was just pre-reserved */
   if ((p_lcb) && ((p_ccb->local_cid >= L2CAP_BASE_APPL_CID))) {
+    l2cu_set_ccb_remote_cid(p_ccb, 0);
     l2cu_dequeue_ccb(p_ccb);
 
     /* Delink the CCB from the LCB */
@@ -1617,6 +1637,13 @@ void l2cu_release_ccb(tL2C_CCB* p_ccb) {
   }
 }
 
+/* Bucket of |remote_cid| on |p_lcb| in the remote CID index */
+static size_t l2cu_remote_cid_bucket(const tL2C_LCB* p_lcb,
+                                     uint16_t remote_cid) {
+  size_t lcb_index = (size_t)(p_lcb - l2cb.lcb_pool);
+  return (lcb_index * 31 + remote_cid) % L2CAP_CCB_REMOTE_CID_BUCKETS;
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_find_ccb_by_remote_cid
@@ -1633,7 +1660,14 @@ tL2C_CCB* l2cu_find_ccb_by_remote_cid(tL2C_LCB* p_lcb, uint16_t remote_cid) {
   /* If LCB is NULL, look through all active links */
   if (!p_lcb) {
     return NULL;
+  } else if (remote_cid != 0) {
+    p_ccb = l2cb.ccb_by_remote_cid[l2cu_remote_cid_bucket(p_lcb, remote_cid)];
+    for (; p_ccb; p_ccb = p_ccb->p_next_rcid_ccb)
+      if ((p_ccb->in_use) && (p_ccb->p_lcb == p_lcb) &&
+          (p_ccb->remote_cid == remote_cid))
+        return (p_ccb);
   } else {
+    /* Channels still waiting for their remote CID are not indexed */
     for (p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb; p_ccb = p_ccb->p_next_ccb)
       if ((p_ccb->in_use) && (p_ccb->remote_cid == remote_cid)) return (p_ccb);
   }
@@ -1642,6 +1676,41 @@ tL2C_CCB* l2cu_find_ccb_by_remote_cid(tL2C_LCB* p_lcb, uint16_t remote_cid) {
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         l2cu_set_ccb_remote_cid
+ *
+ * Description      Set the remote CID of a channel and move it to the
+ *                  matching remote CID index bucket. Only dynamic channels
+ *                  assigned to a link are indexed, like the per-link CCB
+ *                  list they are otherwise found in.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_set_ccb_remote_cid(tL2C_CCB* p_ccb, uint16_t remote_cid) {
+  bool indexed = (p_ccb->p_lcb != NULL) &&
+                 (p_ccb->local_cid >= L2CAP_BASE_APPL_CID);
+
+  if (indexed && p_ccb->remote_cid != 0) {
+    tL2C_CCB** pp_ccb = &l2cb.ccb_by_remote_cid[l2cu_remote_cid_bucket(
+        p_ccb->p_lcb, p_ccb->remote_cid)];
+    while (*pp_ccb != NULL && *pp_ccb != p_ccb)
+      pp_ccb = &(*pp_ccb)->p_next_rcid_ccb;
+    if (*pp_ccb == p_ccb) *pp_ccb = p_ccb->p_next_rcid_ccb;
+  }
+  p_ccb->p_next_rcid_ccb = NULL;
+
+  p_ccb->remote_cid = remote_cid;
+  if (indexed && remote_cid != 0) {
+    tL2C_CCB** pp_bucket =
+        &l2cb.ccb_by_remote_cid[l2cu_remote_cid_bucket(p_ccb->p_lcb,
+                                                       remote_cid)];
+    p_ccb->p_next_rcid_ccb = *pp_bucket;
+    *pp_bucket = p_ccb;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_allocate_rcb
@@ -3257,16 +3326,27 @@ void l2cu_send_peer_ble_credit_based_disconn_req(tL2C_CCB* p_ccb) {
  *
  * Function         l2cu_find_lcb_by_handle
  *
- * Description      Look through all active LCBs for a match based on the
- *                  HCI handle.
+ * Description      Find the active LCB with the given HCI handle. Valid
+ *                  handles are looked up in the handle index, anything
+ *                  else falls back to a scan of the LCB pool.
  *
  * Returns          pointer to matched LCB, or NULL if no match
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
   int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  tL2C_LCB* p_lcb;
+
+  if (handle < L2CAP_LCB_HANDLE_INDEX_SIZE) {
+    uint16_t index = l2cb.lcb_index_by_handle[handle];
+    if (index == 0) return (NULL);
 
+    p_lcb = &l2cb.lcb_pool[index - 1];
+    if ((p_lcb->in_use) && (p_lcb->Handle() == handle)) return (p_lcb);
+    return (NULL);
+  }
+
+  p_lcb = &l2cb.lcb_pool[0];
   for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
     if ((p_lcb->in_use) && (p_lcb->Handle() == handle)) {
       return (p_lcb);
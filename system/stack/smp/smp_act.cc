@@ -2171,6 +2171,7 @@ void smp_br_process_link_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
   if (p_dev_rec) {
     SMP_TRACE_DEBUG("%s: dev_type = %d ", __func__, p_dev_rec->device_type);
     p_dev_rec->device_type |= BT_DEVICE_TYPE_BLE;
+    btm_sec_dev_rec_changed();
   } else {
     SMP_TRACE_ERROR("%s failed to find Security Record", __func__);
   }
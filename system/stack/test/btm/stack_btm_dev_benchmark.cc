@@ -0,0 +1,145 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "btif/include/btif_hh.h"
+#include "hci/include/hci_layer.h"
+#include "stack/btm/btm_dev.h"
+#include "stack/btm/btm_int_types.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+#include "stack/l2cap/l2c_int.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+
+extern tBTM_CB btm_cb;
+
+uint8_t appl_trace_level = BT_TRACE_LEVEL_NONE;
+btif_hh_cb_t btif_hh_cb;
+tL2C_CB l2cb;
+
+const hci_t* hci_layer_get_interface() { return nullptr; }
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+namespace {
+
+constexpr size_t kNumBondedDevices = 100;
+/* More than the number of resolutions btm_find_dev remembers */
+constexpr size_t kNumFreshRpas = 10000;
+
+/* Return a random resolvable address of the device with |irk| */
+RawAddress MakeRpa(const Octet16& irk, std::mt19937* random) {
+  RawAddress rpa;
+  rpa.address[0] = 0x40 | ((*random)() & 0x3f);
+  rpa.address[1] = (*random)();
+  rpa.address[2] = (*random)();
+  uint8_t prand[3] = {rpa.address[2], rpa.address[1], rpa.address[0]};
+  Octet16 hash = crypto_toolbox::aes_128(irk, prand, sizeof(prand));
+  rpa.address[3] = hash[2];
+  rpa.address[4] = hash[1];
+  rpa.address[5] = hash[0];
+  return rpa;
+}
+
+/* Device database with |kNumBondedDevices| bonded LE devices that use privacy,
+ * and random resolvable addresses of those devices */
+class BondedDevices {
+ public:
+  BondedDevices() {
+    btm_cb.Init(BTM_SEC_MODE_SC);
+    std::mt19937 random(42);
+    std::vector<Octet16> irks;
+    for (size_t i = 0; i < kNumBondedDevices; i++) {
+      tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_allocate_dev_rec();
+      p_dev_rec->bd_addr = RawAddress({0x00, 0x11, 0x22, 0x33,
+                                       static_cast<uint8_t>(i >> 8),
+                                       static_cast<uint8_t>(i)});
+      p_dev_rec->ble.pseudo_addr = p_dev_rec->bd_addr;
+      p_dev_rec->device_type = BT_DEVICE_TYPE_BLE;
+      p_dev_rec->ble.key_type = BTM_LE_KEY_PENC | BTM_LE_KEY_PID;
+      for (auto& byte : p_dev_rec->ble.keys.irk) byte = random();
+      btm_sec_dev_rec_changed();
+      irks.push_back(p_dev_rec->ble.keys.irk);
+      identity_addresses_.push_back(p_dev_rec->bd_addr);
+      rpas_.push_back(MakeRpa(p_dev_rec->ble.keys.irk, &random));
+    }
+    for (size_t i = 0; i < kNumFreshRpas; i++) {
+      fresh_rpas_.push_back(MakeRpa(irks[i % irks.size()], &random));
+    }
+  }
+  ~BondedDevices() { btm_cb.Free(); }
+
+  const std::vector<RawAddress>& IdentityAddresses() const {
+    return identity_addresses_;
+  }
+  const std::vector<RawAddress>& Rpas() const { return rpas_; }
+  const std::vector<RawAddress>& FreshRpas() const { return fresh_rpas_; }
+
+ private:
+  std::vector<RawAddress> identity_addresses_;
+  /* One address per device, as when the same devices keep advertising */
+  std::vector<RawAddress> rpas_;
+  /* Addresses never looked up twice, as after every device rotated */
+  std::vector<RawAddress> fresh_rpas_;
+};
+
+/* The lookup btm_find_dev did before the address index */
+tBTM_SEC_DEV_REC* FindDevByLinearScan(const RawAddress& bd_addr) {
+  list_node_t* n =
+      list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
+  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  return nullptr;
+}
+
+void RunLookups(State& state, const std::vector<RawAddress>& addresses,
+                tBTM_SEC_DEV_REC* (*find)(const RawAddress&)) {
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(find(addresses[i++ % addresses.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LinearScan_Rpa(State& state) {
+  BondedDevices devices;
+  RunLookups(state, devices.Rpas(), FindDevByLinearScan);
+}
+BENCHMARK(BM_LinearScan_Rpa);
+
+void BM_FindDev_IdentityAddress(State& state) {
+  BondedDevices devices;
+  RunLookups(state, devices.IdentityAddresses(), btm_find_dev);
+}
+BENCHMARK(BM_FindDev_IdentityAddress);
+
+void BM_FindDev_Rpa(State& state) {
+  BondedDevices devices;
+  RunLookups(state, devices.Rpas(), btm_find_dev);
+}
+BENCHMARK(BM_FindDev_Rpa);
+
+void BM_FindDev_FreshRpa(State& state) {
+  BondedDevices devices;
+  RunLookups(state, devices.FreshRpas(), btm_find_dev);
+}
+BENCHMARK(BM_FindDev_FreshRpa);
+
+}  // namespace
@@ -36,6 +36,7 @@
 #include "stack/btm/btm_sco.h"
 #include "stack/btm/btm_sec.h"
 #include "stack/btm/security_device_record.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/acl_hci_link_interface.h"
 #include "stack/include/btm_client_interface.h"
@@ -276,6 +277,92 @@ TEST(ScoTest, make_sco_packet) {
 
 TEST(BtmTest, BTM_EIR_MAX_SERVICES) { ASSERT_EQ(46, BTM_EIR_MAX_SERVICES); }
 
+RawAddress make_rpa(const Octet16& irk, uint8_t prand_seed) {
+  RawAddress rpa({static_cast<uint8_t>(0x40 | (prand_seed & 0x3f)),
+                  prand_seed, 0x5a, 0x00, 0x00, 0x00});
+  uint8_t prand[3] = {rpa.address[2], rpa.address[1], rpa.address[0]};
+  Octet16 hash = crypto_toolbox::aes_128(irk, prand, sizeof(prand));
+  rpa.address[3] = hash[2];
+  rpa.address[4] = hash[1];
+  rpa.address[5] = hash[0];
+  return rpa;
+}
+
+tBTM_SEC_DEV_REC* add_bonded_le_device(const RawAddress& identity_addr,
+                                       uint8_t irk_seed) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_allocate_dev_rec();
+  p_dev_rec->bd_addr = identity_addr;
+  p_dev_rec->ble.pseudo_addr = identity_addr;
+  p_dev_rec->device_type = BT_DEVICE_TYPE_BLE;
+  p_dev_rec->ble.key_type = BTM_LE_KEY_PID;
+  p_dev_rec->ble.keys.irk.fill(irk_seed);
+  btm_sec_dev_rec_changed();
+  return p_dev_rec;
+}
+
+TEST_F(StackBtmWithInitFreeTest, btm_find_dev_by_address) {
+  RawAddress addr1({0x00, 0x11, 0x22, 0x33, 0x44, 0x01});
+  RawAddress addr2({0x00, 0x11, 0x22, 0x33, 0x44, 0x02});
+  RawAddress unknown({0x00, 0x11, 0x22, 0x33, 0x44, 0x03});
+  tBTM_SEC_DEV_REC* p_dev_rec1 = add_bonded_le_device(addr1, 0x01);
+  tBTM_SEC_DEV_REC* p_dev_rec2 = add_bonded_le_device(addr2, 0x02);
+
+  ASSERT_EQ(p_dev_rec1, btm_find_dev(addr1));
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(addr2));
+  ASSERT_EQ(nullptr, btm_find_dev(unknown));
+
+  p_dev_rec2->bd_addr = unknown;
+  btm_sec_dev_rec_changed();
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(unknown));
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(addr2));
+
+  wipe_secrets_and_remove(p_dev_rec1);
+  ASSERT_EQ(nullptr, btm_find_dev(addr1));
+}
+
+TEST_F(StackBtmWithInitFreeTest, btm_find_dev_by_rpa) {
+  RawAddress addr1({0x00, 0x11, 0x22, 0x33, 0x44, 0x01});
+  RawAddress addr2({0x00, 0x11, 0x22, 0x33, 0x44, 0x02});
+  tBTM_SEC_DEV_REC* p_dev_rec1 = add_bonded_le_device(addr1, 0x01);
+  tBTM_SEC_DEV_REC* p_dev_rec2 = add_bonded_le_device(addr2, 0x02);
+
+  RawAddress rpa1 = make_rpa(p_dev_rec1->ble.keys.irk, 0x01);
+  RawAddress rpa2 = make_rpa(p_dev_rec2->ble.keys.irk, 0x02);
+  // The second lookup is answered from the resolution cache
+  ASSERT_EQ(p_dev_rec1, btm_find_dev(rpa1));
+  ASSERT_EQ(p_dev_rec1, btm_find_dev(rpa1));
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(rpa2));
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(rpa2));
+
+  // A new IRK no longer resolves the addresses made with the old one
+  p_dev_rec2->ble.keys.irk.fill(0x03);
+  btm_sec_dev_rec_changed();
+  ASSERT_EQ(nullptr, btm_find_dev(rpa2));
+  RawAddress new_rpa2 = make_rpa(p_dev_rec2->ble.keys.irk, 0x02);
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(new_rpa2));
+
+  // Nor does a device without its IRK
+  p_dev_rec1->ble.key_type = BTM_LE_KEY_NONE;
+  btm_sec_dev_rec_changed();
+  ASSERT_EQ(nullptr, btm_find_dev(rpa1));
+}
+
+TEST_F(StackBtmWithInitFreeTest, btm_find_dev_by_rpa_returns_first_match) {
+  RawAddress addr1({0x00, 0x11, 0x22, 0x33, 0x44, 0x01});
+  tBTM_SEC_DEV_REC* p_dev_rec1 = add_bonded_le_device(addr1, 0x01);
+  RawAddress rpa1 = make_rpa(p_dev_rec1->ble.keys.irk, 0x01);
+
+  // A later record known by the random address itself
+  tBTM_SEC_DEV_REC* p_dev_rec2 = btm_sec_allocate_dev_rec();
+  p_dev_rec2->bd_addr = rpa1;
+  btm_sec_dev_rec_changed();
+  ASSERT_EQ(p_dev_rec1, btm_find_dev(rpa1));
+
+  p_dev_rec1->ble.key_type = BTM_LE_KEY_NONE;
+  btm_sec_dev_rec_changed();
+  ASSERT_EQ(p_dev_rec2, btm_find_dev(rpa1));
+}
+
 }  // namespace
 
 void btm_sec_rmt_name_request_complete(const RawAddress* p_bd_addr,
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/aes_backend.h"
 #include "stack/include/bt_octets.h"
 
 using ::testing::ElementsAreArray;
@@ -319,6 +320,66 @@ TEST(CryptoToolboxTest, bt_spec_example_d_7_test) {
   EXPECT_EQ(result[2], expected_ah[2]);
 }
 
+TEST(CryptoToolboxTest, ah_test) {
+  Octet16 IRK{0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
+              0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b};
+  std::reverse(std::begin(IRK), std::end(IRK));
+  EXPECT_EQ(ah(IRK, 0x708194), 0x0dfbaau);
+
+  // Batched hashes are the ones of ah() with each key, in order
+  std::vector<Octet16> irks(100);
+  for (size_t i = 0; i < irks.size(); i++) {
+    irks[i] = IRK;
+    irks[i][i % OCTET16_LEN] ^= static_cast<uint8_t>(i);
+  }
+  std::vector<uint32_t> hashes(irks.size());
+  ah(irks.data(), irks.size(), 0x708194, hashes.data());
+  for (size_t i = 0; i < irks.size(); i++) {
+    EXPECT_EQ(hashes[i], ah(irks[i], 0x708194));
+  }
+  EXPECT_EQ(hashes[0], 0x0dfbaau);
+}
+
+// Every AES implementation must give the same result as the reference one of
+// aes.h
+TEST(CryptoToolboxTest, aes_implementations_match_reference) {
+  constexpr size_t kNumBlocks = 71;
+  uint8_t keys[kNumBlocks][kAesBlockSize];
+  uint8_t in[kNumBlocks][kAesBlockSize];
+  uint8_t expected[kNumBlocks][kAesBlockSize];
+  uint32_t seed = 1;
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    for (size_t j = 0; j < kAesBlockSize; j++) {
+      seed = seed * 1103515245 + 12345;
+      keys[i][j] = seed >> 16;
+      in[i][j] = seed >> 24;
+    }
+    aes_context ctx;
+    aes_set_key(keys[i], kAesBlockSize, &ctx);
+    aes_encrypt(in[i], expected[i], &ctx);
+  }
+
+  for (auto implementation :
+       {AesImplementation::TABLE, AesImplementation::X86_AESNI,
+        AesImplementation::ARMV8_CRYPTO}) {
+    if (!IsAesImplementationSupported(implementation)) continue;
+    uint8_t out[kNumBlocks][kAesBlockSize];
+    aes128_encrypt_blocks(implementation, keys, in, out, kNumBlocks);
+    for (size_t i = 0; i < kNumBlocks; i++) {
+      EXPECT_EQ(0, memcmp(out[i], expected[i], kAesBlockSize))
+          << "implementation " << static_cast<int>(implementation);
+    }
+  }
+
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    Aes128KeySchedule schedule;
+    aes128_expand_key(keys[i], &schedule);
+    uint8_t out[kAesBlockSize];
+    aes128_encrypt(schedule, in[i], out);
+    EXPECT_EQ(0, memcmp(out, expected[i], kAesBlockSize));
+  }
+}
+
 // BT Spec 5.0 | Vol 3, Part H D.8
 TEST(CryptoToolboxTest, bt_spec_example_d_8_test) {
   Octet16 Key{0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
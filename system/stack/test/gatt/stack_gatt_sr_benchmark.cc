@@ -0,0 +1,176 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "stack/gatt/gatt_int.h"
+#include "stack/include/gatt_api.h"
+#include "stack/include/l2cdefs.h"
+#include "test/mock/mock_stack_l2cap_api.h"
+#include "types/bluetooth/uuid.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+std::map<std::string, int> mock_function_count_map;
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+namespace {
+
+constexpr size_t kNumCharacteristics = 10;
+constexpr uint16_t kPayloadSize = 517;
+
+void RequestCallback(uint16_t conn_id, uint32_t trans_id, tGATTS_REQ_TYPE type,
+                     tGATTS_DATA* p_data) {}
+
+tGATT_CBACK gatt_callbacks = {
+    .p_req_cb = RequestCallback,
+};
+
+/* GATT server exposing |num_services| custom primary services, each with
+ * |kNumCharacteristics| notifiable characteristics, to one connected client */
+class GattServer {
+ public:
+  explicit GattServer(size_t num_services) {
+    test::mock::stack_l2cap_api::L2CA_SendFixedChnlData.body =
+        [](uint16_t fixed_cid, const RawAddress& rem_bda, BT_HDR* p_buf) {
+          osi_free(p_buf);
+          return (uint16_t)L2CAP_DW_SUCCESS;
+        };
+
+    gatt_init();
+    gatt_if_ =
+        GATT_Register(Uuid::GetRandom(), "benchmark", &gatt_callbacks, false);
+
+    for (size_t i = 0; i < num_services; i++) {
+      std::vector<btgatt_db_element_t> service;
+      service.push_back({
+          .uuid = Uuid::GetRandom(),
+          .type = BTGATT_DB_PRIMARY_SERVICE,
+      });
+      for (size_t j = 0; j < kNumCharacteristics; j++) {
+        service.push_back({
+            .uuid = Uuid::GetRandom(),
+            .type = BTGATT_DB_CHARACTERISTIC,
+            .properties = GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_NOTIFY,
+            .permissions = GATT_PERM_READ,
+        });
+        service.push_back({
+            .uuid = Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG),
+            .type = BTGATT_DB_DESCRIPTOR,
+            .permissions = GATT_PERM_READ | GATT_PERM_WRITE,
+        });
+      }
+      GATTS_AddService(gatt_if_, service.data(), service.size());
+
+      last_service_ = service.front();
+      last_char_decl_handle_ = service.back().attribute_handle - 2;
+    }
+
+    tGATT_TCB& tcb = gatt_cb.tcb[0];
+    tcb.in_use = true;
+    tcb.transport = BT_TRANSPORT_LE;
+    tcb.att_lcid = L2CAP_ATT_CID;
+    tcb.payload_size = kPayloadSize;
+    tcb.is_robust_cache_change_aware = true;
+  }
+
+  ~GattServer() {
+    gatt_cb.tcb[0].in_use = false;
+    GATT_Deregister(gatt_if_);
+    gatt_free();
+  }
+
+  /* Handle one request; the response is sent and freed synchronously */
+  void Request(uint8_t op_code, std::vector<uint8_t>& payload) {
+    gatt_server_handle_client_req(gatt_cb.tcb[0], L2CAP_ATT_CID, op_code,
+                                  payload.size(), payload.data());
+  }
+
+  /* Start of the last service, found last by the linear lookups */
+  uint16_t LastServiceHandle() const {
+    return last_service_.attribute_handle;
+  }
+
+  /* Declaration handle of the last characteristic of the last service */
+  uint16_t LastCharacteristicHandle() const { return last_char_decl_handle_; }
+
+ private:
+  tGATT_IF gatt_if_;
+  btgatt_db_element_t last_service_;
+  uint16_t last_char_decl_handle_;
+};
+
+std::vector<uint8_t> HandleRange(uint16_t s_hdl, uint16_t e_hdl,
+                                 uint16_t uuid16) {
+  return {static_cast<uint8_t>(s_hdl), static_cast<uint8_t>(s_hdl >> 8),
+          static_cast<uint8_t>(e_hdl), static_cast<uint8_t>(e_hdl >> 8),
+          static_cast<uint8_t>(uuid16), static_cast<uint8_t>(uuid16 >> 8)};
+}
+
+}  // namespace
+
+/* Primary service discovery continuing from the last service */
+static void BM_GattServerReadByGroupType(State& state) {
+  GattServer server(state.range(0));
+  std::vector<uint8_t> payload = HandleRange(server.LastServiceHandle(), 0xffff,
+                                             GATT_UUID_PRI_SERVICE);
+  for (auto _ : state) {
+    server.Request(GATT_REQ_READ_BY_GRP_TYPE, payload);
+  }
+}
+BENCHMARK(BM_GattServerReadByGroupType)->Arg(10)->Arg(100);
+
+/* Characteristic discovery in the last service */
+static void BM_GattServerReadByType(State& state) {
+  GattServer server(state.range(0));
+  std::vector<uint8_t> payload = HandleRange(server.LastServiceHandle(), 0xffff,
+                                             GATT_UUID_CHAR_DECLARE);
+  for (auto _ : state) {
+    server.Request(GATT_REQ_READ_BY_TYPE, payload);
+  }
+}
+BENCHMARK(BM_GattServerReadByType)->Arg(10)->Arg(100);
+
+/* Descriptor discovery of the last characteristic */
+static void BM_GattServerFindInfo(State& state) {
+  GattServer server(state.range(0));
+  uint16_t handle = server.LastCharacteristicHandle();
+  std::vector<uint8_t> payload = HandleRange(handle, 0xffff, 0);
+  payload.resize(4);
+  for (auto _ : state) {
+    server.Request(GATT_REQ_FIND_INFO, payload);
+  }
+}
+BENCHMARK(BM_GattServerFindInfo)->Arg(10)->Arg(100);
+
+/* Read of the last characteristic declaration, answered by the stack */
+static void BM_GattServerRead(State& state) {
+  GattServer server(state.range(0));
+  uint16_t handle = server.LastCharacteristicHandle();
+  std::vector<uint8_t> payload = {static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8)};
+  for (auto _ : state) {
+    server.Request(GATT_REQ_READ, payload);
+  }
+}
+BENCHMARK(BM_GattServerRead)->Arg(10)->Arg(100);
@@ -139,3 +139,69 @@ TEST_F(StackGattTest, GATT_Register_Deregister) {
 
   gatt_free();
 }
+
+TEST_F(StackGattTest, server_lookup_tables_follow_started_services) {
+  gatt_init();
+
+  tGATT_IF gatt_if = GATT_Register(bluetooth::Uuid::GetRandom(), "name",
+                                   &gatt_callbacks, false);
+
+  bluetooth::Uuid service_uuid = bluetooth::Uuid::From16Bit(0x180d);
+  bluetooth::Uuid char_uuid = bluetooth::Uuid::From16Bit(0x2a37);
+  btgatt_db_element_t service[] = {
+      {
+          .uuid = service_uuid,
+          .type = BTGATT_DB_PRIMARY_SERVICE,
+      },
+      {
+          .uuid = char_uuid,
+          .type = BTGATT_DB_CHARACTERISTIC,
+          .properties = GATT_CHAR_PROP_BIT_READ,
+          .permissions = GATT_PERM_READ,
+      },
+      {
+          .uuid = bluetooth::Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG),
+          .type = BTGATT_DB_DESCRIPTOR,
+          .permissions = GATT_PERM_READ | GATT_PERM_WRITE,
+      },
+  };
+  ASSERT_EQ(GATT_SERVICE_STARTED,
+            GATTS_AddService(gatt_if, service,
+                             sizeof(service) / sizeof(btgatt_db_element_t)));
+
+  uint16_t s_hdl = service[0].attribute_handle;
+  uint16_t char_hdl = service[1].attribute_handle;
+  uint16_t descr_hdl = service[2].attribute_handle;
+
+  auto it = gatt_sr_find_i_rcb_by_handle(descr_hdl);
+  ASSERT_NE(gatt_cb.srv_list_info->end(), it);
+  ASSERT_EQ(s_hdl, it->s_hdl);
+  ASSERT_EQ(descr_hdl, find_attr_by_handle(it->p_db, descr_hdl)->handle);
+  ASSERT_EQ(nullptr, find_attr_by_handle(it->p_db, descr_hdl + 1));
+
+  const auto& chars = gatt_cb.srv_index.attrs_by_type[char_uuid];
+  ASSERT_EQ(1u, chars.size());
+  ASSERT_EQ(char_hdl, chars[0]->handle);
+
+  // The service started last reports 0xFFFF as its end handle
+  const tGATT_SRV_GRP_RSP& rsp = gatt_cb.srv_index.primary_services.back();
+  ASSERT_EQ(s_hdl, rsp.s_hdl);
+  ASSERT_EQ(service_uuid, rsp.uuid);
+  ASSERT_EQ(6, rsp.len);
+  uint8_t expected[] = {static_cast<uint8_t>(s_hdl),
+                        static_cast<uint8_t>(s_hdl >> 8),
+                        0xff,
+                        0xff,
+                        0x0d,
+                        0x18};
+  ASSERT_EQ(0, memcmp(expected, rsp.value, sizeof(expected)));
+
+  ASSERT_TRUE(GATTS_DeleteService(gatt_if, &service_uuid, s_hdl));
+  ASSERT_EQ(gatt_cb.srv_list_info->end(),
+            gatt_sr_find_i_rcb_by_handle(descr_hdl));
+  ASSERT_EQ(0u, gatt_cb.srv_index.attrs_by_type[char_uuid].size());
+  ASSERT_NE(s_hdl, gatt_cb.srv_index.primary_services.back().s_hdl);
+
+  GATT_Deregister(gatt_if);
+  gatt_free();
+}
@@ -65,3 +65,79 @@ TEST_F(StackL2capTest, l2cble_process_data_length_change_event) {
   l2cble_process_data_length_change_event(0x1234, 0x001b, 0x001b);
   ASSERT_EQ(0x001b, l2cb.lcb_pool[0].tx_data_len);
 }
+
+TEST_F(StackL2capTest, l2cu_find_lcb_by_handle) {
+  ASSERT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0001));
+
+  l2cb.lcb_pool[0].in_use = true;
+  l2cu_set_lcb_handle(l2cb.lcb_pool[0], 0x0001);
+  l2cb.lcb_pool[3].in_use = true;
+  l2cu_set_lcb_handle(l2cb.lcb_pool[3], 0x0eff);
+  ASSERT_EQ(&l2cb.lcb_pool[0], l2cu_find_lcb_by_handle(0x0001));
+  ASSERT_EQ(&l2cb.lcb_pool[3], l2cu_find_lcb_by_handle(0x0eff));
+  ASSERT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0002));
+
+  // Handle moved to a new value
+  l2cu_set_lcb_handle(l2cb.lcb_pool[0], 0x0002);
+  ASSERT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0001));
+  ASSERT_EQ(&l2cb.lcb_pool[0], l2cu_find_lcb_by_handle(0x0002));
+
+  // Handles outside the index are still found
+  l2cu_set_lcb_handle(l2cb.lcb_pool[0], 0x1234);
+  ASSERT_EQ(&l2cb.lcb_pool[0], l2cu_find_lcb_by_handle(0x1234));
+  ASSERT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0234));
+
+  // Invalidated handles are rejected even though the index is not updated
+  l2cb.lcb_pool[3].InvalidateHandle();
+  ASSERT_EQ(nullptr, l2cu_find_lcb_by_handle(0x0eff));
+
+  l2cb.lcb_pool[0].in_use = false;
+  ASSERT_EQ(nullptr, l2cu_find_lcb_by_handle(0x1234));
+}
+
+TEST_F(StackL2capTest, l2cu_find_ccb_by_remote_cid) {
+  for (int i = 0; i < 3; i++) {
+    l2cb.ccb_pool[i].in_use = true;
+    l2cb.ccb_pool[i].local_cid = L2CAP_BASE_APPL_CID + i;
+  }
+  l2cb.ccb_pool[0].p_lcb = &l2cb.lcb_pool[0];
+  l2cb.ccb_pool[1].p_lcb = &l2cb.lcb_pool[1];
+  l2cb.ccb_pool[2].p_lcb = &l2cb.lcb_pool[0];
+
+  // The same remote CID on two links, and two remote CIDs in one bucket
+  l2cu_set_ccb_remote_cid(&l2cb.ccb_pool[0], 0x0040);
+  l2cu_set_ccb_remote_cid(&l2cb.ccb_pool[1], 0x0040);
+  l2cu_set_ccb_remote_cid(&l2cb.ccb_pool[2],
+                          0x0040 + L2CAP_CCB_REMOTE_CID_BUCKETS);
+  ASSERT_EQ(&l2cb.ccb_pool[0],
+            l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[0], 0x0040));
+  ASSERT_EQ(&l2cb.ccb_pool[1],
+            l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[1], 0x0040));
+  ASSERT_EQ(&l2cb.ccb_pool[2],
+            l2cu_find_ccb_by_remote_cid(
+                &l2cb.lcb_pool[0], 0x0040 + L2CAP_CCB_REMOTE_CID_BUCKETS));
+  ASSERT_EQ(nullptr, l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[2], 0x0040));
+  ASSERT_EQ(nullptr, l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[0], 0x0041));
+  ASSERT_EQ(nullptr, l2cu_find_ccb_by_remote_cid(nullptr, 0x0040));
+
+  // Remote CID changed
+  l2cu_set_ccb_remote_cid(&l2cb.ccb_pool[0], 0x0041);
+  ASSERT_EQ(nullptr, l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[0], 0x0040));
+  ASSERT_EQ(&l2cb.ccb_pool[0],
+            l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[0], 0x0041));
+  ASSERT_EQ(&l2cb.ccb_pool[2],
+            l2cu_find_ccb_by_remote_cid(
+                &l2cb.lcb_pool[0], 0x0040 + L2CAP_CCB_REMOTE_CID_BUCKETS));
+
+  // Channels no longer in use are not found
+  l2cb.ccb_pool[1].in_use = false;
+  ASSERT_EQ(nullptr, l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[1], 0x0040));
+
+  // Fixed channels are not on the link's channel list, and not indexed
+  l2cb.ccb_pool[3].in_use = true;
+  l2cb.ccb_pool[3].local_cid = L2CAP_ATT_CID;
+  l2cb.ccb_pool[3].p_lcb = &l2cb.lcb_pool[0];
+  l2cu_set_ccb_remote_cid(&l2cb.ccb_pool[3], L2CAP_ATT_CID);
+  ASSERT_EQ(nullptr,
+            l2cu_find_ccb_by_remote_cid(&l2cb.lcb_pool[0], L2CAP_ATT_CID));
+}
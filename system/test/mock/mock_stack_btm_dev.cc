@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:16
+ *   Functions generated:17
  */
 
 #include <map>
@@ -106,6 +106,7 @@ void BTM_SecClearSecurityFlags(const RawAddress& bd_addr) {
 void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
   mock_function_count_map[__func__]++;
 }
+void btm_sec_dev_rec_changed(void) { mock_function_count_map[__func__]++; }
 void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
   mock_function_count_map[__func__]++;
 }
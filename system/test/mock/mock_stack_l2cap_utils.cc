@@ -273,6 +273,9 @@ void l2cu_send_peer_info_rsp(tL2C_LCB* p_lcb, uint8_t remote_id,
 void l2cu_set_acl_hci_header(BT_HDR* p_buf, tL2C_CCB* p_ccb) {
   mock_function_count_map[__func__]++;
 }
+void l2cu_set_ccb_remote_cid(tL2C_CCB* p_ccb, uint16_t remote_cid) {
+  mock_function_count_map[__func__]++;
+}
 void l2cu_set_lcb_handle(struct t_l2c_linkcb& p_lcb, uint16_t handle) {
   mock_function_count_map[__func__]++;
 }